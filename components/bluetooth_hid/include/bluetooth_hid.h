@@ -7,10 +7,8 @@
 #define BLUETOOTH_HID_H
 
 #include "esp_err.h"
-#include "esp_bt.h"
-#include "esp_bt_main.h"
-#include "esp_gap_bt_api.h"
-#include "esp_bt_device.h"
+#include "hid_transport.h"
+#include "hid_report_pool.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -18,6 +16,11 @@
 extern "C" {
 #endif
 
+/**
+ * @brief 同时连接的HID设备数上限
+ */
+#define BLUETOOTH_HID_MAX_DEVICES    4
+
 /**
  * @brief HID设备信息结构体
  */
@@ -26,16 +29,36 @@ typedef struct {
     char name[64];               ///< 设备名称
     bool connected;              ///< 连接状态
     void *dev_handle;            ///< 设备句柄（通用指针）
+    uint8_t slot;                ///< 设备槽位 (0 to BLUETOOTH_HID_MAX_DEVICES-1)
+    uint16_t vendor_id;          ///< 厂商ID（未知时为0）
+    uint16_t product_id;         ///< 产品ID（未知时为0）
+    uint16_t version;            ///< 设备固件版本（未知时为0）
+    const uint8_t *report_desc;  ///< 报告描述符（未获取时为NULL）
+    uint16_t report_desc_len;    ///< 报告描述符长度
 } hid_device_info_t;
 
+/**
+ * @brief 连接耗时统计（esp_timer微秒，即上电以来的时间）
+ */
+typedef struct {
+    int64_t connect_start_us;    ///< 开始寻呼时间（手柄主动回连时为连接建立时间）
+    int64_t open_us;             ///< HID通道打开时间
+    int64_t first_report_us;     ///< 收到首个输入报告的时间，0表示尚未收到
+    bool from_bond_cache;        ///< 是否通过绑定缓存直接寻呼
+} hid_connect_timing_t;
+
 /**
  * @brief HID输入报告结构体
  */
 typedef struct {
-    uint8_t *data;               ///< 报告数据
+    uint8_t *data;               ///< 报告数据（不含报告ID字节）
     uint16_t len;                ///< 数据长度
+    uint8_t report_id;           ///< 报告ID，0表示描述符未使用报告ID
     uint8_t map_index;           ///< 报告映射索引
     uint8_t protocol_mode;       ///< 协议模式
+    uint32_t seq;                ///< 报告序号（取缓冲时分配，用于延迟追踪）
+    int64_t timestamp_us;        ///< 报告到达的时间 (esp_timer微秒)
+    hid_report_buf_t *buf;       ///< 承载数据的池缓冲，回调内可retain后延长使用
 } hid_input_report_t;
 
 /**
@@ -72,13 +95,16 @@ typedef struct {
         struct {
             esp_bd_addr_t bd_addr;
             esp_err_t status;
+            uint8_t slot;
         } open;
         struct {
             esp_err_t status;
+            uint8_t slot;
         } close;
         struct {
             uint8_t *data;
             uint16_t len;
+            uint8_t slot;
         } data;
     } param;
 } hid_event_param_t;
@@ -93,6 +119,14 @@ typedef void (*hid_event_callback_t)(hid_event_param_t *param);
  */
 typedef void (*hid_input_callback_t)(hid_device_info_t *device, hid_input_report_t *report);
 
+/**
+ * @brief 选择传输后端
+ * @note 在bluetooth_hid_init之前调用；未调用时按Kconfig选择（默认经典蓝牙）
+ * @param ops 后端操作表，如hid_transport_bt()、hid_transport_loopback()
+ * @return ESP_OK 成功，ESP_ERR_INVALID_STATE 已初始化
+ */
+esp_err_t bluetooth_hid_set_transport(const hid_transport_ops_t *ops);
+
 /**
  * @brief 初始化蓝牙HID主机
  * @param event_cb HID事件回调函数
@@ -101,6 +135,15 @@ typedef void (*hid_input_callback_t)(hid_device_info_t *device, hid_input_report
  */
 esp_err_t bluetooth_hid_init(hid_event_callback_t event_cb, hid_input_callback_t input_cb);
 
+/**
+ * @brief 订阅输入报告队列（可在bluetooth_hid_init之前调用，重复订阅同一队列无效果）
+ * @note 每个报告只拷贝一次进池缓冲，所有订阅队列共享同一缓冲；
+ *       消费者出队后处理完须调用hid_report_pool_release。队列满时该报告对此队列丢弃。
+ * @param queue 已初始化的报告队列，须一直有效
+ * @return ESP_OK 成功，ESP_ERR_NO_MEM 订阅数已满
+ */
+esp_err_t bluetooth_hid_add_report_queue(hid_report_queue_t *queue);
+
 /**
  * @brief 反初始化蓝牙HID主机
  * @return ESP_OK 成功，其他值表示错误
@@ -120,10 +163,18 @@ esp_err_t bluetooth_hid_start_scan(uint32_t duration_sec);
  */
 esp_err_t bluetooth_hid_stop_scan(void);
 
+/**
+ * @brief 按最近使用顺序逐个寻呼已绑定的手柄，未连上时交给重连状态机按轮次重试
+ * @param fallback_scan_sec 每轮查询扫描的时长（秒），0表示沿用重连配置
+ * @return ESP_OK 已开始寻呼，ESP_ERR_NOT_FOUND 没有绑定设备，其他值表示错误
+ */
+esp_err_t bluetooth_hid_reconnect_bonded(uint32_t fallback_scan_sec);
+
 /**
  * @brief 连接HID设备
+ * @note 异步完成，结果通过HID_EVENT_OPEN通知
  * @param bda 设备蓝牙地址
- * @return ESP_OK 成功，其他值表示错误
+ * @return ESP_OK 已开始连接，ESP_ERR_NO_MEM 槽位已满，其他值表示错误
  */
 esp_err_t bluetooth_hid_connect(esp_bd_addr_t bda);
 
@@ -136,21 +187,45 @@ esp_err_t bluetooth_hid_disconnect(void *dev_handle);
 
 /**
  * @brief 发送HID输出报告（震动等）
+ * @note 报告交给输出调度器后立即返回：同一报告ID尚未发出的旧报告被覆盖，
+ *       与上次发出内容相同的报告被丢弃，发送按每设备预算节奏进行（见hid_output_sched.h）
  * @param dev_handle 设备句柄
  * @param report 输出报告
- * @return ESP_OK 成功，其他值表示错误
+ * @return ESP_OK 已交给调度器，其他值表示错误
  */
 esp_err_t bluetooth_hid_send_output_report(void *dev_handle, hid_output_report_t *report);
 
 /**
- * @brief 获取已连接的HID设备信息
+ * @brief 获取已连接的HID设备信息（槽位号最小的设备）
  * @param device_info 输出设备信息
  * @return ESP_OK 成功，其他值表示错误
  */
 esp_err_t bluetooth_hid_get_connected_device(hid_device_info_t *device_info);
 
 /**
- * @brief 检查HID设备是否已连接
+ * @brief 获取指定槽位的HID设备信息
+ * @param slot 设备槽位
+ * @param device_info 输出设备信息
+ * @return ESP_OK 成功，ESP_ERR_NOT_FOUND 槽位未连接，其他值表示错误
+ */
+esp_err_t bluetooth_hid_get_device(uint8_t slot, hid_device_info_t *device_info);
+
+/**
+ * @brief 获取槽位的连接耗时统计（上电到首个报告的时间等）
+ * @param slot 设备槽位
+ * @param timing 输出统计
+ * @return ESP_OK 成功，ESP_ERR_NOT_FOUND 槽位未连接，其他值表示错误
+ */
+esp_err_t bluetooth_hid_get_connect_timing(uint8_t slot, hid_connect_timing_t *timing);
+
+/**
+ * @brief 获取已连接槽位位图
+ * @return 第n位为1表示槽位n已连接
+ */
+uint8_t bluetooth_hid_get_connected_mask(void);
+
+/**
+ * @brief 检查是否有HID设备已连接
  * @return true 已连接，false 未连接
  */
 bool bluetooth_hid_is_connected(void);
@@ -163,6 +238,13 @@ bool bluetooth_hid_is_connected(void);
  */
 esp_err_t bluetooth_hid_set_discoverable(bool discoverable, bool connectable);
 
+/**
+ * @brief 设置寻呼超时（主动连接时等待设备应答的时间）
+ * @param timeout_ms 超时时间（毫秒），由后端换算并限制到协议允许的范围
+ * @return ESP_OK 成功，ESP_ERR_NOT_SUPPORTED 后端不支持，其他值表示错误
+ */
+esp_err_t bluetooth_hid_set_page_timeout(uint32_t timeout_ms);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,123 @@
+/**
+ * @file hid_battery.h
+ * @brief 手柄电池与状态解析头文件
+ *
+ * 按槽位缓存手柄的电量、充电状态和温度：PS4从输入报告0x01/0x11的状态字节解析，
+ * Xbox从电池报告0x04解析，BLE手柄还可来自电池服务的电量通知。
+ * 解析在输入路径上完成，读取只拷贝缓存，不会发起蓝牙传输。
+ * 电量跨过低电量/严重低电量阈值或充电状态变化时通知注册的回调。
+ */
+
+#ifndef HID_BATTERY_H
+#define HID_BATTERY_H
+
+#include "esp_err.h"
+#include "hid_report_parser.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 缓存的槽位数（与BLUETOOTH_HID_MAX_DEVICES相同）
+ */
+#define HID_BATTERY_MAX_DEVICES      4
+
+/**
+ * @brief 电量未知
+ */
+#define HID_BATTERY_LEVEL_UNKNOWN    (-1)
+
+/**
+ * @brief 电池状态档位
+ */
+typedef enum {
+    HID_BATTERY_STATE_UNKNOWN = 0, ///< 尚未收到电量
+    HID_BATTERY_STATE_NORMAL,      ///< 正常
+    HID_BATTERY_STATE_LOW,         ///< 低电量
+    HID_BATTERY_STATE_CRITICAL,    ///< 严重低电量
+    HID_BATTERY_STATE_CHARGING     ///< 充电中或已充满（接着线缆）
+} hid_battery_state_t;
+
+/**
+ * @brief 单个手柄的电池与状态
+ */
+typedef struct {
+    bool connected;              ///< 槽位是否已连接
+    hid_controller_type_t type;  ///< 解析所用的手柄型号
+    int8_t level;                ///< 电量百分比，HID_BATTERY_LEVEL_UNKNOWN表示未知
+    bool charging;               ///< 正在充电
+    bool cable;                  ///< 接着线缆供电
+    hid_battery_state_t state;   ///< 状态档位
+    bool temperature_valid;      ///< 是否有温度数据
+    int8_t temperature;          ///< 传感器温度原始值（PS4，单位未公开）
+    uint16_t firmware_version;   ///< 设备固件版本（DID/PnP记录中的版本号），0表示未知
+    int64_t updated_us;          ///< 最近一次电量更新时间
+} hid_battery_status_t;
+
+/**
+ * @brief 状态档位变化回调（在输入路径所在任务中调用，须尽快返回）
+ * @param slot 设备槽位
+ * @param status 新的状态
+ */
+typedef void (*hid_battery_callback_t)(uint8_t slot, const hid_battery_status_t *status);
+
+/**
+ * @brief 槽位连接，清空缓存并记录型号和固件版本
+ * @param slot 设备槽位
+ * @param type 手柄型号
+ * @param firmware_version 固件版本，0表示未知
+ */
+void hid_battery_on_connect(uint8_t slot, hid_controller_type_t type, uint16_t firmware_version);
+
+/**
+ * @brief 槽位断开
+ * @param slot 设备槽位
+ */
+void hid_battery_on_disconnect(uint8_t slot);
+
+/**
+ * @brief 从输入报告中解析电池状态（输入路径调用，状态字节不变时不加锁）
+ * @param slot 设备槽位
+ * @param report_id 报告ID
+ * @param data 报告数据（不含报告ID字节）
+ * @param len 数据长度
+ */
+void hid_battery_parse_report(uint8_t slot, uint8_t report_id, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief 记录电池服务通知的电量
+ * @param slot 设备槽位
+ * @param level 电量百分比
+ */
+void hid_battery_record_level(uint8_t slot, uint8_t level);
+
+/**
+ * @brief 设置低电量阈值
+ * @param low_percent 低电量阈值
+ * @param critical_percent 严重低电量阈值，须小于低电量阈值
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数错误
+ */
+esp_err_t hid_battery_set_thresholds(uint8_t low_percent, uint8_t critical_percent);
+
+/**
+ * @brief 注册状态档位变化回调
+ * @param callback 回调函数，NULL表示取消
+ */
+void hid_battery_register_callback(hid_battery_callback_t callback);
+
+/**
+ * @brief 获取槽位的电池状态（只读缓存）
+ * @param slot 设备槽位
+ * @param status 输出的状态
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数错误
+ */
+esp_err_t hid_battery_get(uint8_t slot, hid_battery_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HID_BATTERY_H
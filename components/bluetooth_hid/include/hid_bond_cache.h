@@ -0,0 +1,92 @@
+/**
+ * @file hid_bond_cache.h
+ * @brief 已绑定手柄缓存头文件
+ *
+ * 在NVS中保存最近连接过的手柄（地址、传输方式、VID/PID、名称和最后一次的报告描述符），
+ * 上电后按最近使用顺序直接寻呼，不必再做一次完整的查询扫描。
+ * 链路密钥由协议栈自己的绑定存储保管，加载时逐条向传输后端核对，
+ * 已被解除绑定的条目会被丢弃。
+ */
+
+#ifndef HID_BOND_CACHE_H
+#define HID_BOND_CACHE_H
+
+#include "esp_err.h"
+#include "hid_transport.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 缓存条目数上限
+ */
+#define HID_BOND_CACHE_MAX_ENTRIES   4
+
+/**
+ * @brief 缓存的报告描述符最大长度，超出时不缓存描述符
+ */
+#define HID_BOND_CACHE_MAX_DESC_LEN  512
+
+/**
+ * @brief 缓存条目
+ */
+typedef struct {
+    esp_bd_addr_t bda;           ///< 设备蓝牙地址
+    uint8_t transport;           ///< 传输方式 (esp_hid_transport_t)
+    uint16_t vendor_id;          ///< 厂商ID
+    uint16_t product_id;         ///< 产品ID
+    char name[32];               ///< 设备名称
+    uint32_t last_used;          ///< 使用计数，越大表示越近连接过
+    uint16_t desc_len;           ///< 缓存的描述符长度，0表示未缓存
+    uint32_t desc_hash;          ///< 描述符哈希，未变化时不重写
+} hid_bond_entry_t;
+
+/**
+ * @brief 从NVS加载缓存，并丢弃协议栈中已不存在绑定的条目
+ * @note 需要在协议栈启用之后调用
+ * @param is_bonded 绑定核对函数，NULL表示不核对
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t hid_bond_cache_init(bool (*is_bonded)(const uint8_t *bda));
+
+/**
+ * @brief 按最近使用顺序列出缓存条目
+ * @param entries 输出条目数组
+ * @param max 数组容量
+ * @return 实际输出的条目数
+ */
+size_t hid_bond_cache_list(hid_bond_entry_t *entries, size_t max);
+
+/**
+ * @brief 记录一次成功连接（更新或新增条目，缓存满时替换最久未用的条目）
+ * @param entry 条目信息（last_used和desc_hash由缓存填写）
+ * @param desc 报告描述符，可为NULL
+ * @param desc_len 描述符长度
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t hid_bond_cache_store(const hid_bond_entry_t *entry, const uint8_t *desc, uint16_t desc_len);
+
+/**
+ * @brief 读取缓存的报告描述符
+ * @param bda 设备蓝牙地址
+ * @param desc 输出缓冲
+ * @param len 输入缓冲大小，输出描述符长度
+ * @return ESP_OK 成功，ESP_ERR_NOT_FOUND 未缓存，其他值表示错误
+ */
+esp_err_t hid_bond_cache_get_descriptor(const esp_bd_addr_t bda, uint8_t *desc, uint16_t *len);
+
+/**
+ * @brief 删除一个缓存条目
+ * @param bda 设备蓝牙地址
+ * @return ESP_OK 成功，ESP_ERR_NOT_FOUND 不在缓存中
+ */
+esp_err_t hid_bond_cache_remove(const esp_bd_addr_t bda);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HID_BOND_CACHE_H
@@ -0,0 +1,116 @@
+/**
+ * @file hid_discovery.h
+ * @brief 查询结果筛选与候选排序头文件
+ *
+ * 每条查询结果按设备类别码、信号强度、名称和EIR厂商数据判断：
+ * 不是游戏手柄/摇杆的设备直接丢弃，其余放入按地址去重的候选表。
+ * 见到首选型号的手柄时立即结束查询；否则第一个候选出现后再等待一小段时间，
+ * 查询结束时连接排名最高的候选（首选型号 > 手柄/摇杆类 > 未分类外设，同级按RSSI）。
+ */
+
+#ifndef HID_DISCOVERY_H
+#define HID_DISCOVERY_H
+
+#include "esp_err.h"
+#include "hid_transport.h"
+#include "hid_report_parser.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 候选表容量
+ */
+#define HID_DISCOVERY_MAX_CANDIDATES 8
+
+/**
+ * @brief 候选名称最大长度（含结束符）
+ */
+#define HID_DISCOVERY_NAME_LEN       32
+
+/**
+ * @brief 查询结果中没有厂商数据时的公司ID
+ */
+#define HID_DISCOVERY_COMPANY_UNKNOWN 0xFFFF
+
+/**
+ * @brief 候选设备
+ */
+typedef struct {
+    esp_bd_addr_t bda;           ///< 设备地址
+    uint32_t cod;                ///< 设备类别码
+    int8_t rssi;                 ///< 最近一次RSSI (dBm)，INT8_MIN表示未知
+    uint16_t company_id;         ///< EIR厂商数据中的蓝牙公司ID
+    hid_controller_type_t type;  ///< 按名称或公司ID识别的型号
+    bool preferred;              ///< 是否为首选型号
+    uint8_t seen;                ///< 收到的查询结果次数
+    char name[HID_DISCOVERY_NAME_LEN]; ///< 设备名称，未知时为空串
+} hid_discovery_candidate_t;
+
+/**
+ * @brief 单条查询结果的判断
+ */
+typedef enum {
+    HID_DISCOVERY_REJECTED = 0,  ///< 不是手柄或信号太弱
+    HID_DISCOVERY_CANDIDATE,     ///< 放入候选表
+    HID_DISCOVERY_PREFERRED      ///< 首选手柄，应立即结束查询并连接
+} hid_discovery_verdict_t;
+
+/**
+ * @brief 初始化（创建候选等待定时器）
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t hid_discovery_init(void);
+
+/**
+ * @brief 释放资源
+ */
+void hid_discovery_deinit(void);
+
+/**
+ * @brief 开始新一次查询，清空候选表
+ */
+void hid_discovery_begin(void);
+
+/**
+ * @brief 判断一条查询结果，同一地址的结果合并到已有候选
+ * @param result 查询结果
+ * @return 判断结果
+ */
+hid_discovery_verdict_t hid_discovery_add(const hid_transport_disc_result_t *result);
+
+/**
+ * @brief 查询已结束，停止候选等待定时器
+ */
+void hid_discovery_end(void);
+
+/**
+ * @brief 取出排名最高的候选（从表中移除）
+ * @param bda 输出的设备地址
+ * @return true 有候选，false 候选表为空
+ */
+bool hid_discovery_take_best(uint8_t *bda);
+
+/**
+ * @brief 设置首选型号
+ * @param type_mask 第n位为1表示hid_controller_type_t中的型号n为首选
+ */
+void hid_discovery_set_preferred(uint32_t type_mask);
+
+/**
+ * @brief 获取当前候选表（按排名从高到低）
+ * @param out 输出数组
+ * @param max 数组容量
+ * @return 写入的候选数
+ */
+size_t hid_discovery_get_candidates(hid_discovery_candidate_t *out, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HID_DISCOVERY_H
@@ -0,0 +1,127 @@
+/**
+ * @file hid_link_stats.h
+ * @brief 手柄链路质量与报告节奏统计头文件
+ *
+ * 按槽位统计：周期采样的RSSI、报告到达间隔直方图、超过N个正常间隔的断档、
+ * 估计的报告速率、BLE协商的连接间隔，以及全局的连接/断开次数。用于区分控制卡顿来自无线链路还是固件。
+ * 协议栈没有提供链路层重传和冲刷计数，这两项不统计。
+ */
+
+#ifndef HID_LINK_STATS_H
+#define HID_LINK_STATS_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 统计的槽位数（与BLUETOOTH_HID_MAX_DEVICES相同）
+ */
+#define HID_LINK_STATS_MAX_DEVICES   4
+
+/**
+ * @brief 到达间隔直方图桶数：桶0为<1ms，桶i为[2^(i-1), 2^i)ms，最后一桶包含更长的间隔
+ */
+#define HID_LINK_INTERVAL_BUCKETS    12
+
+/**
+ * @brief 单个链路的统计
+ */
+typedef struct {
+    bool connected;              ///< 槽位是否已连接
+    bool rssi_valid;             ///< 是否已采到RSSI
+    int8_t rssi;                 ///< 最近一次RSSI（经典蓝牙为相对黄金接收功率范围的偏差，其他后端为dBm）
+    int8_t rssi_min;             ///< 连接以来的最小RSSI
+    uint32_t rssi_samples;       ///< RSSI采样次数
+    uint32_t reports;            ///< 收到的输入报告数
+    uint32_t interval_hist[HID_LINK_INTERVAL_BUCKETS]; ///< 报告到达间隔直方图
+    uint32_t avg_interval_us;    ///< 正常到达间隔的滑动平均（不含断档）
+    float report_rate_hz;        ///< 估计的报告速率
+    uint32_t gaps;               ///< 超过N个正常间隔的断档次数
+    uint32_t max_gap_us;         ///< 最长到达间隔
+    int64_t last_report_us;      ///< 最近一个报告的到达时间
+    uint32_t conn_interval_us;   ///< BLE协商的连接间隔，经典蓝牙为0
+    uint16_t conn_latency;       ///< BLE从机延迟
+} hid_link_stats_t;
+
+/**
+ * @brief 全局连接计数
+ */
+typedef struct {
+    uint32_t connects;           ///< 成功连接次数
+    uint32_t connect_failures;   ///< 连接失败次数
+    uint32_t disconnects;        ///< 断开次数
+    uint32_t avg_connect_ms;     ///< 平均连接耗时（开始寻呼到HID通道打开）
+} hid_link_counters_t;
+
+/**
+ * @brief 槽位连接成功，清零该槽位的链路统计
+ * @param slot 设备槽位
+ * @param connect_ms 连接耗时
+ */
+void hid_link_stats_on_connect(uint8_t slot, uint32_t connect_ms);
+
+/**
+ * @brief 连接失败
+ */
+void hid_link_stats_on_connect_failed(void);
+
+/**
+ * @brief 槽位断开
+ * @param slot 设备槽位
+ */
+void hid_link_stats_on_disconnect(uint8_t slot);
+
+/**
+ * @brief 记录一个输入报告的到达时间（输入路径调用，开销为一次短临界区）
+ * @param slot 设备槽位
+ * @param timestamp_us 到达时间 (esp_timer微秒)
+ */
+void hid_link_stats_record_report(uint8_t slot, int64_t timestamp_us);
+
+/**
+ * @brief 记录一次RSSI采样
+ * @param slot 设备槽位
+ * @param rssi RSSI
+ */
+void hid_link_stats_record_rssi(uint8_t slot, int8_t rssi);
+
+/**
+ * @brief 记录BLE协商的连接参数
+ * @param slot 设备槽位
+ * @param interval_us 连接间隔
+ * @param latency 从机延迟
+ */
+void hid_link_stats_record_conn_params(uint8_t slot, uint32_t interval_us, uint16_t latency);
+
+/**
+ * @brief 设置断档阈值
+ * @param intervals 到达间隔超过平均间隔的多少倍计为断档（至少为2）
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数错误
+ */
+esp_err_t hid_link_stats_set_gap_threshold(uint8_t intervals);
+
+/**
+ * @brief 获取槽位的链路统计
+ * @param slot 设备槽位
+ * @param stats 输出的统计
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数错误
+ */
+esp_err_t hid_link_stats_get(uint8_t slot, hid_link_stats_t *stats);
+
+/**
+ * @brief 获取全局连接计数
+ * @param counters 输出的计数
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数错误
+ */
+esp_err_t hid_link_stats_get_counters(hid_link_counters_t *counters);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HID_LINK_STATS_H
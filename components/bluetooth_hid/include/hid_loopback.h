@@ -0,0 +1,94 @@
+/**
+ * @file hid_loopback.h
+ * @brief 回环HID传输后端头文件
+ *
+ * 在本机模拟若干个已连接的手柄，按配置的速率（可达数kHz）合成输入报告，
+ * 并可注入抖动和丢包。报告内容来自脚本帧序列，没有脚本时使用内置的
+ * 摇杆和扳机扫动（通用8字节布局，按键保持松开）。录制的轨迹可通过hid_loopback_inject送入。
+ * 生成任务以系统节拍为精度，节拍内到期的报告连续发出，平均速率不受节拍限制。
+ */
+
+#ifndef HID_LOOPBACK_H
+#define HID_LOOPBACK_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 模拟手柄个数上限
+ */
+#define HID_LOOPBACK_MAX_DEVICES     4
+
+/**
+ * @brief 脚本帧最大长度
+ */
+#define HID_LOOPBACK_MAX_FRAME_LEN   64
+
+/**
+ * @brief 脚本帧
+ */
+typedef struct {
+    uint8_t report_id;           ///< 报告ID
+    uint8_t len;                 ///< 数据长度
+    uint8_t data[HID_LOOPBACK_MAX_FRAME_LEN]; ///< 报告数据
+} hid_loopback_frame_t;
+
+/**
+ * @brief 回环后端配置
+ */
+typedef struct {
+    uint8_t device_count;        ///< 初始化后自动连接的模拟手柄数
+    uint32_t rate_hz;            ///< 每个手柄的报告速率，0表示不自动生成
+    uint32_t jitter_us;          ///< 每个报告时刻的随机抖动幅度（±）
+    uint16_t drop_per_mille;     ///< 丢包率（千分比）
+    uint32_t seed;               ///< 随机数种子，相同种子得到相同的抖动和丢包序列
+    const hid_loopback_frame_t *script; ///< 脚本帧序列（循环播放），NULL使用内置扫动
+    size_t script_len;           ///< 脚本帧数
+} hid_loopback_config_t;
+
+/**
+ * @brief 回环后端统计
+ */
+typedef struct {
+    uint32_t generated;          ///< 到期的报告数
+    uint32_t dropped;            ///< 按丢包率丢弃的报告数
+    uint32_t delivered;          ///< 送达的报告数（含注入）
+    uint32_t output_reports;     ///< 收到的输出报告数
+    uint32_t late_max_us;        ///< 报告发出时刻相对计划时刻的最大滞后
+} hid_loopback_stats_t;
+
+/**
+ * @brief 设置回环后端配置
+ * @note 在bluetooth_hid_init之前调用；未调用时使用Kconfig中的默认值
+ * @param config 配置，script指向的数据须一直有效
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数错误
+ */
+esp_err_t hid_loopback_configure(const hid_loopback_config_t *config);
+
+/**
+ * @brief 向模拟手柄注入一个输入报告（在调用者任务中同步送达）
+ * @param device 模拟手柄序号 (0 to device_count-1)
+ * @param report_id 报告ID
+ * @param data 报告数据
+ * @param len 数据长度
+ * @return ESP_OK 成功，ESP_ERR_INVALID_STATE 该手柄未连接
+ */
+esp_err_t hid_loopback_inject(uint8_t device, uint8_t report_id, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief 获取回环后端统计
+ * @param stats 输出的统计
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t hid_loopback_get_stats(hid_loopback_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HID_LOOPBACK_H
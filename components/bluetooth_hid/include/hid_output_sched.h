@@ -0,0 +1,96 @@
+/**
+ * @file hid_output_sched.h
+ * @brief 输出报告调度器头文件
+ *
+ * 每个设备的每个报告ID只保留一个待发报告：新报告覆盖尚未发出的旧报告（最新的生效），
+ * 与上次已发出内容完全相同的报告直接丢弃。发送由调度任务按每个设备的预算节奏进行，
+ * 即每个发送窗口（对应连接间隔）内最多发出budget个报告，避免输出报告挤占输入报告的链路带宽。
+ * 发送失败的报告在没有被更新的报告取代时重新挂起，按预算重试。
+ */
+
+#ifndef HID_OUTPUT_SCHED_H
+#define HID_OUTPUT_SCHED_H
+
+#include "esp_err.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 每个设备可同时挂起的不同报告ID个数
+ */
+#define HID_OUTPUT_MAX_REPORT_IDS    4
+
+/**
+ * @brief 单个输出报告最大长度（DS4输出报告0x11为78字节）
+ */
+#define HID_OUTPUT_MAX_LEN           80
+
+/**
+ * @brief 发送函数，在调度任务中调用
+ */
+typedef esp_err_t (*hid_output_send_fn_t)(uint8_t slot, uint8_t report_id, uint8_t *data, uint16_t len);
+
+/**
+ * @brief 调度统计
+ */
+typedef struct {
+    uint32_t submitted;          ///< 提交的报告数
+    uint32_t coalesced;          ///< 被后来的报告覆盖而未发出的报告数
+    uint32_t suppressed;         ///< 与上次发出内容相同而丢弃的报告数
+    uint32_t sent;               ///< 发出的报告数
+    uint32_t failed;             ///< 传输后端返回错误的报告数
+} hid_output_stats_t;
+
+/**
+ * @brief 初始化调度器并启动调度任务
+ * @param send 发送函数
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t hid_output_sched_init(hid_output_send_fn_t send);
+
+/**
+ * @brief 停止调度任务，丢弃所有待发报告
+ * @return ESP_OK 成功
+ */
+esp_err_t hid_output_sched_deinit(void);
+
+/**
+ * @brief 提交一个输出报告（拷贝数据后立即返回）
+ * @param slot 设备槽位
+ * @param report_id 报告ID
+ * @param data 报告数据
+ * @param len 数据长度
+ * @return ESP_OK 已挂起、已合并或已去重，ESP_ERR_INVALID_SIZE 报告过长，
+ *         ESP_ERR_NO_MEM 该设备挂起的报告ID已满
+ */
+esp_err_t hid_output_sched_submit(uint8_t slot, uint8_t report_id, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief 清除槽位的待发报告和去重记录（设备连接或断开时调用）
+ * @param slot 设备槽位
+ */
+void hid_output_sched_reset_slot(uint8_t slot);
+
+/**
+ * @brief 设置发送预算
+ * @param reports_per_window 每个窗口最多发出的报告数（每设备）
+ * @param window_us 窗口长度（微秒）
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 报告数为0或窗口短于报告数微秒
+ */
+esp_err_t hid_output_sched_set_budget(uint8_t reports_per_window, uint32_t window_us);
+
+/**
+ * @brief 获取调度统计（所有设备合计）
+ * @param stats 输出的统计
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t hid_output_sched_get_stats(hid_output_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HID_OUTPUT_SCHED_H
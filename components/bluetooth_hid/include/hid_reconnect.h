@@ -0,0 +1,132 @@
+/**
+ * @file hid_reconnect.h
+ * @brief 手柄自动重连状态机头文件
+ *
+ * 手柄意外断开后按以下顺序尝试找回，每一轮依次经过：
+ * 1. 寻呼：用较短的寻呼超时直接寻呼刚断开的设备（上电时为绑定缓存中的设备）；
+ * 2. 页扫描：只开启可连接，等待手柄自己回连；
+ * 3. 查询：做一次查询扫描。
+ * 一轮失败后按指数退避等待再开始下一轮，达到最大尝试次数后停止主动寻找
+ * （仍保持可连接，手柄自己回连时照常接受）。从断开到重新连上的时间会被记录。
+ */
+
+#ifndef HID_RECONNECT_H
+#define HID_RECONNECT_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 同时跟踪的待重连设备数
+ */
+#define HID_RECONNECT_MAX_TARGETS    4
+
+/**
+ * @brief 重连配置
+ */
+typedef struct {
+    uint32_t page_timeout_ms;    ///< 单次寻呼超时
+    uint32_t page_scan_ms;       ///< 等待手柄主动回连的时长，0表示跳过
+    uint32_t inquiry_sec;        ///< 每轮查询扫描时长（秒）
+    uint32_t backoff_initial_ms; ///< 第一次失败后的等待时间，之后每轮加倍
+    uint32_t backoff_max_ms;     ///< 等待时间上限
+    uint8_t max_attempts;        ///< 最大尝试轮数，0表示不限
+} hid_reconnect_config_t;
+
+/**
+ * @brief 重连状态
+ */
+typedef enum {
+    HID_RECONNECT_IDLE = 0,      ///< 没有待重连的设备
+    HID_RECONNECT_PAGING,        ///< 寻呼待重连的设备
+    HID_RECONNECT_PAGE_SCAN,     ///< 等待手柄主动回连
+    HID_RECONNECT_INQUIRY,       ///< 查询扫描
+    HID_RECONNECT_BACKOFF,       ///< 等待下一轮
+    HID_RECONNECT_GAVE_UP        ///< 已达最大尝试次数
+} hid_reconnect_state_t;
+
+/**
+ * @brief 重连统计
+ */
+typedef struct {
+    hid_reconnect_state_t state; ///< 当前状态
+    uint8_t attempt;             ///< 当前已失败的轮数
+    uint32_t reconnects;         ///< 意外断开后成功重连的次数
+    uint32_t last_reconnect_ms;  ///< 最近一次从断开到重连的时间
+    uint32_t max_reconnect_ms;   ///< 最长的重连时间
+    uint32_t avg_reconnect_ms;   ///< 平均重连时间
+    uint32_t give_ups;           ///< 达到最大尝试次数的次数
+} hid_reconnect_stats_t;
+
+/**
+ * @brief 初始化重连状态机（bluetooth_hid_init中调用）
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t hid_reconnect_init(void);
+
+/**
+ * @brief 停止重连并释放资源（bluetooth_hid_deinit中调用）
+ */
+void hid_reconnect_deinit(void);
+
+/**
+ * @brief 设置重连配置
+ * @param config 配置
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数错误
+ */
+esp_err_t hid_reconnect_set_config(const hid_reconnect_config_t *config);
+
+/**
+ * @brief 获取当前配置
+ * @param config 输出的配置
+ */
+void hid_reconnect_get_config(hid_reconnect_config_t *config);
+
+/**
+ * @brief 开始连接：先寻呼绑定缓存中的设备，任一设备连上即结束，否则按轮次重试
+ * @return ESP_OK 已开始或已在进行，其他值表示错误
+ */
+esp_err_t hid_reconnect_start(void);
+
+/**
+ * @brief 停止主动寻找，清除待重连设备
+ */
+void hid_reconnect_stop(void);
+
+/**
+ * @brief 获取重连统计
+ * @param stats 输出的统计
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数错误
+ */
+esp_err_t hid_reconnect_get_stats(hid_reconnect_stats_t *stats);
+
+/**
+ * @brief 连接结果（由bluetooth_hid调用）
+ * @param bda 设备地址，可为NULL
+ * @param success 是否连接成功
+ */
+void hid_reconnect_on_open(const uint8_t *bda, bool success);
+
+/**
+ * @brief 连接断开（由bluetooth_hid调用）
+ * @param bda 设备地址
+ * @param unexpected 是否为意外断开（主动断开不重连）
+ */
+void hid_reconnect_on_close(const uint8_t *bda, bool unexpected);
+
+/**
+ * @brief 查询扫描结束（由bluetooth_hid调用）
+ * @param connecting 扫描中选中了设备并已开始连接
+ */
+void hid_reconnect_on_scan_stopped(bool connecting);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HID_RECONNECT_H
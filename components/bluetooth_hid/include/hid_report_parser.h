@@ -0,0 +1,206 @@
+/**
+ * @file hid_report_parser.h
+ * @brief HID报告描述符解析与字段提取头文件
+ *
+ * 连接时解析一次报告描述符，把按键、摇杆、方向键和扳机编译成紧凑的提取表
+ * （位偏移、位宽、逻辑范围、缩放系数）；之后每个输入报告只需遍历提取表，
+ * 热路径上不再区分手柄型号。
+ */
+
+#ifndef HID_REPORT_PARSER_H
+#define HID_REPORT_PARSER_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 提取表最大字段数
+ */
+#define HID_REPORT_MAP_MAX_FIELDS    32
+
+/**
+ * @brief 按键映射表中表示"忽略该按键"的取值
+ */
+#define HID_BUTTON_UNMAPPED          0xFF
+
+/**
+ * @brief 手柄型号枚举（与配置文件supported_controllers对应）
+ */
+typedef enum {
+    HID_CONTROLLER_GENERIC = 0,  ///< 通用手柄（兼容旧的8字节固定布局）
+    HID_CONTROLLER_PS4,          ///< PS4 DualShock 4
+    HID_CONTROLLER_XBOX,         ///< Xbox One S / Series
+    HID_CONTROLLER_BEITONG,      ///< 北通手柄
+    HID_CONTROLLER_TYPE_MAX
+} hid_controller_type_t;
+
+/**
+ * @brief 逻辑按键编号（提取结果中按键位图的位号）
+ */
+typedef enum {
+    HID_GAMEPAD_BUTTON_A = 0,
+    HID_GAMEPAD_BUTTON_B,
+    HID_GAMEPAD_BUTTON_X,
+    HID_GAMEPAD_BUTTON_Y,
+    HID_GAMEPAD_BUTTON_L1,
+    HID_GAMEPAD_BUTTON_R1,
+    HID_GAMEPAD_BUTTON_L2,
+    HID_GAMEPAD_BUTTON_R2,
+    HID_GAMEPAD_BUTTON_SELECT,
+    HID_GAMEPAD_BUTTON_START,
+    HID_GAMEPAD_BUTTON_HOME,
+    HID_GAMEPAD_BUTTON_DPAD_UP,
+    HID_GAMEPAD_BUTTON_DPAD_DOWN,
+    HID_GAMEPAD_BUTTON_DPAD_LEFT,
+    HID_GAMEPAD_BUTTON_DPAD_RIGHT,
+    HID_GAMEPAD_BUTTON_MAX
+} hid_gamepad_button_t;
+
+/**
+ * @brief 摇杆轴编号
+ */
+typedef enum {
+    HID_GAMEPAD_AXIS_LX = 0,
+    HID_GAMEPAD_AXIS_LY,
+    HID_GAMEPAD_AXIS_RX,
+    HID_GAMEPAD_AXIS_RY,
+    HID_GAMEPAD_AXIS_MAX
+} hid_gamepad_axis_t;
+
+/**
+ * @brief 扳机编号
+ */
+typedef enum {
+    HID_GAMEPAD_TRIGGER_LEFT = 0,
+    HID_GAMEPAD_TRIGGER_RIGHT,
+    HID_GAMEPAD_TRIGGER_MAX
+} hid_gamepad_trigger_t;
+
+/**
+ * @brief 提取字段类型
+ */
+typedef enum {
+    HID_FIELD_BUTTON = 0,        ///< 单个按键位
+    HID_FIELD_AXIS,              ///< 摇杆轴，输出-32768到32767
+    HID_FIELD_TRIGGER,           ///< 扳机，输出0到255
+    HID_FIELD_HAT                ///< 方向键帽，转换为四个方向按键位
+} hid_field_kind_t;
+
+/**
+ * @brief 单个字段提取器
+ */
+typedef struct {
+    uint16_t bit_offset;         ///< 字段在报告中的位偏移（不含报告ID字节）
+    uint8_t bit_size;            ///< 字段位宽 (1-24)
+    uint8_t kind;                ///< 字段类型 (hid_field_kind_t)
+    uint8_t target;              ///< 目标：按键位号/轴编号/扳机编号
+    uint8_t pre_shift;           ///< 逻辑范围超过16位时的预右移位数
+    bool is_signed;              ///< 逻辑最小值为负，需要符号扩展
+    int32_t logical_min;         ///< 逻辑最小值
+    int32_t logical_max;         ///< 逻辑最大值
+    uint32_t scale;              ///< 归一化系数：(value - min) * scale 映射到0..0xFFFF0000
+} hid_field_extractor_t;
+
+/**
+ * @brief 编译后的报告提取表
+ */
+typedef struct {
+    uint8_t report_id;           ///< 手柄数据所在报告ID，0表示描述符未使用报告ID
+    uint8_t ext_report_id;       ///< 扩展报告ID：与report_id布局相同，数据前多ext_header_bytes字节，0表示没有
+    uint8_t ext_header_bytes;    ///< 扩展报告在完整布局之前的字节数
+    uint8_t field_count;         ///< 有效字段数
+    uint16_t report_bytes;       ///< 报告最小长度(字节)，短报告直接丢弃
+    hid_field_extractor_t fields[HID_REPORT_MAP_MAX_FIELDS];
+} hid_report_map_t;
+
+/**
+ * @brief 提取出的手柄输入
+ */
+typedef struct {
+    uint32_t buttons;                            ///< 按键位图，位号见hid_gamepad_button_t
+    int16_t axes[HID_GAMEPAD_AXIS_MAX];          ///< 摇杆 (-32768 to 32767)
+    uint8_t triggers[HID_GAMEPAD_TRIGGER_MAX];   ///< 扳机 (0 to 255)
+} hid_gamepad_report_t;
+
+/**
+ * @brief 解析报告描述符并编译提取表
+ * @param desc 报告描述符
+ * @param desc_len 描述符长度
+ * @param button_map HID按键编号(从1开始)到逻辑按键位号的映射，NULL表示按顺序映射
+ * @param button_map_len 映射表长度
+ * @param map 输出的提取表
+ * @return ESP_OK 成功，ESP_ERR_NOT_FOUND 描述符中没有手柄字段，其他值表示错误
+ */
+esp_err_t hid_report_map_compile(const uint8_t *desc, size_t desc_len,
+                                 const uint8_t *button_map, size_t button_map_len,
+                                 hid_report_map_t *map);
+
+/**
+ * @brief 使用内置描述符编译提取表
+ * @param type 手柄型号
+ * @param map 输出的提取表
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t hid_report_map_compile_builtin(hid_controller_type_t type, hid_report_map_t *map);
+
+/**
+ * @brief 按手柄型号为提取表加上扩展报告
+ *
+ * PS4蓝牙收到输出报告0x11（如震动）后，输入改为报告0x11：同样的完整布局前多2字节。
+ * 只在提取表的报告ID是该型号基础报告的ID时生效；hid_report_map_compile_builtin已调用过。
+ *
+ * @param type 手柄型号
+ * @param map 已编译的提取表
+ */
+void hid_report_map_apply_profile(hid_controller_type_t type, hid_report_map_t *map);
+
+/**
+ * @brief 按提取表解析一个输入报告（热路径）
+ * @param map 提取表
+ * @param report_id 报告ID，report_id或ext_report_id
+ * @param data 报告数据（不含报告ID字节）
+ * @param len 数据长度
+ * @param out 输出的手柄输入
+ * @return ESP_OK 成功，ESP_ERR_NOT_FOUND 报告ID不匹配，ESP_ERR_INVALID_SIZE 报告过短
+ */
+esp_err_t hid_report_map_extract(const hid_report_map_t *map, uint8_t report_id,
+                                 const uint8_t *data, uint16_t len,
+                                 hid_gamepad_report_t *out);
+
+/**
+ * @brief 获取内置的参考报告描述符
+ * @param type 手柄型号
+ * @param desc 输出描述符指针
+ * @param len 输出描述符长度
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t hid_report_parser_get_builtin(hid_controller_type_t type, const uint8_t **desc, size_t *len);
+
+/**
+ * @brief 获取手柄型号的按键映射表
+ * @param type 手柄型号
+ * @param len 输出映射表长度
+ * @return 映射表指针，NULL表示按顺序映射
+ */
+const uint8_t *hid_report_parser_get_button_map(hid_controller_type_t type, size_t *len);
+
+/**
+ * @brief 根据VID/PID和设备名识别手柄型号
+ * @param vendor_id 厂商ID（未知时为0）
+ * @param product_id 产品ID（未知时为0）
+ * @param name 设备名（可为NULL）
+ * @return 识别出的手柄型号，无法识别时返回HID_CONTROLLER_GENERIC
+ */
+hid_controller_type_t hid_report_parser_detect_type(uint16_t vendor_id, uint16_t product_id, const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HID_REPORT_PARSER_H
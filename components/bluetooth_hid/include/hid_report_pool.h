@@ -0,0 +1,146 @@
+/**
+ * @file hid_report_pool.h
+ * @brief 输入报告缓冲池与无锁报告队列头文件
+ *
+ * 传输后端收到报告后从固定大小的缓冲池中取一个缓冲，只拷贝一次；
+ * 之后缓冲以引用计数的方式经无锁队列交给任意多个消费者（解析、录制、遥测），
+ * 每个消费者用完后释放自己的引用，最后一个引用释放时缓冲回到池中。
+ * 热路径上没有堆分配，也没有按消费者的拷贝。
+ */
+
+#ifndef HID_REPORT_POOL_H
+#define HID_REPORT_POOL_H
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 缓冲池容量
+ */
+#define HID_REPORT_POOL_SIZE         32
+
+/**
+ * @brief 单个报告最大长度（DS4扩展报告0x11为77字节）
+ */
+#define HID_REPORT_MAX_LEN           80
+
+/**
+ * @brief 报告队列最大深度（须为2的幂）
+ */
+#define HID_REPORT_QUEUE_MAX_DEPTH   32
+
+/**
+ * @brief 报告标志：来自回放而非真实设备
+ */
+#define HID_REPORT_FLAG_REPLAY       0x01
+
+/**
+ * @brief 池中的报告缓冲
+ * @note refs由池管理，使用者只能通过retain/release修改
+ */
+typedef struct {
+    _Atomic uint32_t refs;       ///< 引用计数
+    uint32_t seq;                ///< 报告序号（分配时写入，从不为0）
+    int64_t timestamp_us;        ///< 报告到达时间 (esp_timer微秒，分配时写入)
+    uint8_t slot;                ///< 设备槽位
+    uint8_t report_id;           ///< 报告ID，0表示描述符未使用报告ID
+    uint8_t map_index;           ///< 报告映射索引
+    uint8_t flags;               ///< HID_REPORT_FLAG_*
+    uint16_t len;                ///< 数据长度
+    uint8_t data[HID_REPORT_MAX_LEN]; ///< 报告数据（不含报告ID字节）
+} hid_report_buf_t;
+
+/**
+ * @brief 多生产者多消费者无锁报告队列（有界，满时丢弃新报告）
+ */
+typedef struct {
+    struct {
+        _Atomic uint32_t seq;
+        hid_report_buf_t *buf;
+    } cells[HID_REPORT_QUEUE_MAX_DEPTH];
+    _Atomic uint32_t enqueue_pos;
+    _Atomic uint32_t dequeue_pos;
+    uint32_t mask;
+    _Atomic uint32_t dropped;    ///< 队列满丢弃的报告数
+    TaskHandle_t notify_task;    ///< 入队后通知的任务，可为NULL
+} hid_report_queue_t;
+
+/**
+ * @brief 缓冲池统计
+ */
+typedef struct {
+    uint32_t capacity;           ///< 缓冲总数
+    uint32_t in_use;             ///< 当前占用数
+    uint32_t high_water;         ///< 占用数峰值
+    uint32_t exhausted;          ///< 池空导致丢弃的报告数
+} hid_report_pool_stats_t;
+
+/**
+ * @brief 初始化缓冲池（只在首次调用时生效）
+ * @return ESP_OK 成功
+ */
+esp_err_t hid_report_pool_init(void);
+
+/**
+ * @brief 分配一个缓冲，写入序号和到达时间，引用计数为1
+ * @note 任意任务中可调用，不阻塞
+ * @return 缓冲，池空时返回NULL并计数
+ */
+hid_report_buf_t *hid_report_pool_alloc(void);
+
+/**
+ * @brief 增加一个引用
+ */
+void hid_report_pool_retain(hid_report_buf_t *buf);
+
+/**
+ * @brief 释放一个引用，最后一个引用释放时缓冲回到池中
+ */
+void hid_report_pool_release(hid_report_buf_t *buf);
+
+/**
+ * @brief 获取缓冲池统计
+ * @param stats 输出的统计
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t hid_report_pool_get_stats(hid_report_pool_stats_t *stats);
+
+/**
+ * @brief 初始化报告队列
+ * @param queue 队列
+ * @param depth 深度，2的幂且不超过HID_REPORT_QUEUE_MAX_DEPTH
+ * @param notify_task 入队后通知的任务，可为NULL
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 深度无效
+ */
+esp_err_t hid_report_queue_init(hid_report_queue_t *queue, uint32_t depth, TaskHandle_t notify_task);
+
+/**
+ * @brief 设置入队后通知的任务
+ */
+void hid_report_queue_set_notify(hid_report_queue_t *queue, TaskHandle_t notify_task);
+
+/**
+ * @brief 入队：成功时队列持有一个新引用，调用者的引用不变
+ * @return true 成功，false 队列已满（计入dropped）
+ */
+bool hid_report_queue_push(hid_report_queue_t *queue, hid_report_buf_t *buf);
+
+/**
+ * @brief 出队：调用者获得队列持有的引用，用完后须release
+ * @return 缓冲，队列为空时返回NULL
+ */
+hid_report_buf_t *hid_report_queue_pop(hid_report_queue_t *queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HID_REPORT_POOL_H
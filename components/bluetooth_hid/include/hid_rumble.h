@@ -0,0 +1,62 @@
+/**
+ * @file hid_rumble.h
+ * @brief 手柄震动报告编码头文件
+ *
+ * 各型号手柄的震动输出报告布局不同：PS4蓝牙为带CRC32的78字节报告0x11，Xbox为报告0x03，
+ * 北通和未识别的手柄沿用通用的报告0x01。设备连接时按型号和VID/PID在编码表中选定编码器，
+ * 并在该槽位预分配的缓冲中写好报告的固定部分；之后每次更新强度只改写马达字节（及校验和）
+ * 后交给输出调度器，不做型号判断、不分配内存，也不拷贝设备信息。
+ */
+
+#ifndef HID_RUMBLE_H
+#define HID_RUMBLE_H
+
+#include "esp_err.h"
+#include "hid_report_parser.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 槽位数（与BLUETOOTH_HID_MAX_DEVICES相同）
+ */
+#define HID_RUMBLE_MAX_DEVICES       4
+
+/**
+ * @brief hid_rumble_send的槽位参数：发给槽位号最小的已连接手柄
+ */
+#define HID_RUMBLE_SLOT_PRIMARY      0xFF
+
+/**
+ * @brief 设备连接时选定并绑定震动编码器
+ * @param slot 设备槽位
+ * @param type 手柄型号
+ * @param vendor_id 厂商ID（未知时为0）
+ * @param product_id 产品ID（未知时为0）
+ */
+void hid_rumble_bind(uint8_t slot, hid_controller_type_t type, uint16_t vendor_id, uint16_t product_id);
+
+/**
+ * @brief 设备断开时解除绑定
+ * @param slot 设备槽位
+ */
+void hid_rumble_unbind(uint8_t slot);
+
+/**
+ * @brief 编码并提交震动报告
+ * @note 编码直接写入槽位的缓冲，同一槽位的调用须串行（由震动模块的互斥锁保证）
+ * @param slot 设备槽位，HID_RUMBLE_SLOT_PRIMARY表示槽位号最小的已连接手柄
+ * @param left 左（低频大）马达强度 (0-255)
+ * @param right 右（高频小）马达强度 (0-255)
+ * @return ESP_OK 已交给输出调度器，ESP_ERR_INVALID_STATE 没有已连接的手柄，
+ *         ESP_ERR_NOT_SUPPORTED 该手柄不支持震动，其他值同hid_output_sched_submit
+ */
+esp_err_t hid_rumble_send(uint8_t slot, uint8_t left, uint8_t right);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HID_RUMBLE_H
@@ -0,0 +1,162 @@
+/**
+ * @file hid_transport.h
+ * @brief HID传输后端接口头文件
+ *
+ * bluetooth_hid_*接口负责槽位、绑定缓存和回调分发，具体的链路由传输后端实现：
+ * 蓝牙后端基于esp_hidh（经典蓝牙HID，启用BLE时同时支持HID over GATT），回环后端在本机合成输入报告，用于没有手柄
+ * （或在Linux目标上）时运行完整的解析、映射和执行链路。
+ */
+
+#ifndef HID_TRANSPORT_H
+#define HID_TRANSPORT_H
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#if CONFIG_BT_ENABLED
+#include "esp_bt_defs.h"
+#else
+// 没有蓝牙协议栈时（如Linux目标上的回环后端）自行定义地址类型
+#define ESP_BD_ADDR_LEN 6
+typedef uint8_t esp_bd_addr_t[ESP_BD_ADDR_LEN];
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 连接建立时后端提供的设备信息
+ */
+typedef struct {
+    const char *name;            ///< 设备名称，可为NULL
+    uint16_t vendor_id;          ///< 厂商ID（未知时为0）
+    uint16_t product_id;         ///< 产品ID（未知时为0）
+    uint16_t version;            ///< 设备固件版本（DID/PnP记录，未知时为0）
+    const uint8_t *report_desc;  ///< 报告描述符，可为NULL（只在回调期间有效）
+    uint16_t report_desc_len;    ///< 报告描述符长度
+    uint8_t transport;           ///< 传输方式，写入绑定缓存
+} hid_transport_dev_info_t;
+
+/**
+ * @brief 扫描发现的设备属性（只在回调期间有效）
+ */
+typedef struct {
+    const uint8_t *bda;          ///< 设备地址
+    uint32_t cod;                ///< 设备类别码，0表示未知
+    int8_t rssi;                 ///< 信号强度 (dBm)，INT8_MIN表示未知
+    uint16_t company_id;         ///< EIR厂商数据中的蓝牙公司ID，0xFFFF表示未知
+    const char *name;            ///< 设备名称（BDNAME或EIR中的名称），可为NULL
+} hid_transport_disc_result_t;
+
+/**
+ * @brief 后端向bluetooth_hid上报事件的回调
+ * @note 可在后端的任意任务中调用，但同一设备的事件须来自同一任务
+ */
+typedef struct {
+    /**
+     * @brief 连接结果（主动连接的结果或设备主动回连）
+     * @param info 成功时的设备信息，失败时为NULL
+     */
+    void (*on_open)(void *dev_handle, const uint8_t *bda, esp_err_t status,
+                    const hid_transport_dev_info_t *info);
+
+    /**
+     * @brief 连接断开，回调返回后句柄失效
+     */
+    void (*on_close)(void *dev_handle, int reason);
+
+    /**
+     * @brief 输入报告（data只在回调期间有效）
+     */
+    void (*on_input)(void *dev_handle, uint8_t report_id, uint8_t map_index,
+                     uint8_t *data, uint16_t len);
+
+    /**
+     * @brief 扫描发现设备（同一设备可能上报多次，后续结果可能带上名称）
+     * @return true 选中该设备：后端结束扫描并在on_scan_stopped中返回它
+     */
+    bool (*on_discovered)(const hid_transport_disc_result_t *result);
+
+    /**
+     * @brief 扫描已完全停止（此时才能寻呼）
+     * @param selected 扫描中选中的设备地址，没有时为NULL（由上层从候选中挑选）
+     */
+    void (*on_scan_stopped)(const uint8_t *selected);
+
+    /**
+     * @brief read_rssi的结果
+     * @param rssi 经典蓝牙为相对"黄金接收功率范围"的偏差（0表示在范围内），BLE和其他后端为dBm
+     */
+    void (*on_rssi)(const uint8_t *bda, int8_t rssi);
+
+    /**
+     * @brief BLE连接参数已协商（经典蓝牙链路不上报）
+     * @param interval_us 连接间隔
+     * @param latency 从机延迟（连接事件数）
+     */
+    void (*on_conn_params)(const uint8_t *bda, uint32_t interval_us, uint16_t latency);
+
+    /**
+     * @brief 电池服务上报的电量（BLE手柄），可不调用
+     * @param level 电量百分比
+     */
+    void (*on_battery)(void *dev_handle, uint8_t level);
+} hid_transport_callbacks_t;
+
+/**
+ * @brief 传输后端操作表
+ */
+typedef struct {
+    const char *name;            ///< 后端名称（日志用）
+    bool supports_bonding;       ///< 是否使用绑定缓存做快速回连
+
+    esp_err_t (*init)(const hid_transport_callbacks_t *callbacks);
+    esp_err_t (*deinit)(void);
+    esp_err_t (*start_scan)(uint32_t duration_sec);
+    esp_err_t (*stop_scan)(void);
+
+    /**
+     * @brief 发起连接，结果通过on_open返回
+     * @param dev_handle 输出设备句柄（on_open可能在本函数返回前到达）
+     */
+    esp_err_t (*open)(const uint8_t *bda, void **dev_handle);
+    esp_err_t (*close)(void *dev_handle);
+    esp_err_t (*send_output)(void *dev_handle, uint8_t report_id, uint8_t *data, uint16_t len);
+    esp_err_t (*set_discoverable)(bool discoverable, bool connectable);
+
+    /**
+     * @brief 协议栈是否仍保存着该设备的绑定（链路密钥），可为NULL
+     */
+    bool (*is_bonded)(const uint8_t *bda);
+
+    /**
+     * @brief 读取已连接设备的信号强度，结果通过on_rssi返回，可为NULL
+     */
+    esp_err_t (*read_rssi)(void *dev_handle);
+
+    /**
+     * @brief 设置寻呼超时，可为NULL
+     */
+    esp_err_t (*set_page_timeout)(uint32_t timeout_ms);
+} hid_transport_ops_t;
+
+#if CONFIG_BT_ENABLED
+/**
+ * @brief 蓝牙后端（esp_hidh，经典蓝牙与BLE）
+ */
+const hid_transport_ops_t *hid_transport_bt(void);
+#endif
+
+/**
+ * @brief 回环后端（合成输入报告）
+ */
+const hid_transport_ops_t *hid_transport_loopback(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HID_TRANSPORT_H
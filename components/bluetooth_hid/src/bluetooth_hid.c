@@ -1,105 +1,560 @@
 /**
  * @file bluetooth_hid.c
- * @brief 蓝牙HID协议处理实现（简化版本）
+ * @brief 蓝牙HID协议处理实现（槽位、绑定缓存和回调分发，链路由传输后端实现）
  */
 
 #include "bluetooth_hid.h"
+#include "hid_bond_cache.h"
+#include "hid_output_sched.h"
+#include "hid_link_stats.h"
+#include "hid_reconnect.h"
+#include "hid_discovery.h"
+#include "hid_battery.h"
+#include "hid_rumble.h"
 #include "esp_log.h"
-#include "esp_bt_main.h"
-#include "esp_gap_bt_api.h"
-#include "esp_bt_device.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
 #include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
 
 static const char *TAG = "BT_HID";
 
+// 输入报告的协议模式（报告模式）
+#define HID_PROTOCOL_MODE_REPORT 1
+
+// 输入报告订阅队列个数上限
+#define MAX_REPORT_QUEUES        4
+
+#ifndef CONFIG_BLUETOOTH_HID_RSSI_INTERVAL_MS
+#define CONFIG_BLUETOOTH_HID_RSSI_INTERVAL_MS    2000
+#endif
+
+_Static_assert(HID_LINK_STATS_MAX_DEVICES == BLUETOOTH_HID_MAX_DEVICES, "link stats cover every slot");
+
+#if CONFIG_BLUETOOTH_HID_TRANSPORT_LOOPBACK || !CONFIG_BT_ENABLED
+#define DEFAULT_TRANSPORT()      hid_transport_loopback()
+#else
+#define DEFAULT_TRANSPORT()      hid_transport_bt()
+#endif
+
+/**
+ * @brief 设备槽位（对外的设备信息加上连接过程状态）
+ */
+typedef struct {
+    hid_device_info_t info;
+    bool pending;                ///< 正在寻呼，尚未收到打开事件
+    bool closing;                ///< 本地主动断开，断开后不自动重连
+    hid_connect_timing_t timing; ///< 连接耗时统计
+    uint8_t report_desc[HID_BOND_CACHE_MAX_DESC_LEN]; ///< 报告描述符副本，info.report_desc指向这里
+} hid_slot_t;
+
 // 静态变量
-static hid_device_info_t connected_device = {0};
+static hid_slot_t slots[BLUETOOTH_HID_MAX_DEVICES];
+static portMUX_TYPE slots_lock = portMUX_INITIALIZER_UNLOCKED;
+static const hid_transport_ops_t *transport = NULL;
 static hid_event_callback_t event_callback = NULL;
 static hid_input_callback_t input_callback = NULL;
 static bool hid_initialized = false;
 static bool scanning = false;
+static hid_report_queue_t *report_queues[MAX_REPORT_QUEUES];
+static _Atomic uint8_t report_queue_count = 0;
+static esp_timer_handle_t rssi_timer = NULL;
+
+static inline bool slot_in_use(const hid_slot_t *slot)
+{
+    return slot->info.connected || slot->pending;
+}
+
+/**
+ * @brief 根据句柄查找设备槽位（包括正在寻呼的槽位）
+ * @return 槽位号，未找到返回-1
+ */
+static int find_slot_by_handle(void *dev_handle)
+{
+    if (!dev_handle) {
+        return -1;
+    }
+    for (int i = 0; i < BLUETOOTH_HID_MAX_DEVICES; i++) {
+        if (slot_in_use(&slots[i]) && slots[i].info.dev_handle == dev_handle) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief 根据地址查找设备槽位（包括正在寻呼的槽位）
+ * @return 槽位号，未找到返回-1
+ */
+static int find_slot_by_bda(const uint8_t *bda)
+{
+    if (!bda) {
+        return -1;
+    }
+    for (int i = 0; i < BLUETOOTH_HID_MAX_DEVICES; i++) {
+        if (slot_in_use(&slots[i]) && memcmp(slots[i].info.bda, bda, sizeof(esp_bd_addr_t)) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief 占用空闲槽位（优先槽位号小的）
+ * @return 槽位号，已满返回-1
+ */
+static int reserve_slot(const uint8_t *bda)
+{
+    int slot = -1;
+    portENTER_CRITICAL(&slots_lock);
+    for (int i = 0; i < BLUETOOTH_HID_MAX_DEVICES; i++) {
+        if (!slot_in_use(&slots[i])) {
+            memset(&slots[i].info, 0, sizeof(slots[i].info));
+            memset(&slots[i].timing, 0, sizeof(slots[i].timing));
+            memcpy(slots[i].info.bda, bda, sizeof(esp_bd_addr_t));
+            slots[i].info.slot = (uint8_t)i;
+            slots[i].pending = true;
+            slots[i].closing = false;
+            slot = i;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&slots_lock);
+    return slot;
+}
+
+/**
+ * @brief 释放槽位
+ */
+static void release_slot(int slot)
+{
+    portENTER_CRITICAL(&slots_lock);
+    slots[slot].pending = false;
+    slots[slot].info.connected = false;
+    slots[slot].info.dev_handle = NULL;
+    slots[slot].info.report_desc = NULL;
+    slots[slot].info.report_desc_len = 0;
+    portEXIT_CRITICAL(&slots_lock);
+    hid_rumble_unbind((uint8_t)slot);
+    hid_output_sched_reset_slot((uint8_t)slot);
+}
+
+static bool in_bond_cache(const uint8_t *bda)
+{
+    hid_bond_entry_t bonds[HID_BOND_CACHE_MAX_ENTRIES];
+    size_t count = hid_bond_cache_list(bonds, HID_BOND_CACHE_MAX_ENTRIES);
+    for (size_t i = 0; i < count; i++) {
+        if (memcmp(bonds[i].bda, bda, sizeof(esp_bd_addr_t)) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 
 /**
- * @brief GAP事件回调函数
+ * @brief 连接建立后填写设备信息并刷新绑定缓存
  */
-static void gap_event_handler(esp_bt_gap_cb_event_t event, esp_bt_gap_cb_param_t *param)
-{
-    switch (event) {
-    case ESP_BT_GAP_DISC_RES_EVT:
-        ESP_LOGI(TAG, "Discovery result: device found");
-        // 检查设备类型
-        uint32_t cod = 0x002500; // 默认HID设备类别码
-        
-        // HID设备的设备类别码检查
-        // 键盘: 0x002540, 鼠标: 0x002580, 游戏手柄: 0x002508
-        if ((cod & 0x00FF00) == 0x002500) { // HID设备
-            ESP_LOGI(TAG, "Found HID device: COD: 0x%06lx", cod);
-            
-            // 可以在这里自动连接或通知上层应用
-            if (event_callback) {
-                hid_event_param_t hid_param = {
-                    .event = HID_EVENT_OPEN,
-                    .param.open.status = ESP_OK
-                };
-                // 使用默认的蓝牙地址
-                memset(hid_param.param.open.bd_addr, 0, sizeof(esp_bd_addr_t));
-                event_callback(&hid_param);
-            }
+static void fill_device_info(int slot, const hid_transport_dev_info_t *dev_info)
+{
+    hid_slot_t *s = &slots[slot];
+
+    strncpy(s->info.name, dev_info->name ? dev_info->name : "", sizeof(s->info.name) - 1);
+    s->info.name[sizeof(s->info.name) - 1] = '\0';
+    s->info.vendor_id = dev_info->vendor_id;
+    s->info.product_id = dev_info->product_id;
+    s->info.version = dev_info->version;
+
+    // 优先使用本次连接取到的描述符，取不到时用缓存中上一次的描述符
+    uint16_t desc_len = 0;
+    if (dev_info->report_desc && dev_info->report_desc_len > 0 &&
+        dev_info->report_desc_len <= sizeof(s->report_desc)) {
+        memcpy(s->report_desc, dev_info->report_desc, dev_info->report_desc_len);
+        desc_len = dev_info->report_desc_len;
+    } else if (transport->supports_bonding) {
+        desc_len = sizeof(s->report_desc);
+        if (hid_bond_cache_get_descriptor(s->info.bda, s->report_desc, &desc_len) == ESP_OK) {
+            ESP_LOGI(TAG, "Using cached report descriptor for slot %d", slot);
+        } else {
+            desc_len = 0;
         }
-        break;
-        
-    case ESP_BT_GAP_DISC_STATE_CHANGED_EVT:
-        if (param->disc_st_chg.state == ESP_BT_GAP_DISCOVERY_STOPPED) {
-            ESP_LOGI(TAG, "Discovery stopped");
-            scanning = false;
-        } else if (param->disc_st_chg.state == ESP_BT_GAP_DISCOVERY_STARTED) {
-            ESP_LOGI(TAG, "Discovery started");
-            scanning = true;
+    }
+    s->info.report_desc = desc_len ? s->report_desc : NULL;
+    s->info.report_desc_len = desc_len;
+
+    if (transport->supports_bonding) {
+        hid_bond_entry_t entry = {
+            .transport = dev_info->transport,
+            .vendor_id = s->info.vendor_id,
+            .product_id = s->info.product_id
+        };
+        memcpy(entry.bda, s->info.bda, sizeof(esp_bd_addr_t));
+        strncpy(entry.name, s->info.name, sizeof(entry.name) - 1);
+        hid_bond_cache_store(&entry, s->info.report_desc, desc_len);
+    }
+}
+
+/**
+ * @brief 通知上层连接结果
+ */
+static void notify_open(const uint8_t *bda, esp_err_t status, int slot)
+{
+    if (event_callback) {
+        hid_event_param_t param = {
+            .event = HID_EVENT_OPEN,
+            .param.open.status = status,
+            .param.open.slot = slot >= 0 ? (uint8_t)slot : 0xFF
+        };
+        if (bda) {
+            memcpy(param.param.open.bd_addr, bda, sizeof(esp_bd_addr_t));
         }
-        break;
-        
-    case ESP_BT_GAP_MODE_CHG_EVT:
-        ESP_LOGI(TAG, "GAP mode changed to %d", param->mode_chg.mode);
-        break;
-        
-    default:
-        ESP_LOGD(TAG, "GAP event: %d", event);
-        break;
+        event_callback(&param);
     }
 }
 
+/**
+ * @brief 后端回调：连接结果
+ */
+static void transport_on_open(void *dev_handle, const uint8_t *bda, esp_err_t status,
+                              const hid_transport_dev_info_t *dev_info)
+{
+    int slot = find_slot_by_handle(dev_handle);
+    if (slot < 0) {
+        slot = find_slot_by_bda(bda);
+    }
+
+    if (status != ESP_OK || !dev_info) {
+        ESP_LOGW(TAG, "HID open failed: %s", esp_err_to_name(status));
+        if (slot >= 0 && slots[slot].pending) {
+            release_slot(slot);
+        }
+        hid_link_stats_on_connect_failed();
+        notify_open(bda, status != ESP_OK ? status : ESP_FAIL, -1);
+        hid_reconnect_on_open(bda, false);
+        return;
+    }
+
+    if (slot < 0) {
+        // 手柄主动回连
+        slot = bda ? reserve_slot(bda) : -1;
+        if (slot < 0) {
+            ESP_LOGW(TAG, "All %d device slots in use, rejecting device", BLUETOOTH_HID_MAX_DEVICES);
+            transport->close(dev_handle);
+            return;
+        }
+        slots[slot].timing.connect_start_us = esp_timer_get_time();
+    }
+
+    hid_slot_t *s = &slots[slot];
+    s->info.dev_handle = dev_handle;
+    fill_device_info(slot, dev_info);
+    s->timing.open_us = esp_timer_get_time();
+
+    hid_output_sched_reset_slot((uint8_t)slot);
+    portENTER_CRITICAL(&slots_lock);
+    s->pending = false;
+    s->info.connected = true;
+    portEXIT_CRITICAL(&slots_lock);
+
+    ESP_LOGI(TAG, "HID device '%s' (%04x:%04x) connected in slot %d after %lld ms%s",
+             s->info.name, s->info.vendor_id, s->info.product_id, slot,
+             (s->timing.open_us - s->timing.connect_start_us) / 1000,
+             s->timing.from_bond_cache ? " (bonded page)" : "");
+
+    hid_link_stats_on_connect((uint8_t)slot, (uint32_t)((s->timing.open_us - s->timing.connect_start_us) / 1000));
+    hid_controller_type_t type = hid_report_parser_detect_type(s->info.vendor_id, s->info.product_id, s->info.name);
+    hid_battery_on_connect((uint8_t)slot, type, s->info.version);
+    hid_rumble_bind((uint8_t)slot, type, s->info.vendor_id, s->info.product_id);
+    notify_open(s->info.bda, ESP_OK, slot);
+    hid_reconnect_on_open(s->info.bda, true);
+}
+
+/**
+ * @brief 后端回调：连接断开
+ */
+static void transport_on_close(void *dev_handle, int reason)
+{
+    int slot = find_slot_by_handle(dev_handle);
+    if (slot < 0) {
+        return;
+    }
+
+    bool was_connected = slots[slot].info.connected;
+    bool unexpected = was_connected && !slots[slot].closing;
+    esp_bd_addr_t bda;
+    memcpy(bda, slots[slot].info.bda, sizeof(esp_bd_addr_t));
+    release_slot(slot);
+    if (was_connected) {
+        hid_link_stats_on_disconnect((uint8_t)slot);
+        hid_battery_on_disconnect((uint8_t)slot);
+    }
+    ESP_LOGI(TAG, "HID device in slot %d disconnected, reason %d", slot, reason);
+
+    if (was_connected && event_callback) {
+        hid_event_param_t param = {
+            .event = HID_EVENT_CLOSE,
+            .param.close.status = ESP_OK,
+            .param.close.slot = (uint8_t)slot
+        };
+        event_callback(&param);
+    }
+
+    // 通知上层之后再开始重连，上层据此更新的状态不会被重连结果覆盖
+    hid_reconnect_on_close(bda, unexpected);
+}
+
+/**
+ * @brief 后端回调：输入报告
+ */
+static void transport_on_input(void *dev_handle, uint8_t report_id, uint8_t map_index,
+                               uint8_t *data, uint16_t len)
+{
+    int slot = find_slot_by_handle(dev_handle);
+    if (slot < 0 || !slots[slot].info.connected) {
+        return;
+    }
+
+    hid_slot_t *s = &slots[slot];
+    if (s->timing.first_report_us == 0) {
+        s->timing.first_report_us = esp_timer_get_time();
+        ESP_LOGI(TAG, "First report from slot %d: %lld ms after power-on, %lld ms after connect start",
+                 slot, s->timing.first_report_us / 1000,
+                 (s->timing.first_report_us - s->timing.connect_start_us) / 1000);
+    }
+
+    // 只拷贝这一次，之后所有消费者共享同一个池缓冲
+    if (len > HID_REPORT_MAX_LEN) {
+        ESP_LOGW(TAG, "Report %u from slot %d truncated: %u bytes", report_id, slot, len);
+        len = HID_REPORT_MAX_LEN;
+    }
+    hid_report_buf_t *buf = hid_report_pool_alloc();
+    hid_link_stats_record_report((uint8_t)slot, buf ? buf->timestamp_us : esp_timer_get_time());
+    hid_battery_parse_report((uint8_t)slot, report_id, data, len);
+    if (!buf) {
+        return;
+    }
+    buf->slot = (uint8_t)slot;
+    buf->report_id = report_id;
+    buf->map_index = map_index;
+    buf->len = len;
+    memcpy(buf->data, data, len);
+
+    uint8_t queue_count = atomic_load_explicit(&report_queue_count, memory_order_acquire);
+    for (uint8_t i = 0; i < queue_count; i++) {
+        hid_report_queue_push(report_queues[i], buf);
+    }
+
+    if (input_callback) {
+        hid_input_report_t report = {
+            .data = buf->data,
+            .len = buf->len,
+            .report_id = report_id,
+            .map_index = map_index,
+            .protocol_mode = HID_PROTOCOL_MODE_REPORT,
+            .seq = buf->seq,
+            .timestamp_us = buf->timestamp_us,
+            .buf = buf
+        };
+        input_callback(&s->info, &report);
+    }
+
+    hid_report_pool_release(buf);
+}
+
+/**
+ * @brief 后端回调：RSSI采样结果
+ */
+static void transport_on_rssi(const uint8_t *bda, int8_t rssi)
+{
+    int slot = find_slot_by_bda(bda);
+    if (slot >= 0 && slots[slot].info.connected) {
+        hid_link_stats_record_rssi((uint8_t)slot, rssi);
+    }
+}
+
+/**
+ * @brief 后端回调：BLE连接参数
+ */
+static void transport_on_conn_params(const uint8_t *bda, uint32_t interval_us, uint16_t latency)
+{
+    int slot = find_slot_by_bda(bda);
+    if (slot >= 0) {
+        hid_link_stats_record_conn_params((uint8_t)slot, interval_us, latency);
+    }
+}
+
+/**
+ * @brief 后端回调：电池服务电量
+ */
+static void transport_on_battery(void *dev_handle, uint8_t level)
+{
+    int slot = find_slot_by_handle(dev_handle);
+    if (slot >= 0 && slots[slot].info.connected) {
+        hid_battery_record_level((uint8_t)slot, level);
+    }
+}
+
+/**
+ * @brief RSSI采样定时器：依次请求各已连接设备的RSSI
+ */
+static void rssi_timer_callback(void *arg)
+{
+    if (!hid_initialized || !transport->read_rssi) {
+        return;
+    }
+    
+    for (int i = 0; i < BLUETOOTH_HID_MAX_DEVICES; i++) {
+        portENTER_CRITICAL(&slots_lock);
+        void *dev_handle = slots[i].info.connected ? slots[i].info.dev_handle : NULL;
+        portEXIT_CRITICAL(&slots_lock);
+        if (dev_handle) {
+            transport->read_rssi(dev_handle);
+        }
+    }
+}
+
+/**
+ * @brief 输出调度器的发送函数：在调度任务中按槽位取当前句柄发送
+ */
+static esp_err_t output_send(uint8_t slot, uint8_t report_id, uint8_t *data, uint16_t len)
+{
+    portENTER_CRITICAL(&slots_lock);
+    void *dev_handle = slots[slot].info.connected ? slots[slot].info.dev_handle : NULL;
+    portEXIT_CRITICAL(&slots_lock);
+    
+    if (!dev_handle) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    ESP_LOGD(TAG, "Report ID: 0x%02x, Length: %d, slot %d", report_id, len, slot);
+    return transport->send_output(dev_handle, report_id, data, len);
+}
+
+/**
+ * @brief 后端回调：扫描发现设备，筛选后放入候选表，首选手柄立即选中
+ */
+static bool transport_on_discovered(const hid_transport_disc_result_t *result)
+{
+    if (find_slot_by_bda(result->bda) >= 0) {
+        return false;
+    }
+
+    return hid_discovery_add(result) == HID_DISCOVERY_PREFERRED;
+}
+
+/**
+ * @brief 后端回调：扫描停止，连接选中的设备，没有选中时按排名依次尝试候选
+ */
+static void transport_on_scan_stopped(const uint8_t *selected)
+{
+    scanning = false;
+    hid_discovery_end();
+
+    esp_bd_addr_t bda;
+    bool connecting = false;
+    if (selected) {
+        memcpy(bda, selected, sizeof(esp_bd_addr_t));
+        connecting = bluetooth_hid_connect(bda) == ESP_OK;
+    }
+    while (!connecting && hid_discovery_take_best(bda)) {
+        connecting = bluetooth_hid_connect(bda) == ESP_OK;
+    }
+    hid_reconnect_on_scan_stopped(connecting);
+}
+
+static const hid_transport_callbacks_t transport_callbacks = {
+    .on_open = transport_on_open,
+    .on_close = transport_on_close,
+    .on_input = transport_on_input,
+    .on_discovered = transport_on_discovered,
+    .on_scan_stopped = transport_on_scan_stopped,
+    .on_rssi = transport_on_rssi,
+    .on_conn_params = transport_on_conn_params,
+    .on_battery = transport_on_battery
+};
+
+esp_err_t bluetooth_hid_set_transport(const hid_transport_ops_t *ops)
+{
+    if (!ops) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (hid_initialized) {
+        ESP_LOGE(TAG, "Transport must be selected before init");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    transport = ops;
+    return ESP_OK;
+}
+
 esp_err_t bluetooth_hid_init(hid_event_callback_t event_cb, hid_input_callback_t input_cb)
 {
-    ESP_LOGI(TAG, "Initializing Bluetooth HID host (simplified version)...");
+    ESP_LOGI(TAG, "Initializing Bluetooth HID host...");
     
     if (hid_initialized) {
         ESP_LOGW(TAG, "HID already initialized");
         return ESP_OK;
     }
     
+    if (!transport) {
+        transport = DEFAULT_TRANSPORT();
+    }
+    
+    hid_report_pool_init();
+    
     // 保存回调函数
     event_callback = event_cb;
     input_callback = input_cb;
     
     // 初始化连接设备信息
-    memset(&connected_device, 0, sizeof(connected_device));
+    memset(slots, 0, sizeof(slots));
+    scanning = false;
+    
+    // 绑定缓存加载失败不影响首次配对
+    if (transport->supports_bonding && hid_bond_cache_init(transport->is_bonded) != ESP_OK) {
+        ESP_LOGW(TAG, "Bond cache unavailable, reconnect will use inquiry");
+    }
     
-    // 注册GAP回调函数
-    esp_err_t ret = esp_bt_gap_register_callback(gap_event_handler);
+    esp_err_t ret = hid_output_sched_init(output_send);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to register GAP callback: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "Failed to start output scheduler: %s", esp_err_to_name(ret));
         return ret;
     }
     
-    // 设置GAP扫描模式
-    ret = esp_bt_gap_set_scan_mode(ESP_BT_CONNECTABLE, ESP_BT_GENERAL_DISCOVERABLE);
+    // 设置初始化标志在先：回环后端初始化后可能立即上报连接
+    hid_initialized = true;
+    ret = transport->init(&transport_callbacks);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to set scan mode: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "Failed to initialize %s transport: %s", transport->name, esp_err_to_name(ret));
+        hid_initialized = false;
+        hid_output_sched_deinit();
         return ret;
     }
     
-    hid_initialized = true;
-    ESP_LOGI(TAG, "Bluetooth HID host initialized successfully (simplified)");
+    if (hid_discovery_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Discovery will run the full inquiry before choosing a device");
+    }
+    
+    // 重连定时器创建失败时仍可手动扫描连接
+    if (hid_reconnect_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Automatic reconnect unavailable");
+    }
+    
+    // RSSI周期采样，定时器创建失败只影响链路统计
+    if (CONFIG_BLUETOOTH_HID_RSSI_INTERVAL_MS > 0 && transport->read_rssi) {
+        esp_timer_create_args_t timer_args = {
+            .callback = rssi_timer_callback,
+            .arg = NULL,
+            .name = "hid_rssi"
+        };
+        if (esp_timer_create(&timer_args, &rssi_timer) != ESP_OK ||
+            esp_timer_start_periodic(rssi_timer, CONFIG_BLUETOOTH_HID_RSSI_INTERVAL_MS * 1000ULL) != ESP_OK) {
+            ESP_LOGW(TAG, "RSSI sampling unavailable");
+        }
+    }
+    
+    ESP_LOGI(TAG, "Bluetooth HID host initialized successfully (%s transport)", transport->name);
     
     // 触发初始化完成事件
     if (event_callback) {
@@ -113,6 +568,32 @@ esp_err_t bluetooth_hid_init(hid_event_callback_t event_cb, hid_input_callback_t
     return ESP_OK;
 }
 
+esp_err_t bluetooth_hid_add_report_queue(hid_report_queue_t *queue)
+{
+    if (!queue) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // 只追加不删除：先写入数组再发布计数，输入路径无需加锁
+    portENTER_CRITICAL(&slots_lock);
+    uint8_t count = atomic_load_explicit(&report_queue_count, memory_order_relaxed);
+    for (uint8_t i = 0; i < count; i++) {
+        if (report_queues[i] == queue) {
+            portEXIT_CRITICAL(&slots_lock);
+            return ESP_OK;
+        }
+    }
+    if (count >= MAX_REPORT_QUEUES) {
+        portEXIT_CRITICAL(&slots_lock);
+        return ESP_ERR_NO_MEM;
+    }
+    report_queues[count] = queue;
+    atomic_store_explicit(&report_queue_count, count + 1, memory_order_release);
+    portEXIT_CRITICAL(&slots_lock);
+    
+    return ESP_OK;
+}
+
 esp_err_t bluetooth_hid_deinit(void)
 {
     ESP_LOGI(TAG, "Deinitializing Bluetooth HID host...");
@@ -122,16 +603,31 @@ esp_err_t bluetooth_hid_deinit(void)
         return ESP_OK;
     }
     
-    // 停止扫描
+    // 停止扫描和回连
+    hid_reconnect_deinit();
     if (scanning) {
         bluetooth_hid_stop_scan();
     }
+    hid_discovery_deinit();
     
-    // 断开连接
-    if (connected_device.connected) {
-        bluetooth_hid_disconnect(connected_device.dev_handle);
+    if (rssi_timer) {
+        esp_timer_stop(rssi_timer);
+        esp_timer_delete(rssi_timer);
+        rssi_timer = NULL;
     }
     
+    // 先停止输出调度，避免断开过程中仍向设备发送
+    hid_output_sched_deinit();
+    
+    // 断开所有连接
+    for (int i = 0; i < BLUETOOTH_HID_MAX_DEVICES; i++) {
+        if (slot_in_use(&slots[i]) && slots[i].info.dev_handle) {
+            transport->close(slots[i].info.dev_handle);
+        }
+    }
+    
+    transport->deinit();
+    
     hid_initialized = false;
     event_callback = NULL;
     input_callback = NULL;
@@ -155,8 +651,12 @@ esp_err_t bluetooth_hid_start_scan(uint32_t duration_sec)
         return ESP_OK;
     }
     
-    esp_err_t ret = esp_bt_gap_start_discovery(ESP_BT_INQ_MODE_GENERAL_INQUIRY, duration_sec, 0);
+    // 后端可能在start_scan内同步结束扫描，先置标志
+    hid_discovery_begin();
+    scanning = true;
+    esp_err_t ret = transport->start_scan(duration_sec);
     if (ret != ESP_OK) {
+        scanning = false;
         ESP_LOGE(TAG, "Failed to start discovery: %s", esp_err_to_name(ret));
         return ret;
     }
@@ -174,7 +674,7 @@ esp_err_t bluetooth_hid_stop_scan(void)
         return ESP_OK;
     }
     
-    esp_err_t ret = esp_bt_gap_cancel_discovery();
+    esp_err_t ret = transport->stop_scan();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to stop discovery: %s", esp_err_to_name(ret));
         return ret;
@@ -184,38 +684,70 @@ esp_err_t bluetooth_hid_stop_scan(void)
     return ESP_OK;
 }
 
+esp_err_t bluetooth_hid_reconnect_bonded(uint32_t fallback_scan_sec)
+{
+    if (!hid_initialized) {
+        ESP_LOGE(TAG, "HID not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    hid_bond_entry_t bonds[HID_BOND_CACHE_MAX_ENTRIES];
+    if (!transport->supports_bonding || hid_bond_cache_list(bonds, HID_BOND_CACHE_MAX_ENTRIES) == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    // 查询时长沿用重连配置，调用方指定时覆盖
+    if (fallback_scan_sec > 0) {
+        hid_reconnect_config_t config;
+        hid_reconnect_get_config(&config);
+        config.inquiry_sec = fallback_scan_sec;
+        hid_reconnect_set_config(&config);
+    }
+    
+    return hid_reconnect_start();
+}
+
 esp_err_t bluetooth_hid_connect(esp_bd_addr_t bda)
 {
-    ESP_LOGI(TAG, "Connecting to HID device (simulated)...");
+    ESP_LOGI(TAG, "Connecting to HID device...");
     
     if (!hid_initialized) {
         ESP_LOGE(TAG, "HID not initialized");
         return ESP_ERR_INVALID_STATE;
     }
     
-    if (connected_device.connected) {
-        ESP_LOGW(TAG, "Already connected to a device");
+    int existing = find_slot_by_bda(bda);
+    if (existing >= 0) {
+        ESP_LOGW(TAG, "Device already connected in slot %d", existing);
         return ESP_ERR_INVALID_STATE;
     }
     
-    // 模拟连接成功
-    memcpy(connected_device.bda, bda, sizeof(esp_bd_addr_t));
-    connected_device.connected = true;
-    strcpy(connected_device.name, "Simulated Gamepad");
-    connected_device.dev_handle = (void*)0x12345678; // 模拟句柄
+    int slot = reserve_slot(bda);
+    if (slot < 0) {
+        ESP_LOGW(TAG, "All %d device slots in use", BLUETOOTH_HID_MAX_DEVICES);
+        return ESP_ERR_NO_MEM;
+    }
     
-    ESP_LOGI(TAG, "HID device connected (simulated)");
+    hid_slot_t *s = &slots[slot];
+    s->timing.connect_start_us = esp_timer_get_time();
+    s->timing.from_bond_cache = in_bond_cache(bda);
     
-    // 触发连接事件
-    if (event_callback) {
-        hid_event_param_t param = {
-            .event = HID_EVENT_OPEN,
-            .param.open.status = ESP_OK
-        };
-        memcpy(param.param.open.bd_addr, bda, sizeof(esp_bd_addr_t));
-        event_callback(&param);
+    // 结果在on_open中返回，可能早于open返回
+    void *dev_handle = NULL;
+    esp_err_t ret = transport->open(bda, &dev_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open HID device: %s", esp_err_to_name(ret));
+        release_slot(slot);
+        return ret;
     }
     
+    portENTER_CRITICAL(&slots_lock);
+    if (s->pending) {
+        s->info.dev_handle = dev_handle;
+    }
+    portEXIT_CRITICAL(&slots_lock);
+    
+    ESP_LOGI(TAG, "Paging HID device for slot %d", slot);
     return ESP_OK;
 }
 
@@ -228,26 +760,23 @@ esp_err_t bluetooth_hid_disconnect(void *dev_handle)
         return ESP_ERR_INVALID_STATE;
     }
     
-    if (!connected_device.connected) {
-        ESP_LOGW(TAG, "No device connected");
+    int slot = find_slot_by_handle(dev_handle);
+    if (slot < 0) {
+        ESP_LOGW(TAG, "No device connected with this handle");
         return ESP_ERR_INVALID_STATE;
     }
     
-    // 模拟断开连接
-    connected_device.connected = false;
-    connected_device.dev_handle = NULL;
-    memset(connected_device.bda, 0, sizeof(esp_bd_addr_t));
-    memset(connected_device.name, 0, sizeof(connected_device.name));
-    
-    ESP_LOGI(TAG, "HID device disconnected");
-    
-    // 触发断开事件
-    if (event_callback) {
-        hid_event_param_t param = {
-            .event = HID_EVENT_CLOSE,
-            .param.close.status = ESP_OK
-        };
-        event_callback(&param);
+    // 主动断开的设备不自动重连；槽位在on_close中释放并通知上层
+    portENTER_CRITICAL(&slots_lock);
+    slots[slot].closing = true;
+    portEXIT_CRITICAL(&slots_lock);
+    esp_err_t ret = transport->close(dev_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to close HID device: %s", esp_err_to_name(ret));
+        portENTER_CRITICAL(&slots_lock);
+        slots[slot].closing = false;
+        portEXIT_CRITICAL(&slots_lock);
+        return ret;
     }
     
     return ESP_OK;
@@ -255,7 +784,7 @@ esp_err_t bluetooth_hid_disconnect(void *dev_handle)
 
 esp_err_t bluetooth_hid_send_output_report(void *dev_handle, hid_output_report_t *report)
 {
-    ESP_LOGD(TAG, "Sending HID output report (simulated)...");
+    ESP_LOGD(TAG, "Sending HID output report...");
     
     if (!hid_initialized) {
         ESP_LOGE(TAG, "HID not initialized");
@@ -267,13 +796,18 @@ esp_err_t bluetooth_hid_send_output_report(void *dev_handle, hid_output_report_t
         return ESP_ERR_INVALID_ARG;
     }
     
-    if (!connected_device.connected) {
-        ESP_LOGW(TAG, "No device connected");
+    int slot = find_slot_by_handle(dev_handle);
+    if (slot < 0 || !slots[slot].info.connected) {
+        ESP_LOGW(TAG, "No device connected with this handle");
         return ESP_ERR_INVALID_STATE;
     }
     
-    ESP_LOGD(TAG, "HID output report sent successfully (simulated)");
-    ESP_LOGD(TAG, "Report ID: 0x%02x, Length: %d", report->report_id, report->len);
+    // 交给调度器合并、去重并按预算发送
+    esp_err_t ret = hid_output_sched_submit((uint8_t)slot, report->report_id, report->data, report->len);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to queue output report: %s", esp_err_to_name(ret));
+        return ret;
+    }
     
     return ESP_OK;
 }
@@ -284,41 +818,93 @@ esp_err_t bluetooth_hid_get_connected_device(hid_device_info_t *device_info)
         return ESP_ERR_INVALID_ARG;
     }
     
-    if (!connected_device.connected) {
+    for (int i = 0; i < BLUETOOTH_HID_MAX_DEVICES; i++) {
+        if (bluetooth_hid_get_device((uint8_t)i, device_info) == ESP_OK) {
+            return ESP_OK;
+        }
+    }
+    
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t bluetooth_hid_get_device(uint8_t slot, hid_device_info_t *device_info)
+{
+    if (!device_info || slot >= BLUETOOTH_HID_MAX_DEVICES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    portENTER_CRITICAL(&slots_lock);
+    if (slots[slot].info.connected) {
+        memcpy(device_info, &slots[slot].info, sizeof(hid_device_info_t));
+        ret = ESP_OK;
+    }
+    portEXIT_CRITICAL(&slots_lock);
+    return ret;
+}
+
+esp_err_t bluetooth_hid_get_connect_timing(uint8_t slot, hid_connect_timing_t *timing)
+{
+    if (!timing || slot >= BLUETOOTH_HID_MAX_DEVICES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (!slots[slot].info.connected) {
         return ESP_ERR_NOT_FOUND;
     }
     
-    memcpy(device_info, &connected_device, sizeof(hid_device_info_t));
+    *timing = slots[slot].timing;
     return ESP_OK;
 }
 
+uint8_t bluetooth_hid_get_connected_mask(void)
+{
+    uint8_t mask = 0;
+    for (int i = 0; i < BLUETOOTH_HID_MAX_DEVICES; i++) {
+        if (slots[i].info.connected) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
 bool bluetooth_hid_is_connected(void)
 {
-    return connected_device.connected;
+    return bluetooth_hid_get_connected_mask() != 0;
 }
 
 esp_err_t bluetooth_hid_set_discoverable(bool discoverable, bool connectable)
 {
     ESP_LOGI(TAG, "Setting discoverable: %d, connectable: %d", discoverable, connectable);
     
-    esp_bt_connection_mode_t c_mode;
-    esp_bt_discovery_mode_t d_mode;
+    if (!hid_initialized) {
+        ESP_LOGE(TAG, "HID not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
     
-    if (connectable) {
-        c_mode = ESP_BT_CONNECTABLE;
-    } else {
-        c_mode = ESP_BT_NON_CONNECTABLE;
+    esp_err_t ret = transport->set_discoverable(discoverable, connectable);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set scan mode: %s", esp_err_to_name(ret));
+        return ret;
     }
     
-    if (discoverable) {
-        d_mode = ESP_BT_GENERAL_DISCOVERABLE;
-    } else {
-        d_mode = ESP_BT_NON_DISCOVERABLE;
+    return ESP_OK;
+}
+
+esp_err_t bluetooth_hid_set_page_timeout(uint32_t timeout_ms)
+{
+    if (!hid_initialized) {
+        ESP_LOGE(TAG, "HID not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    if (!transport->set_page_timeout) {
+        return ESP_ERR_NOT_SUPPORTED;
     }
     
-    esp_err_t ret = esp_bt_gap_set_scan_mode(c_mode, d_mode);
+    esp_err_t ret = transport->set_page_timeout(timeout_ms);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to set scan mode: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "Failed to set page timeout: %s", esp_err_to_name(ret));
         return ret;
     }
     
@@ -0,0 +1,256 @@
+/**
+ * @file hid_battery.c
+ * @brief 手柄电池与状态解析实现
+ */
+
+#include "hid_battery.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+static const char *TAG = "HID_BATTERY";
+
+#ifndef CONFIG_BLUETOOTH_HID_BATTERY_LOW_PERCENT
+#define CONFIG_BLUETOOTH_HID_BATTERY_LOW_PERCENT        20
+#endif
+#ifndef CONFIG_BLUETOOTH_HID_BATTERY_CRITICAL_PERCENT
+#define CONFIG_BLUETOOTH_HID_BATTERY_CRITICAL_PERCENT   5
+#endif
+
+// 离开低电量档位需回升的百分比，避免电量在阈值附近抖动时反复通知
+#define LEVEL_HYSTERESIS         3
+
+// PS4输入报告：USB布局的0x01带完整数据，蓝牙的0x11在同样的数据前多2字节
+#define DS4_REPORT_FULL          0x01
+#define DS4_REPORT_BT            0x11
+#define DS4_BT_HEADER_LEN        2
+#define DS4_TEMPERATURE_OFFSET   11
+#define DS4_STATUS_OFFSET        29
+#define DS4_BATTERY_MASK         0x0F
+#define DS4_CABLE_BIT            0x10
+#define DS4_BATTERY_FULL         10
+
+// Xbox电池报告：低2位为电量档，第2-3位为电池类型（0表示线缆供电），第4位为充电中
+#define XBOX_REPORT_BATTERY      0x04
+#define XBOX_LEVEL_MASK          0x03
+#define XBOX_TYPE_SHIFT          2
+#define XBOX_TYPE_MASK           0x03
+#define XBOX_CHARGING_BIT        0x10
+
+// Xbox只上报4档电量（严重低/低/中/满），换算成百分比
+static const int8_t xbox_level_percent[] = { 5, 20, 60, 100 };
+
+static hid_battery_status_t batteries[HID_BATTERY_MAX_DEVICES];
+// 上一个状态字节（含温度），未变化时跳过解析；只由输入路径所在任务访问
+static uint32_t last_raw[HID_BATTERY_MAX_DEVICES];
+static uint8_t low_percent = CONFIG_BLUETOOTH_HID_BATTERY_LOW_PERCENT;
+static uint8_t critical_percent = CONFIG_BLUETOOTH_HID_BATTERY_CRITICAL_PERCENT;
+static hid_battery_callback_t battery_callback = NULL;
+static portMUX_TYPE battery_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#define RAW_NONE                 UINT32_MAX
+
+/**
+ * @brief 按电量和供电方式确定状态档位，已在低档位时需回升LEVEL_HYSTERESIS才离开
+ */
+static hid_battery_state_t classify(const hid_battery_status_t *b, hid_battery_state_t prev)
+{
+    if (b->cable) {
+        return HID_BATTERY_STATE_CHARGING;
+    }
+    if (b->level == HID_BATTERY_LEVEL_UNKNOWN) {
+        return HID_BATTERY_STATE_UNKNOWN;
+    }
+
+    int critical_margin = prev == HID_BATTERY_STATE_CRITICAL ? LEVEL_HYSTERESIS : 0;
+    int low_margin = (prev == HID_BATTERY_STATE_CRITICAL || prev == HID_BATTERY_STATE_LOW) ? LEVEL_HYSTERESIS : 0;
+    if (b->level <= critical_percent + critical_margin) {
+        return HID_BATTERY_STATE_CRITICAL;
+    }
+    if (b->level <= low_percent + low_margin) {
+        return HID_BATTERY_STATE_LOW;
+    }
+    return HID_BATTERY_STATE_NORMAL;
+}
+
+/**
+ * @brief 写入新的电量，档位变化时在锁外通知回调
+ * @param temperature 温度原始值，INT16_MIN表示报告中没有温度
+ */
+static void update(uint8_t slot, int8_t level, bool charging, bool cable, int16_t temperature)
+{
+    portENTER_CRITICAL(&battery_lock);
+    hid_battery_status_t *b = &batteries[slot];
+    hid_battery_state_t prev = b->state;
+    b->level = level;
+    b->charging = charging;
+    b->cable = cable;
+    if (temperature != INT16_MIN) {
+        b->temperature = (int8_t)temperature;
+        b->temperature_valid = true;
+    }
+    b->updated_us = esp_timer_get_time();
+    b->state = classify(b, prev);
+    hid_battery_status_t snapshot = *b;
+    hid_battery_callback_t callback = battery_callback;
+    portEXIT_CRITICAL(&battery_lock);
+
+    if (snapshot.state == prev) {
+        return;
+    }
+    if (snapshot.state == HID_BATTERY_STATE_LOW || snapshot.state == HID_BATTERY_STATE_CRITICAL) {
+        ESP_LOGW(TAG, "Controller in slot %d battery %s: %d%%", slot,
+                 snapshot.state == HID_BATTERY_STATE_CRITICAL ? "critical" : "low", snapshot.level);
+    } else {
+        ESP_LOGI(TAG, "Controller in slot %d battery %d%%%s", slot, snapshot.level,
+                 snapshot.cable ? (snapshot.charging ? ", charging" : ", on cable") : "");
+    }
+    if (callback) {
+        callback(slot, &snapshot);
+    }
+}
+
+/**
+ * @brief 解析PS4状态字节：低4位为电量（0-10档），第4位为接着线缆
+ */
+static void parse_ds4(uint8_t slot, uint8_t report_id, const uint8_t *data, uint16_t len)
+{
+    size_t base;
+    if (report_id == DS4_REPORT_BT) {
+        base = DS4_BT_HEADER_LEN;
+    } else if (report_id == DS4_REPORT_FULL) {
+        base = 0;  // 蓝牙连接初期的短0x01报告没有状态字节，由长度排除
+    } else {
+        return;
+    }
+    if (len <= base + DS4_STATUS_OFFSET) {
+        return;
+    }
+
+    uint8_t status = data[base + DS4_STATUS_OFFSET];
+    uint8_t temperature = data[base + DS4_TEMPERATURE_OFFSET];
+    uint32_t raw = status | ((uint32_t)temperature << 8);
+    if (raw == last_raw[slot]) {
+        return;
+    }
+    last_raw[slot] = raw;
+
+    uint8_t steps = status & DS4_BATTERY_MASK;
+    bool cable = (status & DS4_CABLE_BIT) != 0;
+    int8_t level;
+    if (steps < DS4_BATTERY_FULL) {
+        level = steps * 10 + 5;
+    } else if (!cable || steps <= DS4_BATTERY_FULL + 1) {
+        level = 100;  // 接着线缆时10和11都表示已充满
+    } else {
+        level = HID_BATTERY_LEVEL_UNKNOWN;  // 接着线缆时更大的值表示充电错误
+    }
+    update(slot, level, cable && steps < DS4_BATTERY_FULL, cable, (int8_t)temperature);
+}
+
+/**
+ * @brief 解析Xbox电池报告
+ */
+static void parse_xbox(uint8_t slot, uint8_t report_id, const uint8_t *data, uint16_t len)
+{
+    if (report_id != XBOX_REPORT_BATTERY || len < 1 || data[0] == last_raw[slot]) {
+        return;
+    }
+    last_raw[slot] = data[0];
+
+    bool charging = (data[0] & XBOX_CHARGING_BIT) != 0;
+    bool cable = charging || ((data[0] >> XBOX_TYPE_SHIFT) & XBOX_TYPE_MASK) == 0;
+    update(slot, xbox_level_percent[data[0] & XBOX_LEVEL_MASK], charging, cable, INT16_MIN);
+}
+
+void hid_battery_on_connect(uint8_t slot, hid_controller_type_t type, uint16_t firmware_version)
+{
+    if (slot >= HID_BATTERY_MAX_DEVICES) {
+        return;
+    }
+
+    portENTER_CRITICAL(&battery_lock);
+    memset(&batteries[slot], 0, sizeof(batteries[slot]));
+    batteries[slot].connected = true;
+    batteries[slot].type = type;
+    batteries[slot].level = HID_BATTERY_LEVEL_UNKNOWN;
+    batteries[slot].firmware_version = firmware_version;
+    last_raw[slot] = RAW_NONE;
+    portEXIT_CRITICAL(&battery_lock);
+}
+
+void hid_battery_on_disconnect(uint8_t slot)
+{
+    if (slot >= HID_BATTERY_MAX_DEVICES) {
+        return;
+    }
+
+    portENTER_CRITICAL(&battery_lock);
+    batteries[slot].connected = false;
+    portEXIT_CRITICAL(&battery_lock);
+}
+
+void hid_battery_parse_report(uint8_t slot, uint8_t report_id, const uint8_t *data, uint16_t len)
+{
+    if (slot >= HID_BATTERY_MAX_DEVICES) {
+        return;
+    }
+
+    // 型号只在连接时写入，同一任务中读取无需加锁
+    switch (batteries[slot].type) {
+    case HID_CONTROLLER_PS4:
+        parse_ds4(slot, report_id, data, len);
+        break;
+    case HID_CONTROLLER_XBOX:
+        parse_xbox(slot, report_id, data, len);
+        break;
+    default:
+        break;  // 其他型号只有电池服务通知
+    }
+}
+
+void hid_battery_record_level(uint8_t slot, uint8_t level)
+{
+    if (slot >= HID_BATTERY_MAX_DEVICES) {
+        return;
+    }
+
+    portENTER_CRITICAL(&battery_lock);
+    bool charging = batteries[slot].charging;
+    bool cable = batteries[slot].cable;
+    portEXIT_CRITICAL(&battery_lock);
+    update(slot, level > 100 ? 100 : (int8_t)level, charging, cable, INT16_MIN);
+}
+
+esp_err_t hid_battery_set_thresholds(uint8_t low, uint8_t critical)
+{
+    if (low > 100 || critical >= low) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&battery_lock);
+    low_percent = low;
+    critical_percent = critical;
+    portEXIT_CRITICAL(&battery_lock);
+    return ESP_OK;
+}
+
+void hid_battery_register_callback(hid_battery_callback_t callback)
+{
+    portENTER_CRITICAL(&battery_lock);
+    battery_callback = callback;
+    portEXIT_CRITICAL(&battery_lock);
+}
+
+esp_err_t hid_battery_get(uint8_t slot, hid_battery_status_t *status)
+{
+    if (slot >= HID_BATTERY_MAX_DEVICES || !status) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&battery_lock);
+    *status = batteries[slot];
+    portEXIT_CRITICAL(&battery_lock);
+    return ESP_OK;
+}
@@ -0,0 +1,304 @@
+/**
+ * @file hid_bond_cache.c
+ * @brief 已绑定手柄缓存实现
+ */
+
+#include "hid_bond_cache.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "HID_BOND";
+
+#define BOND_NVS_NAMESPACE      "hid_bonds"
+#define BOND_NVS_INDEX_KEY      "index"
+#define BOND_INDEX_VERSION      1
+
+/**
+ * @brief NVS中保存的索引
+ */
+typedef struct {
+    uint8_t version;
+    uint8_t count;
+    uint32_t use_counter;
+    hid_bond_entry_t entries[HID_BOND_CACHE_MAX_ENTRIES];
+} bond_index_t;
+
+static bond_index_t bond_index;
+static portMUX_TYPE bond_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief 描述符键名："d_" + 12位十六进制地址
+ */
+static void descriptor_key(const esp_bd_addr_t bda, char key[16])
+{
+    snprintf(key, 16, "d_%02x%02x%02x%02x%02x%02x", bda[0], bda[1], bda[2], bda[3], bda[4], bda[5]);
+}
+
+/**
+ * @brief FNV-1a哈希，判断描述符是否需要重写
+ */
+static uint32_t descriptor_hash(const uint8_t *data, uint16_t len)
+{
+    uint32_t hash = 2166136261u;
+    for (uint16_t i = 0; i < len; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static int find_entry(const bond_index_t *index, const esp_bd_addr_t bda)
+{
+    for (int i = 0; i < index->count; i++) {
+        if (memcmp(index->entries[i].bda, bda, sizeof(esp_bd_addr_t)) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void remove_entry(bond_index_t *index, int i)
+{
+    index->count--;
+    if (i < index->count) {
+        memmove(&index->entries[i], &index->entries[i + 1],
+                (index->count - i) * sizeof(hid_bond_entry_t));
+    }
+}
+
+/**
+ * @brief 把索引快照写入NVS
+ */
+static esp_err_t save_index(const bond_index_t *index)
+{
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(BOND_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = nvs_set_blob(handle, BOND_NVS_INDEX_KEY, index, sizeof(*index));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return ret;
+}
+
+static void erase_descriptor(nvs_handle_t handle, const esp_bd_addr_t bda)
+{
+    char key[16];
+    descriptor_key(bda, key);
+    nvs_erase_key(handle, key);
+}
+
+esp_err_t hid_bond_cache_init(bool (*is_bonded)(const uint8_t *bda))
+{
+    bond_index_t loaded = {0};
+    nvs_handle_t handle;
+
+    esp_err_t ret = nvs_open(BOND_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS namespace: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    size_t size = sizeof(loaded);
+    ret = nvs_get_blob(handle, BOND_NVS_INDEX_KEY, &loaded, &size);
+    if (ret != ESP_OK || size != sizeof(loaded) || loaded.version != BOND_INDEX_VERSION ||
+        loaded.count > HID_BOND_CACHE_MAX_ENTRIES) {
+        memset(&loaded, 0, sizeof(loaded));
+        loaded.version = BOND_INDEX_VERSION;
+    }
+
+    // 与协议栈的绑定核对：链路密钥已不存在的条目只能重新配对
+    bool changed = false;
+    for (int i = loaded.count - 1; i >= 0 && is_bonded; i--) {
+        if (!is_bonded(loaded.entries[i].bda)) {
+            ESP_LOGI(TAG, "Dropping cached device without link key");
+            erase_descriptor(handle, loaded.entries[i].bda);
+            remove_entry(&loaded, i);
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        nvs_set_blob(handle, BOND_NVS_INDEX_KEY, &loaded, sizeof(loaded));
+        nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    portENTER_CRITICAL(&bond_lock);
+    bond_index = loaded;
+    portEXIT_CRITICAL(&bond_lock);
+
+    ESP_LOGI(TAG, "Bond cache loaded: %d device(s)", loaded.count);
+    return ESP_OK;
+}
+
+size_t hid_bond_cache_list(hid_bond_entry_t *entries, size_t max)
+{
+    if (!entries || max == 0) {
+        return 0;
+    }
+
+    bond_index_t index;
+    portENTER_CRITICAL(&bond_lock);
+    index = bond_index;
+    portEXIT_CRITICAL(&bond_lock);
+
+    // 按last_used降序排序（条目很少，插入排序即可）
+    for (int i = 1; i < index.count; i++) {
+        hid_bond_entry_t e = index.entries[i];
+        int j = i;
+        while (j > 0 && index.entries[j - 1].last_used < e.last_used) {
+            index.entries[j] = index.entries[j - 1];
+            j--;
+        }
+        index.entries[j] = e;
+    }
+
+    size_t n = index.count < max ? index.count : max;
+    memcpy(entries, index.entries, n * sizeof(hid_bond_entry_t));
+    return n;
+}
+
+esp_err_t hid_bond_cache_store(const hid_bond_entry_t *entry, const uint8_t *desc, uint16_t desc_len)
+{
+    if (!entry) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!desc || desc_len > HID_BOND_CACHE_MAX_DESC_LEN) {
+        desc_len = 0;
+    }
+
+    uint32_t hash = desc_len ? descriptor_hash(desc, desc_len) : 0;
+    bool write_desc = false;
+    bool evicted = false;
+    esp_bd_addr_t evicted_bda;
+    bond_index_t snapshot;
+
+    portENTER_CRITICAL(&bond_lock);
+    int i = find_entry(&bond_index, entry->bda);
+    if (i < 0) {
+        if (bond_index.count == HID_BOND_CACHE_MAX_ENTRIES) {
+            // 替换最久未用的条目
+            int oldest = 0;
+            for (int j = 1; j < bond_index.count; j++) {
+                if (bond_index.entries[j].last_used < bond_index.entries[oldest].last_used) {
+                    oldest = j;
+                }
+            }
+            memcpy(evicted_bda, bond_index.entries[oldest].bda, sizeof(esp_bd_addr_t));
+            evicted = true;
+            remove_entry(&bond_index, oldest);
+        }
+        i = bond_index.count++;
+        write_desc = desc_len > 0;
+    } else {
+        write_desc = desc_len > 0 &&
+                     (bond_index.entries[i].desc_len != desc_len || bond_index.entries[i].desc_hash != hash);
+        if (desc_len == 0) {
+            // 本次没有拿到描述符时保留原有缓存
+            desc_len = bond_index.entries[i].desc_len;
+            hash = bond_index.entries[i].desc_hash;
+        }
+    }
+    hid_bond_entry_t *slot = &bond_index.entries[i];
+    *slot = *entry;
+    slot->name[sizeof(slot->name) - 1] = '\0';
+    slot->last_used = ++bond_index.use_counter;
+    slot->desc_len = desc_len;
+    slot->desc_hash = hash;
+    snapshot = bond_index;
+    portEXIT_CRITICAL(&bond_lock);
+
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(BOND_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS namespace: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    if (evicted) {
+        erase_descriptor(handle, evicted_bda);
+    }
+    if (write_desc) {
+        char key[16];
+        descriptor_key(entry->bda, key);
+        ret = nvs_set_blob(handle, key, desc, desc_len);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to cache report descriptor: %s", esp_err_to_name(ret));
+        }
+    }
+    ret = nvs_set_blob(handle, BOND_NVS_INDEX_KEY, &snapshot, sizeof(snapshot));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to save bond cache: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+esp_err_t hid_bond_cache_get_descriptor(const esp_bd_addr_t bda, uint8_t *desc, uint16_t *len)
+{
+    if (!desc || !len) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&bond_lock);
+    int i = find_entry(&bond_index, bda);
+    uint16_t cached_len = i >= 0 ? bond_index.entries[i].desc_len : 0;
+    portEXIT_CRITICAL(&bond_lock);
+
+    if (cached_len == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (cached_len > *len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(BOND_NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    char key[16];
+    descriptor_key(bda, key);
+    size_t size = *len;
+    ret = nvs_get_blob(handle, key, desc, &size);
+    nvs_close(handle);
+
+    if (ret != ESP_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    *len = (uint16_t)size;
+    return ESP_OK;
+}
+
+esp_err_t hid_bond_cache_remove(const esp_bd_addr_t bda)
+{
+    bond_index_t snapshot;
+
+    portENTER_CRITICAL(&bond_lock);
+    int i = find_entry(&bond_index, bda);
+    if (i >= 0) {
+        remove_entry(&bond_index, i);
+    }
+    snapshot = bond_index;
+    portEXIT_CRITICAL(&bond_lock);
+
+    if (i < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    nvs_handle_t handle;
+    if (nvs_open(BOND_NVS_NAMESPACE, NVS_READWRITE, &handle) == ESP_OK) {
+        erase_descriptor(handle, bda);
+        nvs_close(handle);
+    }
+    return save_index(&snapshot);
+}
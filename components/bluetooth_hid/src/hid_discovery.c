@@ -0,0 +1,285 @@
+/**
+ * @file hid_discovery.c
+ * @brief 查询结果筛选与候选排序实现
+ */
+
+#include "hid_discovery.h"
+#include "bluetooth_hid.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+static const char *TAG = "HID_DISCOVERY";
+
+#ifndef CONFIG_BLUETOOTH_HID_DISCOVERY_SETTLE_MS
+#define CONFIG_BLUETOOTH_HID_DISCOVERY_SETTLE_MS   2560
+#endif
+#ifndef CONFIG_BLUETOOTH_HID_DISCOVERY_MIN_RSSI
+#define CONFIG_BLUETOOTH_HID_DISCOVERY_MIN_RSSI    (-90)
+#endif
+
+// 设备类别码：主设备类为外设，次设备类低4位为具体类型，高2位为键盘/指点设备标志
+#define COD_MAJOR_DEVICE(cod)    (((cod) >> 8) & 0x1F)
+#define COD_MAJOR_PERIPHERAL     0x05
+#define COD_MINOR_TYPE(cod)      (((cod) >> 2) & 0x0F)
+#define COD_MINOR_COMBO(cod)     (((cod) >> 6) & 0x03)
+#define COD_MINOR_UNCATEGORIZED  0x00
+#define COD_MINOR_JOYSTICK       0x01
+#define COD_MINOR_GAMEPAD        0x02
+
+// EIR厂商数据中的蓝牙SIG公司ID（与USB厂商ID不同）
+#define COMPANY_ID_MICROSOFT     0x0006
+#define COMPANY_ID_SONY          0x012D
+
+// 排名档次，同档按RSSI排序
+#define RANK_PREFERRED           3
+#define RANK_GAMEPAD             2
+#define RANK_PERIPHERAL          1
+
+static hid_discovery_candidate_t candidates[HID_DISCOVERY_MAX_CANDIDATES];
+static size_t candidate_count = 0;
+static uint32_t preferred_mask = (1u << HID_CONTROLLER_PS4) | (1u << HID_CONTROLLER_XBOX) |
+                                 (1u << HID_CONTROLLER_BEITONG);
+static esp_timer_handle_t settle_timer = NULL;
+static portMUX_TYPE discovery_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief 候选的排名档次
+ */
+static int candidate_rank(const hid_discovery_candidate_t *c)
+{
+    if (c->preferred) {
+        return RANK_PREFERRED;
+    }
+    uint32_t minor = COD_MINOR_TYPE(c->cod);
+    if (c->type != HID_CONTROLLER_GENERIC || minor == COD_MINOR_JOYSTICK || minor == COD_MINOR_GAMEPAD) {
+        return RANK_GAMEPAD;
+    }
+    return RANK_PERIPHERAL;
+}
+
+/**
+ * @brief a是否排在b之前
+ */
+static bool ranks_above(const hid_discovery_candidate_t *a, const hid_discovery_candidate_t *b)
+{
+    int rank_a = candidate_rank(a);
+    int rank_b = candidate_rank(b);
+    if (rank_a != rank_b) {
+        return rank_a > rank_b;
+    }
+    return a->rssi > b->rssi;
+}
+
+/**
+ * @brief 按名称识别型号，名称未知时按公司ID
+ */
+static hid_controller_type_t identify(const char *name, uint16_t company_id)
+{
+    hid_controller_type_t type = hid_report_parser_detect_type(0, 0, name[0] ? name : NULL);
+    if (type != HID_CONTROLLER_GENERIC) {
+        return type;
+    }
+
+    switch (company_id) {
+    case COMPANY_ID_SONY:
+        return HID_CONTROLLER_PS4;
+    case COMPANY_ID_MICROSOFT:
+        return HID_CONTROLLER_XBOX;
+    default:
+        return HID_CONTROLLER_GENERIC;
+    }
+}
+
+/**
+ * @brief 类别码是否可能是手柄：手柄、摇杆或未分类的外设（不含键盘和鼠标）
+ */
+static bool cod_may_be_gamepad(uint32_t cod)
+{
+    if (COD_MAJOR_DEVICE(cod) != COD_MAJOR_PERIPHERAL || COD_MINOR_COMBO(cod) != 0) {
+        return false;
+    }
+    uint32_t minor = COD_MINOR_TYPE(cod);
+    return minor == COD_MINOR_UNCATEGORIZED || minor == COD_MINOR_JOYSTICK || minor == COD_MINOR_GAMEPAD;
+}
+
+/**
+ * @brief 候选等待结束：停止查询，在on_scan_stopped中连接最佳候选
+ */
+static void settle_timer_callback(void *arg)
+{
+    ESP_LOGI(TAG, "Candidate window closed, stopping inquiry");
+    bluetooth_hid_stop_scan();
+}
+
+esp_err_t hid_discovery_init(void)
+{
+    if (settle_timer || CONFIG_BLUETOOTH_HID_DISCOVERY_SETTLE_MS == 0) {
+        return ESP_OK;
+    }
+
+    esp_timer_create_args_t timer_args = {
+        .callback = settle_timer_callback,
+        .arg = NULL,
+        .name = "hid_discovery"
+    };
+    return esp_timer_create(&timer_args, &settle_timer);
+}
+
+void hid_discovery_deinit(void)
+{
+    if (settle_timer) {
+        esp_timer_stop(settle_timer);
+        esp_timer_delete(settle_timer);
+        settle_timer = NULL;
+    }
+    hid_discovery_begin();
+}
+
+void hid_discovery_begin(void)
+{
+    portENTER_CRITICAL(&discovery_lock);
+    candidate_count = 0;
+    portEXIT_CRITICAL(&discovery_lock);
+}
+
+hid_discovery_verdict_t hid_discovery_add(const hid_transport_disc_result_t *result)
+{
+    char name[HID_DISCOVERY_NAME_LEN] = {0};
+    if (result->name) {
+        strncpy(name, result->name, sizeof(name) - 1);
+    }
+
+    // 名称和公司ID可能只出现在后续的查询结果中，按地址合并后再判断
+    portENTER_CRITICAL(&discovery_lock);
+    size_t index;
+    for (index = 0; index < candidate_count; index++) {
+        if (memcmp(candidates[index].bda, result->bda, sizeof(esp_bd_addr_t)) == 0) {
+            break;
+        }
+    }
+    bool known = index < candidate_count;
+    hid_discovery_candidate_t candidate = {0};
+    if (known) {
+        candidate = candidates[index];
+    } else {
+        memcpy(candidate.bda, result->bda, sizeof(esp_bd_addr_t));
+        candidate.company_id = HID_DISCOVERY_COMPANY_UNKNOWN;
+    }
+    portEXIT_CRITICAL(&discovery_lock);
+
+    if (result->cod) {
+        candidate.cod = result->cod;
+    }
+    if (result->rssi != INT8_MIN) {
+        candidate.rssi = result->rssi;
+    } else if (!known) {
+        candidate.rssi = INT8_MIN;
+    }
+    if (result->company_id != HID_DISCOVERY_COMPANY_UNKNOWN) {
+        candidate.company_id = result->company_id;
+    }
+    if (name[0]) {
+        memcpy(candidate.name, name, sizeof(candidate.name));
+    }
+    candidate.type = identify(candidate.name, candidate.company_id);
+    candidate.preferred = candidate.type != HID_CONTROLLER_GENERIC && (preferred_mask & (1u << candidate.type));
+    if (candidate.seen < UINT8_MAX) {
+        candidate.seen++;
+    }
+
+    // 已识别的型号不看类别码（部分手柄上报为键盘组合类）
+    bool gamepad = candidate.type != HID_CONTROLLER_GENERIC || cod_may_be_gamepad(candidate.cod);
+    bool strong = candidate.rssi == INT8_MIN || candidate.rssi >= CONFIG_BLUETOOTH_HID_DISCOVERY_MIN_RSSI;
+    if (!gamepad || !strong) {
+        if (known) {
+            portENTER_CRITICAL(&discovery_lock);
+            if (index < candidate_count && memcmp(candidates[index].bda, candidate.bda, sizeof(esp_bd_addr_t)) == 0) {
+                memmove(&candidates[index], &candidates[index + 1],
+                        (candidate_count - index - 1) * sizeof(candidates[0]));
+                candidate_count--;
+            }
+            portEXIT_CRITICAL(&discovery_lock);
+        }
+        return HID_DISCOVERY_REJECTED;
+    }
+
+    // 保持候选表有序：先移出旧位置，再插到第一个排名低于它的位置，表满时挤掉最后一名
+    portENTER_CRITICAL(&discovery_lock);
+    if (index < candidate_count && memcmp(candidates[index].bda, candidate.bda, sizeof(esp_bd_addr_t)) == 0) {
+        memmove(&candidates[index], &candidates[index + 1], (candidate_count - index - 1) * sizeof(candidates[0]));
+        candidate_count--;
+    }
+    size_t pos = 0;
+    while (pos < candidate_count && !ranks_above(&candidate, &candidates[pos])) {
+        pos++;
+    }
+    bool inserted = pos < HID_DISCOVERY_MAX_CANDIDATES;
+    if (inserted) {
+        size_t move = candidate_count - pos;
+        if (candidate_count == HID_DISCOVERY_MAX_CANDIDATES) {
+            move--;
+        } else {
+            candidate_count++;
+        }
+        memmove(&candidates[pos + 1], &candidates[pos], move * sizeof(candidates[0]));
+        candidates[pos] = candidate;
+    }
+    portEXIT_CRITICAL(&discovery_lock);
+
+    if (!inserted) {
+        return HID_DISCOVERY_REJECTED;
+    }
+
+    if (!known) {
+        ESP_LOGI(TAG, "Candidate %s: COD 0x%06lx, RSSI %d%s", candidate.name[0] ? candidate.name : "(unnamed)",
+                 (unsigned long)candidate.cod, candidate.rssi, candidate.preferred ? " (preferred)" : "");
+    }
+
+    if (candidate.preferred) {
+        return HID_DISCOVERY_PREFERRED;
+    }
+
+    // 第一个候选出现后只再等待一小段时间，不必跑完整个查询
+    if (settle_timer && !esp_timer_is_active(settle_timer)) {
+        esp_timer_start_once(settle_timer, CONFIG_BLUETOOTH_HID_DISCOVERY_SETTLE_MS * 1000ULL);
+    }
+    return HID_DISCOVERY_CANDIDATE;
+}
+
+void hid_discovery_end(void)
+{
+    if (settle_timer) {
+        esp_timer_stop(settle_timer);
+    }
+}
+
+bool hid_discovery_take_best(uint8_t *bda)
+{
+    portENTER_CRITICAL(&discovery_lock);
+    bool found = candidate_count > 0;
+    if (found) {
+        memcpy(bda, candidates[0].bda, sizeof(esp_bd_addr_t));
+        memmove(&candidates[0], &candidates[1], (candidate_count - 1) * sizeof(candidates[0]));
+        candidate_count--;
+    }
+    portEXIT_CRITICAL(&discovery_lock);
+    return found;
+}
+
+void hid_discovery_set_preferred(uint32_t type_mask)
+{
+    portENTER_CRITICAL(&discovery_lock);
+    preferred_mask = type_mask;
+    portEXIT_CRITICAL(&discovery_lock);
+}
+
+size_t hid_discovery_get_candidates(hid_discovery_candidate_t *out, size_t max)
+{
+    portENTER_CRITICAL(&discovery_lock);
+    size_t count = candidate_count < max ? candidate_count : max;
+    memcpy(out, candidates, count * sizeof(candidates[0]));
+    portEXIT_CRITICAL(&discovery_lock);
+    return count;
+}
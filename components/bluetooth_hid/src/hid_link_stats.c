@@ -0,0 +1,172 @@
+/**
+ * @file hid_link_stats.c
+ * @brief 手柄链路质量与报告节奏统计实现
+ */
+
+#include "hid_link_stats.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+#ifndef CONFIG_BLUETOOTH_HID_GAP_INTERVALS
+#define CONFIG_BLUETOOTH_HID_GAP_INTERVALS   3
+#endif
+
+// 平均间隔用1/16的指数滑动平均，定点保留4位小数
+#define INTERVAL_EWMA_SHIFT     4
+// 积累足够的间隔样本后才判断断档
+#define GAP_WARMUP_REPORTS      8
+
+static hid_link_stats_t links[HID_LINK_STATS_MAX_DEVICES];
+static uint32_t interval_ewma_q4[HID_LINK_STATS_MAX_DEVICES];
+static hid_link_counters_t counters;
+static uint64_t connect_ms_total = 0;
+static uint8_t gap_intervals = CONFIG_BLUETOOTH_HID_GAP_INTERVALS;
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief 到达间隔对应的直方图桶
+ */
+static inline uint32_t interval_bucket(uint32_t interval_us)
+{
+    uint32_t ms = interval_us / 1000;
+    if (ms == 0) {
+        return 0;
+    }
+    uint32_t index = 32 - __builtin_clz(ms);
+    return index < HID_LINK_INTERVAL_BUCKETS ? index : HID_LINK_INTERVAL_BUCKETS - 1;
+}
+
+void hid_link_stats_on_connect(uint8_t slot, uint32_t connect_ms)
+{
+    if (slot >= HID_LINK_STATS_MAX_DEVICES) {
+        return;
+    }
+
+    portENTER_CRITICAL(&stats_lock);
+    memset(&links[slot], 0, sizeof(links[slot]));
+    links[slot].connected = true;
+    interval_ewma_q4[slot] = 0;
+    counters.connects++;
+    connect_ms_total += connect_ms;
+    counters.avg_connect_ms = (uint32_t)(connect_ms_total / counters.connects);
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+void hid_link_stats_on_connect_failed(void)
+{
+    portENTER_CRITICAL(&stats_lock);
+    counters.connect_failures++;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+void hid_link_stats_on_disconnect(uint8_t slot)
+{
+    if (slot >= HID_LINK_STATS_MAX_DEVICES) {
+        return;
+    }
+
+    // 保留断开前的统计以便事后查看
+    portENTER_CRITICAL(&stats_lock);
+    links[slot].connected = false;
+    counters.disconnects++;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+void hid_link_stats_record_report(uint8_t slot, int64_t timestamp_us)
+{
+    if (slot >= HID_LINK_STATS_MAX_DEVICES) {
+        return;
+    }
+
+    portENTER_CRITICAL(&stats_lock);
+    hid_link_stats_t *link = &links[slot];
+    if (link->reports > 0 && timestamp_us > link->last_report_us) {
+        int64_t delta = timestamp_us - link->last_report_us;
+        uint32_t interval_us = delta > UINT32_MAX ? UINT32_MAX : (uint32_t)delta;
+        link->interval_hist[interval_bucket(interval_us)]++;
+        if (interval_us > link->max_gap_us) {
+            link->max_gap_us = interval_us;
+        }
+
+        // 断档不计入平均间隔，否则一次长断档会把阈值抬高
+        uint32_t avg_us = interval_ewma_q4[slot] >> INTERVAL_EWMA_SHIFT;
+        bool warmed_up = link->reports > GAP_WARMUP_REPORTS;
+        if (warmed_up && avg_us > 0 && interval_us > avg_us * gap_intervals) {
+            link->gaps++;
+        } else if (interval_ewma_q4[slot] == 0) {
+            interval_ewma_q4[slot] = (interval_us < (UINT32_MAX >> INTERVAL_EWMA_SHIFT) ?
+                                      interval_us : (UINT32_MAX >> INTERVAL_EWMA_SHIFT)) << INTERVAL_EWMA_SHIFT;
+        } else {
+            interval_ewma_q4[slot] += interval_us - avg_us;
+        }
+
+        link->avg_interval_us = interval_ewma_q4[slot] >> INTERVAL_EWMA_SHIFT;
+        link->report_rate_hz = link->avg_interval_us ? 1000000.0f / link->avg_interval_us : 0.0f;
+    }
+    link->reports++;
+    link->last_report_us = timestamp_us;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+void hid_link_stats_record_rssi(uint8_t slot, int8_t rssi)
+{
+    if (slot >= HID_LINK_STATS_MAX_DEVICES) {
+        return;
+    }
+
+    portENTER_CRITICAL(&stats_lock);
+    hid_link_stats_t *link = &links[slot];
+    if (!link->rssi_valid || rssi < link->rssi_min) {
+        link->rssi_min = rssi;
+    }
+    link->rssi = rssi;
+    link->rssi_valid = true;
+    link->rssi_samples++;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+void hid_link_stats_record_conn_params(uint8_t slot, uint32_t interval_us, uint16_t latency)
+{
+    if (slot >= HID_LINK_STATS_MAX_DEVICES) {
+        return;
+    }
+
+    portENTER_CRITICAL(&stats_lock);
+    links[slot].conn_interval_us = interval_us;
+    links[slot].conn_latency = latency;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+esp_err_t hid_link_stats_set_gap_threshold(uint8_t intervals)
+{
+    if (intervals < 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    gap_intervals = intervals;
+    return ESP_OK;
+}
+
+esp_err_t hid_link_stats_get(uint8_t slot, hid_link_stats_t *stats)
+{
+    if (slot >= HID_LINK_STATS_MAX_DEVICES || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&stats_lock);
+    *stats = links[slot];
+    portEXIT_CRITICAL(&stats_lock);
+    return ESP_OK;
+}
+
+esp_err_t hid_link_stats_get_counters(hid_link_counters_t *out)
+{
+    if (!out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&stats_lock);
+    *out = counters;
+    portEXIT_CRITICAL(&stats_lock);
+    return ESP_OK;
+}
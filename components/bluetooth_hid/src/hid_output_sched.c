@@ -0,0 +1,349 @@
+/**
+ * @file hid_output_sched.c
+ * @brief 输出报告调度器实现
+ */
+
+#include "hid_output_sched.h"
+#include "bluetooth_hid.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char *TAG = "HID_OUTPUT";
+
+#ifndef CONFIG_BLUETOOTH_HID_OUTPUT_BUDGET
+#define CONFIG_BLUETOOTH_HID_OUTPUT_BUDGET       1
+#endif
+#ifndef CONFIG_BLUETOOTH_HID_OUTPUT_WINDOW_MS
+#define CONFIG_BLUETOOTH_HID_OUTPUT_WINDOW_MS    10
+#endif
+
+// 调度任务：发送可能在传输后端中阻塞，优先级低于输入处理
+#define OUTPUT_TASK_STACK_SIZE      3072
+#define OUTPUT_TASK_PRIORITY        8
+
+/**
+ * @brief 一个报告ID的待发报告和上次发出的内容
+ */
+typedef struct {
+    bool used;
+    bool pending;
+    bool sent_valid;             ///< last_sent有效，可用于去重
+    uint8_t report_id;
+    uint16_t len;
+    uint16_t sent_len;
+    uint8_t data[HID_OUTPUT_MAX_LEN];
+    uint8_t last_sent[HID_OUTPUT_MAX_LEN];
+} output_entry_t;
+
+/**
+ * @brief 每个设备的调度状态
+ */
+typedef struct {
+    output_entry_t entries[HID_OUTPUT_MAX_REPORT_IDS];
+    int64_t credit_us;           ///< 发送额度，每发一个报告消耗一个间隔，上限为一个窗口
+    int64_t refill_us;           ///< 上次补充额度的时间
+    uint8_t next_entry;          ///< 轮询起点，避免某个报告ID独占额度
+} output_device_t;
+
+static output_device_t devices[BLUETOOTH_HID_MAX_DEVICES];
+static portMUX_TYPE sched_lock = portMUX_INITIALIZER_UNLOCKED;
+static hid_output_send_fn_t send_fn = NULL;
+static hid_output_stats_t stats;
+static TaskHandle_t sched_task_handle = NULL;
+static volatile bool running = false;
+
+static uint32_t window_us = CONFIG_BLUETOOTH_HID_OUTPUT_WINDOW_MS * 1000;
+static uint32_t send_cost_us = CONFIG_BLUETOOTH_HID_OUTPUT_WINDOW_MS * 1000 / CONFIG_BLUETOOTH_HID_OUTPUT_BUDGET;
+
+/**
+ * @brief 按经过的时间补充发送额度（需持有sched_lock）
+ */
+static void refill_credit(output_device_t *dev, int64_t now)
+{
+    dev->credit_us += now - dev->refill_us;
+    dev->refill_us = now;
+    if (dev->credit_us > window_us) {
+        dev->credit_us = window_us;
+    }
+}
+
+/**
+ * @brief 取出设备下一个可发送的报告（需持有sched_lock）
+ * @return 有报告可发送时返回true，并拷贝到输出参数
+ */
+static bool take_next(output_device_t *dev, uint8_t *report_id, uint8_t *data, uint16_t *len)
+{
+    if (dev->credit_us < send_cost_us) {
+        return false;
+    }
+
+    for (int n = 0; n < HID_OUTPUT_MAX_REPORT_IDS; n++) {
+        int i = (dev->next_entry + n) % HID_OUTPUT_MAX_REPORT_IDS;
+        output_entry_t *e = &dev->entries[i];
+        if (!e->pending) {
+            continue;
+        }
+
+        *report_id = e->report_id;
+        *len = e->len;
+        memcpy(data, e->data, e->len);
+        memcpy(e->last_sent, e->data, e->len);
+        e->sent_len = e->len;
+        e->sent_valid = true;
+        e->pending = false;
+        dev->credit_us -= send_cost_us;
+        dev->next_entry = (uint8_t)((i + 1) % HID_OUTPUT_MAX_REPORT_IDS);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 发送失败后重新挂起发出的内容，除非期间已有更新的报告
+ *
+ * take_next已把报告记为已发出，不处理的话失败的报告（如停止震动的(0,0)）不会重发，
+ * 之后提交的相同内容也会被去重丢弃。
+ */
+static void requeue_failed(uint8_t slot, uint8_t report_id)
+{
+    portENTER_CRITICAL(&sched_lock);
+    for (int i = 0; i < HID_OUTPUT_MAX_REPORT_IDS; i++) {
+        output_entry_t *e = &devices[slot].entries[i];
+        if (!e->used || e->report_id != report_id) {
+            continue;
+        }
+        if (!e->pending && e->sent_valid) {
+            memcpy(e->data, e->last_sent, e->sent_len);
+            e->len = e->sent_len;
+            e->pending = true;
+        }
+        e->sent_valid = false;
+    }
+    stats.failed++;
+    portEXIT_CRITICAL(&sched_lock);
+}
+
+/**
+ * @brief 调度任务：按额度发送各设备的待发报告，额度不足时睡到额度够用为止
+ */
+static void output_sched_task(void *arg)
+{
+    uint8_t data[HID_OUTPUT_MAX_LEN];
+
+    while (running) {
+        TickType_t wait = portMAX_DELAY;
+
+        for (uint8_t slot = 0; slot < BLUETOOTH_HID_MAX_DEVICES && running; slot++) {
+            output_device_t *dev = &devices[slot];
+            uint8_t report_id;
+            uint16_t len;
+
+            while (running) {
+                portENTER_CRITICAL(&sched_lock);
+                refill_credit(dev, esp_timer_get_time());
+                bool ready = take_next(dev, &report_id, data, &len);
+                int64_t shortfall = 0;
+                if (!ready) {
+                    for (int i = 0; i < HID_OUTPUT_MAX_REPORT_IDS; i++) {
+                        if (dev->entries[i].pending) {
+                            shortfall = send_cost_us - dev->credit_us;
+                            break;
+                        }
+                    }
+                }
+                portEXIT_CRITICAL(&sched_lock);
+
+                if (!ready) {
+                    if (shortfall > 0) {
+                        TickType_t ticks = pdMS_TO_TICKS((shortfall + 999) / 1000);
+                        if (ticks == 0) {
+                            ticks = 1;
+                        }
+                        if (ticks < wait) {
+                            wait = ticks;
+                        }
+                    }
+                    break;
+                }
+
+                esp_err_t ret = send_fn(slot, report_id, data, len);
+                if (ret != ESP_OK) {
+                    ESP_LOGW(TAG, "Output report 0x%02x to slot %d failed: %s",
+                             report_id, slot, esp_err_to_name(ret));
+                    requeue_failed(slot, report_id);
+                } else {
+                    portENTER_CRITICAL(&sched_lock);
+                    stats.sent++;
+                    portEXIT_CRITICAL(&sched_lock);
+                }
+            }
+        }
+
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+
+    sched_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t hid_output_sched_init(hid_output_send_fn_t send)
+{
+    if (!send) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (running) {
+        return ESP_OK;
+    }
+
+    send_fn = send;
+    memset(devices, 0, sizeof(devices));
+    memset(&stats, 0, sizeof(stats));
+
+    running = true;
+    BaseType_t ret = xTaskCreate(output_sched_task, "hid_output", OUTPUT_TASK_STACK_SIZE,
+                                 NULL, OUTPUT_TASK_PRIORITY, &sched_task_handle);
+    if (ret != pdPASS) {
+        running = false;
+        ESP_LOGE(TAG, "Failed to create output scheduler task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Output scheduler: %lu report(s) per %lu us window per device",
+             (unsigned long)(window_us / send_cost_us), (unsigned long)window_us);
+    return ESP_OK;
+}
+
+esp_err_t hid_output_sched_deinit(void)
+{
+    if (!running) {
+        return ESP_OK;
+    }
+
+    running = false;
+    TaskHandle_t task = sched_task_handle;
+    if (task) {
+        xTaskNotifyGive(task);
+    }
+    while (sched_task_handle != NULL) {
+        vTaskDelay(1);
+    }
+    return ESP_OK;
+}
+
+esp_err_t hid_output_sched_submit(uint8_t slot, uint8_t report_id, const uint8_t *data, uint16_t len)
+{
+    if (slot >= BLUETOOTH_HID_MAX_DEVICES || !data) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len > HID_OUTPUT_MAX_LEN) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (!running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    output_device_t *dev = &devices[slot];
+    bool wake = false;
+    esp_err_t ret = ESP_OK;
+
+    portENTER_CRITICAL(&sched_lock);
+    stats.submitted++;
+
+    output_entry_t *entry = NULL;
+    output_entry_t *free_entry = NULL;
+    for (int i = 0; i < HID_OUTPUT_MAX_REPORT_IDS; i++) {
+        output_entry_t *e = &dev->entries[i];
+        if (e->used && e->report_id == report_id) {
+            entry = e;
+            break;
+        }
+        if (!e->used && free_entry == NULL) {
+            free_entry = e;
+        }
+    }
+
+    if (entry == NULL && free_entry == NULL) {
+        ret = ESP_ERR_NO_MEM;
+    } else if (entry == NULL) {
+        // 新的报告ID
+        entry = free_entry;
+        memset(entry, 0, sizeof(*entry));
+        entry->used = true;
+        entry->report_id = report_id;
+    }
+
+    if (entry != NULL) {
+        bool same_as_sent = entry->sent_valid && entry->sent_len == len &&
+                            memcmp(entry->last_sent, data, len) == 0;
+        if (entry->pending) {
+            // 最新的生效：覆盖尚未发出的报告；若又变回已发出的内容则整体撤销
+            stats.coalesced++;
+            if (same_as_sent) {
+                entry->pending = false;
+            } else {
+                memcpy(entry->data, data, len);
+                entry->len = len;
+            }
+        } else if (same_as_sent) {
+            stats.suppressed++;
+        } else {
+            memcpy(entry->data, data, len);
+            entry->len = len;
+            entry->pending = true;
+            wake = true;
+        }
+    }
+    portEXIT_CRITICAL(&sched_lock);
+
+    if (wake && sched_task_handle) {
+        xTaskNotifyGive(sched_task_handle);
+    }
+    return ret;
+}
+
+void hid_output_sched_reset_slot(uint8_t slot)
+{
+    if (slot >= BLUETOOTH_HID_MAX_DEVICES) {
+        return;
+    }
+
+    portENTER_CRITICAL(&sched_lock);
+    memset(devices[slot].entries, 0, sizeof(devices[slot].entries));
+    devices[slot].credit_us = window_us;
+    devices[slot].refill_us = esp_timer_get_time();
+    devices[slot].next_entry = 0;
+    portEXIT_CRITICAL(&sched_lock);
+}
+
+esp_err_t hid_output_sched_set_budget(uint8_t reports_per_window, uint32_t window)
+{
+    // 每个报告至少消耗1us额度，否则额度检查失效
+    if (reports_per_window == 0 || window < reports_per_window) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&sched_lock);
+    window_us = window;
+    send_cost_us = window / reports_per_window;
+    portEXIT_CRITICAL(&sched_lock);
+
+    if (sched_task_handle) {
+        xTaskNotifyGive(sched_task_handle);
+    }
+    return ESP_OK;
+}
+
+esp_err_t hid_output_sched_get_stats(hid_output_stats_t *out)
+{
+    if (!out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&sched_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&sched_lock);
+    return ESP_OK;
+}
@@ -0,0 +1,495 @@
+/**
+ * @file hid_reconnect.c
+ * @brief 手柄自动重连状态机实现
+ */
+
+#include "hid_reconnect.h"
+#include "bluetooth_hid.h"
+#include "hid_bond_cache.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+static const char *TAG = "HID_RECONNECT";
+
+#ifndef CONFIG_BLUETOOTH_HID_RECONNECT_PAGE_TIMEOUT_MS
+#define CONFIG_BLUETOOTH_HID_RECONNECT_PAGE_TIMEOUT_MS   2560
+#endif
+#ifndef CONFIG_BLUETOOTH_HID_RECONNECT_PAGE_SCAN_MS
+#define CONFIG_BLUETOOTH_HID_RECONNECT_PAGE_SCAN_MS      10000
+#endif
+#ifndef CONFIG_BLUETOOTH_HID_RECONNECT_BACKOFF_MS
+#define CONFIG_BLUETOOTH_HID_RECONNECT_BACKOFF_MS        2000
+#endif
+#ifndef CONFIG_BLUETOOTH_HID_RECONNECT_BACKOFF_MAX_MS
+#define CONFIG_BLUETOOTH_HID_RECONNECT_BACKOFF_MAX_MS    60000
+#endif
+
+// 寻呼结果迟迟不来时的保护时间（超出寻呼超时的部分）
+#define PAGE_GUARD_MS           1000
+
+/**
+ * @brief 待重连设备
+ */
+typedef struct {
+    esp_bd_addr_t bda;
+    int64_t lost_us;             ///< 断开时间（上电连接为开始时间）
+    bool lost;                   ///< true为意外断开的设备，false为上电时的绑定设备
+} reconnect_target_t;
+
+static reconnect_target_t targets[HID_RECONNECT_MAX_TARGETS];
+static size_t target_count = 0;
+static size_t page_index = 0;
+static hid_reconnect_state_t state = HID_RECONNECT_IDLE;
+static uint8_t attempt = 0;
+static hid_reconnect_stats_t stats;
+static uint64_t reconnect_ms_total = 0;
+static esp_timer_handle_t phase_timer = NULL;
+static portMUX_TYPE reconnect_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static hid_reconnect_config_t config = {
+    .page_timeout_ms = CONFIG_BLUETOOTH_HID_RECONNECT_PAGE_TIMEOUT_MS,
+    .page_scan_ms = CONFIG_BLUETOOTH_HID_RECONNECT_PAGE_SCAN_MS,
+    .inquiry_sec = 30,
+    .backoff_initial_ms = CONFIG_BLUETOOTH_HID_RECONNECT_BACKOFF_MS,
+    .backoff_max_ms = CONFIG_BLUETOOTH_HID_RECONNECT_BACKOFF_MAX_MS,
+    .max_attempts = 5,
+};
+
+static const char *state_names[] = {
+    "idle", "paging", "page scan", "inquiry", "backoff", "gave up"
+};
+
+static void page_next(void);
+
+/**
+ * @brief 切换状态（需持有reconnect_lock）
+ */
+static inline void set_state(hid_reconnect_state_t next)
+{
+    state = next;
+    stats.state = next;
+    stats.attempt = attempt;
+}
+
+static inline bool is_active(hid_reconnect_state_t s)
+{
+    return s != HID_RECONNECT_IDLE && s != HID_RECONNECT_GAVE_UP;
+}
+
+static void arm_timer(uint32_t ms)
+{
+    if (phase_timer) {
+        esp_timer_stop(phase_timer);
+        esp_timer_start_once(phase_timer, (uint64_t)ms * 1000);
+    }
+}
+
+static void disarm_timer(void)
+{
+    if (phase_timer) {
+        esp_timer_stop(phase_timer);
+    }
+}
+
+/**
+ * @brief 开始新的一轮：从第一个待重连设备寻呼
+ */
+static void start_round(void)
+{
+    portENTER_CRITICAL(&reconnect_lock);
+    page_index = 0;
+    set_state(HID_RECONNECT_PAGING);
+    portEXIT_CRITICAL(&reconnect_lock);
+
+    ESP_LOGI(TAG, "Reconnect round %d", attempt + 1);
+    page_next();
+}
+
+/**
+ * @brief 页扫描：只保持可连接，让手柄自己回连
+ */
+static void enter_page_scan(void)
+{
+    portENTER_CRITICAL(&reconnect_lock);
+    set_state(HID_RECONNECT_PAGE_SCAN);
+    uint32_t window_ms = config.page_scan_ms;
+    portEXIT_CRITICAL(&reconnect_lock);
+
+    if (window_ms == 0) {
+        // 跳过页扫描，定时器立即转入查询
+        arm_timer(0);
+        return;
+    }
+
+    // 关闭查询扫描，射频时间全部留给页扫描
+    bluetooth_hid_set_discoverable(false, true);
+    arm_timer(window_ms);
+}
+
+/**
+ * @brief 查询扫描，结果在hid_reconnect_on_scan_stopped中返回
+ */
+static void enter_inquiry(void)
+{
+    portENTER_CRITICAL(&reconnect_lock);
+    set_state(HID_RECONNECT_INQUIRY);
+    uint32_t duration = config.inquiry_sec;
+    portEXIT_CRITICAL(&reconnect_lock);
+
+    bluetooth_hid_set_discoverable(true, true);
+    esp_err_t ret = bluetooth_hid_start_scan(duration);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Inquiry failed to start: %s", esp_err_to_name(ret));
+        hid_reconnect_on_scan_stopped(false);
+    }
+}
+
+/**
+ * @brief 本轮结束仍有设备未连上：退避后开始下一轮，或达到上限后放弃
+ */
+static void end_round(void)
+{
+    portENTER_CRITICAL(&reconnect_lock);
+    if (state != HID_RECONNECT_INQUIRY) {
+        portEXIT_CRITICAL(&reconnect_lock);
+        return;
+    }
+
+    attempt++;
+    if (config.max_attempts > 0 && attempt >= config.max_attempts) {
+        stats.give_ups++;
+        set_state(HID_RECONNECT_GAVE_UP);
+        portEXIT_CRITICAL(&reconnect_lock);
+        ESP_LOGW(TAG, "Giving up after %d rounds, still accepting incoming connections", attempt);
+        return;
+    }
+
+    uint32_t shift = attempt - 1 < 16 ? attempt - 1 : 16;
+    uint64_t delay_ms = (uint64_t)config.backoff_initial_ms << shift;
+    if (delay_ms > config.backoff_max_ms) {
+        delay_ms = config.backoff_max_ms;
+    }
+    set_state(HID_RECONNECT_BACKOFF);
+    portEXIT_CRITICAL(&reconnect_lock);
+
+    ESP_LOGI(TAG, "Round %d failed, retrying in %lu ms", attempt, (unsigned long)delay_ms);
+    arm_timer((uint32_t)delay_ms);
+}
+
+/**
+ * @brief 所有待重连设备都已连上
+ */
+static void finish(void)
+{
+    portENTER_CRITICAL(&reconnect_lock);
+    bool was_active = is_active(state);
+    target_count = 0;
+    attempt = 0;
+    set_state(HID_RECONNECT_IDLE);
+    portEXIT_CRITICAL(&reconnect_lock);
+
+    disarm_timer();
+    if (was_active) {
+        bluetooth_hid_set_discoverable(true, true);
+    }
+}
+
+/**
+ * @brief 寻呼下一个待重连设备，全部寻呼过后转入页扫描（没有待重连设备时直接查询）
+ */
+static void page_next(void)
+{
+    for (;;) {
+        esp_bd_addr_t bda;
+
+        portENTER_CRITICAL(&reconnect_lock);
+        if (state != HID_RECONNECT_PAGING) {
+            portEXIT_CRITICAL(&reconnect_lock);
+            return;
+        }
+        if (page_index >= target_count) {
+            portEXIT_CRITICAL(&reconnect_lock);
+            break;
+        }
+        memcpy(bda, targets[page_index++].bda, sizeof(esp_bd_addr_t));
+        uint32_t guard_ms = config.page_timeout_ms + PAGE_GUARD_MS;
+        portEXIT_CRITICAL(&reconnect_lock);
+
+        // 已连接或正在连接的设备返回错误，直接跳过
+        if (bluetooth_hid_connect(bda) == ESP_OK) {
+            arm_timer(guard_ms);
+            return;
+        }
+    }
+
+    // 没有绑定设备时不会有手柄主动回连，直接查询
+    portENTER_CRITICAL(&reconnect_lock);
+    bool have_targets = target_count > 0;
+    portEXIT_CRITICAL(&reconnect_lock);
+    if (have_targets) {
+        enter_page_scan();
+    } else {
+        enter_inquiry();
+    }
+}
+
+/**
+ * @brief 阶段定时器：寻呼保护超时、页扫描窗口结束或退避结束
+ */
+static void phase_timer_callback(void *arg)
+{
+    portENTER_CRITICAL(&reconnect_lock);
+    hid_reconnect_state_t s = state;
+    portEXIT_CRITICAL(&reconnect_lock);
+
+    switch (s) {
+    case HID_RECONNECT_PAGING:
+        ESP_LOGW(TAG, "Page result overdue, moving on");
+        page_next();
+        break;
+    case HID_RECONNECT_PAGE_SCAN:
+        enter_inquiry();
+        break;
+    case HID_RECONNECT_BACKOFF:
+        start_round();
+        break;
+    default:
+        break;
+    }
+}
+
+esp_err_t hid_reconnect_init(void)
+{
+    if (phase_timer) {
+        return ESP_OK;
+    }
+
+    esp_timer_create_args_t timer_args = {
+        .callback = phase_timer_callback,
+        .arg = NULL,
+        .name = "hid_reconnect"
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &phase_timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create reconnect timer: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    portENTER_CRITICAL(&reconnect_lock);
+    target_count = 0;
+    attempt = 0;
+    set_state(HID_RECONNECT_IDLE);
+    portEXIT_CRITICAL(&reconnect_lock);
+
+    bluetooth_hid_set_page_timeout(config.page_timeout_ms);
+    return ESP_OK;
+}
+
+void hid_reconnect_deinit(void)
+{
+    portENTER_CRITICAL(&reconnect_lock);
+    target_count = 0;
+    set_state(HID_RECONNECT_IDLE);
+    portEXIT_CRITICAL(&reconnect_lock);
+
+    if (phase_timer) {
+        esp_timer_stop(phase_timer);
+        esp_timer_delete(phase_timer);
+        phase_timer = NULL;
+    }
+}
+
+esp_err_t hid_reconnect_set_config(const hid_reconnect_config_t *new_config)
+{
+    if (!new_config || new_config->page_timeout_ms == 0 || new_config->inquiry_sec == 0 ||
+        new_config->backoff_initial_ms == 0 || new_config->backoff_max_ms < new_config->backoff_initial_ms) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&reconnect_lock);
+    config = *new_config;
+    portEXIT_CRITICAL(&reconnect_lock);
+
+    if (phase_timer) {
+        bluetooth_hid_set_page_timeout(new_config->page_timeout_ms);
+    }
+    ESP_LOGI(TAG, "Reconnect: page %lu ms, page scan %lu ms, inquiry %lu s, backoff %lu-%lu ms, %d rounds",
+             (unsigned long)new_config->page_timeout_ms, (unsigned long)new_config->page_scan_ms,
+             (unsigned long)new_config->inquiry_sec, (unsigned long)new_config->backoff_initial_ms,
+             (unsigned long)new_config->backoff_max_ms, new_config->max_attempts);
+    return ESP_OK;
+}
+
+void hid_reconnect_get_config(hid_reconnect_config_t *out)
+{
+    portENTER_CRITICAL(&reconnect_lock);
+    *out = config;
+    portEXIT_CRITICAL(&reconnect_lock);
+}
+
+esp_err_t hid_reconnect_start(void)
+{
+    hid_bond_entry_t bonds[HID_BOND_CACHE_MAX_ENTRIES];
+    size_t bond_count = hid_bond_cache_list(bonds, HID_BOND_CACHE_MAX_ENTRIES);
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&reconnect_lock);
+    if (is_active(state)) {
+        portEXIT_CRITICAL(&reconnect_lock);
+        return ESP_OK;
+    }
+
+    // 绑定缓存已按最近使用排序
+    target_count = 0;
+    for (size_t i = 0; i < bond_count && target_count < HID_RECONNECT_MAX_TARGETS; i++) {
+        reconnect_target_t *t = &targets[target_count++];
+        memcpy(t->bda, bonds[i].bda, sizeof(esp_bd_addr_t));
+        t->lost_us = now;
+        t->lost = false;
+    }
+    attempt = 0;
+    set_state(HID_RECONNECT_PAGING);
+    portEXIT_CRITICAL(&reconnect_lock);
+
+    ESP_LOGI(TAG, "Connecting: %d bonded device(s) to page", (int)bond_count);
+    start_round();
+    return ESP_OK;
+}
+
+void hid_reconnect_stop(void)
+{
+    finish();
+}
+
+esp_err_t hid_reconnect_get_stats(hid_reconnect_stats_t *out)
+{
+    if (!out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&reconnect_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&reconnect_lock);
+    return ESP_OK;
+}
+
+void hid_reconnect_on_open(const uint8_t *bda, bool success)
+{
+    int64_t now = esp_timer_get_time();
+    bool measured = false;
+    bool lost = false;
+    uint32_t elapsed_ms = 0;
+    bool done = false;
+
+    portENTER_CRITICAL(&reconnect_lock);
+    hid_reconnect_state_t s = state;
+
+    if (success && bda) {
+        for (size_t i = 0; i < target_count; i++) {
+            if (memcmp(targets[i].bda, bda, sizeof(esp_bd_addr_t)) == 0) {
+                elapsed_ms = (uint32_t)((now - targets[i].lost_us) / 1000);
+                lost = targets[i].lost;
+                measured = true;
+                memmove(&targets[i], &targets[i + 1], (target_count - i - 1) * sizeof(targets[0]));
+                target_count--;
+                if (page_index > i) {
+                    page_index--;
+                }
+                break;
+            }
+        }
+
+        if (measured && lost) {
+            stats.reconnects++;
+            stats.last_reconnect_ms = elapsed_ms;
+            if (elapsed_ms > stats.max_reconnect_ms) {
+                stats.max_reconnect_ms = elapsed_ms;
+            }
+            reconnect_ms_total += elapsed_ms;
+            stats.avg_reconnect_ms = (uint32_t)(reconnect_ms_total / stats.reconnects);
+        }
+
+        // 上电连接：任一设备连上后不再寻找其余绑定设备
+        size_t kept = 0;
+        for (size_t i = 0; i < target_count; i++) {
+            if (targets[i].lost) {
+                targets[kept++] = targets[i];
+            }
+        }
+        target_count = kept;
+        page_index = page_index < kept ? page_index : kept;
+        done = target_count == 0 && s != HID_RECONNECT_IDLE;
+    }
+    portEXIT_CRITICAL(&reconnect_lock);
+
+    if (measured) {
+        ESP_LOGI(TAG, "Device %s %lu ms after %s (%s)", lost ? "reconnected" : "connected",
+                 (unsigned long)elapsed_ms, lost ? "disconnect" : "start", state_names[s]);
+    }
+
+    if (done) {
+        finish();
+        return;
+    }
+
+    // 本轮还有事要做：继续寻呼，或查询选中的设备没连上
+    if (s == HID_RECONNECT_PAGING) {
+        page_next();
+    } else if (s == HID_RECONNECT_INQUIRY) {
+        end_round();
+    }
+}
+
+void hid_reconnect_on_close(const uint8_t *bda, bool unexpected)
+{
+    if (!unexpected || !bda) {
+        return;
+    }
+
+    portENTER_CRITICAL(&reconnect_lock);
+    // 最近断开的设备排在最前，列表满时丢弃最早的
+    size_t i;
+    for (i = 0; i < target_count; i++) {
+        if (memcmp(targets[i].bda, bda, sizeof(esp_bd_addr_t)) == 0) {
+            break;
+        }
+    }
+    if (i == target_count && target_count < HID_RECONNECT_MAX_TARGETS) {
+        target_count++;
+    } else if (i == target_count) {
+        i = target_count - 1;
+    }
+    memmove(&targets[1], &targets[0], i * sizeof(targets[0]));
+    memcpy(targets[0].bda, bda, sizeof(esp_bd_addr_t));
+    targets[0].lost_us = esp_timer_get_time();
+    targets[0].lost = true;
+
+    bool start = !is_active(state);
+    if (start) {
+        attempt = 0;
+        set_state(HID_RECONNECT_PAGING);
+    } else if (state == HID_RECONNECT_PAGING && page_index <= i) {
+        // 前移的条目之后的位置整体后移一位，保持寻呼进度
+        page_index++;
+    }
+    portEXIT_CRITICAL(&reconnect_lock);
+
+    if (start) {
+        ESP_LOGI(TAG, "Device lost, starting reconnect");
+        start_round();
+    }
+}
+
+void hid_reconnect_on_scan_stopped(bool connecting)
+{
+    portENTER_CRITICAL(&reconnect_lock);
+    hid_reconnect_state_t s = state;
+    portEXIT_CRITICAL(&reconnect_lock);
+
+    // 选中了设备时等连接结果再决定
+    if (s == HID_RECONNECT_INQUIRY && !connecting) {
+        end_round();
+    }
+}
@@ -0,0 +1,742 @@
+/**
+ * @file hid_report_parser.c
+ * @brief HID报告描述符解析与字段提取实现
+ */
+
+#include "hid_report_parser.h"
+#include "esp_log.h"
+#include <string.h>
+#include <ctype.h>
+
+static const char *TAG = "HID_PARSER";
+
+// 描述符条目类型
+#define ITEM_TYPE_MAIN                  0
+#define ITEM_TYPE_GLOBAL                1
+#define ITEM_TYPE_LOCAL                 2
+#define ITEM_LONG_PREFIX                0xFE
+
+// 主条目标签
+#define MAIN_INPUT                      0x8
+#define MAIN_OUTPUT                     0x9
+#define MAIN_COLLECTION                 0xA
+#define MAIN_FEATURE                    0xB
+#define MAIN_END_COLLECTION             0xC
+
+// 全局条目标签
+#define GLOBAL_USAGE_PAGE               0x0
+#define GLOBAL_LOGICAL_MIN              0x1
+#define GLOBAL_LOGICAL_MAX              0x2
+#define GLOBAL_REPORT_SIZE              0x7
+#define GLOBAL_REPORT_ID                0x8
+#define GLOBAL_REPORT_COUNT             0x9
+#define GLOBAL_PUSH                     0xA
+#define GLOBAL_POP                      0xB
+
+// 局部条目标签
+#define LOCAL_USAGE                     0x0
+#define LOCAL_USAGE_MIN                 0x1
+#define LOCAL_USAGE_MAX                 0x2
+
+// Input条目标志位
+#define INPUT_FLAG_CONSTANT             0x01
+#define INPUT_FLAG_VARIABLE             0x02
+
+// 用途页
+#define USAGE_PAGE_GENERIC_DESKTOP      0x01
+#define USAGE_PAGE_SIMULATION           0x02
+#define USAGE_PAGE_BUTTON               0x09
+
+// Generic Desktop用途
+#define USAGE_X                         0x30
+#define USAGE_Y                         0x31
+#define USAGE_Z                         0x32
+#define USAGE_RX                        0x33
+#define USAGE_RY                        0x34
+#define USAGE_RZ                        0x35
+#define USAGE_HAT_SWITCH                0x39
+
+// Simulation用途
+#define USAGE_ACCELERATOR               0xC4
+#define USAGE_BRAKE                     0xC5
+
+// 解析器限制
+#define MAX_LOCAL_USAGES                16
+#define MAX_GLOBAL_STACK                4
+#define MAX_REPORT_IDS                  8
+#define MAX_FIELD_BITS                  24
+
+// 方向键帽数值(0-7，从正上方顺时针)到方向按键位图的转换表，第9项为中立
+#define DPAD_BIT(b) (1u << HID_GAMEPAD_BUTTON_DPAD_##b)
+static const uint32_t hat_to_dpad[9] = {
+    DPAD_BIT(UP),
+    DPAD_BIT(UP) | DPAD_BIT(RIGHT),
+    DPAD_BIT(RIGHT),
+    DPAD_BIT(DOWN) | DPAD_BIT(RIGHT),
+    DPAD_BIT(DOWN),
+    DPAD_BIT(DOWN) | DPAD_BIT(LEFT),
+    DPAD_BIT(LEFT),
+    DPAD_BIT(UP) | DPAD_BIT(LEFT),
+    0
+};
+
+/**
+ * @brief 全局条目状态
+ */
+typedef struct {
+    uint16_t usage_page;
+    int32_t logical_min;
+    int32_t logical_max;
+    bool logical_min_negative;
+    uint32_t report_size;
+    uint32_t report_count;
+    uint8_t report_id;
+} global_state_t;
+
+/**
+ * @brief 局部条目状态（每个主条目后清空）
+ */
+typedef struct {
+    uint32_t usages[MAX_LOCAL_USAGES];   ///< 高16位为用途页，0表示沿用全局用途页
+    uint8_t usage_count;
+    uint32_t usage_min;
+    uint32_t usage_max;
+    bool has_range;
+} local_state_t;
+
+/**
+ * @brief 每个报告ID的当前位偏移
+ */
+typedef struct {
+    uint8_t ids[MAX_REPORT_IDS];
+    uint32_t offsets[MAX_REPORT_IDS];
+    uint8_t count;
+} report_offsets_t;
+
+/* ==================== 内置参考描述符 ==================== */
+
+// 通用布局：16个按键 + 4个8位摇杆 + 2个8位扳机，与早期固定偏移解析一致
+static const uint8_t generic_report_desc[] = {
+    0x05, 0x01, 0x09, 0x05, 0xA1, 0x01,
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x10, 0x15, 0x00, 0x25, 0x01,
+    0x75, 0x01, 0x95, 0x10, 0x81, 0x02,
+    0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x09, 0x32, 0x09, 0x35,
+    0x15, 0x00, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x95, 0x04, 0x81, 0x02,
+    0x09, 0x33, 0x09, 0x34, 0x95, 0x02, 0x81, 0x02,
+    0xC0
+};
+
+// DualShock 4 蓝牙基础模式报告0x01
+static const uint8_t ps4_report_desc[] = {
+    0x05, 0x01, 0x09, 0x05, 0xA1, 0x01, 0x85, 0x01,
+    0x09, 0x30, 0x09, 0x31, 0x09, 0x32, 0x09, 0x35,
+    0x15, 0x00, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x95, 0x04, 0x81, 0x02,
+    0x09, 0x39, 0x15, 0x00, 0x25, 0x07, 0x35, 0x00, 0x46, 0x3B, 0x01,
+    0x65, 0x14, 0x75, 0x04, 0x95, 0x01, 0x81, 0x42, 0x65, 0x00,
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x0E, 0x15, 0x00, 0x25, 0x01,
+    0x75, 0x01, 0x95, 0x0E, 0x81, 0x02,
+    0x06, 0x00, 0xFF, 0x09, 0x20, 0x75, 0x06, 0x95, 0x01,
+    0x15, 0x00, 0x25, 0x7F, 0x81, 0x02,
+    0x05, 0x01, 0x09, 0x33, 0x09, 0x34, 0x15, 0x00, 0x26, 0xFF, 0x00,
+    0x75, 0x08, 0x95, 0x02, 0x81, 0x02,
+    0xC0
+};
+
+// Xbox One S / Series 蓝牙报告0x01：16位摇杆、10位扳机
+static const uint8_t xbox_report_desc[] = {
+    0x05, 0x01, 0x09, 0x05, 0xA1, 0x01, 0x85, 0x01,
+    0x09, 0x01, 0xA1, 0x00, 0x09, 0x30, 0x09, 0x31,
+    0x15, 0x00, 0x27, 0xFF, 0xFF, 0x00, 0x00, 0x95, 0x02, 0x75, 0x10, 0x81, 0x02, 0xC0,
+    0x09, 0x01, 0xA1, 0x00, 0x09, 0x32, 0x09, 0x35,
+    0x15, 0x00, 0x27, 0xFF, 0xFF, 0x00, 0x00, 0x95, 0x02, 0x75, 0x10, 0x81, 0x02, 0xC0,
+    0x05, 0x02, 0x09, 0xC5, 0x15, 0x00, 0x26, 0xFF, 0x03, 0x95, 0x01, 0x75, 0x0A, 0x81, 0x02,
+    0x15, 0x00, 0x25, 0x00, 0x75, 0x06, 0x95, 0x01, 0x81, 0x03,
+    0x05, 0x02, 0x09, 0xC4, 0x15, 0x00, 0x26, 0xFF, 0x03, 0x95, 0x01, 0x75, 0x0A, 0x81, 0x02,
+    0x15, 0x00, 0x25, 0x00, 0x75, 0x06, 0x95, 0x01, 0x81, 0x03,
+    0x05, 0x01, 0x09, 0x39, 0x15, 0x01, 0x25, 0x08, 0x35, 0x00, 0x46, 0x3B, 0x01,
+    0x66, 0x14, 0x00, 0x75, 0x04, 0x95, 0x01, 0x81, 0x42,
+    0x75, 0x04, 0x95, 0x01, 0x15, 0x00, 0x25, 0x00, 0x35, 0x00, 0x45, 0x00,
+    0x65, 0x00, 0x81, 0x03,
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x0F, 0x15, 0x00, 0x25, 0x01,
+    0x75, 0x01, 0x95, 0x0F, 0x81, 0x02,
+    0x15, 0x00, 0x25, 0x00, 0x75, 0x01, 0x95, 0x01, 0x81, 0x03,
+    0xC0
+};
+
+// 北通（DirectInput模式）：4个8位摇杆 + 方向键帽 + 12个按键 + 模拟扳机
+static const uint8_t beitong_report_desc[] = {
+    0x05, 0x01, 0x09, 0x05, 0xA1, 0x01,
+    0x09, 0x30, 0x09, 0x31, 0x09, 0x32, 0x09, 0x35,
+    0x15, 0x00, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x95, 0x04, 0x81, 0x02,
+    0x09, 0x39, 0x15, 0x00, 0x25, 0x07, 0x75, 0x04, 0x95, 0x01, 0x81, 0x42,
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x0C, 0x15, 0x00, 0x25, 0x01,
+    0x75, 0x01, 0x95, 0x0C, 0x81, 0x02,
+    0x05, 0x02, 0x09, 0xC5, 0x09, 0xC4, 0x15, 0x00, 0x26, 0xFF, 0x00,
+    0x75, 0x08, 0x95, 0x02, 0x81, 0x02,
+    0xC0
+};
+
+/* ==================== 按键映射表 ==================== */
+
+#define BTN(name) HID_GAMEPAD_BUTTON_##name
+#define NONE      HID_BUTTON_UNMAPPED
+
+static const uint8_t generic_button_map[] = {
+    BTN(A), BTN(B), BTN(X), BTN(Y), BTN(L1), BTN(R1), BTN(SELECT), BTN(START)
+};
+
+// DS4: 方块、叉、圆、三角、L1、R1、L2、R2、Share、Options、L3、R3、PS、触摸板
+static const uint8_t ps4_button_map[] = {
+    BTN(X), BTN(A), BTN(B), BTN(Y), BTN(L1), BTN(R1), BTN(L2), BTN(R2),
+    BTN(SELECT), BTN(START), NONE, NONE, BTN(HOME), NONE
+};
+
+// Xbox蓝牙: A、B、保留、X、Y、保留、LB、RB、保留、保留、View、Menu、Xbox、LS、RS
+static const uint8_t xbox_button_map[] = {
+    BTN(A), BTN(B), NONE, BTN(X), BTN(Y), NONE, BTN(L1), BTN(R1),
+    NONE, NONE, BTN(SELECT), BTN(START), BTN(HOME), NONE, NONE
+};
+
+static const uint8_t beitong_button_map[] = {
+    BTN(A), BTN(B), BTN(X), BTN(Y), BTN(L1), BTN(R1), BTN(L2), BTN(R2),
+    BTN(SELECT), BTN(START), NONE, NONE
+};
+
+#undef BTN
+#undef NONE
+
+/**
+ * @brief 内置手柄描述表
+ */
+typedef struct {
+    const uint8_t *desc;
+    size_t desc_len;
+    const uint8_t *button_map;
+    size_t button_map_len;
+    uint8_t base_report_id;      ///< 扩展报告对应的基础报告ID
+    uint8_t ext_report_id;       ///< 扩展报告ID，0表示没有
+    uint8_t ext_header_bytes;    ///< 扩展报告在完整布局之前的字节数
+} builtin_profile_t;
+
+// DS4蓝牙报告0x11：2字节头之后与报告0x01的完整布局相同
+#define DS4_REPORT_BASIC        0x01
+#define DS4_REPORT_BT           0x11
+#define DS4_BT_HEADER_LEN       2
+
+static const builtin_profile_t builtin_profiles[HID_CONTROLLER_TYPE_MAX] = {
+    [HID_CONTROLLER_GENERIC] = { generic_report_desc, sizeof(generic_report_desc),
+                                 generic_button_map, sizeof(generic_button_map) },
+    [HID_CONTROLLER_PS4]     = { ps4_report_desc, sizeof(ps4_report_desc),
+                                 ps4_button_map, sizeof(ps4_button_map),
+                                 DS4_REPORT_BASIC, DS4_REPORT_BT, DS4_BT_HEADER_LEN },
+    [HID_CONTROLLER_XBOX]    = { xbox_report_desc, sizeof(xbox_report_desc),
+                                 xbox_button_map, sizeof(xbox_button_map) },
+    [HID_CONTROLLER_BEITONG] = { beitong_report_desc, sizeof(beitong_report_desc),
+                                 beitong_button_map, sizeof(beitong_button_map) },
+};
+
+/* ==================== 描述符编译 ==================== */
+
+/**
+ * @brief 读取条目数据（小端，无符号）
+ */
+static uint32_t item_unsigned(const uint8_t *data, uint8_t size)
+{
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < size; i++) {
+        value |= (uint32_t)data[i] << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * @brief 读取条目数据（小端，有符号）
+ */
+static int32_t item_signed(const uint8_t *data, uint8_t size)
+{
+    uint32_t value = item_unsigned(data, size);
+    if (size == 1) return (int8_t)value;
+    if (size == 2) return (int16_t)value;
+    return (int32_t)value;
+}
+
+/**
+ * @brief 获取报告ID对应的位偏移槽
+ */
+static uint32_t *report_offset_slot(report_offsets_t *offsets, uint8_t report_id)
+{
+    for (uint8_t i = 0; i < offsets->count; i++) {
+        if (offsets->ids[i] == report_id) {
+            return &offsets->offsets[i];
+        }
+    }
+    if (offsets->count >= MAX_REPORT_IDS) {
+        return NULL;
+    }
+    offsets->ids[offsets->count] = report_id;
+    offsets->offsets[offsets->count] = 0;
+    return &offsets->offsets[offsets->count++];
+}
+
+/**
+ * @brief 把用途映射为提取字段类型和目标
+ * @return true 该用途是需要提取的手柄字段
+ */
+static bool classify_usage(uint32_t usage, const uint8_t *button_map, size_t button_map_len,
+                           uint8_t *kind, uint8_t *target)
+{
+    uint16_t page = usage >> 16;
+    uint16_t id = usage & 0xFFFF;
+
+    switch (page) {
+    case USAGE_PAGE_GENERIC_DESKTOP:
+        switch (id) {
+        case USAGE_X:  *kind = HID_FIELD_AXIS; *target = HID_GAMEPAD_AXIS_LX; return true;
+        case USAGE_Y:  *kind = HID_FIELD_AXIS; *target = HID_GAMEPAD_AXIS_LY; return true;
+        case USAGE_Z:  *kind = HID_FIELD_AXIS; *target = HID_GAMEPAD_AXIS_RX; return true;
+        case USAGE_RZ: *kind = HID_FIELD_AXIS; *target = HID_GAMEPAD_AXIS_RY; return true;
+        case USAGE_RX: *kind = HID_FIELD_TRIGGER; *target = HID_GAMEPAD_TRIGGER_LEFT; return true;
+        case USAGE_RY: *kind = HID_FIELD_TRIGGER; *target = HID_GAMEPAD_TRIGGER_RIGHT; return true;
+        case USAGE_HAT_SWITCH: *kind = HID_FIELD_HAT; *target = 0; return true;
+        default: return false;
+        }
+
+    case USAGE_PAGE_SIMULATION:
+        if (id == USAGE_BRAKE) {
+            *kind = HID_FIELD_TRIGGER; *target = HID_GAMEPAD_TRIGGER_LEFT; return true;
+        }
+        if (id == USAGE_ACCELERATOR) {
+            *kind = HID_FIELD_TRIGGER; *target = HID_GAMEPAD_TRIGGER_RIGHT; return true;
+        }
+        return false;
+
+    case USAGE_PAGE_BUTTON:
+        if (id == 0) {
+            return false;
+        }
+        if (button_map != NULL) {
+            if (id > button_map_len || button_map[id - 1] == HID_BUTTON_UNMAPPED) {
+                return false;
+            }
+            *target = button_map[id - 1];
+        } else {
+            if (id > HID_GAMEPAD_BUTTON_MAX) {
+                return false;
+            }
+            *target = id - 1;
+        }
+        *kind = HID_FIELD_BUTTON;
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief 计算字段的归一化参数
+ */
+static void setup_field_scale(hid_field_extractor_t *field)
+{
+    uint32_t range = (uint32_t)(field->logical_max - field->logical_min);
+
+    // 逻辑范围压缩到16位以内，保证乘法不溢出32位
+    field->pre_shift = 0;
+    while ((range >> field->pre_shift) > 0xFFFF) {
+        field->pre_shift++;
+    }
+    range >>= field->pre_shift;
+    if (range == 0) {
+        range = 1;
+    }
+
+    // (value - min) * scale 的最大值为0xFFFF0000，轴取高16位，扳机取高8位
+    field->scale = (uint32_t)(((uint64_t)0xFFFFu << 16) / range);
+}
+
+/**
+ * @brief 为一个Input主条目生成字段提取器
+ */
+static void compile_input_item(const global_state_t *global, const local_state_t *local,
+                               uint32_t flags, uint32_t bit_offset,
+                               const uint8_t *button_map, size_t button_map_len,
+                               hid_report_map_t *map)
+{
+    if ((flags & INPUT_FLAG_CONSTANT) || !(flags & INPUT_FLAG_VARIABLE)) {
+        return;  // 填充位和数组型字段不提取
+    }
+    if (global->report_size == 0 || global->report_size > MAX_FIELD_BITS) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < global->report_count; i++) {
+        uint32_t usage;
+        if (local->has_range) {
+            usage = local->usage_min + i;
+            if (usage > local->usage_max) {
+                break;
+            }
+        } else if (local->usage_count > 0) {
+            usage = local->usages[i < local->usage_count ? i : local->usage_count - 1];
+        } else {
+            break;
+        }
+        if ((usage >> 16) == 0) {
+            usage |= (uint32_t)global->usage_page << 16;
+        }
+
+        uint8_t kind, target;
+        if (!classify_usage(usage, button_map, button_map_len, &kind, &target)) {
+            continue;
+        }
+
+        // 只编译第一个包含手柄字段的报告
+        if (map->field_count == 0) {
+            map->report_id = global->report_id;
+        } else if (map->report_id != global->report_id) {
+            continue;
+        }
+
+        if (map->field_count >= HID_REPORT_MAP_MAX_FIELDS) {
+            ESP_LOGW(TAG, "Too many fields, ignoring usage 0x%08lx", (unsigned long)usage);
+            return;
+        }
+
+        hid_field_extractor_t *field = &map->fields[map->field_count++];
+        memset(field, 0, sizeof(*field));
+        field->bit_offset = bit_offset + i * global->report_size;
+        field->bit_size = global->report_size;
+        field->kind = kind;
+        field->target = target;
+        field->is_signed = global->logical_min_negative;
+        field->logical_min = global->logical_min;
+        field->logical_max = global->logical_max;
+        setup_field_scale(field);
+
+        uint32_t end_bits = field->bit_offset + field->bit_size;
+        uint16_t end_bytes = (end_bits + 7) / 8;
+        if (end_bytes > map->report_bytes) {
+            map->report_bytes = end_bytes;
+        }
+    }
+}
+
+esp_err_t hid_report_map_compile(const uint8_t *desc, size_t desc_len,
+                                 const uint8_t *button_map, size_t button_map_len,
+                                 hid_report_map_t *map)
+{
+    if (!desc || desc_len == 0 || !map) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(map, 0, sizeof(hid_report_map_t));
+
+    global_state_t global = {0};
+    global_state_t global_stack[MAX_GLOBAL_STACK];
+    uint8_t global_depth = 0;
+    local_state_t local = {0};
+    report_offsets_t offsets = {0};
+
+    size_t pos = 0;
+    while (pos < desc_len) {
+        uint8_t prefix = desc[pos];
+
+        // 长条目：跳过
+        if (prefix == ITEM_LONG_PREFIX) {
+            if (pos + 2 >= desc_len) {
+                break;
+            }
+            pos += 3 + desc[pos + 1];
+            continue;
+        }
+
+        uint8_t size = prefix & 0x03;
+        if (size == 3) {
+            size = 4;
+        }
+        uint8_t type = (prefix >> 2) & 0x03;
+        uint8_t tag = prefix >> 4;
+
+        if (pos + 1 + size > desc_len) {
+            ESP_LOGW(TAG, "Truncated report descriptor at offset %u", (unsigned)pos);
+            break;
+        }
+        const uint8_t *data = &desc[pos + 1];
+        uint32_t value = item_unsigned(data, size);
+        pos += 1 + size;
+
+        if (type == ITEM_TYPE_MAIN) {
+            if (tag == MAIN_INPUT) {
+                uint32_t *offset = report_offset_slot(&offsets, global.report_id);
+                if (offset == NULL) {
+                    ESP_LOGW(TAG, "Too many report IDs in descriptor");
+                    return ESP_ERR_NOT_SUPPORTED;
+                }
+                compile_input_item(&global, &local, value, *offset,
+                                   button_map, button_map_len, map);
+                *offset += global.report_size * global.report_count;
+            }
+            // Output/Feature/Collection条目不影响输入报告布局
+            memset(&local, 0, sizeof(local));
+        } else if (type == ITEM_TYPE_GLOBAL) {
+            switch (tag) {
+            case GLOBAL_USAGE_PAGE:
+                global.usage_page = value;
+                break;
+            case GLOBAL_LOGICAL_MIN:
+                global.logical_min = item_signed(data, size);
+                global.logical_min_negative = global.logical_min < 0;
+                break;
+            case GLOBAL_LOGICAL_MAX:
+                global.logical_max = item_signed(data, size);
+                // 常见描述符把255写成单字节0xFF，最小值非负时按无符号解释
+                if (global.logical_min >= 0 && global.logical_max < global.logical_min) {
+                    global.logical_max = (int32_t)value;
+                }
+                break;
+            case GLOBAL_REPORT_SIZE:
+                global.report_size = value;
+                break;
+            case GLOBAL_REPORT_ID:
+                global.report_id = value;
+                break;
+            case GLOBAL_REPORT_COUNT:
+                global.report_count = value;
+                break;
+            case GLOBAL_PUSH:
+                if (global_depth < MAX_GLOBAL_STACK) {
+                    global_stack[global_depth++] = global;
+                }
+                break;
+            case GLOBAL_POP:
+                if (global_depth > 0) {
+                    global = global_stack[--global_depth];
+                }
+                break;
+            default:
+                break;
+            }
+        } else if (type == ITEM_TYPE_LOCAL) {
+            // 4字节用途的高16位即用途页
+            uint32_t usage = (size == 4) ? value : value & 0xFFFF;
+            switch (tag) {
+            case LOCAL_USAGE:
+                if (local.usage_count < MAX_LOCAL_USAGES) {
+                    local.usages[local.usage_count++] = usage;
+                }
+                break;
+            case LOCAL_USAGE_MIN:
+                local.usage_min = usage;
+                local.has_range = true;
+                break;
+            case LOCAL_USAGE_MAX:
+                local.usage_max = usage;
+                local.has_range = true;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    if (map->field_count == 0) {
+        ESP_LOGW(TAG, "No gamepad fields found in report descriptor");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    ESP_LOGI(TAG, "Compiled report map: report_id=%d, fields=%d, min_len=%d",
+             map->report_id, map->field_count, map->report_bytes);
+    return ESP_OK;
+}
+
+esp_err_t hid_report_map_compile_builtin(hid_controller_type_t type, hid_report_map_t *map)
+{
+    if (type >= HID_CONTROLLER_TYPE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const builtin_profile_t *profile = &builtin_profiles[type];
+    esp_err_t ret = hid_report_map_compile(profile->desc, profile->desc_len,
+                                           profile->button_map, profile->button_map_len, map);
+    if (ret == ESP_OK) {
+        hid_report_map_apply_profile(type, map);
+    }
+    return ret;
+}
+
+void hid_report_map_apply_profile(hid_controller_type_t type, hid_report_map_t *map)
+{
+    if (type >= HID_CONTROLLER_TYPE_MAX) {
+        return;
+    }
+
+    const builtin_profile_t *profile = &builtin_profiles[type];
+    if (profile->ext_report_id == 0 || map->report_id != profile->base_report_id) {
+        return;
+    }
+    map->ext_report_id = profile->ext_report_id;
+    map->ext_header_bytes = profile->ext_header_bytes;
+}
+
+/* ==================== 热路径提取 ==================== */
+
+/**
+ * @brief 从报告中读取任意位偏移的字段
+ */
+static inline uint32_t extract_bits(const uint8_t *data, uint16_t bit_offset, uint8_t bit_size)
+{
+    const uint8_t *p = data + (bit_offset >> 3);
+    uint8_t shift = bit_offset & 7;
+    uint8_t nbytes = (shift + bit_size + 7) >> 3;
+
+    uint32_t raw = 0;
+    for (uint8_t i = 0; i < nbytes; i++) {
+        raw |= (uint32_t)p[i] << (8 * i);
+    }
+
+    return (raw >> shift) & ((1u << bit_size) - 1);
+}
+
+esp_err_t hid_report_map_extract(const hid_report_map_t *map, uint8_t report_id,
+                                 const uint8_t *data, uint16_t len,
+                                 hid_gamepad_report_t *out)
+{
+    if (report_id != map->report_id) {
+        if (map->ext_report_id == 0 || report_id != map->ext_report_id) {
+            return ESP_ERR_NOT_FOUND;
+        }
+        // 扩展报告：跳过完整布局之前的头
+        if (len < map->ext_header_bytes) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        data += map->ext_header_bytes;
+        len -= map->ext_header_bytes;
+    }
+    if (len < map->report_bytes) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    uint32_t buttons = 0;
+    memset(out, 0, sizeof(hid_gamepad_report_t));
+
+    const hid_field_extractor_t *field = map->fields;
+    const hid_field_extractor_t *end = map->fields + map->field_count;
+    for (; field < end; field++) {
+        uint32_t raw = extract_bits(data, field->bit_offset, field->bit_size);
+        int32_t value = (int32_t)raw;
+        if (field->is_signed && (raw & (1u << (field->bit_size - 1)))) {
+            value = (int32_t)(raw | ~((1u << field->bit_size) - 1));  // 符号扩展
+        }
+
+        // 超出逻辑范围的值视为空值（如方向键帽的中立位）
+        if (value < field->logical_min || value > field->logical_max) {
+            continue;
+        }
+        uint32_t normalized = ((uint32_t)(value - field->logical_min) >> field->pre_shift) * field->scale;
+
+        switch (field->kind) {
+        case HID_FIELD_BUTTON:
+            buttons |= (uint32_t)(raw != 0) << field->target;
+            break;
+        case HID_FIELD_AXIS:
+            out->axes[field->target] = (int16_t)((int32_t)(normalized >> 16) - 32768);
+            break;
+        case HID_FIELD_TRIGGER:
+            out->triggers[field->target] = normalized >> 24;
+            break;
+        case HID_FIELD_HAT:
+            {
+                uint32_t direction = (uint32_t)(value - field->logical_min);
+                buttons |= hat_to_dpad[direction < 8 ? direction : 8];
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    out->buttons = buttons;
+    return ESP_OK;
+}
+
+/* ==================== 型号识别 ==================== */
+
+#define VENDOR_ID_SONY          0x054C
+#define VENDOR_ID_MICROSOFT     0x045E
+#define VENDOR_ID_BETOP         0x20BC
+
+/**
+ * @brief 不区分大小写的子串查找
+ */
+static bool name_contains(const char *name, const char *pattern)
+{
+    size_t pattern_len = strlen(pattern);
+    for (; *name; name++) {
+        size_t i = 0;
+        while (i < pattern_len && name[i] &&
+               toupper((unsigned char)name[i]) == toupper((unsigned char)pattern[i])) {
+            i++;
+        }
+        if (i == pattern_len) {
+            return true;
+        }
+    }
+    return false;
+}
+
+esp_err_t hid_report_parser_get_builtin(hid_controller_type_t type, const uint8_t **desc, size_t *len)
+{
+    if (type >= HID_CONTROLLER_TYPE_MAX || !desc || !len) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *desc = builtin_profiles[type].desc;
+    *len = builtin_profiles[type].desc_len;
+    return ESP_OK;
+}
+
+const uint8_t *hid_report_parser_get_button_map(hid_controller_type_t type, size_t *len)
+{
+    if (type >= HID_CONTROLLER_TYPE_MAX) {
+        if (len) {
+            *len = 0;
+        }
+        return NULL;
+    }
+
+    if (len) {
+        *len = builtin_profiles[type].button_map_len;
+    }
+    return builtin_profiles[type].button_map;
+}
+
+hid_controller_type_t hid_report_parser_detect_type(uint16_t vendor_id, uint16_t product_id, const char *name)
+{
+    (void)product_id;  // 目前各厂商内所有型号共用同一布局
+
+    switch (vendor_id) {
+    case VENDOR_ID_SONY:
+        return HID_CONTROLLER_PS4;
+    case VENDOR_ID_MICROSOFT:
+        return HID_CONTROLLER_XBOX;
+    case VENDOR_ID_BETOP:
+        return HID_CONTROLLER_BEITONG;
+    default:
+        break;
+    }
+
+    // 部分手柄不提供设备ID，按名称识别
+    if (name != NULL) {
+        if (name_contains(name, "Wireless Controller") || name_contains(name, "DUALSHOCK")) {
+            return HID_CONTROLLER_PS4;
+        }
+        if (name_contains(name, "Xbox")) {
+            return HID_CONTROLLER_XBOX;
+        }
+        if (name_contains(name, "BEITONG") || name_contains(name, "BETOP")) {
+            return HID_CONTROLLER_BEITONG;
+        }
+    }
+
+    return HID_CONTROLLER_GENERIC;
+}
@@ -0,0 +1,193 @@
+/**
+ * @file hid_report_pool.c
+ * @brief 输入报告缓冲池与无锁报告队列实现
+ */
+
+#include "hid_report_pool.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "HID_POOL";
+
+// 空闲链表头：高16位为版本号（防ABA），低16位为缓冲下标
+#define FREE_INDEX_MASK         0xFFFFu
+#define FREE_TAG_STEP           0x10000u
+#define FREE_EMPTY              FREE_INDEX_MASK
+
+static hid_report_buf_t pool[HID_REPORT_POOL_SIZE];
+static _Atomic uint16_t free_next[HID_REPORT_POOL_SIZE];
+static _Atomic uint32_t free_head = FREE_EMPTY;
+static _Atomic bool pool_initialized = false;
+
+static _Atomic uint32_t pool_in_use = 0;
+static _Atomic uint32_t pool_high_water = 0;
+static _Atomic uint32_t pool_exhausted = 0;
+static _Atomic uint32_t report_seq = 0;
+
+/**
+ * @brief 把下标压回空闲链表（Treiber栈）
+ */
+static void free_list_push(uint16_t index)
+{
+    uint32_t head = atomic_load_explicit(&free_head, memory_order_relaxed);
+    uint32_t next;
+    do {
+        atomic_store_explicit(&free_next[index], (uint16_t)(head & FREE_INDEX_MASK), memory_order_relaxed);
+        next = ((head + FREE_TAG_STEP) & ~FREE_INDEX_MASK) | index;
+    } while (!atomic_compare_exchange_weak_explicit(&free_head, &head, next,
+                                                    memory_order_release, memory_order_relaxed));
+}
+
+esp_err_t hid_report_pool_init(void)
+{
+    bool expected = false;
+    if (!atomic_compare_exchange_strong(&pool_initialized, &expected, true)) {
+        return ESP_OK;
+    }
+
+    for (int i = HID_REPORT_POOL_SIZE - 1; i >= 0; i--) {
+        atomic_store_explicit(&pool[i].refs, 0, memory_order_relaxed);
+        free_list_push((uint16_t)i);
+    }
+
+    ESP_LOGI(TAG, "Report pool: %d buffers of %d bytes", HID_REPORT_POOL_SIZE, HID_REPORT_MAX_LEN);
+    return ESP_OK;
+}
+
+hid_report_buf_t *hid_report_pool_alloc(void)
+{
+    uint32_t head = atomic_load_explicit(&free_head, memory_order_acquire);
+    uint32_t next;
+    uint16_t index;
+    do {
+        index = (uint16_t)(head & FREE_INDEX_MASK);
+        if (index == FREE_EMPTY) {
+            atomic_fetch_add_explicit(&pool_exhausted, 1, memory_order_relaxed);
+            return NULL;
+        }
+        next = ((head + FREE_TAG_STEP) & ~FREE_INDEX_MASK) |
+               atomic_load_explicit(&free_next[index], memory_order_relaxed);
+    } while (!atomic_compare_exchange_weak_explicit(&free_head, &head, next,
+                                                    memory_order_acquire, memory_order_acquire));
+
+    uint32_t in_use = atomic_fetch_add_explicit(&pool_in_use, 1, memory_order_relaxed) + 1;
+    uint32_t high = atomic_load_explicit(&pool_high_water, memory_order_relaxed);
+    while (in_use > high &&
+           !atomic_compare_exchange_weak_explicit(&pool_high_water, &high, in_use,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+
+    hid_report_buf_t *buf = &pool[index];
+    uint32_t seq = atomic_fetch_add_explicit(&report_seq, 1, memory_order_relaxed) + 1;
+    buf->seq = seq ? seq : 1;
+    buf->timestamp_us = esp_timer_get_time();
+    buf->flags = 0;
+    buf->map_index = 0;
+    atomic_store_explicit(&buf->refs, 1, memory_order_relaxed);
+    return buf;
+}
+
+void hid_report_pool_retain(hid_report_buf_t *buf)
+{
+    atomic_fetch_add_explicit(&buf->refs, 1, memory_order_relaxed);
+}
+
+void hid_report_pool_release(hid_report_buf_t *buf)
+{
+    if (atomic_fetch_sub_explicit(&buf->refs, 1, memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    atomic_fetch_sub_explicit(&pool_in_use, 1, memory_order_relaxed);
+    free_list_push((uint16_t)(buf - pool));
+}
+
+esp_err_t hid_report_pool_get_stats(hid_report_pool_stats_t *stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    stats->capacity = HID_REPORT_POOL_SIZE;
+    stats->in_use = atomic_load_explicit(&pool_in_use, memory_order_relaxed);
+    stats->high_water = atomic_load_explicit(&pool_high_water, memory_order_relaxed);
+    stats->exhausted = atomic_load_explicit(&pool_exhausted, memory_order_relaxed);
+    return ESP_OK;
+}
+
+esp_err_t hid_report_queue_init(hid_report_queue_t *queue, uint32_t depth, TaskHandle_t notify_task)
+{
+    if (!queue || depth == 0 || depth > HID_REPORT_QUEUE_MAX_DEPTH || (depth & (depth - 1)) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (uint32_t i = 0; i < depth; i++) {
+        atomic_store_explicit(&queue->cells[i].seq, i, memory_order_relaxed);
+        queue->cells[i].buf = NULL;
+    }
+    atomic_store_explicit(&queue->enqueue_pos, 0, memory_order_relaxed);
+    atomic_store_explicit(&queue->dequeue_pos, 0, memory_order_relaxed);
+    atomic_store_explicit(&queue->dropped, 0, memory_order_relaxed);
+    queue->mask = depth - 1;
+    queue->notify_task = notify_task;
+    return ESP_OK;
+}
+
+void hid_report_queue_set_notify(hid_report_queue_t *queue, TaskHandle_t notify_task)
+{
+    queue->notify_task = notify_task;
+}
+
+bool hid_report_queue_push(hid_report_queue_t *queue, hid_report_buf_t *buf)
+{
+    // 有界MPMC队列：每个单元的序号表示它当前可写（==pos）还是可读（==pos+1）
+    uint32_t pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+    for (;;) {
+        uint32_t seq = atomic_load_explicit(&queue->cells[pos & queue->mask].seq, memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&queue->dropped, 1, memory_order_relaxed);
+            return false;
+        } else {
+            pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    hid_report_pool_retain(buf);
+    queue->cells[pos & queue->mask].buf = buf;
+    atomic_store_explicit(&queue->cells[pos & queue->mask].seq, pos + 1, memory_order_release);
+
+    TaskHandle_t task = queue->notify_task;
+    if (task) {
+        xTaskNotifyGive(task);
+    }
+    return true;
+}
+
+hid_report_buf_t *hid_report_queue_pop(hid_report_queue_t *queue)
+{
+    uint32_t pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+    for (;;) {
+        uint32_t seq = atomic_load_explicit(&queue->cells[pos & queue->mask].seq, memory_order_acquire);
+        int32_t diff = (int32_t)(seq - (pos + 1));
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->dequeue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return NULL;
+        } else {
+            pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+        }
+    }
+
+    hid_report_buf_t *buf = queue->cells[pos & queue->mask].buf;
+    atomic_store_explicit(&queue->cells[pos & queue->mask].seq, pos + queue->mask + 1, memory_order_release);
+    return buf;
+}
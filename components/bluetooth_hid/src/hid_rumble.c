@@ -0,0 +1,210 @@
+/**
+ * @file hid_rumble.c
+ * @brief 手柄震动报告编码实现
+ */
+
+#include "hid_rumble.h"
+#include "hid_output_sched.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+static const char *TAG = "HID_RUMBLE";
+
+#define VENDOR_ID_SONY             0x054C
+#define PRODUCT_ID_DUALSENSE       0x0CE6
+#define PRODUCT_ID_DUALSENSE_EDGE  0x0DF2
+
+// PS4蓝牙输出报告0x11：数据（不含报告ID）77字节，最后4字节为CRC32，
+// 校验范围为传输头0xA2、报告ID和之前的全部数据。
+// 手柄收到后输入也改为报告0x11，提取表按型号接受它（见hid_report_map_apply_profile）
+#define DS4_REPORT_ID              0x11
+#define DS4_REPORT_LEN             77
+#define DS4_BT_HEADER              0xA2
+#define DS4_HW_CONTROL             0xC0   // HID报告，带CRC32
+#define DS4_VALID_MOTOR            0x01   // 只更新马达，不改变灯条
+#define DS4_OFFSET_HW_CONTROL      0
+#define DS4_OFFSET_VALID_FLAGS     2
+#define DS4_OFFSET_MOTOR_RIGHT     5
+#define DS4_OFFSET_MOTOR_LEFT      6
+#define DS4_OFFSET_CRC             73
+
+// Xbox震动报告0x03：使能位、左右扳机马达、主马达（强/弱）强度（百分比）、持续时间、延迟、重复次数
+#define XBOX_REPORT_ID             0x03
+#define XBOX_REPORT_LEN            8
+#define XBOX_ENABLE_WEAK           0x01
+#define XBOX_ENABLE_STRONG         0x02
+#define XBOX_OFFSET_ENABLE         0
+#define XBOX_OFFSET_STRONG         3
+#define XBOX_OFFSET_WEAK           4
+#define XBOX_OFFSET_DURATION       5
+#define XBOX_OFFSET_LOOP           7
+#define XBOX_DURATION_MAX          0xFF   // 单次2.55秒
+#define XBOX_LOOP_MAX              0xFF   // 重复后约10分钟；强度变化时会重新发送
+
+// 通用报告0x01：报告ID + 保留字节 + 左右马达强度（北通等布局未公开的手柄沿用原来的格式）
+#define GENERIC_REPORT_ID          0x01
+#define GENERIC_REPORT_LEN         4
+#define GENERIC_OFFSET_LEFT        2
+#define GENERIC_OFFSET_RIGHT       3
+
+/**
+ * @brief 震动编码器：init在绑定时写入报告的固定部分，encode每次只改写强度相关的字节
+ */
+typedef struct {
+    const char *name;
+    hid_controller_type_t type;
+    uint16_t vendor_id;          ///< 0表示任意
+    uint16_t product_id;         ///< 0表示任意
+    uint8_t report_id;
+    uint16_t len;
+    void (*init)(uint8_t *buf);
+    void (*encode)(uint8_t *buf, uint8_t left, uint8_t right);  ///< NULL表示不支持震动
+} rumble_encoder_t;
+
+/**
+ * @brief 槽位绑定的编码器和报告缓冲
+ */
+typedef struct {
+    const rumble_encoder_t *encoder; ///< NULL表示未连接
+    uint8_t buf[HID_OUTPUT_MAX_LEN];
+} rumble_binding_t;
+
+static rumble_binding_t bindings[HID_RUMBLE_MAX_DEVICES];
+static uint32_t bound_mask = 0;
+static portMUX_TYPE rumble_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void ds4_init(uint8_t *buf)
+{
+    buf[DS4_OFFSET_HW_CONTROL] = DS4_HW_CONTROL;
+    buf[DS4_OFFSET_VALID_FLAGS] = DS4_VALID_MOTOR;
+}
+
+static void ds4_encode(uint8_t *buf, uint8_t left, uint8_t right)
+{
+    static const uint8_t header[] = { DS4_BT_HEADER, DS4_REPORT_ID };
+
+    buf[DS4_OFFSET_MOTOR_RIGHT] = right;
+    buf[DS4_OFFSET_MOTOR_LEFT] = left;
+    uint32_t crc = esp_rom_crc32_le(0, header, sizeof(header));
+    crc = esp_rom_crc32_le(crc, buf, DS4_OFFSET_CRC);
+    buf[DS4_OFFSET_CRC] = (uint8_t)crc;
+    buf[DS4_OFFSET_CRC + 1] = (uint8_t)(crc >> 8);
+    buf[DS4_OFFSET_CRC + 2] = (uint8_t)(crc >> 16);
+    buf[DS4_OFFSET_CRC + 3] = (uint8_t)(crc >> 24);
+}
+
+static void xbox_init(uint8_t *buf)
+{
+    buf[XBOX_OFFSET_ENABLE] = XBOX_ENABLE_WEAK | XBOX_ENABLE_STRONG;
+    buf[XBOX_OFFSET_DURATION] = XBOX_DURATION_MAX;
+    buf[XBOX_OFFSET_LOOP] = XBOX_LOOP_MAX;
+}
+
+static void xbox_encode(uint8_t *buf, uint8_t left, uint8_t right)
+{
+    buf[XBOX_OFFSET_STRONG] = (uint8_t)((left * 100 + 127) / 255);
+    buf[XBOX_OFFSET_WEAK] = (uint8_t)((right * 100 + 127) / 255);
+}
+
+static void generic_init(uint8_t *buf)
+{
+    buf[0] = GENERIC_REPORT_ID;
+}
+
+static void generic_encode(uint8_t *buf, uint8_t left, uint8_t right)
+{
+    buf[GENERIC_OFFSET_LEFT] = left;
+    buf[GENERIC_OFFSET_RIGHT] = right;
+}
+
+// 按顺序匹配，指定VID/PID的条目放在同型号的通用条目之前；没有匹配时使用最后的通用编码器
+static const rumble_encoder_t encoders[] = {
+    // DualSense同为索尼VID并被识别为PS4，但输出报告布局不同，暂不支持震动
+    { "DualSense", HID_CONTROLLER_PS4, VENDOR_ID_SONY, PRODUCT_ID_DUALSENSE, 0, 0, NULL, NULL },
+    { "DualSense Edge", HID_CONTROLLER_PS4, VENDOR_ID_SONY, PRODUCT_ID_DUALSENSE_EDGE, 0, 0, NULL, NULL },
+    { "DS4", HID_CONTROLLER_PS4, 0, 0, DS4_REPORT_ID, DS4_REPORT_LEN, ds4_init, ds4_encode },
+    { "Xbox", HID_CONTROLLER_XBOX, 0, 0, XBOX_REPORT_ID, XBOX_REPORT_LEN, xbox_init, xbox_encode },
+    { "generic", HID_CONTROLLER_GENERIC, 0, 0, GENERIC_REPORT_ID, GENERIC_REPORT_LEN, generic_init, generic_encode },
+};
+
+#define ENCODER_COUNT    (sizeof(encoders) / sizeof(encoders[0]))
+
+/**
+ * @brief 选择与型号和VID/PID匹配的第一个编码器
+ */
+static const rumble_encoder_t *select_encoder(hid_controller_type_t type, uint16_t vendor_id, uint16_t product_id)
+{
+    for (size_t i = 0; i < ENCODER_COUNT; i++) {
+        const rumble_encoder_t *e = &encoders[i];
+        if (e->type == type && (e->vendor_id == 0 || e->vendor_id == vendor_id) &&
+            (e->product_id == 0 || e->product_id == product_id)) {
+            return e;
+        }
+    }
+    return &encoders[ENCODER_COUNT - 1];
+}
+
+void hid_rumble_bind(uint8_t slot, hid_controller_type_t type, uint16_t vendor_id, uint16_t product_id)
+{
+    if (slot >= HID_RUMBLE_MAX_DEVICES) {
+        return;
+    }
+
+    const rumble_encoder_t *encoder = select_encoder(type, vendor_id, product_id);
+    rumble_binding_t *binding = &bindings[slot];
+    memset(binding->buf, 0, sizeof(binding->buf));
+    if (encoder->init) {
+        encoder->init(binding->buf);
+    }
+
+    portENTER_CRITICAL(&rumble_lock);
+    binding->encoder = encoder;
+    bound_mask |= 1u << slot;
+    portEXIT_CRITICAL(&rumble_lock);
+
+    if (encoder->encode) {
+        ESP_LOGI(TAG, "Slot %d rumble: %s report 0x%02x", slot, encoder->name, encoder->report_id);
+    } else {
+        ESP_LOGI(TAG, "Slot %d rumble: not supported on %s", slot, encoder->name);
+    }
+}
+
+void hid_rumble_unbind(uint8_t slot)
+{
+    if (slot >= HID_RUMBLE_MAX_DEVICES) {
+        return;
+    }
+
+    portENTER_CRITICAL(&rumble_lock);
+    bindings[slot].encoder = NULL;
+    bound_mask &= ~(1u << slot);
+    portEXIT_CRITICAL(&rumble_lock);
+}
+
+esp_err_t hid_rumble_send(uint8_t slot, uint8_t left, uint8_t right)
+{
+    if (slot >= HID_RUMBLE_MAX_DEVICES && slot != HID_RUMBLE_SLOT_PRIMARY) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&rumble_lock);
+    if (slot == HID_RUMBLE_SLOT_PRIMARY) {
+        slot = bound_mask ? (uint8_t)__builtin_ctz(bound_mask) : HID_RUMBLE_MAX_DEVICES;
+    }
+    const rumble_encoder_t *encoder = slot < HID_RUMBLE_MAX_DEVICES ? bindings[slot].encoder : NULL;
+    portEXIT_CRITICAL(&rumble_lock);
+
+    if (!encoder) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!encoder->encode) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    // 调度器拷贝报告后立即返回，缓冲可在下一次更新时直接改写
+    uint8_t *buf = bindings[slot].buf;
+    encoder->encode(buf, left, right);
+    return hid_output_sched_submit(slot, encoder->report_id, buf, encoder->len);
+}
@@ -0,0 +1,859 @@
+/**
+ * @file hid_transport_bt.c
+ * @brief 蓝牙HID传输后端（esp_hidh，经典蓝牙HID与BLE HOGP）
+ */
+
+#include "hid_transport.h"
+#include "bluetooth_hid.h"
+#include "esp_log.h"
+#include "esp_bt_main.h"
+#include "esp_gap_bt_api.h"
+#include "esp_bt_device.h"
+#include "esp_hidh.h"
+#include <string.h>
+
+// 协议栈只编译了其中一种时（对应BLUETOOTH_HID_BT_PROFILE的单模配置），另一种的接口不存在
+#define HID_BT_CLASSIC   CONFIG_BT_CLASSIC_ENABLED
+#define HID_BT_BLE       CONFIG_BT_BLE_ENABLED
+
+// 控制器的经典蓝牙ACL连接数少于槽位数时，后面的手柄连接会被控制器拒绝
+#ifdef CONFIG_BTDM_CTRL_BR_EDR_MAX_ACL_CONN_EFF
+_Static_assert(!HID_BT_CLASSIC || CONFIG_BTDM_CTRL_BR_EDR_MAX_ACL_CONN_EFF >= BLUETOOTH_HID_MAX_DEVICES,
+               "CONFIG_BTDM_CTRL_BR_EDR_MAX_ACL_CONN must be at least BLUETOOTH_HID_MAX_DEVICES");
+#endif
+
+#if HID_BT_BLE
+#include "esp_gap_ble_api.h"
+#include "esp_gattc_api.h"
+#include "esp_hidh_gattc.h"
+#endif
+
+static const char *TAG = "HID_BT";
+
+// esp_hidh事件任务栈大小
+#define HIDH_EVENT_STACK_SIZE    4096
+
+// 传统配对使用的PIN码
+#define HID_LEGACY_PIN           "0000"
+
+// 查询时长单位为1.28秒，协议允许的最大值
+#define INQUIRY_LEN_MAX          0x30
+
+#if HID_BT_BLE
+#ifndef CONFIG_BLUETOOTH_HID_BLE_CONN_INTERVAL_MIN
+#define CONFIG_BLUETOOTH_HID_BLE_CONN_INTERVAL_MIN   6
+#endif
+#ifndef CONFIG_BLUETOOTH_HID_BLE_CONN_INTERVAL_MAX
+#define CONFIG_BLUETOOTH_HID_BLE_CONN_INTERVAL_MAX   12
+#endif
+
+// 连接间隔单位为1.25ms，监督超时单位为10ms
+#define BLE_CONN_INTERVAL_UNIT_US    1250
+#define BLE_SUPERVISION_TIMEOUT      400
+
+// 扫描间隔和窗口（单位0.625ms）：窗口小于间隔，给同时进行的经典查询留出射频时间
+#define BLE_SCAN_INTERVAL            0x50
+#define BLE_SCAN_WINDOW              0x30
+
+// GAP外观值中的HID类
+#define BLE_APPEARANCE_HID           0x03C0
+#define BLE_APPEARANCE_KEYBOARD      0x03C1
+#define BLE_APPEARANCE_MOUSE         0x03C2
+#define BLE_APPEARANCE_JOYSTICK      0x03C3
+#define BLE_APPEARANCE_GAMEPAD       0x03C4
+#define BLE_UUID_HID_SERVICE         0x1812
+
+// 按外观值合成的设备类别码，使BLE广播和经典查询结果走同一套候选筛选
+#define COD_PERIPHERAL_UNCATEGORIZED 0x002500
+#define COD_PERIPHERAL_KEYBOARD      0x002540
+#define COD_PERIPHERAL_GAMEPAD       0x002508
+
+// 记住扫描到的BLE地址及地址类型，open时据此选择BLE连接
+#define BLE_PEER_MAX                 8
+#endif
+
+static const hid_transport_callbacks_t *callbacks = NULL;
+
+// 扫描中选中的设备：先停止查询和BLE扫描再连接
+static esp_bd_addr_t selected_bda;
+static bool selected = false;
+static bool inquiry_running = false;
+
+#if HID_BT_BLE
+typedef struct {
+    esp_bd_addr_t bda;
+    esp_ble_addr_type_t addr_type;
+} ble_peer_t;
+
+static ble_peer_t ble_peers[BLE_PEER_MAX];
+static size_t ble_peer_count = 0;
+static size_t ble_peer_next = 0;
+static bool ble_scan_running = false;
+static uint32_t ble_scan_duration = 0;
+
+static void ble_request_conn_params(const uint8_t *bda);
+#endif
+
+/**
+ * @brief 查询和BLE扫描都已停止时通知上层
+ */
+static void scan_finished(void)
+{
+#if HID_BT_BLE
+    if (ble_scan_running) {
+        return;
+    }
+#endif
+    if (inquiry_running) {
+        return;
+    }
+
+    bool had_selection = selected;
+    selected = false;
+    callbacks->on_scan_stopped(had_selection ? selected_bda : NULL);
+}
+
+/**
+ * @brief 停止正在进行的查询和BLE扫描，停止事件到达后由scan_finished通知上层
+ */
+static esp_err_t cancel_scans(void)
+{
+    esp_err_t ret = ESP_OK;
+#if HID_BT_CLASSIC
+    if (inquiry_running) {
+        ret = esp_bt_gap_cancel_discovery();
+    }
+#endif
+#if HID_BT_BLE
+    if (ble_scan_running) {
+        esp_err_t ble_ret = esp_ble_gap_stop_scanning();
+        if (ret == ESP_OK) {
+            ret = ble_ret;
+        }
+    }
+#endif
+    return ret;
+}
+
+/**
+ * @brief 扫描结果被上层选中
+ */
+static void select_device(const uint8_t *bda)
+{
+    // 扫描进行中连接容易失败，先停止扫描，全部停止后再连接
+    memcpy(selected_bda, bda, sizeof(esp_bd_addr_t));
+    selected = true;
+    cancel_scans();
+}
+
+/**
+ * @brief esp_hidh事件回调（在esp_hidh事件任务中执行）
+ */
+static void hidh_event_handler(void *handler_args, esp_event_base_t base, int32_t id, void *event_data)
+{
+    esp_hidh_event_data_t *param = (esp_hidh_event_data_t *)event_data;
+
+    switch ((esp_hidh_event_t)id) {
+    case ESP_HIDH_OPEN_EVENT: {
+        esp_hidh_dev_t *dev = param->open.dev;
+        const uint8_t *bda = dev ? esp_hidh_dev_bda_get(dev) : NULL;
+
+        if (param->open.status != ESP_OK) {
+            ESP_LOGW(TAG, "HID open failed: %s", esp_err_to_name(param->open.status));
+            callbacks->on_open(dev, bda, param->open.status, NULL);
+            break;
+        }
+
+        hid_transport_dev_info_t info = {
+            .name = esp_hidh_dev_name_get(dev),
+            .vendor_id = esp_hidh_dev_vendor_id_get(dev),
+            .product_id = esp_hidh_dev_product_id_get(dev),
+            .version = esp_hidh_dev_version_get(dev),
+            .transport = (uint8_t)esp_hidh_dev_transport_get(dev)
+        };
+        size_t num_maps = 0;
+        esp_hid_raw_report_map_t *maps = NULL;
+        if (esp_hidh_dev_report_maps_get(dev, &num_maps, &maps) == ESP_OK && num_maps > 0) {
+            info.report_desc = maps[0].data;
+            info.report_desc_len = maps[0].len;
+        }
+        callbacks->on_open(dev, bda, ESP_OK, &info);
+
+#if HID_BT_BLE
+        // esp_hidh已订阅输入报告通知，再请求短连接间隔
+        if (info.transport == ESP_HID_TRANSPORT_BLE) {
+            ble_request_conn_params(bda);
+        }
+#endif
+        break;
+    }
+
+    case ESP_HIDH_CLOSE_EVENT:
+        callbacks->on_close(param->close.dev, param->close.reason);
+        esp_hidh_dev_free(param->close.dev);
+        break;
+
+    case ESP_HIDH_INPUT_EVENT:
+        callbacks->on_input(param->input.dev, (uint8_t)param->input.report_id, param->input.map_index,
+                            param->input.data, param->input.length);
+        break;
+
+    case ESP_HIDH_BATTERY_EVENT:
+        ESP_LOGD(TAG, "Battery level: %d%%", param->battery.level);
+        callbacks->on_battery(param->battery.dev, param->battery.level);
+        break;
+
+    default:
+        ESP_LOGD(TAG, "HIDH event: %ld", (long)id);
+        break;
+    }
+}
+
+/**
+ * @brief 拷贝不以0结尾的名称，超长截断
+ */
+static void copy_prop_string(char *dst, size_t dst_size, const uint8_t *src, size_t len)
+{
+    if (len >= dst_size) {
+        len = dst_size - 1;
+    }
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+#if HID_BT_CLASSIC
+/**
+ * @brief 读取查询结果中的设备类别码、信号强度、名称和EIR厂商数据
+ */
+static void parse_disc_res(esp_bt_gap_cb_param_t *param, hid_transport_disc_result_t *result,
+                           char *name, size_t name_size)
+{
+    uint8_t *eir = NULL;
+
+    result->bda = param->disc_res.bda;
+    result->cod = 0;
+    result->rssi = INT8_MIN;
+    result->company_id = 0xFFFF;
+    result->name = NULL;
+    name[0] = '\0';
+
+    for (int i = 0; i < param->disc_res.num_prop; i++) {
+        esp_bt_gap_dev_prop_t *prop = &param->disc_res.prop[i];
+        if (prop->type == ESP_BT_GAP_DEV_PROP_COD && prop->len >= (int)sizeof(uint32_t)) {
+            result->cod = *(uint32_t *)prop->val;
+        } else if (prop->type == ESP_BT_GAP_DEV_PROP_RSSI && prop->len >= (int)sizeof(int8_t)) {
+            result->rssi = *(int8_t *)prop->val;
+        } else if (prop->type == ESP_BT_GAP_DEV_PROP_BDNAME && prop->len > 0) {
+            copy_prop_string(name, name_size, prop->val, prop->len);
+        } else if (prop->type == ESP_BT_GAP_DEV_PROP_EIR) {
+            eir = prop->val;
+        }
+    }
+
+    if (eir) {
+        uint8_t len = 0;
+        uint8_t *data;
+        if (name[0] == '\0') {
+            data = esp_bt_gap_resolve_eir_data(eir, ESP_BT_EIR_TYPE_CMPL_LOCAL_NAME, &len);
+            if (!data) {
+                data = esp_bt_gap_resolve_eir_data(eir, ESP_BT_EIR_TYPE_SHORT_LOCAL_NAME, &len);
+            }
+            if (data && len > 0) {
+                copy_prop_string(name, name_size, data, len);
+            }
+        }
+        // 厂商数据以小端的公司ID开头
+        data = esp_bt_gap_resolve_eir_data(eir, ESP_BT_EIR_TYPE_MANU_SPECIFIC, &len);
+        if (data && len >= 2) {
+            result->company_id = (uint16_t)(data[0] | (data[1] << 8));
+        }
+    }
+
+    if (name[0]) {
+        result->name = name;
+    }
+}
+
+/**
+ * @brief GAP事件回调函数
+ */
+static void gap_event_handler(esp_bt_gap_cb_event_t event, esp_bt_gap_cb_param_t *param)
+{
+    switch (event) {
+    case ESP_BT_GAP_DISC_RES_EVT: {
+        hid_transport_disc_result_t result;
+        char name[ESP_BT_GAP_MAX_BDNAME_LEN + 1];
+        parse_disc_res(param, &result, name, sizeof(name));
+
+        if (!selected && callbacks->on_discovered(&result)) {
+            select_device(param->disc_res.bda);
+        }
+        break;
+    }
+
+    case ESP_BT_GAP_DISC_STATE_CHANGED_EVT:
+        if (param->disc_st_chg.state == ESP_BT_GAP_DISCOVERY_STOPPED) {
+            ESP_LOGI(TAG, "Discovery stopped");
+            inquiry_running = false;
+            scan_finished();
+        } else if (param->disc_st_chg.state == ESP_BT_GAP_DISCOVERY_STARTED) {
+            ESP_LOGI(TAG, "Discovery started");
+        }
+        break;
+
+    case ESP_BT_GAP_AUTH_CMPL_EVT:
+        if (param->auth_cmpl.stat == ESP_BT_STATUS_SUCCESS) {
+            ESP_LOGI(TAG, "Authentication success: %s", param->auth_cmpl.device_name);
+        } else {
+            ESP_LOGW(TAG, "Authentication failed, status %d", param->auth_cmpl.stat);
+        }
+        break;
+
+    case ESP_BT_GAP_PIN_REQ_EVT: {
+        esp_bt_pin_code_t pin_code = {0};
+        memcpy(pin_code, HID_LEGACY_PIN, sizeof(HID_LEGACY_PIN) - 1);
+        esp_bt_gap_pin_reply(param->pin_req.bda, true, sizeof(HID_LEGACY_PIN) - 1, pin_code);
+        break;
+    }
+
+#if CONFIG_BT_SSP_ENABLED
+    case ESP_BT_GAP_CFM_REQ_EVT:
+        // 手柄没有显示和输入能力，数值比较直接确认
+        esp_bt_gap_ssp_confirm_reply(param->cfm_req.bda, true);
+        break;
+#endif
+
+    case ESP_BT_GAP_READ_RSSI_DELTA_EVT:
+        if (param->read_rssi_delta.stat == ESP_BT_STATUS_SUCCESS) {
+            callbacks->on_rssi(param->read_rssi_delta.bda, param->read_rssi_delta.rssi_delta);
+        }
+        break;
+
+    case ESP_BT_GAP_MODE_CHG_EVT:
+        ESP_LOGI(TAG, "GAP mode changed to %d", param->mode_chg.mode);
+        break;
+
+    default:
+        ESP_LOGD(TAG, "GAP event: %d", event);
+        break;
+    }
+}
+
+#endif
+
+#if HID_BT_BLE
+static void ble_peer_remember(const uint8_t *bda, esp_ble_addr_type_t addr_type)
+{
+    for (size_t i = 0; i < ble_peer_count; i++) {
+        if (memcmp(ble_peers[i].bda, bda, sizeof(esp_bd_addr_t)) == 0) {
+            ble_peers[i].addr_type = addr_type;
+            return;
+        }
+    }
+
+    // 表满时循环覆盖最早的条目
+    ble_peer_t *peer = &ble_peers[ble_peer_next];
+    memcpy(peer->bda, bda, sizeof(esp_bd_addr_t));
+    peer->addr_type = addr_type;
+    ble_peer_next = (ble_peer_next + 1) % BLE_PEER_MAX;
+    if (ble_peer_count < BLE_PEER_MAX) {
+        ble_peer_count++;
+    }
+}
+
+/**
+ * @brief 在协议栈的BLE绑定列表中查找设备
+ */
+static bool ble_bond_find(const uint8_t *bda, esp_ble_addr_type_t *addr_type)
+{
+    int count = esp_ble_get_bond_device_num();
+    if (count <= 0) {
+        return false;
+    }
+
+    esp_ble_bond_dev_t bonded[count];
+    if (esp_ble_get_bond_device_list(&count, bonded) != ESP_OK) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        if (memcmp(bonded[i].bd_addr, bda, sizeof(esp_bd_addr_t)) == 0) {
+            *addr_type = bonded[i].bd_addr_type;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 查找BLE设备的地址类型：先查本次上电扫描到的地址，再查BLE绑定列表
+ * @return true 是BLE设备
+ */
+static bool ble_peer_find(const uint8_t *bda, esp_ble_addr_type_t *addr_type)
+{
+    for (size_t i = 0; i < ble_peer_count; i++) {
+        if (memcmp(ble_peers[i].bda, bda, sizeof(esp_bd_addr_t)) == 0) {
+            *addr_type = ble_peers[i].addr_type;
+            return true;
+        }
+    }
+    return ble_bond_find(bda, addr_type);
+}
+
+/**
+ * @brief 解析广播和扫描响应：外观值或HID服务UUID换算为设备类别码，另取名称、厂商数据和RSSI
+ */
+static void ble_parse_scan_result(esp_ble_gap_cb_param_t *param, hid_transport_disc_result_t *result,
+                                  char *name, size_t name_size)
+{
+    uint8_t *adv = param->scan_rst.ble_adv;
+    uint8_t len = 0;
+    uint8_t *data;
+
+    result->bda = param->scan_rst.bda;
+    result->cod = 0;
+    result->rssi = (int8_t)param->scan_rst.rssi;
+    result->company_id = 0xFFFF;
+    result->name = NULL;
+    name[0] = '\0';
+
+    data = esp_ble_resolve_adv_data(adv, ESP_BLE_AD_TYPE_APPEARANCE, &len);
+    if (data && len >= 2) {
+        uint16_t appearance = (uint16_t)(data[0] | (data[1] << 8));
+        switch (appearance) {
+        case BLE_APPEARANCE_GAMEPAD:
+        case BLE_APPEARANCE_JOYSTICK:
+            result->cod = COD_PERIPHERAL_GAMEPAD;
+            break;
+        case BLE_APPEARANCE_KEYBOARD:
+        case BLE_APPEARANCE_MOUSE:
+            result->cod = COD_PERIPHERAL_KEYBOARD;
+            break;
+        case BLE_APPEARANCE_HID:
+            result->cod = COD_PERIPHERAL_UNCATEGORIZED;
+            break;
+        default:
+            break;
+        }
+    }
+
+    // 没有外观值时，广播了HID服务的设备按未分类外设处理
+    if (result->cod == 0) {
+        static const uint8_t uuid_types[] = { ESP_BLE_AD_TYPE_16SRV_CMPL, ESP_BLE_AD_TYPE_16SRV_PART };
+        for (size_t t = 0; t < sizeof(uuid_types) && result->cod == 0; t++) {
+            data = esp_ble_resolve_adv_data(adv, uuid_types[t], &len);
+            for (uint8_t i = 0; data && i + 1 < len; i += 2) {
+                if ((uint16_t)(data[i] | (data[i + 1] << 8)) == BLE_UUID_HID_SERVICE) {
+                    result->cod = COD_PERIPHERAL_UNCATEGORIZED;
+                    break;
+                }
+            }
+        }
+    }
+
+    data = esp_ble_resolve_adv_data(adv, ESP_BLE_AD_TYPE_NAME_CMPL, &len);
+    if (!data) {
+        data = esp_ble_resolve_adv_data(adv, ESP_BLE_AD_TYPE_NAME_SHORT, &len);
+    }
+    if (data && len > 0) {
+        copy_prop_string(name, name_size, data, len);
+        result->name = name;
+    }
+
+    data = esp_ble_resolve_adv_data(adv, ESP_BLE_AD_MANUFACTURER_SPECIFIC_TYPE, &len);
+    if (data && len >= 2) {
+        result->company_id = (uint16_t)(data[0] | (data[1] << 8));
+    }
+}
+
+/**
+ * @brief 请求短连接间隔、从机延迟为0，手柄每个连接事件都能发送通知
+ */
+static void ble_request_conn_params(const uint8_t *bda)
+{
+    esp_ble_conn_update_params_t params = {
+        .min_int = CONFIG_BLUETOOTH_HID_BLE_CONN_INTERVAL_MIN,
+        .max_int = CONFIG_BLUETOOTH_HID_BLE_CONN_INTERVAL_MAX,
+        .latency = 0,
+        .timeout = BLE_SUPERVISION_TIMEOUT
+    };
+    memcpy(params.bda, bda, sizeof(esp_bd_addr_t));
+
+    esp_err_t ret = esp_ble_gap_update_conn_params(&params);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to request BLE connection parameters: %s", esp_err_to_name(ret));
+    }
+}
+
+/**
+ * @brief BLE GAP事件回调函数
+ */
+static void ble_gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param)
+{
+    switch (event) {
+    case ESP_GAP_BLE_SCAN_PARAM_SET_COMPLETE_EVT:
+        if (!ble_scan_running) {
+            break;
+        }
+        if (param->scan_param_cmpl.status != ESP_BT_STATUS_SUCCESS ||
+            esp_ble_gap_start_scanning(ble_scan_duration) != ESP_OK) {
+            ESP_LOGW(TAG, "BLE scan failed to start");
+            ble_scan_running = false;
+            scan_finished();
+        }
+        break;
+
+    case ESP_GAP_BLE_SCAN_START_COMPLETE_EVT:
+        if (param->scan_start_cmpl.status != ESP_BT_STATUS_SUCCESS) {
+            ESP_LOGW(TAG, "BLE scan failed to start, status %d", param->scan_start_cmpl.status);
+            ble_scan_running = false;
+            scan_finished();
+        } else {
+            ESP_LOGI(TAG, "BLE scan started");
+        }
+        break;
+
+    case ESP_GAP_BLE_SCAN_RESULT_EVT:
+        if (param->scan_rst.search_evt == ESP_GAP_SEARCH_INQ_RES_EVT) {
+            hid_transport_disc_result_t result;
+            char name[ESP_BLE_ADV_DATA_LEN_MAX + 1];
+            ble_parse_scan_result(param, &result, name, sizeof(name));
+            if (result.cod == 0 && !result.name) {
+                break;
+            }
+
+            ble_peer_remember(param->scan_rst.bda, param->scan_rst.ble_addr_type);
+            if (!selected && callbacks->on_discovered(&result)) {
+                select_device(param->scan_rst.bda);
+            }
+        } else if (param->scan_rst.search_evt == ESP_GAP_SEARCH_INQ_CMPL_EVT) {
+            ESP_LOGI(TAG, "BLE scan complete");
+            ble_scan_running = false;
+            scan_finished();
+        }
+        break;
+
+    case ESP_GAP_BLE_SCAN_STOP_COMPLETE_EVT:
+        ESP_LOGI(TAG, "BLE scan stopped");
+        ble_scan_running = false;
+        scan_finished();
+        break;
+
+    case ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT:
+        if (param->update_conn_params.status == ESP_BT_STATUS_SUCCESS) {
+            uint32_t interval_us = param->update_conn_params.conn_int * BLE_CONN_INTERVAL_UNIT_US;
+            ESP_LOGI(TAG, "BLE connection interval %lu us, latency %d, timeout %d ms",
+                     (unsigned long)interval_us, param->update_conn_params.latency,
+                     param->update_conn_params.timeout * 10);
+            callbacks->on_conn_params(param->update_conn_params.bda, interval_us,
+                                      param->update_conn_params.latency);
+        } else {
+            ESP_LOGW(TAG, "BLE connection parameter update failed, status %d", param->update_conn_params.status);
+        }
+        break;
+
+    case ESP_GAP_BLE_SEC_REQ_EVT:
+        esp_ble_gap_security_rsp(param->ble_security.ble_req.bd_addr, true);
+        break;
+
+    case ESP_GAP_BLE_READ_RSSI_COMPLETE_EVT:
+        if (param->read_rssi_cmpl.status == ESP_BT_STATUS_SUCCESS) {
+            callbacks->on_rssi(param->read_rssi_cmpl.remote_addr, param->read_rssi_cmpl.rssi);
+        }
+        break;
+
+    default:
+        ESP_LOGD(TAG, "BLE GAP event: %d", event);
+        break;
+    }
+}
+
+/**
+ * @brief 注册BLE GAP/GATT回调并设置绑定参数（需在esp_hidh_init之前）
+ */
+static esp_err_t ble_init(void)
+{
+    esp_err_t ret = esp_ble_gap_register_callback(ble_gap_event_handler);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register BLE GAP callback: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = esp_ble_gattc_register_callback(esp_hidh_gattc_event_handler);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register GATT client callback: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    esp_ble_auth_req_t auth_req = ESP_LE_AUTH_BOND;
+    esp_ble_io_cap_t iocap = ESP_IO_CAP_NONE;
+    uint8_t key_mask = ESP_BLE_ENC_KEY_MASK | ESP_BLE_ID_KEY_MASK;
+    esp_ble_gap_set_security_param(ESP_BLE_SM_AUTHEN_REQ_MODE, &auth_req, sizeof(auth_req));
+    esp_ble_gap_set_security_param(ESP_BLE_SM_IOCAP_MODE, &iocap, sizeof(iocap));
+    esp_ble_gap_set_security_param(ESP_BLE_SM_SET_INIT_KEY, &key_mask, sizeof(key_mask));
+    esp_ble_gap_set_security_param(ESP_BLE_SM_SET_RSP_KEY, &key_mask, sizeof(key_mask));
+    return ESP_OK;
+}
+
+/**
+ * @brief 开始BLE扫描：先设置参数，参数设置完成事件中开始扫描
+ */
+static esp_err_t ble_start_scan(uint32_t duration_sec)
+{
+    esp_ble_scan_params_t scan_params = {
+        .scan_type = BLE_SCAN_TYPE_ACTIVE,
+        .own_addr_type = BLE_ADDR_TYPE_PUBLIC,
+        .scan_filter_policy = BLE_SCAN_FILTER_ALLOW_ALL,
+        .scan_interval = BLE_SCAN_INTERVAL,
+        .scan_window = BLE_SCAN_WINDOW,
+        .scan_duplicate = BLE_SCAN_DUPLICATE_DISABLE
+    };
+    ble_scan_duration = duration_sec;
+    return esp_ble_gap_set_scan_params(&scan_params);
+}
+#endif
+
+static esp_err_t bt_init(const hid_transport_callbacks_t *cb)
+{
+    callbacks = cb;
+    selected = false;
+    inquiry_running = false;
+
+    esp_err_t ret;
+
+#if HID_BT_CLASSIC
+    ret = esp_bt_gap_register_callback(gap_event_handler);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register GAP callback: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+#if CONFIG_BT_SSP_ENABLED
+    esp_bt_io_cap_t iocap = ESP_BT_IO_CAP_NONE;
+    esp_bt_gap_set_security_param(ESP_BT_SP_IOCAP_MODE, &iocap, sizeof(iocap));
+#endif
+#endif
+
+#if HID_BT_BLE
+    ble_scan_running = false;
+    ble_peer_count = 0;
+    ret = ble_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+#endif
+
+    esp_hidh_config_t hidh_config = {
+        .callback = hidh_event_handler,
+        .event_stack_size = HIDH_EVENT_STACK_SIZE,
+        .callback_arg = NULL
+    };
+    ret = esp_hidh_init(&hidh_config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize HID host: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+#if HID_BT_CLASSIC
+    // 可连接：已绑定的手柄开机后可以主动回连
+    ret = esp_bt_gap_set_scan_mode(ESP_BT_CONNECTABLE, ESP_BT_GENERAL_DISCOVERABLE);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set scan mode: %s", esp_err_to_name(ret));
+        esp_hidh_deinit();
+        return ret;
+    }
+#endif
+
+    return ESP_OK;
+}
+
+static esp_err_t bt_deinit(void)
+{
+    selected = false;
+    cancel_scans();
+    return esp_hidh_deinit();
+}
+
+/**
+ * @brief 经典查询与BLE扫描同时进行，两者都停止后才上报on_scan_stopped
+ */
+static esp_err_t bt_start_scan(uint32_t duration_sec)
+{
+    esp_err_t ret = ESP_ERR_NOT_SUPPORTED;
+    selected = false;
+
+    // 先置标志：一边很快结束时不会提前上报扫描停止
+#if HID_BT_CLASSIC
+    inquiry_running = true;
+#endif
+#if HID_BT_BLE
+    ble_scan_running = true;
+    ret = ble_start_scan(duration_sec);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "BLE scan failed to start: %s", esp_err_to_name(ret));
+        ble_scan_running = false;
+    }
+#endif
+
+#if HID_BT_CLASSIC
+    uint32_t inquiry_len = (duration_sec * 100 + 127) / 128;
+    if (inquiry_len < 1) inquiry_len = 1;
+    if (inquiry_len > INQUIRY_LEN_MAX) inquiry_len = INQUIRY_LEN_MAX;
+
+    esp_err_t inquiry_ret = esp_bt_gap_start_discovery(ESP_BT_INQ_MODE_GENERAL_INQUIRY, (uint8_t)inquiry_len, 0);
+    if (inquiry_ret != ESP_OK) {
+        inquiry_running = false;
+        ESP_LOGW(TAG, "Inquiry failed to start: %s", esp_err_to_name(inquiry_ret));
+    }
+    if (ret != ESP_OK) {
+        ret = inquiry_ret;
+    }
+#endif
+
+    // 任一扫描启动成功即可
+    return ret;
+}
+
+static esp_err_t bt_stop_scan(void)
+{
+    selected = false;
+    return cancel_scans();
+}
+
+static esp_err_t bt_open(const uint8_t *bda, void **dev_handle)
+{
+    esp_hid_transport_t hid_transport = ESP_HID_TRANSPORT_BT;
+    uint8_t addr_type = 0;
+#if HID_BT_BLE
+    esp_ble_addr_type_t ble_addr_type;
+    if (ble_peer_find(bda, &ble_addr_type)) {
+        hid_transport = ESP_HID_TRANSPORT_BLE;
+        addr_type = ble_addr_type;
+    }
+#endif
+#if !HID_BT_CLASSIC
+    if (hid_transport != ESP_HID_TRANSPORT_BLE) {
+        return ESP_ERR_NOT_FOUND;
+    }
+#endif
+
+    // 经典蓝牙直接寻呼，BLE等待设备广播后直接连接；结果在ESP_HIDH_OPEN_EVENT中返回
+    esp_hidh_dev_t *dev = esp_hidh_dev_open((uint8_t *)bda, hid_transport, addr_type);
+    if (dev == NULL) {
+        return ESP_FAIL;
+    }
+    *dev_handle = dev;
+    return ESP_OK;
+}
+
+static esp_err_t bt_close(void *dev_handle)
+{
+    return esp_hidh_dev_close((esp_hidh_dev_t *)dev_handle);
+}
+
+static esp_err_t bt_send_output(void *dev_handle, uint8_t report_id, uint8_t *data, uint16_t len)
+{
+    return esp_hidh_dev_output_set((esp_hidh_dev_t *)dev_handle, 0, report_id, data, len);
+}
+
+/**
+ * @brief 只影响经典蓝牙的页扫描/查询扫描，BLE主机不广播
+ */
+static esp_err_t bt_set_discoverable(bool discoverable, bool connectable)
+{
+#if HID_BT_CLASSIC
+    return esp_bt_gap_set_scan_mode(connectable ? ESP_BT_CONNECTABLE : ESP_BT_NON_CONNECTABLE,
+                                    discoverable ? ESP_BT_GENERAL_DISCOVERABLE : ESP_BT_NON_DISCOVERABLE);
+#else
+    return ESP_OK;
+#endif
+}
+
+static bool bt_is_bonded(const uint8_t *bda)
+{
+#if HID_BT_BLE
+    esp_ble_addr_type_t addr_type;
+    if (ble_bond_find(bda, &addr_type)) {
+        return true;
+    }
+#endif
+
+#if HID_BT_CLASSIC
+    int count = esp_bt_gap_get_bond_device_num();
+    if (count <= 0) {
+        return false;
+    }
+
+    esp_bd_addr_t bonded[count];
+    if (esp_bt_gap_get_bond_device_list(&count, bonded) != ESP_OK) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        if (memcmp(bonded[i], bda, sizeof(esp_bd_addr_t)) == 0) {
+            return true;
+        }
+    }
+#endif
+    return false;
+}
+
+/**
+ * @brief 经典蓝牙只提供相对黄金接收功率范围的RSSI偏差，BLE为dBm
+ */
+static esp_err_t bt_read_rssi(void *dev_handle)
+{
+    const uint8_t *bda = esp_hidh_dev_bda_get((esp_hidh_dev_t *)dev_handle);
+    if (!bda) {
+        return ESP_ERR_INVALID_STATE;
+    }
+#if HID_BT_BLE
+    if (esp_hidh_dev_transport_get((esp_hidh_dev_t *)dev_handle) == ESP_HID_TRANSPORT_BLE) {
+        return esp_ble_gap_read_rssi((uint8_t *)bda);
+    }
+#endif
+#if HID_BT_CLASSIC
+    return esp_bt_gap_read_rssi_delta((uint8_t *)bda);
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+#if HID_BT_CLASSIC
+/**
+ * @brief 寻呼超时以0.625ms时隙为单位，协议允许0x0016~0xFFFF
+ */
+static esp_err_t bt_set_page_timeout(uint32_t timeout_ms)
+{
+    uint32_t slots = timeout_ms * 8 / 5;
+    if (slots < 0x0016) {
+        slots = 0x0016;
+    } else if (slots > 0xFFFF) {
+        slots = 0xFFFF;
+    }
+    return esp_bt_gap_set_page_timeout((uint16_t)slots);
+}
+#endif
+
+static const hid_transport_ops_t bt_transport = {
+    .name = "bluetooth",
+    .supports_bonding = true,
+    .init = bt_init,
+    .deinit = bt_deinit,
+    .start_scan = bt_start_scan,
+    .stop_scan = bt_stop_scan,
+    .open = bt_open,
+    .close = bt_close,
+    .send_output = bt_send_output,
+    .set_discoverable = bt_set_discoverable,
+    .is_bonded = bt_is_bonded,
+    .read_rssi = bt_read_rssi,
+#if HID_BT_CLASSIC
+    .set_page_timeout = bt_set_page_timeout
+#else
+    .set_page_timeout = NULL
+#endif
+};
+
+const hid_transport_ops_t *hid_transport_bt(void)
+{
+    return &bt_transport;
+}
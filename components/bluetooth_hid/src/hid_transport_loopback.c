@@ -0,0 +1,436 @@
+/**
+ * @file hid_transport_loopback.c
+ * @brief 回环HID传输后端实现
+ */
+
+#include "hid_transport.h"
+#include "hid_loopback.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "HID_LOOPBACK";
+
+// 未通过Kconfig选择回环后端时的默认参数
+#ifndef CONFIG_BLUETOOTH_HID_LOOPBACK_DEVICES
+#define CONFIG_BLUETOOTH_HID_LOOPBACK_DEVICES        1
+#endif
+#ifndef CONFIG_BLUETOOTH_HID_LOOPBACK_RATE_HZ
+#define CONFIG_BLUETOOTH_HID_LOOPBACK_RATE_HZ        250
+#endif
+#ifndef CONFIG_BLUETOOTH_HID_LOOPBACK_JITTER_US
+#define CONFIG_BLUETOOTH_HID_LOOPBACK_JITTER_US      0
+#endif
+#ifndef CONFIG_BLUETOOTH_HID_LOOPBACK_DROP_PER_MILLE
+#define CONFIG_BLUETOOTH_HID_LOOPBACK_DROP_PER_MILLE 0
+#endif
+
+// 生成任务：输入回调在此任务中执行，栈要容纳完整的解析路径
+#define LOOPBACK_TASK_STACK_SIZE    4096
+#define LOOPBACK_TASK_PRIORITY      10
+
+// 模拟手柄的类别码：外设/游戏手柄
+#define LOOPBACK_COD                0x002508
+#define LOOPBACK_RSSI               (-40)
+
+// 生成任务被长时间阻塞后不补发，直接从当前时刻重新排程
+#define LOOPBACK_RESYNC_US          100000
+
+// 内置扫动使用的通用8字节布局：按键(2) X Y Z Rz Rx Ry
+#define SWEEP_REPORT_LEN            8
+
+/**
+ * @brief 模拟手柄状态
+ */
+typedef struct {
+    bool connected;
+    esp_bd_addr_t bda;
+    int64_t nominal_us;          ///< 不含抖动的计划时刻
+    int64_t next_us;             ///< 含抖动的下次发送时刻
+    size_t script_pos;           ///< 脚本播放位置
+    uint32_t phase;              ///< 内置扫动相位
+} loopback_device_t;
+
+/**
+ * @brief 内部统计（生成任务和注入调用者并发更新）
+ */
+typedef struct {
+    _Atomic uint32_t generated;
+    _Atomic uint32_t dropped;
+    _Atomic uint32_t delivered;
+    _Atomic uint32_t output_reports;
+    _Atomic uint32_t late_max_us;
+} loopback_counters_t;
+
+static const hid_transport_callbacks_t *callbacks = NULL;
+static loopback_device_t devices[HID_LOOPBACK_MAX_DEVICES];
+static loopback_counters_t counters;
+static TaskHandle_t loopback_task_handle = NULL;
+static volatile bool running = false;
+static uint32_t rng_state;
+
+static hid_loopback_config_t config = {
+    .device_count = CONFIG_BLUETOOTH_HID_LOOPBACK_DEVICES,
+    .rate_hz = CONFIG_BLUETOOTH_HID_LOOPBACK_RATE_HZ,
+    .jitter_us = CONFIG_BLUETOOTH_HID_LOOPBACK_JITTER_US,
+    .drop_per_mille = CONFIG_BLUETOOTH_HID_LOOPBACK_DROP_PER_MILLE,
+    .seed = 1,
+    .script = NULL,
+    .script_len = 0
+};
+
+/**
+ * @brief xorshift32，同一种子得到可重复的抖动和丢包序列
+ */
+static inline uint32_t next_random(void)
+{
+    uint32_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rng_state = x;
+    return x;
+}
+
+/**
+ * @brief 周期512的三角波 (0-255)
+ */
+static inline uint8_t triangle(uint32_t phase)
+{
+    uint8_t ramp = (uint8_t)phase;
+    return (phase & 0x100) ? (uint8_t)(0xFF - ramp) : ramp;
+}
+
+static int find_device_by_bda(const uint8_t *bda)
+{
+    for (int i = 0; i < HID_LOOPBACK_MAX_DEVICES; i++) {
+        if (memcmp(devices[i].bda, bda, sizeof(esp_bd_addr_t)) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief 排定下一次发送时刻
+ */
+static void schedule_next(loopback_device_t *dev, int64_t now)
+{
+    int64_t period = 1000000 / config.rate_hz;
+    dev->nominal_us += period;
+    if (now - dev->nominal_us > LOOPBACK_RESYNC_US) {
+        dev->nominal_us = now + period;
+    }
+
+    int64_t jitter = 0;
+    if (config.jitter_us > 0) {
+        jitter = (int64_t)(next_random() % (2 * config.jitter_us + 1)) - config.jitter_us;
+    }
+    dev->next_us = dev->nominal_us + jitter;
+}
+
+/**
+ * @brief 模拟手柄连接：与真实手柄一样先上报连接，再开始发送报告
+ */
+static void connect_device(int index)
+{
+    loopback_device_t *dev = &devices[index];
+    char name[24];
+    snprintf(name, sizeof(name), "Loopback Gamepad %d", index);
+
+    // 先排程再置连接标志，生成任务看到的总是有效的发送时刻
+    dev->script_pos = 0;
+    dev->phase = 0;
+    dev->nominal_us = esp_timer_get_time();
+    dev->next_us = dev->nominal_us;
+    dev->connected = true;
+
+    // 不提供描述符，使用通用手柄的内置布局
+    hid_transport_dev_info_t info = {
+        .name = name,
+        .vendor_id = 0,
+        .product_id = 0,
+        .version = 0,
+        .report_desc = NULL,
+        .report_desc_len = 0,
+        .transport = 0
+    };
+    callbacks->on_open(dev, dev->bda, ESP_OK, &info);
+
+    // 模拟电池服务通知，使电量读取链路也能在本机运行
+    callbacks->on_battery(dev, 100);
+}
+
+/**
+ * @brief 生成一个报告：脚本帧或内置的摇杆/扳机三角波扫动
+ */
+static void emit_report(loopback_device_t *dev)
+{
+    uint8_t data[HID_LOOPBACK_MAX_FRAME_LEN];
+    uint8_t report_id = 0;
+    uint16_t len;
+
+    if (config.script && config.script_len > 0) {
+        const hid_loopback_frame_t *frame = &config.script[dev->script_pos];
+        dev->script_pos = (dev->script_pos + 1) % config.script_len;
+        report_id = frame->report_id;
+        len = frame->len;
+        memcpy(data, frame->data, len);
+    } else {
+        uint32_t phase = dev->phase++;
+        uint8_t tri = triangle(phase);
+        uint8_t tri_q = triangle(phase + 0x80);
+        len = SWEEP_REPORT_LEN;
+        data[0] = 0;             // 按键保持松开，避免误触发组合键
+        data[1] = 0;
+        data[2] = tri;           // 左摇杆X
+        data[3] = tri_q;         // 左摇杆Y（相位差90度）
+        data[4] = 0x80;          // 右摇杆X
+        data[5] = 0x80;          // 右摇杆Y
+        data[6] = tri;           // 左扳机
+        data[7] = tri_q;         // 右扳机
+    }
+
+    callbacks->on_input(dev, report_id, 0, data, len);
+    atomic_fetch_add_explicit(&counters.delivered, 1, memory_order_relaxed);
+}
+
+static void update_late_max(uint32_t late_us)
+{
+    uint32_t prev = atomic_load_explicit(&counters.late_max_us, memory_order_relaxed);
+    while (late_us > prev &&
+           !atomic_compare_exchange_weak_explicit(&counters.late_max_us, &prev, late_us,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief 生成任务：每个节拍发出所有已到期的报告
+ */
+static void loopback_task(void *arg)
+{
+    for (int i = 0; i < config.device_count && i < HID_LOOPBACK_MAX_DEVICES; i++) {
+        connect_device(i);
+    }
+
+    while (running) {
+        if (config.rate_hz > 0) {
+            int64_t now = esp_timer_get_time();
+            for (int i = 0; i < HID_LOOPBACK_MAX_DEVICES; i++) {
+                loopback_device_t *dev = &devices[i];
+                while (running && dev->connected && dev->next_us <= now) {
+                    atomic_fetch_add_explicit(&counters.generated, 1, memory_order_relaxed);
+                    if (config.drop_per_mille > 0 && next_random() % 1000 < config.drop_per_mille) {
+                        atomic_fetch_add_explicit(&counters.dropped, 1, memory_order_relaxed);
+                    } else {
+                        update_late_max((uint32_t)(esp_timer_get_time() - dev->next_us));
+                        emit_report(dev);
+                    }
+                    schedule_next(dev, now);
+                }
+            }
+        }
+        vTaskDelay(1);
+    }
+
+    loopback_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+static esp_err_t loopback_init(const hid_transport_callbacks_t *cb)
+{
+    callbacks = cb;
+    rng_state = config.seed ? config.seed : 1;
+    memset(&counters, 0, sizeof(counters));
+
+    // 地址 02:4C:4F:4F:50:nn ("LOOP")，本地管理地址不会与真实设备冲突
+    for (int i = 0; i < HID_LOOPBACK_MAX_DEVICES; i++) {
+        static const uint8_t base[ESP_BD_ADDR_LEN] = {0x02, 'L', 'O', 'O', 'P', 0};
+        memset(&devices[i], 0, sizeof(devices[i]));
+        memcpy(devices[i].bda, base, sizeof(base));
+        devices[i].bda[5] = (uint8_t)i;
+    }
+
+    running = true;
+    BaseType_t ret = xTaskCreate(loopback_task, "hid_loopback", LOOPBACK_TASK_STACK_SIZE,
+                                 NULL, LOOPBACK_TASK_PRIORITY, &loopback_task_handle);
+    if (ret != pdPASS) {
+        running = false;
+        ESP_LOGE(TAG, "Failed to create loopback task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Loopback transport: %d device(s), %lu Hz, jitter %lu us, drop %u/1000",
+             config.device_count, (unsigned long)config.rate_hz,
+             (unsigned long)config.jitter_us, config.drop_per_mille);
+    return ESP_OK;
+}
+
+static esp_err_t loopback_deinit(void)
+{
+    running = false;
+    while (loopback_task_handle != NULL) {
+        vTaskDelay(1);
+    }
+
+    for (int i = 0; i < HID_LOOPBACK_MAX_DEVICES; i++) {
+        if (devices[i].connected) {
+            devices[i].connected = false;
+            callbacks->on_close(&devices[i], 0);
+        }
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 扫描：依次"发现"未连接的模拟手柄，扫描立即结束
+ */
+static esp_err_t loopback_start_scan(uint32_t duration_sec)
+{
+    const uint8_t *selected = NULL;
+    for (int i = 0; i < HID_LOOPBACK_MAX_DEVICES && !selected; i++) {
+        if (devices[i].connected) {
+            continue;
+        }
+        // 槽位号越大信号越弱，候选排序结果可预期
+        char name[24];
+        snprintf(name, sizeof(name), "Loopback Gamepad %d", i);
+        hid_transport_disc_result_t result = {
+            .bda = devices[i].bda,
+            .cod = LOOPBACK_COD,
+            .rssi = (int8_t)(LOOPBACK_RSSI - i),
+            .company_id = 0xFFFF,
+            .name = name
+        };
+        if (callbacks->on_discovered(&result)) {
+            selected = devices[i].bda;
+        }
+    }
+    callbacks->on_scan_stopped(selected);
+    return ESP_OK;
+}
+
+static esp_err_t loopback_stop_scan(void)
+{
+    return ESP_OK;
+}
+
+static esp_err_t loopback_open(const uint8_t *bda, void **dev_handle)
+{
+    int index = find_device_by_bda(bda);
+    if (index < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (devices[index].connected) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    *dev_handle = &devices[index];
+    connect_device(index);
+    return ESP_OK;
+}
+
+static esp_err_t loopback_close(void *dev_handle)
+{
+    loopback_device_t *dev = (loopback_device_t *)dev_handle;
+    if (!dev->connected) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    dev->connected = false;
+    callbacks->on_close(dev, 0);
+    return ESP_OK;
+}
+
+static esp_err_t loopback_send_output(void *dev_handle, uint8_t report_id, uint8_t *data, uint16_t len)
+{
+    atomic_fetch_add_explicit(&counters.output_reports, 1, memory_order_relaxed);
+    ESP_LOGD(TAG, "Output report 0x%02x, %d bytes", report_id, len);
+    return ESP_OK;
+}
+
+static esp_err_t loopback_set_discoverable(bool discoverable, bool connectable)
+{
+    return ESP_OK;
+}
+
+static esp_err_t loopback_read_rssi(void *dev_handle)
+{
+    loopback_device_t *dev = (loopback_device_t *)dev_handle;
+    callbacks->on_rssi(dev->bda, LOOPBACK_RSSI);
+    return ESP_OK;
+}
+
+static const hid_transport_ops_t loopback_transport = {
+    .name = "loopback",
+    .supports_bonding = false,
+    .init = loopback_init,
+    .deinit = loopback_deinit,
+    .start_scan = loopback_start_scan,
+    .stop_scan = loopback_stop_scan,
+    .open = loopback_open,
+    .close = loopback_close,
+    .send_output = loopback_send_output,
+    .set_discoverable = loopback_set_discoverable,
+    .is_bonded = NULL,
+    .read_rssi = loopback_read_rssi,
+    .set_page_timeout = NULL
+};
+
+const hid_transport_ops_t *hid_transport_loopback(void)
+{
+    return &loopback_transport;
+}
+
+esp_err_t hid_loopback_configure(const hid_loopback_config_t *cfg)
+{
+    if (!cfg || cfg->device_count > HID_LOOPBACK_MAX_DEVICES || (cfg->script_len > 0 && !cfg->script) ||
+        cfg->drop_per_mille > 1000 || cfg->rate_hz > 1000000) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < cfg->script_len; i++) {
+        if (cfg->script[i].len > HID_LOOPBACK_MAX_FRAME_LEN) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    if (running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    config = *cfg;
+    return ESP_OK;
+}
+
+esp_err_t hid_loopback_inject(uint8_t device, uint8_t report_id, const uint8_t *data, uint16_t len)
+{
+    if (!data || len == 0 || len > HID_LOOPBACK_MAX_FRAME_LEN || device >= HID_LOOPBACK_MAX_DEVICES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!running || !devices[device].connected) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint8_t buffer[HID_LOOPBACK_MAX_FRAME_LEN];
+    memcpy(buffer, data, len);
+    callbacks->on_input(&devices[device], report_id, 0, buffer, len);
+    atomic_fetch_add_explicit(&counters.delivered, 1, memory_order_relaxed);
+    return ESP_OK;
+}
+
+esp_err_t hid_loopback_get_stats(hid_loopback_stats_t *stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    stats->generated = atomic_load_explicit(&counters.generated, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&counters.dropped, memory_order_relaxed);
+    stats->delivered = atomic_load_explicit(&counters.delivered, memory_order_relaxed);
+    stats->output_reports = atomic_load_explicit(&counters.output_reports, memory_order_relaxed);
+    stats->late_max_us = atomic_load_explicit(&counters.late_max_us, memory_order_relaxed);
+    return ESP_OK;
+}
@@ -57,6 +57,23 @@ typedef enum {
     ACCEL_CURVE_MAX
 } accel_curve_t;
 
+/* 摇杆滤波器类型 */
+typedef enum {
+    FILTER_TYPE_NONE = 0,
+    FILTER_TYPE_EMA,
+    FILTER_TYPE_ONE_EURO,
+    FILTER_TYPE_MAX
+} filter_type_t;
+
+/* 摇杆轴编号（滤波参数按此顺序存放） */
+typedef enum {
+    STICK_AXIS_LX = 0,
+    STICK_AXIS_LY,
+    STICK_AXIS_RX,
+    STICK_AXIS_RY,
+    STICK_AXIS_MAX
+} stick_axis_t;
+
 /* 震动模式类型 */
 typedef enum {
     VIBRATION_PATTERN_SINGLE = 0,
@@ -65,6 +82,14 @@ typedef enum {
     VIBRATION_PATTERN_MAX
 } vibration_pattern_t;
 
+/* 震动输出目标 */
+typedef enum {
+    VIBRATION_OUTPUT_TARGET_PAD = 0,     // 手柄马达
+    VIBRATION_OUTPUT_TARGET_LOCAL,       // 本机GPIO上的马达
+    VIBRATION_OUTPUT_TARGET_BOTH,
+    VIBRATION_OUTPUT_TARGET_MAX
+} vibration_output_target_t;
+
 /* 日志级别 */
 typedef enum {
     LOG_LEVEL_ERROR = 0,
@@ -83,12 +108,22 @@ typedef struct {
     uint8_t max_reconnect_attempts;
 } gamepad_config_t;
 
+/* 单轴滤波配置结构 */
+typedef struct {
+    filter_type_t type;
+    uint8_t ema_alpha;           // EMA系数 (1-255)
+    float min_cutoff;            // One-Euro最小截止频率 (Hz)
+    float beta;                  // One-Euro速度系数 (Hz / (原始单位/ms))
+    float d_cutoff;              // One-Euro速度截止频率 (Hz)
+} axis_filter_config_t;
+
 /* 控制配置结构 */
 typedef struct {
     control_mode_t default_mode;
     uint8_t stick_deadzone;
     uint8_t max_speed;
     accel_curve_t acceleration_curve;
+    axis_filter_config_t stick_filter[STICK_AXIS_MAX];
 } control_config_t;
 
 /* 震动配置结构 */
@@ -97,6 +132,7 @@ typedef struct {
     uint8_t default_intensity;
     uint16_t default_duration;
     vibration_pattern_t default_pattern;
+    vibration_output_target_t output;    // 默认输出目标，本地马达引脚见gpio配置
 } vibration_config_t;
 
 /* 蓝牙配置结构 */
@@ -144,7 +180,7 @@ typedef struct {
 typedef struct {
     bool enable_watchdog;
     uint32_t connection_lost_timeout;
-    uint32_t emergency_stop_keys;
+    uint32_t emergency_stop_keys;      // 按键位图，位号与gamepad_button_t一致
     bool battery_monitor;
     float low_battery_threshold;
 } safety_config_t;
@@ -155,6 +191,7 @@ typedef struct {
     log_level_t log_level;
     uint32_t uart_baudrate;
     bool enable_performance_monitor;
+    bool hid_trace_record;             // 录制HID输入报告到SPIFFS
 } debug_config_t;
 
 /* 全局配置结构 */
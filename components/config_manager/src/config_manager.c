@@ -12,6 +12,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <ctype.h>
 #include "esp_log.h"
 #include "esp_system.h"
@@ -52,13 +53,23 @@ static const global_config_t g_default_config = {
         .default_mode = CONTROL_MODE_CAR,
         .stick_deadzone = 10,
         .max_speed = 255,
-        .acceleration_curve = ACCEL_CURVE_EXPONENTIAL
+        .acceleration_curve = ACCEL_CURVE_EXPONENTIAL,
+        .stick_filter = {
+            [0 ... STICK_AXIS_MAX - 1] = {
+                .type = FILTER_TYPE_ONE_EURO,
+                .ema_alpha = 64,
+                .min_cutoff = 1.0,
+                .beta = 0.05,
+                .d_cutoff = 1.0
+            }
+        }
     },
     .vibration = {
         .enable_vibration = true,
         .default_intensity = 128,
         .default_duration = 200,
-        .default_pattern = VIBRATION_PATTERN_SINGLE
+        .default_pattern = VIBRATION_PATTERN_SINGLE,
+        .output = VIBRATION_OUTPUT_TARGET_PAD
     },
     .bluetooth = {
         .device_name = "ESP32-Gamepad",
@@ -91,7 +102,7 @@ static const global_config_t g_default_config = {
     .safety = {
         .enable_watchdog = true,
         .connection_lost_timeout = 5000,
-        .emergency_stop_keys = 0x0F, // L1+R1+SELECT+START
+        .emergency_stop_keys = 0x0330, // L1+R1+SELECT+START
         .battery_monitor = true,
         .low_battery_threshold = 3.3
     },
@@ -99,10 +110,14 @@ static const global_config_t g_default_config = {
         .enable_debug = true,
         .log_level = LOG_LEVEL_INFO,
         .uart_baudrate = 115200,
-        .enable_performance_monitor = false
+        .enable_performance_monitor = false,
+        .hid_trace_record = false
     }
 };
 
+/* 摇杆轴名称，用作滤波配置键的后缀 */
+static const char *const g_stick_axis_names[STICK_AXIS_MAX] = { "lx", "ly", "rx", "ry" };
+
 /* 私有函数声明 */
 static esp_err_t config_init_spiffs(void);
 static esp_err_t config_init_nvs(void);
@@ -119,7 +134,11 @@ static char* config_trim_whitespace(char *str);
 static controller_type_t config_parse_controller_type(const char *str);
 static control_mode_t config_parse_control_mode(const char *str);
 static accel_curve_t config_parse_accel_curve(const char *str);
+static filter_type_t config_parse_filter_type(const char *str);
+static uint32_t config_parse_button_mask(const char *str);
+static bool config_parse_filter_key(const char *key, const char *value);
 static vibration_pattern_t config_parse_vibration_pattern(const char *str);
+static vibration_output_target_t config_parse_vibration_output(const char *str);
 static log_level_t config_parse_log_level(const char *str);
 static void config_notify_update(config_type_t type, const void *config);
 
@@ -263,13 +282,23 @@ esp_err_t config_manager_save(const char *config_file)
     fprintf(file, "default_mode = %d\n", g_config.control.default_mode);
     fprintf(file, "stick_deadzone = %d\n", g_config.control.stick_deadzone);
     fprintf(file, "max_speed = %d\n", g_config.control.max_speed);
-    fprintf(file, "acceleration_curve = %d\n\n", g_config.control.acceleration_curve);
+    fprintf(file, "acceleration_curve = %d\n", g_config.control.acceleration_curve);
+    for (int i = 0; i < STICK_AXIS_MAX; i++) {
+        const axis_filter_config_t *filter = &g_config.control.stick_filter[i];
+        fprintf(file, "stick_filter_%s = %d\n", g_stick_axis_names[i], filter->type);
+        fprintf(file, "filter_ema_alpha_%s = %d\n", g_stick_axis_names[i], filter->ema_alpha);
+        fprintf(file, "filter_min_cutoff_%s = %.3f\n", g_stick_axis_names[i], filter->min_cutoff);
+        fprintf(file, "filter_beta_%s = %.4f\n", g_stick_axis_names[i], filter->beta);
+        fprintf(file, "filter_d_cutoff_%s = %.3f\n", g_stick_axis_names[i], filter->d_cutoff);
+    }
+    fprintf(file, "\n");
 
     fprintf(file, "[vibration]\n");
     fprintf(file, "enable_vibration = %s\n", g_config.vibration.enable_vibration ? "true" : "false");
     fprintf(file, "default_intensity = %d\n", g_config.vibration.default_intensity);
     fprintf(file, "default_duration = %d\n", g_config.vibration.default_duration);
-    fprintf(file, "default_pattern = %d\n\n", g_config.vibration.default_pattern);
+    fprintf(file, "default_pattern = %d\n", g_config.vibration.default_pattern);
+    fprintf(file, "output = %d\n\n", g_config.vibration.output);
 
     fprintf(file, "[bluetooth]\n");
     fprintf(file, "device_name = %s\n", g_config.bluetooth.device_name);
@@ -354,6 +383,41 @@ const debug_config_t* config_manager_get_debug_config(void)
     return g_config_initialized ? &g_config.debug : NULL;
 }
 
+/**
+ * @brief 设置手柄配置
+ */
+esp_err_t config_manager_set_gamepad_config(const gamepad_config_t *config)
+{
+    if (!g_config_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!config || config->default_controller >= CONTROLLER_TYPE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    g_config.gamepad = *config;
+    config_notify_update(CONFIG_TYPE_GAMEPAD, &g_config.gamepad);
+    return ESP_OK;
+}
+
+/**
+ * @brief 设置控制配置
+ */
+esp_err_t config_manager_set_control_config(const control_config_t *config)
+{
+    if (!g_config_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!config || config->default_mode >= CONTROL_MODE_MAX ||
+        config->stick_deadzone > 50 || config->acceleration_curve >= ACCEL_CURVE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    g_config.control = *config;
+    config_notify_update(CONFIG_TYPE_CONTROL, &g_config.control);
+    return ESP_OK;
+}
+
 /**
  * @brief 重置所有配置为默认值
  */
@@ -394,6 +458,21 @@ esp_err_t config_manager_validate_config(void)
         return ESP_ERR_INVALID_ARG;
     }
 
+    for (int i = 0; i < STICK_AXIS_MAX; i++) {
+        const axis_filter_config_t *filter = &g_config.control.stick_filter[i];
+        if (filter->type >= FILTER_TYPE_MAX || filter->ema_alpha == 0 ||
+            filter->min_cutoff <= 0 || filter->d_cutoff <= 0 || filter->beta < 0) {
+            ESP_LOGE(TAG, "Invalid stick filter for axis %s", g_stick_axis_names[i]);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    // 验证震动配置
+    if (g_config.vibration.output >= VIBRATION_OUTPUT_TARGET_MAX) {
+        ESP_LOGE(TAG, "Invalid vibration output");
+        return ESP_ERR_INVALID_ARG;
+    }
+
     // 验证PWM配置
     if (g_config.pwm.motor_frequency == 0 || g_config.pwm.servo_frequency == 0) {
         ESP_LOGE(TAG, "Invalid PWM frequency");
@@ -560,10 +639,66 @@ static esp_err_t config_parse_control_section(const char *key, const char *value
         g_config.control.max_speed = atoi(value);
     } else if (strcmp(key, "acceleration_curve") == 0) {
         g_config.control.acceleration_curve = config_parse_accel_curve(value);
+    } else {
+        config_parse_filter_key(key, value);
     }
     return ESP_OK;
 }
 
+/**
+ * @brief 解析摇杆滤波配置键
+ *
+ * 不带后缀的键（如 filter_beta）作用于所有轴，带轴后缀的键（如 filter_beta_rx）
+ * 只作用于对应轴，可用于覆盖前者。
+ */
+static bool config_parse_filter_key(const char *key, const char *value)
+{
+    static const char *const base_keys[] = {
+        "stick_filter", "filter_ema_alpha", "filter_min_cutoff", "filter_beta", "filter_d_cutoff"
+    };
+
+    for (size_t k = 0; k < sizeof(base_keys) / sizeof(base_keys[0]); k++) {
+        size_t base_len = strlen(base_keys[k]);
+        if (strncmp(key, base_keys[k], base_len) != 0) {
+            continue;
+        }
+
+        // 确定作用的轴范围
+        const char *suffix = key + base_len;
+        int first = 0, last = STICK_AXIS_MAX - 1;
+        if (*suffix != '\0') {
+            if (*suffix != '_') {
+                continue;
+            }
+            first = -1;
+            for (int i = 0; i < STICK_AXIS_MAX; i++) {
+                if (strcmp(suffix + 1, g_stick_axis_names[i]) == 0) {
+                    first = last = i;
+                    break;
+                }
+            }
+            if (first < 0) {
+                continue;
+            }
+        }
+
+        for (int i = first; i <= last; i++) {
+            axis_filter_config_t *filter = &g_config.control.stick_filter[i];
+            switch (k) {
+            case 0: filter->type = config_parse_filter_type(value); break;
+            case 1: filter->ema_alpha = atoi(value); break;
+            case 2: filter->min_cutoff = atof(value); break;
+            case 3: filter->beta = atof(value); break;
+            case 4: filter->d_cutoff = atof(value); break;
+            default: break;
+            }
+        }
+        return true;
+    }
+
+    return false;
+}
+
 /**
  * @brief 解析震动配置节
  */
@@ -577,6 +712,8 @@ static esp_err_t config_parse_vibration_section(const char *key, const char *val
         g_config.vibration.default_duration = atoi(value);
     } else if (strcmp(key, "default_pattern") == 0) {
         g_config.vibration.default_pattern = config_parse_vibration_pattern(value);
+    } else if (strcmp(key, "output") == 0) {
+        g_config.vibration.output = config_parse_vibration_output(value);
     }
     return ESP_OK;
 }
@@ -663,6 +800,13 @@ static esp_err_t config_parse_safety_section(const char *key, const char *value)
         g_config.safety.enable_watchdog = (strcmp(value, "true") == 0);
     } else if (strcmp(key, "connection_lost_timeout") == 0) {
         g_config.safety.connection_lost_timeout = atoi(value);
+    } else if (strcmp(key, "emergency_stop_keys") == 0) {
+        uint32_t keys = config_parse_button_mask(value);
+        if (keys != 0) {
+            g_config.safety.emergency_stop_keys = keys;
+        } else {
+            ESP_LOGW(TAG, "Invalid emergency_stop_keys: %s", value);
+        }
     } else if (strcmp(key, "battery_monitor") == 0) {
         g_config.safety.battery_monitor = (strcmp(value, "true") == 0);
     } else if (strcmp(key, "low_battery_threshold") == 0) {
@@ -684,6 +828,8 @@ static esp_err_t config_parse_debug_section(const char *key, const char *value)
         g_config.debug.uart_baudrate = atoi(value);
     } else if (strcmp(key, "enable_performance_monitor") == 0) {
         g_config.debug.enable_performance_monitor = (strcmp(value, "true") == 0);
+    } else if (strcmp(key, "hid_trace_record") == 0) {
+        g_config.debug.hid_trace_record = (strcmp(value, "true") == 0);
     }
     return ESP_OK;
 }
@@ -742,6 +888,61 @@ static accel_curve_t config_parse_accel_curve(const char *str)
     return (accel_curve_t)atoi(str);
 }
 
+/**
+ * @brief 解析摇杆滤波器类型字符串
+ */
+static filter_type_t config_parse_filter_type(const char *str)
+{
+    if (strcmp(str, "none") == 0) return FILTER_TYPE_NONE;
+    if (strcmp(str, "ema") == 0) return FILTER_TYPE_EMA;
+    if (strcmp(str, "one_euro") == 0) return FILTER_TYPE_ONE_EURO;
+    return (filter_type_t)atoi(str);
+}
+
+/**
+ * @brief 解析按键列表字符串（如 "L1,R1,SELECT,START"）为按键位图
+ * @return 按键位图，含无法识别的按键名时返回0
+ */
+static uint32_t config_parse_button_mask(const char *str)
+{
+    // 按键名顺序即位号，与gamepad_button_t一致
+    static const char *const button_names[] = {
+        "A", "B", "X", "Y", "L1", "R1", "L2", "R2",
+        "SELECT", "START", "HOME", "UP", "DOWN", "LEFT", "RIGHT"
+    };
+
+    uint32_t mask = 0;
+    char name[16];
+    while (*str) {
+        size_t len = strcspn(str, ",+");
+        if (len > 0 && len < sizeof(name)) {
+            memcpy(name, str, len);
+            name[len] = '\0';
+            char *trimmed = config_trim_whitespace(name);
+            if (*trimmed == '\0') {
+                str += len + (str[len] ? 1 : 0);
+                continue;
+            }
+
+            size_t i;
+            for (i = 0; i < sizeof(button_names) / sizeof(button_names[0]); i++) {
+                if (strcasecmp(trimmed, button_names[i]) == 0) {
+                    mask |= 1UL << i;
+                    break;
+                }
+            }
+            if (i == sizeof(button_names) / sizeof(button_names[0])) {
+                return 0;
+            }
+        }
+        str += len;
+        if (*str) {
+            str++;
+        }
+    }
+    return mask;
+}
+
 /**
  * @brief 解析震动模式字符串
  */
@@ -753,6 +954,17 @@ static vibration_pattern_t config_parse_vibration_pattern(const char *str)
     return (vibration_pattern_t)atoi(str);
 }
 
+/**
+ * @brief 解析震动输出目标字符串
+ */
+static vibration_output_target_t config_parse_vibration_output(const char *str)
+{
+    if (strcmp(str, "pad") == 0) return VIBRATION_OUTPUT_TARGET_PAD;
+    if (strcmp(str, "local") == 0) return VIBRATION_OUTPUT_TARGET_LOCAL;
+    if (strcmp(str, "both") == 0) return VIBRATION_OUTPUT_TARGET_BOTH;
+    return (vibration_output_target_t)atoi(str);
+}
+
 /**
  * @brief 解析日志级别字符串
  */
@@ -769,7 +981,7 @@ static log_level_t config_parse_log_level(const char *str)
 /**
  * @brief 通知配置更新
  */
-static void __attribute__((unused)) config_notify_update(config_type_t type, const void *config)
+static void config_notify_update(config_type_t type, const void *config)
 {
     if (g_update_callback) {
         g_update_callback(type, config);
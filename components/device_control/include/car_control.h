@@ -21,6 +21,8 @@ typedef struct {
     int16_t forward_speed;    ///< 前进速度 (-1000 to 1000)
     int16_t turn_speed;       ///< 转向速度 (-1000 to 1000)
     bool brake_enable;        ///< 刹车使能
+    uint32_t input_seq;       ///< 来源输入报告序号
+    int64_t input_time_us;    ///< 来源输入报告到达时间(esp_timer微秒)，0表示非手柄输入
 } car_control_params_t;
 
 /**
@@ -22,6 +22,8 @@ typedef struct {
     int16_t elevator;         ///< 升降舵 (-1000 to 1000)
     int16_t rudder;           ///< 方向舵 (-1000 to 1000)
     int16_t aileron;          ///< 副翼 (-1000 to 1000)
+    uint32_t input_seq;       ///< 来源输入报告序号
+    int64_t input_time_us;    ///< 来源输入报告到达时间(esp_timer微秒)，0表示非手柄输入
 } plane_control_params_t;
 
 /**
@@ -4,6 +4,7 @@
  */
 
 #include "car_control.h"
+#include "system_monitor.h"
 #include "esp_log.h"
 #include "driver/gpio.h"
 #include "driver/ledc.h"
@@ -277,6 +278,9 @@ esp_err_t car_control_set_motion(const car_control_params_t *params)
         return ret;
     }
     
+    // 两路占空比都已生效，记录输入到PWM的延迟
+    system_monitor_record_pwm_update(params->input_seq, params->input_time_us);
+    
     // 更新当前状态
     current_params.forward_speed = forward_speed;
     current_params.turn_speed = turn_speed;
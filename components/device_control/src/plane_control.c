@@ -4,6 +4,7 @@
  */
 
 #include "plane_control.h"
+#include "system_monitor.h"
 #include "esp_log.h"
 #include "driver/ledc.h"
 #include "freertos/FreeRTOS.h"
@@ -314,6 +315,9 @@ esp_err_t plane_control_set_params(const plane_control_params_t *params)
     }
     ledc_update_duty(LEDC_MODE, LEDC_AILERON_CHANNEL);
     
+    // 四路占空比都已生效，记录输入到PWM的延迟
+    system_monitor_record_pwm_update(params->input_seq, params->input_time_us);
+    
     // 更新当前状态
     current_params.throttle = throttle;
     current_params.elevator = elevator;
@@ -15,6 +15,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include "esp_err.h"
+#include "hid_link_stats.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -74,17 +75,24 @@ typedef struct {
     uint32_t error_count;           /**< 错误计数 */
     float connection_success_rate;  /**< 连接成功率(%) */
     uint32_t avg_connection_time;   /**< 平均连接时间(ms) */
+    uint32_t report_gaps;           /**< 所有链路的报告断档次数 */
+    hid_link_stats_t links[HID_LINK_STATS_MAX_DEVICES]; /**< 各槽位链路质量与报告节奏 */
 } connection_stats_t;
 
 /* 性能统计信息 */
 typedef struct {
     uint32_t input_processing_time; /**< 输入处理时间(us) */
     uint32_t output_processing_time; /**< 输出处理时间(us) */
-    uint32_t bluetooth_latency;     /**< 蓝牙延迟(ms) */
-    uint32_t control_latency;       /**< 控制延迟(ms) */
+    uint32_t bluetooth_latency;     /**< 蓝牙延迟(ms)，空口延迟无法在主机端测量，固定为0 */
+    uint32_t control_latency;       /**< 控制延迟(ms)，输入报告到PWM更新的中位数 */
     uint16_t input_frequency;       /**< 输入频率(Hz) */
     uint16_t output_frequency;      /**< 输出频率(Hz) */
     uint8_t system_load;            /**< 系统负载(%) */
+    uint32_t latency_samples;       /**< 输入到PWM延迟样本数 */
+    uint32_t latency_p50_us;        /**< 输入到PWM延迟中位数(us) */
+    uint32_t latency_p90_us;        /**< 输入到PWM延迟P90(us) */
+    uint32_t latency_p99_us;        /**< 输入到PWM延迟P99(us) */
+    uint32_t latency_max_us;        /**< 输入到PWM最大延迟(us) */
 } performance_stats_t;
 
 /* 错误信息结构 */
@@ -98,6 +106,7 @@ typedef struct {
 /* 系统监控回调函数类型 */
 typedef void (*system_state_callback_t)(system_state_t old_state, system_state_t new_state);
 typedef void (*connection_state_callback_t)(connection_state_t state);
+/* 手柄电池的档位变化也通过电源回调通知，此时voltage为-1（手柄只上报电量百分比） */
 typedef void (*power_state_callback_t)(power_state_t state, float voltage);
 typedef void (*error_callback_t)(const error_info_t *error);
 typedef void (*resource_alert_callback_t)(const char *resource, uint8_t usage);
@@ -219,6 +228,24 @@ esp_err_t system_monitor_record_data_event(uint32_t sent, uint32_t received);
  */
 esp_err_t system_monitor_record_performance(uint32_t input_time, uint32_t output_time, uint32_t latency);
 
+/**
+ * @brief 记录一次由输入报告驱动的PWM更新
+ * 
+ * 在ledc_update_duty之后调用。同一输入报告只记录第一次更新，
+ * 延迟计入对数分桶直方图，无需先初始化系统监控，可在任意任务中调用。
+ * 
+ * @param input_seq 输入报告序号
+ * @param input_time_us 输入报告到达时间(esp_timer微秒)，0表示非手柄输入，不记录
+ */
+void system_monitor_record_pwm_update(uint32_t input_seq, int64_t input_time_us);
+
+/**
+ * @brief 清空输入到PWM延迟直方图
+ * 
+ * 切换控制调度模式时调用，使统计只反映新模式。无需先初始化系统监控，可在任意任务中调用。
+ */
+void system_monitor_reset_latency(void);
+
 /**
  * @brief 记录错误事件
  * 
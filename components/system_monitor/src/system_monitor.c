@@ -9,6 +9,8 @@
  */
 
 #include "system_monitor.h"
+#include "hid_output_sched.h"
+#include "hid_battery.h"
 #include "esp_log.h"
 #include "esp_system.h"
 #include "esp_timer.h"
@@ -20,6 +22,7 @@
 #include "esp_pm.h"
 #include <string.h>
 #include <math.h>
+#include <stdatomic.h>
 
 static const char *TAG = "SYS_MONITOR";
 
@@ -34,6 +37,17 @@ static system_resources_t resources = {0};
 static connection_stats_t conn_stats = {0};
 static performance_stats_t perf_stats = {0};
 
+/* 输入到PWM延迟直方图：每个2的幂区间分4个子桶，相对误差不超过25% */
+#define LATENCY_SUB_BUCKET_BITS     2
+#define LATENCY_SUB_BUCKETS         (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_MAX_MSB             23      /* 覆盖到约16秒，超出部分计入最后一个桶 */
+#define LATENCY_BUCKET_COUNT        ((LATENCY_MAX_MSB - LATENCY_SUB_BUCKET_BITS + 2) * LATENCY_SUB_BUCKETS)
+
+static _Atomic uint32_t latency_buckets[LATENCY_BUCKET_COUNT];
+static _Atomic uint32_t latency_samples = 0;
+static _Atomic uint32_t latency_max_us = 0;
+static _Atomic uint32_t latency_last_seq = 0;
+
 /* 回调函数 */
 static system_state_callback_t system_state_cb = NULL;
 static connection_state_callback_t connection_state_cb = NULL;
@@ -53,6 +67,7 @@ static void monitor_timer_callback(void *arg);
 static void update_system_resources(void);
 static void update_performance_stats(void);
 static void check_power_state(void);
+static void controller_battery_callback(uint8_t slot, const hid_battery_status_t *status);
 
 /**
  * @brief 初始化系统监控模块
@@ -120,6 +135,7 @@ esp_err_t system_monitor_init(void)
     memset(&perf_stats, 0, sizeof(perf_stats));
 
     is_initialized = true;
+    hid_battery_register_callback(controller_battery_callback);
     
     // 设置初始状态
     system_monitor_set_state(SYSTEM_STATE_IDLE);
@@ -159,6 +175,7 @@ esp_err_t system_monitor_deinit(void)
     }
 
     // 清除回调函数
+    hid_battery_register_callback(NULL);
     system_state_cb = NULL;
     connection_state_cb = NULL;
     power_state_cb = NULL;
@@ -286,9 +303,126 @@ esp_err_t system_monitor_get_connection_stats(connection_stats_t *stats)
     }
 
     memcpy(stats, &conn_stats, sizeof(connection_stats_t));
+
+    // 连接次数和数据包数以HID主机的实际计数为准
+    hid_link_counters_t counters;
+    if (hid_link_stats_get_counters(&counters) == ESP_OK) {
+        stats->successful_connections = counters.connects;
+        stats->connection_failures = counters.connect_failures;
+        stats->connection_attempts = counters.connects + counters.connect_failures;
+        stats->disconnections = counters.disconnects;
+        stats->avg_connection_time = counters.avg_connect_ms;
+        stats->connection_success_rate = stats->connection_attempts > 0 ?
+            (float)counters.connects / stats->connection_attempts * 100.0f : 0.0f;
+    }
+
+    hid_output_stats_t output;
+    if (hid_output_sched_get_stats(&output) == ESP_OK) {
+        stats->data_packets_sent = output.sent;
+    }
+
+    stats->data_packets_received = 0;
+    stats->report_gaps = 0;
+    for (uint8_t i = 0; i < HID_LINK_STATS_MAX_DEVICES; i++) {
+        hid_link_stats_get(i, &stats->links[i]);
+        stats->data_packets_received += stats->links[i].reports;
+        stats->report_gaps += stats->links[i].gaps;
+    }
     return ESP_OK;
 }
 
+/**
+ * @brief 延迟值对应的直方图桶
+ */
+static inline uint32_t latency_bucket_index(uint32_t latency_us)
+{
+    if (latency_us < LATENCY_SUB_BUCKETS) {
+        return latency_us;
+    }
+
+    uint32_t msb = 31 - __builtin_clz(latency_us);
+    if (msb > LATENCY_MAX_MSB) {
+        return LATENCY_BUCKET_COUNT - 1;
+    }
+    uint32_t sub = (latency_us >> (msb - LATENCY_SUB_BUCKET_BITS)) & (LATENCY_SUB_BUCKETS - 1);
+    return ((msb - LATENCY_SUB_BUCKET_BITS + 1) << LATENCY_SUB_BUCKET_BITS) + sub;
+}
+
+/**
+ * @brief 直方图桶的上界(us)
+ */
+static inline uint32_t latency_bucket_upper(uint32_t index)
+{
+    if (index < LATENCY_SUB_BUCKETS) {
+        return index;
+    }
+
+    uint32_t msb = (index >> LATENCY_SUB_BUCKET_BITS) + LATENCY_SUB_BUCKET_BITS - 1;
+    uint32_t sub = index & (LATENCY_SUB_BUCKETS - 1);
+    uint32_t width = 1UL << (msb - LATENCY_SUB_BUCKET_BITS);
+    return ((LATENCY_SUB_BUCKETS + sub) << (msb - LATENCY_SUB_BUCKET_BITS)) + width - 1;
+}
+
+/**
+ * @brief 从直方图计算百分位延迟（取桶上界，偏保守）
+ */
+static uint32_t latency_percentile(uint32_t samples, uint32_t percent)
+{
+    if (samples == 0) {
+        return 0;
+    }
+
+    uint32_t target = (uint32_t)(((uint64_t)samples * percent + 99) / 100);
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        count += atomic_load_explicit(&latency_buckets[i], memory_order_relaxed);
+        if (count >= target) {
+            return latency_bucket_upper(i);
+        }
+    }
+    return atomic_load_explicit(&latency_max_us, memory_order_relaxed);
+}
+
+/**
+ * @brief 清空输入到PWM延迟直方图
+ */
+void system_monitor_reset_latency(void)
+{
+    for (uint32_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        atomic_store_explicit(&latency_buckets[i], 0, memory_order_relaxed);
+    }
+    atomic_store_explicit(&latency_samples, 0, memory_order_relaxed);
+    atomic_store_explicit(&latency_max_us, 0, memory_order_relaxed);
+}
+
+/**
+ * @brief 记录一次由输入报告驱动的PWM更新
+ */
+void system_monitor_record_pwm_update(uint32_t input_seq, int64_t input_time_us)
+{
+    if (input_time_us == 0) {
+        return;
+    }
+
+    // 同一报告可能驱动多个控制周期，只统计它第一次到达PWM寄存器的时间
+    uint32_t last = atomic_exchange_explicit(&latency_last_seq, input_seq, memory_order_relaxed);
+    if (last == input_seq) {
+        return;
+    }
+
+    int64_t elapsed = esp_timer_get_time() - input_time_us;
+    uint32_t latency_us = elapsed < 0 ? 0 : elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed;
+
+    atomic_fetch_add_explicit(&latency_buckets[latency_bucket_index(latency_us)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&latency_samples, 1, memory_order_relaxed);
+
+    uint32_t max = atomic_load_explicit(&latency_max_us, memory_order_relaxed);
+    while (latency_us > max &&
+           !atomic_compare_exchange_weak_explicit(&latency_max_us, &max, latency_us,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
 /**
  * @brief 获取性能统计信息
  */
@@ -299,6 +433,15 @@ esp_err_t system_monitor_get_performance_stats(performance_stats_t *stats)
     }
 
     memcpy(stats, &perf_stats, sizeof(performance_stats_t));
+
+    // 百分位按需从直方图计算，读取时允许与记录轻微交错
+    uint32_t samples = atomic_load_explicit(&latency_samples, memory_order_relaxed);
+    stats->latency_samples = samples;
+    stats->latency_p50_us = latency_percentile(samples, 50);
+    stats->latency_p90_us = latency_percentile(samples, 90);
+    stats->latency_p99_us = latency_percentile(samples, 99);
+    stats->latency_max_us = atomic_load_explicit(&latency_max_us, memory_order_relaxed);
+    stats->control_latency = (stats->latency_p50_us + 999) / 1000;
     return ESP_OK;
 }
 
@@ -453,8 +596,8 @@ static void update_performance_stats(void)
     // 目前使用模拟数据
     perf_stats.input_processing_time = 50 + (esp_random() % 100); // 50-150us
     perf_stats.output_processing_time = 30 + (esp_random() % 50); // 30-80us
-    perf_stats.bluetooth_latency = 10 + (esp_random() % 20); // 10-30ms
-    perf_stats.control_latency = 5 + (esp_random() % 10); // 5-15ms
+    perf_stats.bluetooth_latency = 0; // 空口延迟无法在主机端测量
+    perf_stats.control_latency = (latency_percentile(atomic_load(&latency_samples), 50) + 999) / 1000;
     perf_stats.input_frequency = 100; // 100Hz
     perf_stats.output_frequency = 50; // 50Hz
     perf_stats.system_load = resources.cpu_usage;
@@ -487,6 +630,36 @@ static void check_power_state(void)
     }
 }
 
+/**
+ * @brief 手柄电池档位变化：转发到电源回调，不影响本机的电源状态
+ */
+static void controller_battery_callback(uint8_t slot, const hid_battery_status_t *status)
+{
+    power_state_t state;
+    switch (status->state) {
+    case HID_BATTERY_STATE_LOW:
+        state = POWER_STATE_LOW_BATTERY;
+        break;
+    case HID_BATTERY_STATE_CRITICAL:
+        state = POWER_STATE_CRITICAL;
+        break;
+    case HID_BATTERY_STATE_CHARGING:
+        state = POWER_STATE_CHARGING;
+        break;
+    case HID_BATTERY_STATE_NORMAL:
+        state = POWER_STATE_NORMAL;
+        break;
+    default:
+        return;
+    }
+
+    ESP_LOGI(TAG, "Controller %d battery: %d%%, power state %d", slot, status->level, state);
+    power_state_callback_t callback = power_state_cb;
+    if (callback) {
+        callback(state, -1.0f);
+    }
+}
+
 /**
  * @brief 更新数据包统计
  */
@@ -542,6 +715,7 @@ esp_err_t system_monitor_reset_performance_stats(void)
     }
 
     memset(&perf_stats, 0, sizeof(perf_stats));
+    system_monitor_reset_latency();
     ESP_LOGI(TAG, "Performance stats reset");
     return ESP_OK;
 }
@@ -0,0 +1,64 @@
+/**
+ * @file haptic_clip.h
+ * @brief 震动片段库头文件
+ *
+ * 片段库由主机端工具tools/haptic_pack从文本描述打包生成（格式见haptic_clip_format.h），
+ * 烧写到haptics分区后映射到地址空间，或作为二进制数据嵌入固件。
+ * 加载时一次性校验库头、CRC和每个片段的边界，之后播放直接读取映射的数据，不拷贝到RAM。
+ */
+
+#ifndef HAPTIC_CLIP_H
+#define HAPTIC_CLIP_H
+
+#include "esp_err.h"
+#include "haptic_clip_format.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 默认的片段库分区名
+ */
+#define HAPTIC_CLIP_PARTITION        "haptics"
+
+/**
+ * @brief 加载内存中的片段库（如嵌入固件的数据）
+ * @param blob 库数据，须4字节对齐并在之后一直有效
+ * @param len 数据长度
+ * @return ESP_OK 成功，ESP_ERR_INVALID_STATE 已加载，ESP_ERR_INVALID_ARG 未对齐，ESP_ERR_NOT_FOUND 不是片段库，
+ *         ESP_ERR_INVALID_VERSION 版本不支持，ESP_ERR_INVALID_CRC 校验失败，ESP_ERR_INVALID_SIZE 数据不完整
+ */
+esp_err_t haptic_clip_bank_load(const void *blob, size_t len);
+
+/**
+ * @brief 映射并加载数据分区中的片段库
+ * @param label 分区名，NULL表示HAPTIC_CLIP_PARTITION
+ * @return ESP_OK 成功，ESP_ERR_NOT_FOUND 没有该分区或分区中没有片段库，其他值同haptic_clip_bank_load
+ */
+esp_err_t haptic_clip_bank_load_partition(const char *label);
+
+/**
+ * @brief 按名称查找片段
+ * @param name 片段名称
+ * @return 片段（指向映射的库数据），未加载库或没有该片段时为NULL
+ */
+const haptic_clip_t *haptic_clip_find(const char *name);
+
+/**
+ * @brief 求片段在t_ms时刻的左右强度（循环片段由调用者对时长取模）
+ * @param clip 已加载库中的片段
+ * @param t_ms 相对片段开始的时间
+ * @param left 输出左马达强度
+ * @param right 输出右马达强度
+ * @return 强度保持不变的毫秒数，0表示正处于过渡中，需按帧重新求值
+ */
+uint32_t haptic_clip_sample(const haptic_clip_t *clip, uint32_t t_ms, uint8_t *left, uint8_t *right);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HAPTIC_CLIP_H
@@ -0,0 +1,105 @@
+/**
+ * @file haptic_clip_format.h
+ * @brief 震动片段库二进制格式定义（固件与主机端打包工具共用）
+ *
+ * 片段库是一块连续的小端数据，所有结构4字节对齐，可以直接在映射的Flash中读取：
+ *
+ *   haptic_bank_header_t               库头，crc32覆盖库头之后的全部数据
+ *   haptic_clip_entry_t[clip_count]    片段目录，按名称查找
+ *   haptic_clip_t + haptic_keyframe_t  各片段：片段头后依次为左、右马达的关键帧
+ *
+ * 片段在t时刻的强度 = 马达曲线(t) × ADSR包络(t) / 255。
+ * 马达曲线由关键帧组成，每个关键帧指定到下一个关键帧的插值方式，第一个关键帧之前和最后一个之后保持端点强度。
+ * 包络从0经attack_ms升到255，经decay_ms降到sustain_level，在片段结束前release_ms内从当时的值降到0。
+ */
+
+#ifndef HAPTIC_CLIP_FORMAT_H
+#define HAPTIC_CLIP_FORMAT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 库头魔数，字节序列为"HCLP"
+ */
+#define HAPTIC_CLIP_MAGIC            0x504C4348u
+
+/**
+ * @brief 格式版本，结构布局变化时递增
+ */
+#define HAPTIC_CLIP_VERSION          1
+
+/**
+ * @brief 片段名称最大长度（含结束符）
+ */
+#define HAPTIC_CLIP_NAME_LEN         12
+
+/**
+ * @brief 每个马达的最大关键帧数
+ */
+#define HAPTIC_CLIP_MAX_KEYFRAMES    255
+
+/**
+ * @brief 片段循环播放，直到被停止或替换
+ */
+#define HAPTIC_CLIP_FLAG_LOOP        0x01
+
+/**
+ * @brief 关键帧到下一个关键帧的插值方式
+ */
+typedef enum {
+    HAPTIC_INTERP_STEP = 0,      ///< 保持到下一个关键帧
+    HAPTIC_INTERP_LINEAR,        ///< 线性过渡
+    HAPTIC_INTERP_SMOOTH         ///< 平滑过渡（两端斜率为0）
+} haptic_interp_t;
+
+/**
+ * @brief 库头 (16字节)
+ */
+typedef struct {
+    uint32_t magic;              ///< HAPTIC_CLIP_MAGIC
+    uint16_t version;            ///< HAPTIC_CLIP_VERSION
+    uint16_t clip_count;         ///< 片段数
+    uint32_t size;               ///< 含库头的总字节数
+    uint32_t crc32;              ///< 库头之后size-16字节的CRC32（与zlib相同）
+} haptic_bank_header_t;
+
+/**
+ * @brief 片段目录项 (16字节)
+ */
+typedef struct {
+    char name[HAPTIC_CLIP_NAME_LEN]; ///< 片段名称，不足时以0填充
+    uint32_t offset;             ///< 片段头相对库头的偏移，4字节对齐
+} haptic_clip_entry_t;
+
+/**
+ * @brief 片段头 (16字节)，其后为keyframe_count[0]个左马达关键帧和keyframe_count[1]个右马达关键帧
+ */
+typedef struct {
+    uint32_t duration_ms;        ///< 片段时长（循环片段为一个周期）
+    uint16_t attack_ms;          ///< 包络从0升到255的时长
+    uint16_t decay_ms;           ///< 包络从255降到sustain_level的时长
+    uint16_t release_ms;         ///< 片段结束前包络降到0的时长
+    uint8_t sustain_level;       ///< 持续段包络 (0-255)
+    uint8_t flags;               ///< HAPTIC_CLIP_FLAG_*
+    uint8_t keyframe_count[2];   ///< 左、右马达的关键帧数；右马达为0时与左马达相同
+    uint16_t reserved;           ///< 保留，为0
+} haptic_clip_t;
+
+/**
+ * @brief 关键帧 (4字节)
+ */
+typedef struct {
+    uint16_t time_ms;            ///< 相对片段开始的时间，同一马达内不递减
+    uint8_t level;               ///< 强度 (0-255)
+    uint8_t interp;              ///< haptic_interp_t，到下一个关键帧的插值方式
+} haptic_keyframe_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HAPTIC_CLIP_FORMAT_H
@@ -1,12 +1,28 @@
 /**
  * @file vibration.h
  * @brief 震动反馈控制头文件
+ *
+ * 所有震动效果由一个高精度定时器驱动的序列器按步播放：连续震动为一步，
+ * 脉冲为交替的开/关步，模式为逐步的强度表。每步的截止时间按开始时刻累加，
+ * 定时器回调的延迟不会累积。待播放的效果放在固定长度的队列中，不为单个效果创建任务或分配内存。
+ *
+ * 不同来源的效果在各自的声部中同时播放，每帧按优先级从低到高逐个混合：
+ * 取最大值、饱和相加或覆盖更低优先级的结果，得到一组左右强度，只在混合值变化时发送输出报告。
+ * 同一来源的新效果替换该来源正在播放的效果。
+ *
+ * 片段库中的波形片段（见haptic_clip.h）也在声部中播放：直接读取映射的库数据，
+ * 过渡段按帧求值，强度不变的区段作为一步跳过。
+ *
+ * 每个效果按混合参数中的输出目标分别混合到手柄和本地马达（见vibration_local.h）。
+ * 本地马达的包络渐变由LEDC硬件渐变完成，只有手柄声部在渐变时才按帧混合。
  */
 
 #ifndef VIBRATION_H
 #define VIBRATION_H
 
 #include "esp_err.h"
+#include "haptic_clip_format.h"
+#include "vibration_local.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -14,6 +30,31 @@
 extern "C" {
 #endif
 
+/**
+ * @brief 等待播放的效果数上限（不含正在播放的效果）
+ */
+#define VIBRATION_QUEUE_LEN          4
+
+/**
+ * @brief 模式的最大步数
+ */
+#define VIBRATION_PATTERN_MAX_STEPS  32
+
+/**
+ * @brief 同时播放的声部数
+ */
+#define VIBRATION_MAX_VOICES         4
+
+/**
+ * @brief 手柄声部包络渐变期间的混合帧间隔(毫秒)，其余时间只在步切换时混合
+ */
+#define VIBRATION_FRAME_MS           10
+
+/**
+ * @brief vibration_start等接口使用的来源，vibration_queue的效果排在该来源之后
+ */
+#define VIBRATION_SOURCE_DEFAULT     0
+
 /**
  * @brief 震动模式枚举
  */
@@ -21,39 +62,77 @@ typedef enum {
     VIBRATION_MODE_PULSE = 0,    ///< 脉冲模式
     VIBRATION_MODE_CONTINUOUS,   ///< 连续模式
     VIBRATION_MODE_PATTERN,      ///< 模式模式
-    VIBRATION_MODE_FEEDBACK      ///< 反馈模式
+    VIBRATION_MODE_FEEDBACK,     ///< 反馈模式
+    VIBRATION_MODE_CLIP          ///< 波形片段（只由vibration_play_clip使用）
 } vibration_mode_t;
 
 /**
  * @brief 震动参数结构体
+ *
+ * 脉冲模式下duration_ms为每个脉冲的时长；模式模式下为重复播放的总时长，0表示一直重复到停止。
  */
 typedef struct {
     uint8_t left_intensity;      ///< 左侧震动强度 (0-255)
     uint8_t right_intensity;     ///< 右侧震动强度 (0-255)
     uint32_t duration_ms;        ///< 持续时间(毫秒)
     vibration_mode_t mode;       ///< 震动模式
-    uint16_t pulse_count;        ///< 脉冲次数(脉冲模式使用)
+    uint16_t pulse_count;        ///< 脉冲次数(脉冲模式使用，0按1次处理)
     uint16_t pulse_interval_ms;  ///< 脉冲间隔(毫秒)
 } vibration_params_t;
 
 /**
  * @brief 震动模式结构体
+ *
+ * 每个字节为一步的强度 (0-255)，播放时再按vibration_params_t中的左右强度缩放。
  */
 typedef struct {
     uint8_t *pattern_data;       ///< 模式数据
-    uint16_t pattern_length;     ///< 模式长度
+    uint16_t pattern_length;     ///< 模式长度 (1 to VIBRATION_PATTERN_MAX_STEPS)
     uint16_t step_duration_ms;   ///< 每步持续时间
     bool repeat;                 ///< 是否重复
 } vibration_pattern_t;
 
+/**
+ * @brief 混合方式
+ */
+typedef enum {
+    VIBRATION_BLEND_MAX = 0,     ///< 与更低优先级的结果取最大值
+    VIBRATION_BLEND_SUM,         ///< 与更低优先级的结果相加，饱和到255
+    VIBRATION_BLEND_OVERRIDE     ///< 覆盖更低优先级的结果
+} vibration_blend_t;
+
+/**
+ * @brief 效果的混合参数
+ */
+typedef struct {
+    uint8_t priority;            ///< 优先级，越大越后混合；声部用尽时可替换优先级不高于它的声部
+    vibration_blend_t blend;     ///< 混合方式
+    uint16_t attack_ms;          ///< 开始时从0渐强的时长
+    uint16_t release_ms;         ///< 结束前渐弱到0的时长（一直重复的效果没有渐弱）
+    vibration_output_t output;   ///< 输出目标，VIBRATION_OUTPUT_DEFAULT表示默认目标
+} vibration_mix_t;
+
+/**
+ * @brief 混合统计
+ */
+typedef struct {
+    uint32_t frames;             ///< 混合计算的帧数
+    uint32_t reports_sent;       ///< 发送的输出报告数
+    uint32_t reports_suppressed; ///< 混合值未变化而省去的报告数
+    uint32_t voices_stolen;      ///< 声部用尽时替换的效果数
+    uint8_t active_voices;       ///< 正在播放的声部数
+    uint32_t render_us;          ///< 推进声部和混合的累计耗时(微秒)，不含发送报告
+    uint32_t render_us_max;      ///< 单帧推进和混合的最长耗时(微秒)
+} vibration_stats_t;
+
 /**
  * @brief 震动状态结构体
  */
 typedef struct {
     bool active;                 ///< 是否激活
-    vibration_params_t params;   ///< 当前参数
+    vibration_params_t params;   ///< 当前参数（优先级最高的声部）
     uint32_t start_time;         ///< 开始时间
-    uint32_t remaining_time;     ///< 剩余时间
+    uint32_t remaining_time;     ///< 剩余时间，一直重复的模式为UINT32_MAX
 } vibration_status_t;
 
 /**
@@ -69,22 +148,56 @@ esp_err_t vibration_init(void);
 esp_err_t vibration_deinit(void);
 
 /**
- * @brief 开始震动
+ * @brief 开始震动（默认来源：打断该来源的当前效果并清空队列，与其他来源混合）
  * @param params 震动参数
  * @return ESP_OK 成功，其他值表示错误
  */
 esp_err_t vibration_start(const vibration_params_t *params);
 
 /**
- * @brief 停止震动
+ * @brief 以指定来源和混合参数播放效果
+ * @param source 来源，替换该来源正在播放的效果
+ * @param params 震动参数
+ * @param mix 混合参数，NULL表示优先级0、取最大值、无包络、默认输出目标
+ * @return ESP_OK 成功，ESP_ERR_NO_MEM 声部已被更高优先级的效果占满，其他值表示错误
+ */
+esp_err_t vibration_play(uint8_t source, const vibration_params_t *params, const vibration_mix_t *mix);
+
+/**
+ * @brief 以指定来源和混合参数播放波形片段（片段数据不拷贝，须来自已加载的片段库）
+ * @param source 来源，替换该来源正在播放的效果
+ * @param clip 片段，由haptic_clip_find取得
+ * @param intensity 强度缩放 (0-255)，255按片段原强度播放
+ * @param mix 混合参数，NULL表示优先级0、取最大值、无包络、默认输出目标
+ * @return ESP_OK 成功，ESP_ERR_NO_MEM 声部已被更高优先级的效果占满，其他值表示错误
+ */
+esp_err_t vibration_play_clip(uint8_t source, const haptic_clip_t *clip, uint8_t intensity,
+                              const vibration_mix_t *mix);
+
+/**
+ * @brief 停止某个来源的效果
+ * @param source 来源
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t vibration_stop_source(uint8_t source);
+
+/**
+ * @brief 在默认来源的当前效果结束后播放（当前没有效果时立即播放）
+ * @param params 震动参数
+ * @return ESP_OK 成功，ESP_ERR_NO_MEM 队列已满，其他值表示错误
+ */
+esp_err_t vibration_queue(const vibration_params_t *params);
+
+/**
+ * @brief 停止所有来源的震动并清空队列
  * @return ESP_OK 成功，其他值表示错误
  */
 esp_err_t vibration_stop(void);
 
 /**
- * @brief 设置震动模式
+ * @brief 设置模式模式使用的强度表（拷贝保存，之后以VIBRATION_MODE_PATTERN开始的效果使用）
  * @param pattern 震动模式参数
- * @return ESP_OK 成功，其他值表示错误
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数错误
  */
 esp_err_t vibration_set_pattern(const vibration_pattern_t *pattern);
 
@@ -112,6 +225,13 @@ esp_err_t vibration_dual_motor(uint8_t left_intensity, uint8_t right_intensity,
  */
 esp_err_t vibration_get_status(vibration_status_t *status);
 
+/**
+ * @brief 获取混合统计
+ * @param stats 输出统计
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数错误
+ */
+esp_err_t vibration_get_stats(vibration_stats_t *stats);
+
 /**
  * @brief 检查震动是否激活
  * @return true 激活，false 未激活
@@ -0,0 +1,89 @@
+/**
+ * @file vibration_local.h
+ * @brief 本地震动马达与输出目标头文件
+ *
+ * 震动效果除了发给手柄，还可以驱动接在本机GPIO上的马达（LEDC的PWM输出经驱动管驱动）。
+ * 每个效果通过混合参数选择输出目标：手柄、本地或两者。本地马达的包络渐变交给LEDC的硬件渐变完成，
+ * 序列器只在折点处设定一次目标强度和渐变时长，不按帧步进。
+ *
+ * 本头文件不依赖vibration.h，可与config_manager.h一起包含。
+ */
+
+#ifndef VIBRATION_LOCAL_H
+#define VIBRATION_LOCAL_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 单次硬件渐变的最长时间(毫秒)
+ *
+ * ESP32的LEDC不能中途停止渐变，渐变进行中到来的新效果要等当前渐变结束才反映到本地马达，
+ * 长渐变因此拆成不超过这个长度的几段。
+ */
+#define VIBRATION_LOCAL_FADE_MAX_MS  50
+
+/**
+ * @brief 震动输出目标
+ */
+typedef enum {
+    VIBRATION_OUTPUT_DEFAULT = 0,    ///< 使用vibration_set_default_output设置的目标
+    VIBRATION_OUTPUT_PAD,            ///< 手柄马达
+    VIBRATION_OUTPUT_LOCAL,          ///< 本地马达
+    VIBRATION_OUTPUT_BOTH            ///< 手柄和本地马达
+} vibration_output_t;
+
+/**
+ * @brief 本地马达配置
+ */
+typedef struct {
+    int left_gpio;                   ///< 左马达引脚，-1表示不接
+    int right_gpio;                  ///< 右马达引脚，-1表示不接
+    uint32_t pwm_freq_hz;            ///< PWM频率，0表示默认20kHz（高于可听范围）
+} vibration_local_config_t;
+
+/**
+ * @brief 初始化本地马达（LEDC定时器2，通道6和7，并安装硬件渐变）
+ * @param config 马达配置
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t vibration_local_init(const vibration_local_config_t *config);
+
+/**
+ * @brief 关闭本地马达并释放引脚
+ * @return ESP_OK 成功
+ */
+esp_err_t vibration_local_deinit(void);
+
+/**
+ * @brief 本地马达是否已初始化
+ * @return true 已初始化
+ */
+bool vibration_local_is_ready(void);
+
+/**
+ * @brief 设定本地马达强度（由震动序列器调用）
+ * @param left 左马达目标强度 (0-255)
+ * @param right 右马达目标强度 (0-255)
+ * @param fade_ms 从当前强度渐变到目标的时长，0表示立即设定；上一次渐变未结束时会等待其结束
+ * @return ESP_OK 成功，ESP_ERR_INVALID_STATE 未初始化，其他值表示LEDC错误
+ */
+esp_err_t vibration_local_set(uint8_t left, uint8_t right, uint32_t fade_ms);
+
+/**
+ * @brief 设置混合参数中输出目标为VIBRATION_OUTPUT_DEFAULT的效果（包括vibration_start等接口）的输出目标
+ * @param output 输出目标，不能为VIBRATION_OUTPUT_DEFAULT
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数错误
+ */
+esp_err_t vibration_set_default_output(vibration_output_t output);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VIBRATION_LOCAL_H
@@ -0,0 +1,268 @@
+/**
+ * @file haptic_clip.c
+ * @brief 震动片段库加载与求值实现
+ */
+
+#include "haptic_clip.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include <stdbool.h>
+#include <string.h>
+
+static const char *TAG = "HAPTIC_CLIP";
+
+_Static_assert(sizeof(haptic_bank_header_t) == 16, "haptic bank header layout");
+_Static_assert(sizeof(haptic_clip_entry_t) == 16, "haptic clip entry layout");
+_Static_assert(sizeof(haptic_clip_t) == 16, "haptic clip header layout");
+_Static_assert(sizeof(haptic_keyframe_t) == 4, "haptic keyframe layout");
+
+// 加载后一直有效，播放中的声部直接持有其中片段的指针，因此不支持卸载或替换
+static const haptic_bank_header_t *bank = NULL;
+static const haptic_clip_entry_t *bank_entries = NULL;
+
+/**
+ * @brief 检查一条马达曲线：关键帧时间不递减，插值方式有效
+ */
+static bool track_valid(const haptic_keyframe_t *frames, uint8_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (frames[i].interp > HAPTIC_INTERP_SMOOTH || (i > 0 && frames[i].time_ms < frames[i - 1].time_ms)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 校验库头、CRC和每个片段的边界，通过后求值时不再检查
+ */
+static esp_err_t bank_validate(const uint8_t *base, size_t len)
+{
+    const haptic_bank_header_t *header = (const haptic_bank_header_t *)base;
+    if (len < sizeof(*header) || header->magic != HAPTIC_CLIP_MAGIC) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (header->version != HAPTIC_CLIP_VERSION) {
+        ESP_LOGE(TAG, "Unsupported haptic bank version %d (expected %d)", header->version, HAPTIC_CLIP_VERSION);
+        return ESP_ERR_INVALID_VERSION;
+    }
+    size_t directory_end = sizeof(*header) + header->clip_count * sizeof(haptic_clip_entry_t);
+    if (header->size > len || header->size < directory_end) {
+        ESP_LOGE(TAG, "Haptic bank truncated: %lu of %lu bytes", (unsigned long)len, (unsigned long)header->size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (esp_rom_crc32_le(0, base + sizeof(*header), header->size - sizeof(*header)) != header->crc32) {
+        ESP_LOGE(TAG, "Haptic bank CRC mismatch");
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    // 偏移来自库数据，32位size_t上offset加长度可能回绕，边界检查都从size中减去长度。
+    // size不小于directory_end，而directory_end不小于一个片段头，减法不会下溢
+    const haptic_clip_entry_t *entries = (const haptic_clip_entry_t *)(base + sizeof(*header));
+    size_t clip_limit = header->size - sizeof(haptic_clip_t);
+    for (size_t i = 0; i < header->clip_count; i++) {
+        uint32_t offset = entries[i].offset;
+        const haptic_clip_t *clip = (const haptic_clip_t *)(base + offset);
+        bool valid = entries[i].name[HAPTIC_CLIP_NAME_LEN - 1] == '\0' && (offset & 3) == 0 &&
+                     offset >= directory_end && offset <= clip_limit;
+        if (valid) {
+            size_t frames = clip->keyframe_count[0] + clip->keyframe_count[1];
+            const haptic_keyframe_t *keyframes = (const haptic_keyframe_t *)(clip + 1);
+            valid = clip->duration_ms > 0 && clip->keyframe_count[0] > 0 &&
+                    frames * sizeof(haptic_keyframe_t) <= clip_limit - offset &&
+                    track_valid(keyframes, clip->keyframe_count[0]) &&
+                    track_valid(keyframes + clip->keyframe_count[0], clip->keyframe_count[1]);
+        }
+        if (!valid) {
+            ESP_LOGE(TAG, "Haptic clip %d is malformed", (int)i);
+            return ESP_ERR_INVALID_SIZE;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t haptic_clip_bank_load(const void *blob, size_t len)
+{
+    if (bank) {
+        ESP_LOGW(TAG, "Haptic bank already loaded");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!blob || ((uintptr_t)blob & 3) != 0) {
+        ESP_LOGE(TAG, "Haptic bank must be 4-byte aligned");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = bank_validate(blob, len);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    bank = blob;
+    bank_entries = (const haptic_clip_entry_t *)(bank + 1);
+    ESP_LOGI(TAG, "Haptic bank loaded: %d clips, %lu bytes", bank->clip_count, (unsigned long)bank->size);
+    return ESP_OK;
+}
+
+esp_err_t haptic_clip_bank_load_partition(const char *label)
+{
+    if (!label) {
+        label = HAPTIC_CLIP_PARTITION;
+    }
+
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                                ESP_PARTITION_SUBTYPE_ANY, label);
+    if (!partition) {
+        ESP_LOGI(TAG, "No '%s' partition, haptic clips unavailable", label);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // 先读库头得到实际长度，只映射库所占的部分
+    haptic_bank_header_t header;
+    esp_err_t ret = esp_partition_read(partition, 0, &header, sizeof(header));
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to read haptic bank header: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    if (header.magic != HAPTIC_CLIP_MAGIC) {
+        ESP_LOGI(TAG, "Partition '%s' holds no haptic bank", label);
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (header.size > partition->size) {
+        ESP_LOGE(TAG, "Haptic bank (%lu bytes) larger than partition '%s'", (unsigned long)header.size, label);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const void *mapped;
+    esp_partition_mmap_handle_t handle;
+    ret = esp_partition_mmap(partition, 0, header.size, ESP_PARTITION_MMAP_DATA, &mapped, &handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to map haptic bank: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    // 加载成功后映射一直保留
+    ret = haptic_clip_bank_load(mapped, header.size);
+    if (ret != ESP_OK) {
+        esp_partition_munmap(handle);
+    }
+    return ret;
+}
+
+const haptic_clip_t *haptic_clip_find(const char *name)
+{
+    if (!bank || !name) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < bank->clip_count; i++) {
+        if (strncmp(bank_entries[i].name, name, HAPTIC_CLIP_NAME_LEN) == 0) {
+            return (const haptic_clip_t *)((const uint8_t *)bank + bank_entries[i].offset);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 包络在释放段之前的值：attack升到255，decay降到sustain_level
+ */
+static uint32_t envelope_front(const haptic_clip_t *clip, uint32_t t_ms)
+{
+    if (t_ms < clip->attack_ms) {
+        return t_ms * 255 / clip->attack_ms;
+    }
+    t_ms -= clip->attack_ms;
+    if (t_ms < clip->decay_ms) {
+        return 255 - (255 - clip->sustain_level) * t_ms / clip->decay_ms;
+    }
+    return clip->sustain_level;
+}
+
+/**
+ * @brief 求包络 (0-255)
+ * @param stable_ms 输出包络保持不变的毫秒数，0表示正在渐变
+ */
+static uint32_t envelope(const haptic_clip_t *clip, uint32_t t_ms, uint32_t *stable_ms)
+{
+    uint32_t release_start = clip->duration_ms > clip->release_ms ? clip->duration_ms - clip->release_ms : 0;
+    if (clip->release_ms > 0 && t_ms >= release_start) {
+        // 从释放开始时的包络值降到0，decay未完成时也是如此
+        uint32_t remaining_ms = t_ms < clip->duration_ms ? clip->duration_ms - t_ms : 0;
+        *stable_ms = 0;
+        return envelope_front(clip, release_start) * remaining_ms / clip->release_ms;
+    }
+    if (t_ms < (uint32_t)clip->attack_ms + clip->decay_ms || t_ms >= release_start) {
+        *stable_ms = 0;
+    } else {
+        *stable_ms = release_start - t_ms;
+    }
+    return envelope_front(clip, t_ms);
+}
+
+/**
+ * @brief 求一条马达曲线的强度
+ * @param stable_ms 输出强度保持不变的毫秒数，0表示正在过渡
+ */
+static uint8_t track_level(const haptic_keyframe_t *frames, uint8_t count, uint32_t t_ms, uint32_t *stable_ms)
+{
+    if (t_ms < frames[0].time_ms) {
+        *stable_ms = frames[0].time_ms - t_ms;
+        return frames[0].level;
+    }
+
+    // 二分查找最后一个不晚于t_ms的关键帧
+    size_t lo = 0;
+    size_t hi = count;
+    while (hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+        if (frames[mid].time_ms <= t_ms) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    const haptic_keyframe_t *from = &frames[lo];
+    if (lo + 1 == count) {
+        *stable_ms = UINT32_MAX;
+        return from->level;
+    }
+    const haptic_keyframe_t *to = from + 1;
+    if (from->interp == HAPTIC_INTERP_STEP || from->level == to->level) {
+        *stable_ms = to->time_ms - t_ms;
+        return from->level;
+    }
+
+    // 段内位置 (0-256)，平滑过渡取 u^2(3-2u)
+    uint32_t u = (t_ms - from->time_ms) * 256 / (to->time_ms - from->time_ms);
+    if (from->interp == HAPTIC_INTERP_SMOOTH) {
+        u = u * u * (768 - 2 * u) >> 16;
+    }
+    *stable_ms = 0;
+    return (uint8_t)(from->level + ((int32_t)to->level - from->level) * (int32_t)u / 256);
+}
+
+uint32_t haptic_clip_sample(const haptic_clip_t *clip, uint32_t t_ms, uint8_t *left, uint8_t *right)
+{
+    const haptic_keyframe_t *frames = (const haptic_keyframe_t *)(clip + 1);
+    uint32_t stable_ms;
+    uint32_t left_stable_ms;
+    uint32_t gain = envelope(clip, t_ms, &stable_ms);
+
+    uint8_t left_level = track_level(frames, clip->keyframe_count[0], t_ms, &left_stable_ms);
+    uint8_t right_level = left_level;
+    uint32_t right_stable_ms = left_stable_ms;
+    if (clip->keyframe_count[1] > 0) {
+        right_level = track_level(frames + clip->keyframe_count[0], clip->keyframe_count[1], t_ms, &right_stable_ms);
+    }
+
+    if (left_stable_ms < stable_ms) {
+        stable_ms = left_stable_ms;
+    }
+    if (right_stable_ms < stable_ms) {
+        stable_ms = right_stable_ms;
+    }
+    *left = (uint8_t)((left_level * gain + 127) / 255);
+    *right = (uint8_t)((right_level * gain + 127) / 255);
+    return stable_ms;
+}
@@ -4,56 +4,85 @@
  */
 
 #include "vibration.h"
-#include "bluetooth_hid.h"
+#include "haptic_clip.h"
+#include "hid_rumble.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
-#include "freertos/timers.h"
+#include "freertos/semphr.h"
 #include <string.h>
 
 static const char *TAG = "VIBRATION";
 
+// 声部的输出目标位
+#define VOICE_OUTPUT_PAD        0x01
+#define VOICE_OUTPUT_LOCAL      0x02
+
+/**
+ * @brief 一个待播放的效果（模式数据在入队时拷贝，片段只保存指针）
+ */
+typedef struct {
+    vibration_params_t params;
+    uint8_t pattern[VIBRATION_PATTERN_MAX_STEPS];
+    uint16_t pattern_length;
+    uint16_t step_duration_ms;
+    bool repeat;
+    const haptic_clip_t *clip;   ///< 片段模式播放的片段，指向映射的库数据
+} vibration_effect_t;
+
+/**
+ * @brief 一个声部：某个来源正在播放的效果及其步进状态
+ */
+typedef struct {
+    bool active;
+    uint8_t source;
+    uint8_t outputs;             ///< VOICE_OUTPUT_*，提交时按混合参数和默认目标确定
+    vibration_mix_t mix;
+    vibration_effect_t effect;
+    uint32_t step;               ///< 下一步的序号
+    uint8_t left;                ///< 当前步的强度（包络前）
+    uint8_t right;
+    int64_t start_us;            ///< 效果开始时间（渐强起点）
+    int64_t step_deadline_us;    ///< 当前步的截止时间，下一步从这里开始计时
+    int64_t end_us;              ///< 效果结束时间，0表示一直重复
+} vibration_voice_t;
+
 // 静态变量
 static vibration_status_t current_status = {0};
 static bool vibration_enabled = true;
 static bool initialized = false;
-static TimerHandle_t vibration_timer = NULL;
+static esp_timer_handle_t sequencer_timer = NULL;
+static SemaphoreHandle_t sequencer_mutex = NULL;
+
+// 序列器和混合器状态，持有sequencer_mutex时访问
+static vibration_voice_t voices[VIBRATION_MAX_VOICES];
+static vibration_effect_t effect_queue[VIBRATION_QUEUE_LEN];
+static uint8_t queue_head = 0;
+static uint8_t queue_count = 0;
+static uint8_t output_left = 0;            ///< 最近一次成功发送的强度，混合值相同时不重复发送
+static uint8_t output_right = 0;
+static vibration_stats_t mixer_stats = {0};
+static int64_t status_end_us = 0;          ///< 状态中报告的声部的结束时间，0表示一直重复
+static int64_t local_busy_until_us = 0;    ///< 本地马达当前硬件渐变的结束时间，之前不能设定新的强度
+static vibration_output_t default_output = VIBRATION_OUTPUT_PAD;
+
+// vibration_set_pattern保存的强度表
+static vibration_effect_t stored_pattern = {0};
 
 /**
- * @brief 发送震动命令到手柄
+ * @brief 发送震动命令到手柄（报告布局由连接时按型号绑定的编码器决定）
  */
 static esp_err_t send_vibration_command(uint8_t left_intensity, uint8_t right_intensity)
 {
-    if (!bluetooth_hid_is_connected()) {
-        ESP_LOGW(TAG, "Bluetooth HID not connected");
-        return ESP_ERR_INVALID_STATE;
+    esp_err_t ret = hid_rumble_send(HID_RUMBLE_SLOT_PRIMARY, left_intensity, right_intensity);
+    if (ret == ESP_ERR_INVALID_STATE) {
+        ESP_LOGD(TAG, "Bluetooth HID not connected");
+        return ret;
     }
-    
-    // 构造震动报告数据
-    // 这里的数据格式取决于具体的手柄类型
-    // 通用格式：报告ID + 左马达强度 + 右马达强度
-    uint8_t vibration_data[4] = {
-        0x01,              // 报告ID（震动报告）
-        0x00,              // 保留字节
-        left_intensity,    // 左马达强度
-        right_intensity    // 右马达强度
-    };
-    
-    hid_output_report_t report = {
-        .report_id = 0x01,
-        .data = vibration_data,
-        .len = sizeof(vibration_data)
-    };
-    
-    hid_device_info_t device_info;
-    esp_err_t ret = bluetooth_hid_get_connected_device(&device_info);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to get connected device: %s", esp_err_to_name(ret));
+    if (ret == ESP_ERR_NOT_SUPPORTED) {
+        ESP_LOGD(TAG, "Connected controller has no supported rumble report");
         return ret;
     }
-    
-    ret = bluetooth_hid_send_output_report(device_info.dev_handle, &report);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to send vibration command: %s", esp_err_to_name(ret));
         return ret;
@@ -64,66 +93,412 @@ static esp_err_t send_vibration_command(uint8_t left_intensity, uint8_t right_in
 }
 
 /**
- * @brief 震动定时器回调函数
+ * @brief 设置马达输出，混合值未变化时不发送
  */
-static void vibration_timer_callback(TimerHandle_t xTimer)
+static esp_err_t set_output(uint8_t left, uint8_t right)
 {
-    ESP_LOGD(TAG, "Vibration timer expired");
+    if (left == output_left && right == output_right) {
+        mixer_stats.reports_suppressed++;
+        return ESP_OK;
+    }
     
-    // 停止震动
-    send_vibration_command(0, 0);
+    esp_err_t ret = send_vibration_command(left, right);
+    if (ret == ESP_OK) {
+        output_left = left;
+        output_right = right;
+        mixer_stats.reports_sent++;
+    }
+    return ret;
+}
+
+/**
+ * @brief 求效果第step步的强度和时长
+ * @param elapsed_ms 这一步开始时距效果开始的时间
+ * @return false 效果已播放完
+ */
+static bool effect_step(const vibration_effect_t *effect, uint32_t step, uint32_t elapsed_ms,
+                        uint8_t *left, uint8_t *right, uint32_t *duration_ms)
+{
+    const vibration_params_t *p = &effect->params;
+    
+    switch (p->mode) {
+        case VIBRATION_MODE_PULSE: {
+            // 偶数步为脉冲，奇数步为间隔，最后一个脉冲后没有间隔
+            uint32_t pulses = p->pulse_count ? p->pulse_count : 1;
+            if (step >= pulses * 2 - 1) {
+                return false;
+            }
+            bool on = (step & 1) == 0;
+            *left = on ? p->left_intensity : 0;
+            *right = on ? p->right_intensity : 0;
+            *duration_ms = on ? p->duration_ms : p->pulse_interval_ms;
+            return true;
+        }
+        
+        case VIBRATION_MODE_PATTERN: {
+            if (!effect->repeat && step >= effect->pattern_length) {
+                return false;
+            }
+            // 重复播放时到总时长截止，最后一步截短
+            uint32_t elapsed_ms = step * effect->step_duration_ms;
+            if (effect->repeat && p->duration_ms > 0 && elapsed_ms >= p->duration_ms) {
+                return false;
+            }
+            uint8_t level = effect->pattern[step % effect->pattern_length];
+            *left = (uint8_t)((level * p->left_intensity + 127) / 255);
+            *right = (uint8_t)((level * p->right_intensity + 127) / 255);
+            *duration_ms = effect->step_duration_ms;
+            if (effect->repeat && p->duration_ms > 0 && p->duration_ms - elapsed_ms < *duration_ms) {
+                *duration_ms = p->duration_ms - elapsed_ms;
+            }
+            return true;
+        }
+        
+        case VIBRATION_MODE_CLIP: {
+            const haptic_clip_t *clip = effect->clip;
+            if (!(clip->flags & HAPTIC_CLIP_FLAG_LOOP) && elapsed_ms >= clip->duration_ms) {
+                return false;
+            }
+            // 过渡段每帧求值一次，强度不变的区段作为一步跳过
+            uint32_t t_ms = elapsed_ms % clip->duration_ms;
+            uint32_t stable_ms = haptic_clip_sample(clip, t_ms, left, right);
+            *duration_ms = stable_ms ? stable_ms : VIBRATION_FRAME_MS;
+            if (*duration_ms > clip->duration_ms - t_ms) {
+                *duration_ms = clip->duration_ms - t_ms;
+            }
+            *left = (uint8_t)((*left * p->left_intensity + 127) / 255);
+            *right = (uint8_t)((*right * p->right_intensity + 127) / 255);
+            return true;
+        }
+        
+        default:
+            // 连续和反馈模式只有一步
+            if (step > 0) {
+                return false;
+            }
+            *left = p->left_intensity;
+            *right = p->right_intensity;
+            *duration_ms = p->duration_ms;
+            return true;
+    }
+}
+
+/**
+ * @brief 效果的总时长(毫秒)，UINT32_MAX表示一直重复
+ */
+static uint32_t effect_total_ms(const vibration_effect_t *effect)
+{
+    const vibration_params_t *p = &effect->params;
     
-    // 更新状态
-    current_status.active = false;
-    current_status.remaining_time = 0;
+    switch (p->mode) {
+        case VIBRATION_MODE_PULSE: {
+            uint32_t pulses = p->pulse_count ? p->pulse_count : 1;
+            return pulses * p->duration_ms + (pulses - 1) * p->pulse_interval_ms;
+        }
+        
+        case VIBRATION_MODE_PATTERN:
+            if (!effect->repeat) {
+                return effect->pattern_length * effect->step_duration_ms;
+            }
+            return p->duration_ms > 0 ? p->duration_ms : UINT32_MAX;
+        
+        case VIBRATION_MODE_CLIP:
+            return (effect->clip->flags & HAPTIC_CLIP_FLAG_LOOP) ? UINT32_MAX : effect->clip->duration_ms;
+        
+        default:
+            return p->duration_ms;
+    }
+}
+
+/**
+ * @brief 声部从step_deadline_us开始播放新效果
+ */
+static void voice_begin(vibration_voice_t *voice, const vibration_effect_t *effect)
+{
+    voice->effect = *effect;
+    voice->step = 0;
+    voice->left = 0;
+    voice->right = 0;
+    voice->start_us = voice->step_deadline_us;
+    
+    uint32_t total_ms = effect_total_ms(effect);
+    voice->end_us = total_ms == UINT32_MAX ? 0 : voice->start_us + (int64_t)total_ms * 1000;
+    voice->active = true;
+}
+
+/**
+ * @brief 把声部推进到now_us所在的步；默认来源的效果播完时接着播放队列中的效果
+ */
+static void voice_advance(vibration_voice_t *voice, int64_t now_us)
+{
+    uint32_t duration_ms;
+    
+    while (voice->active && voice->step_deadline_us <= now_us) {
+        uint32_t elapsed_ms = (uint32_t)((voice->step_deadline_us - voice->start_us) / 1000);
+        if (effect_step(&voice->effect, voice->step, elapsed_ms, &voice->left, &voice->right, &duration_ms)) {
+            // 截止时间按上一步的截止时间累加，定时器回调的延迟不会累积
+            voice->step++;
+            voice->step_deadline_us += (int64_t)duration_ms * 1000;
+        } else if (voice->source == VIBRATION_SOURCE_DEFAULT && queue_count > 0) {
+            voice_begin(voice, &effect_queue[queue_head]);
+            queue_head = (queue_head + 1) % VIBRATION_QUEUE_LEN;
+            queue_count--;
+        } else {
+            voice->active = false;
+        }
+    }
+}
+
+/**
+ * @brief 声部当前的包络增益 (0-256)
+ * @param ramping 处于渐强或渐弱中时置为true
+ */
+static uint32_t voice_gain(const vibration_voice_t *voice, int64_t now_us, bool *ramping)
+{
+    uint32_t gain = 256;
+    
+    int64_t attack_us = (int64_t)voice->mix.attack_ms * 1000;
+    int64_t since_start_us = now_us - voice->start_us;
+    if (since_start_us < attack_us) {
+        gain = (uint32_t)(since_start_us * 256 / attack_us);
+        *ramping = true;
+    }
     
-    // 停止定时器
-    if (vibration_timer != NULL) {
-        xTimerStop(vibration_timer, 0);
+    int64_t release_us = (int64_t)voice->mix.release_ms * 1000;
+    if (voice->end_us != 0 && release_us > 0 && voice->end_us - now_us <= release_us) {
+        int64_t until_end_us = voice->end_us > now_us ? voice->end_us - now_us : 0;
+        uint32_t release_gain = (uint32_t)(until_end_us * 256 / release_us);
+        if (release_gain < gain) {
+            gain = release_gain;
+        }
+        *ramping = true;
     }
+    
+    return gain;
 }
 
 /**
- * @brief 处理脉冲模式震动
+ * @brief 声部在now_us之后的下一个包络折点（渐强结束或渐弱开始），没有时为INT64_MAX
  */
-static esp_err_t handle_pulse_mode(const vibration_params_t *params)
+static int64_t voice_envelope_breakpoint(const vibration_voice_t *voice, int64_t now_us)
 {
-    ESP_LOGD(TAG, "Starting pulse mode vibration");
+    int64_t breakpoint_us = INT64_MAX;
     
-    // TODO: 实现脉冲模式
-    // 这里需要创建一个任务来处理脉冲序列
-    // 暂时使用简单的连续模式
+    int64_t attack_end_us = voice->start_us + (int64_t)voice->mix.attack_ms * 1000;
+    if (attack_end_us > now_us) {
+        breakpoint_us = attack_end_us;
+    }
+    if (voice->end_us != 0) {
+        int64_t release_start_us = voice->end_us - (int64_t)voice->mix.release_ms * 1000;
+        if (release_start_us > now_us && release_start_us < breakpoint_us) {
+            breakpoint_us = release_start_us;
+        }
+    }
     
-    esp_err_t ret = send_vibration_command(params->left_intensity, params->right_intensity);
-    if (ret != ESP_OK) {
-        return ret;
+    return breakpoint_us;
+}
+
+/**
+ * @brief 按优先级从低到高混合输出到指定目标的声部
+ * @param outputs VOICE_OUTPUT_*，只混合输出到该目标的声部
+ * @return 是否有这些声部处于包络渐变中
+ */
+static bool mix_voices(int64_t now_us, uint8_t outputs, uint8_t *left, uint8_t *right)
+{
+    const vibration_voice_t *order[VIBRATION_MAX_VOICES];
+    size_t count = 0;
+    
+    // 插入排序，同优先级保持声部顺序
+    for (size_t i = 0; i < VIBRATION_MAX_VOICES; i++) {
+        if (!voices[i].active || !(voices[i].outputs & outputs)) {
+            continue;
+        }
+        size_t pos = count++;
+        while (pos > 0 && order[pos - 1]->mix.priority > voices[i].mix.priority) {
+            order[pos] = order[pos - 1];
+            pos--;
+        }
+        order[pos] = &voices[i];
     }
     
-    // 启动定时器
-    if (vibration_timer != NULL) {
-        xTimerChangePeriod(vibration_timer, pdMS_TO_TICKS(params->duration_ms), 0);
-        xTimerStart(vibration_timer, 0);
+    uint32_t mixed_left = 0;
+    uint32_t mixed_right = 0;
+    bool ramping = false;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t gain = voice_gain(order[i], now_us, &ramping);
+        uint32_t voice_left = (order[i]->left * gain) >> 8;
+        uint32_t voice_right = (order[i]->right * gain) >> 8;
+        
+        switch (order[i]->mix.blend) {
+            case VIBRATION_BLEND_SUM:
+                mixed_left = mixed_left + voice_left > 255 ? 255 : mixed_left + voice_left;
+                mixed_right = mixed_right + voice_right > 255 ? 255 : mixed_right + voice_right;
+                break;
+            
+            case VIBRATION_BLEND_OVERRIDE:
+                mixed_left = voice_left;
+                mixed_right = voice_right;
+                break;
+            
+            default:
+                mixed_left = voice_left > mixed_left ? voice_left : mixed_left;
+                mixed_right = voice_right > mixed_right ? voice_right : mixed_right;
+                break;
+        }
     }
     
-    return ESP_OK;
+    *left = (uint8_t)mixed_left;
+    *right = (uint8_t)mixed_right;
+    return ramping;
 }
 
 /**
- * @brief 处理连续模式震动
+ * @brief 把本地马达设到本地声部的混合值，包络渐变交给LEDC硬件渐变
+ *
+ * 渐变中的一段到最近的步切换、包络折点或VIBRATION_LOCAL_FADE_MAX_MS为止，
+ * 以段末的混合值为目标启动一次硬件渐变，段内不再按帧设定强度。
+ * ESP32的硬件渐变不能中途停止，渐变进行中的更新推迟到渐变结束。
+ *
+ * @note 持有sequencer_mutex时调用
+ * @param breakpoint_us 最近的步切换或包络折点
+ * @param next_us 定时器的下次触发时间，本地马达需要更早更新时提前
+ * @return 是否有因渐变未结束而推迟的更新
  */
-static esp_err_t handle_continuous_mode(const vibration_params_t *params)
+static bool render_local(int64_t now_us, int64_t breakpoint_us, int64_t *next_us)
 {
-    ESP_LOGD(TAG, "Starting continuous mode vibration");
+    if (!vibration_local_is_ready()) {
+        return false;
+    }
     
-    esp_err_t ret = send_vibration_command(params->left_intensity, params->right_intensity);
-    if (ret != ESP_OK) {
-        return ret;
+    if (now_us < local_busy_until_us) {
+        if (local_busy_until_us < *next_us) {
+            *next_us = local_busy_until_us;
+        }
+        return true;
+    }
+    
+    uint8_t left, right;
+    if (!mix_voices(now_us, VOICE_OUTPUT_LOCAL, &left, &right)) {
+        vibration_local_set(left, right, 0);
+        return false;
     }
     
-    // 启动定时器
-    if (vibration_timer != NULL) {
-        xTimerChangePeriod(vibration_timer, pdMS_TO_TICKS(params->duration_ms), 0);
-        xTimerStart(vibration_timer, 0);
+    int64_t target_us = now_us + VIBRATION_LOCAL_FADE_MAX_MS * 1000;
+    if (breakpoint_us < target_us) {
+        target_us = breakpoint_us;
+    }
+    
+    // 段内各声部的强度不变、增益线性变化，以段末的混合值为渐变目标
+    uint32_t fade_ms = (uint32_t)((target_us - now_us) / 1000);
+    mix_voices(target_us, VOICE_OUTPUT_LOCAL, &left, &right);
+    if (vibration_local_set(left, right, fade_ms) == ESP_OK) {
+        local_busy_until_us = now_us + (int64_t)fade_ms * 1000;
+    }
+    if (target_us < *next_us) {
+        *next_us = target_us;
+    }
+    return false;
+}
+
+/**
+ * @brief 推进所有声部并输出一帧混合结果，再把定时器设到最近的步切换、包络折点或下一个渐变帧
+ * @note 持有sequencer_mutex时调用
+ * @return 发送混合结果的结果
+ */
+static esp_err_t render_frame(void)
+{
+    int64_t now_us = esp_timer_get_time();
+    int64_t next_us = INT64_MAX;
+    uint8_t active = 0;
+    const vibration_voice_t *top = NULL;
+    
+    for (size_t i = 0; i < VIBRATION_MAX_VOICES; i++) {
+        vibration_voice_t *voice = &voices[i];
+        voice_advance(voice, now_us);
+        if (!voice->active) {
+            continue;
+        }
+        active++;
+        if (voice->step_deadline_us < next_us) {
+            next_us = voice->step_deadline_us;
+        }
+        int64_t breakpoint_us = voice_envelope_breakpoint(voice, now_us);
+        if (breakpoint_us < next_us) {
+            next_us = breakpoint_us;
+        }
+        if (!top || voice->mix.priority >= top->mix.priority) {
+            top = voice;
+        }
+    }
+    
+    // 只有手柄声部的包络渐变需要按帧混合
+    int64_t breakpoint_us = next_us;
+    uint8_t left, right;
+    if (mix_voices(now_us, VOICE_OUTPUT_PAD, &left, &right) && now_us + VIBRATION_FRAME_MS * 1000 < next_us) {
+        next_us = now_us + VIBRATION_FRAME_MS * 1000;
+    }
+    uint32_t render_us = (uint32_t)(esp_timer_get_time() - now_us);
+    mixer_stats.frames++;
+    mixer_stats.active_voices = active;
+    mixer_stats.render_us += render_us;
+    if (render_us > mixer_stats.render_us_max) {
+        mixer_stats.render_us_max = render_us;
+    }
+    
+    // 状态中报告优先级最高的声部
+    current_status.active = active > 0;
+    if (top) {
+        current_status.params = top->effect.params;
+        current_status.start_time = top->start_us / 1000;
+        status_end_us = top->end_us;
+    } else {
+        current_status.remaining_time = 0;
+    }
+    
+    esp_err_t ret = set_output(left, right);
+    bool local_pending = render_local(now_us, breakpoint_us, &next_us);
+    
+    esp_timer_stop(sequencer_timer);
+    if (active > 0 || local_pending) {
+        esp_timer_start_once(sequencer_timer, next_us > now_us ? (uint64_t)(next_us - now_us) : 0);
+    }
+    return ret;
+}
+
+/**
+ * @brief 序列器定时器回调：有声部到了步切换或渐变帧
+ */
+static void sequencer_timer_callback(void *arg)
+{
+    xSemaphoreTake(sequencer_mutex, portMAX_DELAY);
+    render_frame();
+    xSemaphoreGive(sequencer_mutex);
+}
+
+/**
+ * @brief 按参数组装效果，模式模式拷贝当前保存的强度表
+ * @param clip 片段模式的片段，其他模式为NULL
+ */
+static esp_err_t make_effect(const vibration_params_t *params, const haptic_clip_t *clip,
+                             vibration_effect_t *effect)
+{
+    memset(effect, 0, sizeof(*effect));
+    effect->params = *params;
+    effect->clip = clip;
+    
+    if (params->mode > VIBRATION_MODE_CLIP || (params->mode == VIBRATION_MODE_CLIP) != (clip != NULL)) {
+        ESP_LOGE(TAG, "Invalid vibration mode: %d", params->mode);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (params->mode == VIBRATION_MODE_PATTERN) {
+        if (stored_pattern.pattern_length == 0) {
+            ESP_LOGE(TAG, "No vibration pattern set");
+            return ESP_ERR_INVALID_STATE;
+        }
+        memcpy(effect->pattern, stored_pattern.pattern, stored_pattern.pattern_length);
+        effect->pattern_length = stored_pattern.pattern_length;
+        effect->step_duration_ms = stored_pattern.step_duration_ms;
+        effect->repeat = stored_pattern.repeat;
     }
     
     return ESP_OK;
@@ -140,20 +515,34 @@ esp_err_t vibration_init(void)
     
     // 初始化状态
     memset(&current_status, 0, sizeof(current_status));
+    memset(voices, 0, sizeof(voices));
+    memset(&mixer_stats, 0, sizeof(mixer_stats));
+    queue_count = 0;
+    output_left = 0;
+    output_right = 0;
+    local_busy_until_us = 0;
     vibration_enabled = true;
     
-    // 创建定时器
-    vibration_timer = xTimerCreate("VibrationTimer", 
-                                   pdMS_TO_TICKS(100),  // 默认100ms
-                                   pdFALSE,             // 单次触发
-                                   (void *)0,           // 定时器ID
-                                   vibration_timer_callback);
-    
-    if (vibration_timer == NULL) {
-        ESP_LOGE(TAG, "Failed to create vibration timer");
+    sequencer_mutex = xSemaphoreCreateMutex();
+    if (sequencer_mutex == NULL) {
+        ESP_LOGE(TAG, "Failed to create vibration mutex");
         return ESP_ERR_NO_MEM;
     }
     
+    // 创建序列器定时器
+    esp_timer_create_args_t timer_args = {
+        .callback = sequencer_timer_callback,
+        .arg = NULL,
+        .name = "vibration"
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &sequencer_timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create vibration timer: %s", esp_err_to_name(ret));
+        vSemaphoreDelete(sequencer_mutex);
+        sequencer_mutex = NULL;
+        return ret;
+    }
+    
     initialized = true;
     ESP_LOGI(TAG, "Vibration control initialized successfully");
     
@@ -173,10 +562,13 @@ esp_err_t vibration_deinit(void)
     vibration_stop();
     
     // 删除定时器
-    if (vibration_timer != NULL) {
-        xTimerDelete(vibration_timer, portMAX_DELAY);
-        vibration_timer = NULL;
+    if (sequencer_timer != NULL) {
+        esp_timer_stop(sequencer_timer);
+        esp_timer_delete(sequencer_timer);
+        sequencer_timer = NULL;
     }
+    vSemaphoreDelete(sequencer_mutex);
+    sequencer_mutex = NULL;
     
     initialized = false;
     ESP_LOGI(TAG, "Vibration control deinitialized");
@@ -184,8 +576,39 @@ esp_err_t vibration_deinit(void)
     return ESP_OK;
 }
 
-esp_err_t vibration_start(const vibration_params_t *params)
+/**
+ * @brief 按混合参数和默认目标确定声部的输出目标位，未初始化的本地马达不计入
+ * @return 0表示没有可用的输出目标
+ */
+static uint8_t resolve_outputs(vibration_output_t output)
 {
+    if (output == VIBRATION_OUTPUT_DEFAULT) {
+        output = default_output;
+    }
+    
+    uint8_t outputs = 0;
+    if (output == VIBRATION_OUTPUT_PAD || output == VIBRATION_OUTPUT_BOTH) {
+        outputs |= VOICE_OUTPUT_PAD;
+    }
+    if ((output == VIBRATION_OUTPUT_LOCAL || output == VIBRATION_OUTPUT_BOTH) && vibration_local_is_ready()) {
+        outputs |= VOICE_OUTPUT_LOCAL;
+    }
+    return outputs;
+}
+
+/**
+ * @brief 播放或排队一个效果
+ * @param clip 片段模式的片段，其他模式为NULL
+ * @param queue true 排在默认来源当前效果之后，false 替换该来源的当前效果
+ */
+static esp_err_t submit_effect(uint8_t source, const vibration_params_t *params, const haptic_clip_t *clip,
+                               const vibration_mix_t *mix, bool queue)
+{
+    static const vibration_mix_t default_mix = {
+        .priority = 0,
+        .blend = VIBRATION_BLEND_MAX
+    };
+    
     if (!initialized) {
         ESP_LOGE(TAG, "Vibration not initialized");
         return ESP_ERR_INVALID_STATE;
@@ -201,50 +624,153 @@ esp_err_t vibration_start(const vibration_params_t *params)
         return ESP_OK;
     }
     
-    ESP_LOGI(TAG, "Starting vibration: left=%d, right=%d, duration=%lums, mode=%d", 
-             params->left_intensity, params->right_intensity, params->duration_ms, params->mode);
+    vibration_effect_t effect;
+    esp_err_t ret = make_effect(params, clip, &effect);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (!mix) {
+        mix = &default_mix;
+    }
+    if (mix->output > VIBRATION_OUTPUT_BOTH) {
+        ESP_LOGE(TAG, "Invalid vibration output: %d", mix->output);
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint8_t outputs = resolve_outputs(mix->output);
+    if (outputs == 0) {
+        ESP_LOGE(TAG, "Local vibration motors not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
     
-    // 停止当前震动
-    vibration_stop();
+    // 控制任务每个周期都可能重新提交同一来源的效果，只在调试级别记录
+    ESP_LOGD(TAG, "%s vibration from source %d: left=%d, right=%d, duration=%lums, mode=%d, priority=%d",
+             queue ? "Queueing" : "Starting", source, params->left_intensity, params->right_intensity,
+             params->duration_ms, params->mode, mix->priority);
+    
+    xSemaphoreTake(sequencer_mutex, portMAX_DELAY);
+    vibration_voice_t *voice = NULL;
+    vibration_voice_t *free_voice = NULL;
+    vibration_voice_t *lowest = NULL;
+    for (size_t i = 0; i < VIBRATION_MAX_VOICES; i++) {
+        if (!voices[i].active) {
+            if (!free_voice) {
+                free_voice = &voices[i];
+            }
+        } else if (voices[i].source == source) {
+            voice = &voices[i];
+        } else if (!lowest || voices[i].mix.priority < lowest->mix.priority) {
+            lowest = &voices[i];
+        }
+    }
     
-    // 保存参数
-    memcpy(&current_status.params, params, sizeof(vibration_params_t));
-    current_status.active = true;
-    current_status.start_time = esp_timer_get_time() / 1000; // 转换为毫秒
-    current_status.remaining_time = params->duration_ms;
-    
-    // 根据模式处理
-    esp_err_t ret = ESP_OK;
-    switch (params->mode) {
-        case VIBRATION_MODE_PULSE:
-            ret = handle_pulse_mode(params);
-            break;
-            
-        case VIBRATION_MODE_CONTINUOUS:
-            ret = handle_continuous_mode(params);
-            break;
-            
-        case VIBRATION_MODE_PATTERN:
-            // TODO: 实现模式模式
-            ESP_LOGW(TAG, "Pattern mode not implemented yet");
-            ret = handle_continuous_mode(params);
-            break;
-            
-        case VIBRATION_MODE_FEEDBACK:
-            ret = handle_continuous_mode(params);
-            break;
-            
-        default:
-            ESP_LOGE(TAG, "Invalid vibration mode: %d", params->mode);
-            ret = ESP_ERR_INVALID_ARG;
-            break;
+    if (queue && voice) {
+        if (queue_count == VIBRATION_QUEUE_LEN) {
+            ESP_LOGW(TAG, "Vibration queue full");
+            ret = ESP_ERR_NO_MEM;
+        } else {
+            effect_queue[(queue_head + queue_count) % VIBRATION_QUEUE_LEN] = effect;
+            queue_count++;
+        }
+    } else {
+        if (!voice) {
+            voice = free_voice;
+        }
+        bool stolen = false;
+        if (!voice && lowest && lowest->mix.priority <= mix->priority) {
+            // 声部用尽：替换优先级最低的效果
+            voice = lowest;
+            stolen = true;
+        }
+        
+        if (!voice) {
+            ESP_LOGW(TAG, "All %d vibration voices busy with higher priority effects", VIBRATION_MAX_VOICES);
+            ret = ESP_ERR_NO_MEM;
+        } else {
+            // 发送失败时恢复被替换的效果和队列
+            vibration_voice_t previous = *voice;
+            uint8_t previous_queue_count = queue_count;
+            if (source == VIBRATION_SOURCE_DEFAULT && !queue) {
+                queue_count = 0;
+            }
+            memset(voice, 0, sizeof(*voice));
+            voice->source = source;
+            voice->outputs = outputs;
+            voice->mix = *mix;
+            voice->step_deadline_us = esp_timer_get_time();
+            voice_begin(voice, &effect);
+            ret = render_frame();
+            if (ret != ESP_OK && (outputs & VOICE_OUTPUT_LOCAL)) {
+                // 手柄发送失败（如未连接）不影响本地马达
+                ret = ESP_OK;
+            } else if (ret != ESP_OK) {
+                // 发送失败（如手柄未连接）时放弃这个效果，原来的效果继续播放
+                *voice = previous;
+                queue_count = previous_queue_count;
+                stolen = false;
+                render_frame();
+            }
+            if (stolen) {
+                mixer_stats.voices_stolen++;
+            }
+        }
     }
+    xSemaphoreGive(sequencer_mutex);
     
-    if (ret != ESP_OK) {
-        current_status.active = false;
-        current_status.remaining_time = 0;
+    return ret;
+}
+
+esp_err_t vibration_start(const vibration_params_t *params)
+{
+    return submit_effect(VIBRATION_SOURCE_DEFAULT, params, NULL, NULL, false);
+}
+
+esp_err_t vibration_play(uint8_t source, const vibration_params_t *params, const vibration_mix_t *mix)
+{
+    return submit_effect(source, params, NULL, mix, false);
+}
+
+esp_err_t vibration_play_clip(uint8_t source, const haptic_clip_t *clip, uint8_t intensity,
+                              const vibration_mix_t *mix)
+{
+    if (!clip) {
+        ESP_LOGE(TAG, "Invalid haptic clip");
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    vibration_params_t params = {
+        .left_intensity = intensity,
+        .right_intensity = intensity,
+        .duration_ms = clip->duration_ms,
+        .mode = VIBRATION_MODE_CLIP
+    };
+    
+    return submit_effect(source, &params, clip, mix, false);
+}
+
+esp_err_t vibration_queue(const vibration_params_t *params)
+{
+    return submit_effect(VIBRATION_SOURCE_DEFAULT, params, NULL, NULL, true);
+}
+
+esp_err_t vibration_stop_source(uint8_t source)
+{
+    if (!initialized) {
+        ESP_LOGE(TAG, "Vibration not initialized");
+        return ESP_ERR_INVALID_STATE;
     }
     
+    xSemaphoreTake(sequencer_mutex, portMAX_DELAY);
+    for (size_t i = 0; i < VIBRATION_MAX_VOICES; i++) {
+        if (voices[i].source == source) {
+            voices[i].active = false;
+        }
+    }
+    if (source == VIBRATION_SOURCE_DEFAULT) {
+        queue_count = 0;
+    }
+    esp_err_t ret = render_frame();
+    xSemaphoreGive(sequencer_mutex);
+    
     return ret;
 }
 
@@ -257,26 +783,60 @@ esp_err_t vibration_stop(void)
         return ESP_ERR_INVALID_STATE;
     }
     
-    // 停止定时器
-    if (vibration_timer != NULL) {
-        xTimerStop(vibration_timer, 0);
+    xSemaphoreTake(sequencer_mutex, portMAX_DELAY);
+    
+    // 停止定时器和所有声部，清空队列
+    esp_timer_stop(sequencer_timer);
+    for (size_t i = 0; i < VIBRATION_MAX_VOICES; i++) {
+        voices[i].active = false;
     }
+    queue_count = 0;
     
-    // 发送停止命令
+    // 发送停止命令（不论上次发送的强度）
     esp_err_t ret = send_vibration_command(0, 0);
+    output_left = 0;
+    output_right = 0;
+    
+    // 本地马达立即停止（硬件渐变进行中时会等它结束）
+    if (vibration_local_is_ready()) {
+        vibration_local_set(0, 0, 0);
+    }
+    local_busy_until_us = 0;
     
     // 更新状态
     current_status.active = false;
     current_status.remaining_time = 0;
     
+    xSemaphoreGive(sequencer_mutex);
     return ret;
 }
 
 esp_err_t vibration_set_pattern(const vibration_pattern_t *pattern)
 {
-    ESP_LOGW(TAG, "Pattern mode not implemented yet");
-    // TODO: 实现模式震动
-    return ESP_ERR_NOT_SUPPORTED;
+    if (!pattern || !pattern->pattern_data || pattern->pattern_length == 0 ||
+        pattern->pattern_length > VIBRATION_PATTERN_MAX_STEPS || pattern->step_duration_ms == 0) {
+        ESP_LOGE(TAG, "Invalid vibration pattern");
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    vibration_effect_t stored = {
+        .pattern_length = pattern->pattern_length,
+        .step_duration_ms = pattern->step_duration_ms,
+        .repeat = pattern->repeat
+    };
+    memcpy(stored.pattern, pattern->pattern_data, pattern->pattern_length);
+    
+    if (sequencer_mutex) {
+        xSemaphoreTake(sequencer_mutex, portMAX_DELAY);
+    }
+    stored_pattern = stored;
+    if (sequencer_mutex) {
+        xSemaphoreGive(sequencer_mutex);
+    }
+    
+    ESP_LOGD(TAG, "Vibration pattern set: %d steps of %dms%s", pattern->pattern_length,
+             pattern->step_duration_ms, pattern->repeat ? ", repeating" : "");
+    return ESP_OK;
 }
 
 esp_err_t vibration_quick_pulse(uint8_t intensity, uint32_t duration_ms)
@@ -318,17 +878,37 @@ esp_err_t vibration_get_status(vibration_status_t *status)
         return ESP_ERR_INVALID_STATE;
     }
     
+    xSemaphoreTake(sequencer_mutex, portMAX_DELAY);
+    
     // 更新剩余时间
     if (current_status.active) {
-        uint32_t elapsed = (esp_timer_get_time() / 1000) - current_status.start_time;
-        if (elapsed >= current_status.params.duration_ms) {
-            current_status.remaining_time = 0;
+        if (status_end_us == 0) {
+            current_status.remaining_time = UINT32_MAX;
         } else {
-            current_status.remaining_time = current_status.params.duration_ms - elapsed;
+            int64_t remaining_us = status_end_us - esp_timer_get_time();
+            current_status.remaining_time = remaining_us > 0 ? (uint32_t)(remaining_us / 1000) : 0;
         }
     }
     
     memcpy(status, &current_status, sizeof(vibration_status_t));
+    xSemaphoreGive(sequencer_mutex);
+    return ESP_OK;
+}
+
+esp_err_t vibration_get_stats(vibration_stats_t *stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (!initialized) {
+        memset(stats, 0, sizeof(*stats));
+        return ESP_OK;
+    }
+    
+    xSemaphoreTake(sequencer_mutex, portMAX_DELAY);
+    *stats = mixer_stats;
+    xSemaphoreGive(sequencer_mutex);
     return ESP_OK;
 }
 
@@ -354,3 +934,15 @@ bool vibration_is_enabled(void)
 {
     return vibration_enabled;
 }
+
+esp_err_t vibration_set_default_output(vibration_output_t output)
+{
+    if (output == VIBRATION_OUTPUT_DEFAULT || output > VIBRATION_OUTPUT_BOTH) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    ESP_LOGI(TAG, "Default vibration output: %s", output == VIBRATION_OUTPUT_PAD ? "pad" :
+             output == VIBRATION_OUTPUT_LOCAL ? "local" : "both");
+    default_output = output;
+    return ESP_OK;
+}
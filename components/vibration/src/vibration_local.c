@@ -0,0 +1,143 @@
+/**
+ * @file vibration_local.c
+ * @brief 本地震动马达实现（LEDC PWM与硬件渐变）
+ */
+
+#include "vibration_local.h"
+#include "driver/ledc.h"
+#include "driver/gpio.h"
+#include "esp_log.h"
+
+static const char *TAG = "VIBRATION_LOCAL";
+
+// LEDC配置（定时器0/1和通道0-5由小车和飞机控制使用）
+#define LEDC_TIMER              LEDC_TIMER_2
+#define LEDC_MODE               LEDC_LOW_SPEED_MODE
+#define LEDC_LEFT_CHANNEL       LEDC_CHANNEL_6
+#define LEDC_RIGHT_CHANNEL      LEDC_CHANNEL_7
+#define LEDC_DUTY_RES           LEDC_TIMER_8_BIT   // 强度 (0-255) 直接作为占空比
+#define DEFAULT_PWM_FREQ_HZ     20000
+
+#define MOTOR_COUNT             2
+
+static const ledc_channel_t motor_channels[MOTOR_COUNT] = { LEDC_LEFT_CHANNEL, LEDC_RIGHT_CHANNEL };
+static int motor_gpio[MOTOR_COUNT] = { -1, -1 };
+static uint8_t motor_duty[MOTOR_COUNT] = {0};    ///< 最近设定的目标占空比（渐变的终点）
+static bool initialized = false;
+
+esp_err_t vibration_local_init(const vibration_local_config_t *config)
+{
+    if (!config || (config->left_gpio < 0 && config->right_gpio < 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (initialized) {
+        ESP_LOGW(TAG, "Local vibration motors already initialized");
+        return ESP_OK;
+    }
+
+    ledc_timer_config_t ledc_timer = {
+        .speed_mode       = LEDC_MODE,
+        .timer_num        = LEDC_TIMER,
+        .duty_resolution  = LEDC_DUTY_RES,
+        .freq_hz          = config->pwm_freq_hz ? config->pwm_freq_hz : DEFAULT_PWM_FREQ_HZ,
+        .clk_cfg          = LEDC_AUTO_CLK
+    };
+    esp_err_t ret = ledc_timer_config(&ledc_timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure LEDC timer: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    const int gpios[MOTOR_COUNT] = { config->left_gpio, config->right_gpio };
+    for (int i = 0; i < MOTOR_COUNT; i++) {
+        motor_gpio[i] = -1;
+        motor_duty[i] = 0;
+        if (gpios[i] < 0) {
+            continue;
+        }
+
+        ledc_channel_config_t channel = {
+            .speed_mode     = LEDC_MODE,
+            .channel        = motor_channels[i],
+            .timer_sel      = LEDC_TIMER,
+            .intr_type      = LEDC_INTR_DISABLE,
+            .gpio_num       = gpios[i],
+            .duty           = 0,
+            .hpoint         = 0
+        };
+        ret = ledc_channel_config(&channel);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to configure motor channel on GPIO %d: %s", gpios[i], esp_err_to_name(ret));
+            return ret;
+        }
+        motor_gpio[i] = gpios[i];
+    }
+
+    // 渐变服务可能已由其他模块安装
+    ret = ledc_fade_func_install(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "Failed to install LEDC fade: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    initialized = true;
+    ESP_LOGI(TAG, "Local vibration motors on GPIO %d/%d at %lu Hz", motor_gpio[0], motor_gpio[1],
+             (unsigned long)ledc_timer.freq_hz);
+    return ESP_OK;
+}
+
+esp_err_t vibration_local_deinit(void)
+{
+    if (!initialized) {
+        return ESP_OK;
+    }
+
+    // 渐变服务可能仍被其他模块使用，不卸载
+    for (int i = 0; i < MOTOR_COUNT; i++) {
+        if (motor_gpio[i] >= 0) {
+            ledc_stop(LEDC_MODE, motor_channels[i], 0);
+            gpio_reset_pin(motor_gpio[i]);
+            motor_gpio[i] = -1;
+        }
+    }
+    initialized = false;
+    return ESP_OK;
+}
+
+bool vibration_local_is_ready(void)
+{
+    return initialized;
+}
+
+esp_err_t vibration_local_set(uint8_t left, uint8_t right, uint32_t fade_ms)
+{
+    if (!initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const uint8_t target[MOTOR_COUNT] = { left, right };
+    for (int i = 0; i < MOTOR_COUNT; i++) {
+        if (motor_gpio[i] < 0 || target[i] == motor_duty[i]) {
+            continue;
+        }
+
+        esp_err_t ret;
+        if (fade_ms > 0) {
+            ret = ledc_set_fade_with_time(LEDC_MODE, motor_channels[i], target[i], (int)fade_ms);
+            if (ret == ESP_OK) {
+                ret = ledc_fade_start(LEDC_MODE, motor_channels[i], LEDC_FADE_NO_WAIT);
+            }
+        } else {
+            ret = ledc_set_duty(LEDC_MODE, motor_channels[i], target[i]);
+            if (ret == ESP_OK) {
+                ret = ledc_update_duty(LEDC_MODE, motor_channels[i]);
+            }
+        }
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to set motor duty: %s", esp_err_to_name(ret));
+            return ret;
+        }
+        motor_duty[i] = target[i];
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file bench_haptic_clip.c
+ * @brief 震动片段逐帧求值基准
+ *
+ * 在内存中打包一个片段库（与tools/haptic_pack的输出格式相同），用haptic_clip_bank_load加载后
+ * 对每个片段测两种播放方式的开销：
+ *   frame  每VIBRATION_FRAME_MS求值一次（片段没有可跳过的区段时的最坏情况）
+ *   seq    与序列器相同，强度不变的区段作为一步跳过，只在过渡段按帧求值
+ * 输出每次求值的周期数和纳秒数，以及序列器模式下求值次数占总帧数的比例。
+ * 另检查偏移接近UINT32_MAX的目录项被拒绝。
+ *
+ * 用法：bench_haptic_clip [每个片段的播放遍数]
+ */
+
+#include "haptic_clip.h"
+#include "vibration.h"
+#include "esp_rom_crc.h"
+#include "host_test.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define BANK_MAX_BYTES      8192
+#define DENSE_KEYFRAMES     HAPTIC_CLIP_MAX_KEYFRAMES
+
+typedef struct {
+    const char *name;
+    haptic_clip_t header;
+    haptic_keyframe_t frames[2 * DENSE_KEYFRAMES];
+} bench_clip_t;
+
+static bench_clip_t clips[] = {
+    // 与tools/haptic_pack/clips.txt中的同名片段相同
+    { "connect", { .duration_ms = 260, .release_ms = 40, .sustain_level = 255, .keyframe_count = { 6, 0 } },
+      { { 0, 0, HAPTIC_INTERP_SMOOTH }, { 40, 180, HAPTIC_INTERP_SMOOTH }, { 90, 0, HAPTIC_INTERP_STEP },
+        { 130, 0, HAPTIC_INTERP_SMOOTH }, { 170, 220, HAPTIC_INTERP_SMOOTH }, { 260, 0, HAPTIC_INTERP_STEP } } },
+    { "hit", { .duration_ms = 300, .attack_ms = 5, .decay_ms = 80, .sustain_level = 90, .release_ms = 120,
+               .keyframe_count = { 2, 2 } },
+      { { 0, 255, HAPTIC_INTERP_STEP }, { 300, 255, HAPTIC_INTERP_STEP },
+        { 0, 140, HAPTIC_INTERP_STEP }, { 300, 140, HAPTIC_INTERP_STEP } } },
+    { "engine", { .duration_ms = 120, .sustain_level = 255, .flags = HAPTIC_CLIP_FLAG_LOOP,
+                  .keyframe_count = { 3, 3 } },
+      { { 0, 60, HAPTIC_INTERP_SMOOTH }, { 60, 20, HAPTIC_INTERP_SMOOTH }, { 120, 60, HAPTIC_INTERP_STEP },
+        { 0, 20, HAPTIC_INTERP_SMOOTH }, { 60, 60, HAPTIC_INTERP_SMOOTH }, { 120, 20, HAPTIC_INTERP_STEP } } },
+    // 两条马达各255个关键帧，交替线性和阶跃，二分查找最深
+    { "dense", { .duration_ms = DENSE_KEYFRAMES * 8, .attack_ms = 50, .decay_ms = 200, .sustain_level = 160,
+                 .release_ms = 300, .keyframe_count = { DENSE_KEYFRAMES, DENSE_KEYFRAMES } } },
+};
+
+#define CLIP_COUNT  (sizeof(clips) / sizeof(clips[0]))
+
+static uint32_t bank_storage[BANK_MAX_BYTES / sizeof(uint32_t)];
+
+static size_t clip_frame_count(const haptic_clip_t *clip)
+{
+    return (size_t)clip->keyframe_count[0] + clip->keyframe_count[1];
+}
+
+/**
+ * @brief 按库格式打包所有片段
+ * @return 库的字节数
+ */
+static size_t pack_bank(uint8_t *out)
+{
+    haptic_bank_header_t *header = (haptic_bank_header_t *)out;
+    haptic_clip_entry_t *entries = (haptic_clip_entry_t *)(header + 1);
+    size_t offset = sizeof(*header) + CLIP_COUNT * sizeof(*entries);
+
+    for (size_t i = 0; i < CLIP_COUNT; i++) {
+        size_t frames_bytes = clip_frame_count(&clips[i].header) * sizeof(haptic_keyframe_t);
+        memset(&entries[i], 0, sizeof(entries[i]));
+        strncpy(entries[i].name, clips[i].name, HAPTIC_CLIP_NAME_LEN - 1);
+        entries[i].offset = (uint32_t)offset;
+        memcpy(out + offset, &clips[i].header, sizeof(haptic_clip_t));
+        memcpy(out + offset + sizeof(haptic_clip_t), clips[i].frames, frames_bytes);
+        offset += sizeof(haptic_clip_t) + frames_bytes;
+    }
+
+    header->magic = HAPTIC_CLIP_MAGIC;
+    header->version = HAPTIC_CLIP_VERSION;
+    header->clip_count = CLIP_COUNT;
+    header->size = (uint32_t)offset;
+    header->crc32 = esp_rom_crc32_le(0, out + sizeof(*header), header->size - sizeof(*header));
+    return offset;
+}
+
+/**
+ * @brief 把最后一个片段的偏移改成接近UINT32_MAX，库应被拒绝
+ */
+static void check_wrapping_offset(void)
+{
+    static uint32_t storage[BANK_MAX_BYTES / sizeof(uint32_t)];
+    uint8_t *copy = (uint8_t *)storage;
+    memcpy(copy, bank_storage, sizeof(storage));
+
+    haptic_bank_header_t *header = (haptic_bank_header_t *)copy;
+    haptic_clip_entry_t *entries = (haptic_clip_entry_t *)(header + 1);
+    entries[CLIP_COUNT - 1].offset = UINT32_MAX - 3;
+    header->crc32 = esp_rom_crc32_le(0, copy + sizeof(*header), header->size - sizeof(*header));
+    TEST_CHECK_EQ(haptic_clip_bank_load(copy, header->size), ESP_ERR_INVALID_SIZE);
+}
+
+int main(int argc, char **argv)
+{
+    long passes = argc > 1 ? atol(argv[1]) : 20000;
+    if (passes <= 0) {
+        fprintf(stderr, "usage: %s [passes per clip]\n", argv[0]);
+        return 2;
+    }
+
+    bench_clip_t *dense = &clips[CLIP_COUNT - 1];
+    for (size_t i = 0; i < DENSE_KEYFRAMES; i++) {
+        uint8_t interp = (i & 1) ? HAPTIC_INTERP_STEP : HAPTIC_INTERP_LINEAR;
+        dense->frames[i] = (haptic_keyframe_t){ (uint16_t)(i * 8), (uint8_t)(i * 37), interp };
+        dense->frames[DENSE_KEYFRAMES + i] = (haptic_keyframe_t){ (uint16_t)(i * 8 + 3), (uint8_t)(i * 91), interp };
+    }
+
+    uint8_t *blob = (uint8_t *)bank_storage;
+    size_t bank_size = pack_bank(blob);
+    check_wrapping_offset();
+    TEST_CHECK_EQ(haptic_clip_bank_load(blob, bank_size), ESP_OK);
+
+    printf("%-8s %6s %10s %10s %10s %10s %8s\n", "clip", "frames", "frame cyc", "frame ns", "seq cyc", "seq ns",
+           "seq/frm");
+    for (size_t c = 0; c < CLIP_COUNT; c++) {
+        const haptic_clip_t *clip = haptic_clip_find(clips[c].name);
+        TEST_CHECK(clip != NULL);
+        if (!clip) {
+            continue;
+        }
+        uint32_t frames = (clip->duration_ms + VIBRATION_FRAME_MS - 1) / VIBRATION_FRAME_MS;
+        volatile uint32_t sink = 0;
+        uint8_t left, right;
+
+        // 逐帧求值
+        uint64_t start_ns = host_now_ns();
+        uint64_t start_cycles = host_cycles();
+        for (long p = 0; p < passes; p++) {
+            for (uint32_t t_ms = 0; t_ms < clip->duration_ms; t_ms += VIBRATION_FRAME_MS) {
+                sink += haptic_clip_sample(clip, t_ms, &left, &right);
+                sink += left + right;
+            }
+        }
+        double frame_cycles = (double)(host_cycles() - start_cycles) / ((double)passes * frames);
+        double frame_ns = (double)(host_now_ns() - start_ns) / ((double)passes * frames);
+
+        // 序列器的步进：不变区段一步跳过，与vibration.c的effect_step相同
+        uint64_t evaluations = 0;
+        start_ns = host_now_ns();
+        start_cycles = host_cycles();
+        for (long p = 0; p < passes; p++) {
+            uint32_t t_ms = 0;
+            while (t_ms < clip->duration_ms) {
+                uint32_t stable_ms = haptic_clip_sample(clip, t_ms, &left, &right);
+                uint32_t step_ms = stable_ms ? stable_ms : VIBRATION_FRAME_MS;
+                if (step_ms > clip->duration_ms - t_ms) {
+                    step_ms = clip->duration_ms - t_ms;
+                }
+                sink += left + right;
+                t_ms += step_ms;
+                evaluations++;
+            }
+        }
+        double seq_cycles = (double)(host_cycles() - start_cycles) / (double)evaluations;
+        double seq_ns = (double)(host_now_ns() - start_ns) / (double)evaluations;
+        (void)sink;
+
+        printf("%-8s %6u %10.1f %10.1f %10.1f %10.1f %7.0f%%\n", clips[c].name, frames, frame_cycles, frame_ns,
+               seq_cycles, seq_ns, 100.0 * (double)evaluations / ((double)passes * frames));
+    }
+    return host_test_finish("haptic_clip");
+}
@@ -0,0 +1,97 @@
+/**
+ * @file bench_pipeline.c
+ * @brief 主机端完整输入链路基准：回环传输 → 解析 → 映射 → 执行
+ *
+ * 链接真实的bluetooth_hid（回环后端）、gamepad_controller、system_monitor以及解析、滤波、
+ * 调理和组合键模块，FreeRTOS和esp_timer由POSIX实现替代，小车/飞机执行器和震动为替身。
+ * 回环后端按设定速率合成摇杆扫动报告，执行器替身在"PWM更新"处记录延迟，
+ * 结束时输出送达和执行的报告速率以及输入到执行的延迟百分位（取自system_monitor）。
+ *
+ * 用法：bench_pipeline [手柄数] [每个手柄的报告速率Hz] [秒数] [car|plane] [event|polled]
+ */
+
+#include "gamepad_controller.h"
+#include "bluetooth_hid.h"
+#include "hid_loopback.h"
+#include "hid_reconnect.h"
+#include "system_monitor.h"
+#include "actuator_stubs.h"
+#include "host_test.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define WARMUP_MS       500
+
+int main(int argc, char **argv)
+{
+    int devices = argc > 1 ? atoi(argv[1]) : 1;
+    long rate_hz = argc > 2 ? atol(argv[2]) : 1000;
+    double seconds = argc > 3 ? atof(argv[3]) : 3.0;
+    control_mode_t mode = argc > 4 && strcmp(argv[4], "plane") == 0 ? CONTROL_MODE_PLANE : CONTROL_MODE_CAR;
+    gamepad_pipeline_mode_t pipeline = argc > 5 && strcmp(argv[5], "polled") == 0 ?
+                                       GAMEPAD_PIPELINE_POLLED : GAMEPAD_PIPELINE_EVENT;
+    if (devices < 1 || devices > HID_LOOPBACK_MAX_DEVICES || rate_hz <= 0 || seconds <= 0) {
+        fprintf(stderr, "usage: %s [devices 1-%d] [rate Hz] [seconds] [car|plane] [event|polled]\n",
+                argv[0], HID_LOOPBACK_MAX_DEVICES);
+        return 2;
+    }
+
+    hid_loopback_config_t loopback = {
+        .device_count = (uint8_t)devices,
+        .rate_hz = (uint32_t)rate_hz,
+        .jitter_us = 0,
+        .drop_per_mille = 0,
+        .seed = 1,
+    };
+    if (hid_loopback_configure(&loopback) != ESP_OK ||
+        bluetooth_hid_set_transport(hid_transport_loopback()) != ESP_OK) {
+        fprintf(stderr, "loopback transport rejected\n");
+        return 1;
+    }
+
+    if (system_monitor_init() != ESP_OK || gamepad_controller_init() != ESP_OK ||
+        gamepad_controller_set_mode(mode) != ESP_OK ||
+        gamepad_controller_set_pipeline_mode(pipeline) != ESP_OK) {
+        fprintf(stderr, "pipeline init failed\n");
+        return 1;
+    }
+    // 与app_main相同：配置生效后再开始连接
+    hid_reconnect_start();
+
+    // 预热：等模拟手柄连接、各任务进入稳态后再清零统计
+    vTaskDelay(pdMS_TO_TICKS(WARMUP_MS));
+    system_monitor_reset_latency();
+
+    hid_loopback_stats_t before, after;
+    hid_loopback_get_stats(&before);
+    uint32_t actuated_before = actuator_stub_car_updates() + actuator_stub_plane_updates();
+    uint64_t start = host_now_ns();
+
+    vTaskDelay(pdMS_TO_TICKS((uint32_t)(seconds * 1000)));
+
+    uint64_t elapsed = host_now_ns() - start;
+    hid_loopback_get_stats(&after);
+    uint32_t actuated = actuator_stub_car_updates() + actuator_stub_plane_updates() - actuated_before;
+
+    gamepad_latency_stats_t latency;
+    TEST_CHECK_EQ(gamepad_controller_get_latency_stats(&latency), ESP_OK);
+
+    double secs = (double)elapsed / 1e9;
+    uint32_t delivered = after.delivered - before.delivered;
+    printf("%d device(s) x %ld Hz, %s mode, %s pipeline, %.1f s\n", devices, rate_hz,
+           mode == CONTROL_MODE_PLANE ? "plane" : "car",
+           pipeline == GAMEPAD_PIPELINE_EVENT ? "event" : "polled", secs);
+    printf("  delivered   %10u reports  %10.0f reports/s (max lateness %u us)\n",
+           delivered, delivered / secs, after.late_max_us);
+    printf("  actuated    %10u updates  %10.0f updates/s\n", actuated, actuated / secs);
+    printf("  measured    %10u reports  %10.0f reports/s\n", latency.samples, latency.samples / secs);
+    printf("  parse->actuate latency: p50 %u us, p90 %u us, p99 %u us, max %u us\n",
+           latency.p50_us, latency.p90_us, latency.p99_us, latency.max_us);
+
+    // 每个送达的报告至少应有一部分驱动了执行器，否则链路没有接通
+    TEST_CHECK(delivered > 0);
+    TEST_CHECK(latency.samples > 0);
+    return host_test_finish("pipeline");
+}
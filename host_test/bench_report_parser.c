@@ -0,0 +1,67 @@
+/**
+ * @file bench_report_parser.c
+ * @brief 报告提取热路径基准（ns/report）
+ *
+ * 对四个内置描述符（gamepad_config.ini中supported_controllers对应的型号）各编译一次提取表，
+ * 循环提取一组内容随机的报告，输出每个报告的平均耗时。
+ *
+ * 用法：bench_report_parser [每种型号的报告数]
+ */
+
+#include "hid_report_parser.h"
+#include "host_test.h"
+#include <stdlib.h>
+
+#define FRAME_COUNT     256     // 2的幂，循环取帧
+#define FRAME_BYTES     16
+
+static const struct {
+    const char *name;
+    hid_controller_type_t type;
+} profiles[] = {
+    { "generic", HID_CONTROLLER_GENERIC },
+    { "ps4",     HID_CONTROLLER_PS4 },
+    { "xbox",    HID_CONTROLLER_XBOX },
+    { "beitong", HID_CONTROLLER_BEITONG },
+};
+
+int main(int argc, char **argv)
+{
+    long iterations = argc > 1 ? atol(argv[1]) : 5000000;
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: %s [reports per controller]\n", argv[0]);
+        return 2;
+    }
+
+    static uint8_t frames[FRAME_COUNT][FRAME_BYTES];
+    srand(12345);
+    for (int i = 0; i < FRAME_COUNT; i++) {
+        for (int j = 0; j < FRAME_BYTES; j++) {
+            frames[i][j] = (uint8_t)rand();
+        }
+    }
+
+    printf("%-8s %6s %6s %10s %12s\n", "type", "fields", "bytes", "ns/report", "reports/s");
+    for (size_t p = 0; p < sizeof(profiles) / sizeof(profiles[0]); p++) {
+        hid_report_map_t map;
+        if (hid_report_map_compile_builtin(profiles[p].type, &map) != ESP_OK) {
+            fprintf(stderr, "%s: compile failed\n", profiles[p].name);
+            return 1;
+        }
+
+        hid_gamepad_report_t report;
+        volatile uint32_t sink = 0;
+        uint64_t start = host_now_ns();
+        for (long i = 0; i < iterations; i++) {
+            hid_report_map_extract(&map, map.report_id, frames[i & (FRAME_COUNT - 1)], FRAME_BYTES, &report);
+            sink += report.buttons + (uint16_t)report.axes[0];
+        }
+        uint64_t elapsed = host_now_ns() - start;
+        (void)sink;
+
+        double ns = (double)elapsed / (double)iterations;
+        printf("%-8s %6u %6u %10.1f %12.0f\n", profiles[p].name, map.field_count, map.report_bytes,
+               ns, 1e9 / ns);
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file bench_stick_conditioning.c
+ * @brief 摇杆调理基准：查找表对比直接sqrtf/powf/logf计算
+ *
+ * 对每种响应曲线调理同一组随机摇杆样本，输出单轴和双轴（径向死区）每次调用的平均耗时。
+ *
+ * 用法：bench_stick_conditioning [样本数]
+ */
+
+#include "stick_conditioning.h"
+#include "stick_reference.h"
+#include "host_test.h"
+#include <stdlib.h>
+
+#define SAMPLE_COUNT    4096    // 2的幂，循环取样本
+
+static const struct {
+    const char *name;
+    stick_curve_t curve;
+} curves[] = {
+    { "linear",      STICK_CURVE_LINEAR },
+    { "exponential", STICK_CURVE_EXPONENTIAL },
+    { "logarithmic", STICK_CURVE_LOGARITHMIC },
+};
+
+int main(int argc, char **argv)
+{
+    long iterations = argc > 1 ? atol(argv[1]) : 10000000;
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: %s [samples]\n", argv[0]);
+        return 2;
+    }
+
+    static int16_t samples[SAMPLE_COUNT];
+    srand(54321);
+    for (int i = 0; i < SAMPLE_COUNT; i++) {
+        samples[i] = (int16_t)(rand() % 65536 - 32768);
+    }
+
+    stick_conditioning_init();
+    printf("%-12s %12s %12s %8s %12s %12s %8s\n", "curve", "axis lut", "axis direct", "speedup",
+           "2d lut", "2d direct", "speedup");
+    for (size_t c = 0; c < sizeof(curves) / sizeof(curves[0]); c++) {
+        stick_conditioning_config_t config = {
+            .deadzone_percent = 10,
+            .max_speed = 255,
+            .curve = curves[c].curve,
+        };
+        stick_conditioning_set_config(&config);
+
+        volatile int32_t sink = 0;
+        uint64_t start = host_now_ns();
+        for (long i = 0; i < iterations; i++) {
+            sink += stick_conditioning_apply_axis(samples[i & (SAMPLE_COUNT - 1)]);
+        }
+        double lut_ns = (double)(host_now_ns() - start) / (double)iterations;
+
+        volatile float fsink = 0.0f;
+        start = host_now_ns();
+        for (long i = 0; i < iterations; i++) {
+            fsink += reference_apply_axis(&config, samples[i & (SAMPLE_COUNT - 1)]);
+        }
+        double direct_ns = (double)(host_now_ns() - start) / (double)iterations;
+        // 双轴：相邻两个样本作为X/Y
+        start = host_now_ns();
+        for (long i = 0; i < iterations; i++) {
+            int16_t ox, oy;
+            stick_conditioning_apply(samples[i & (SAMPLE_COUNT - 1)], samples[(i + 1) & (SAMPLE_COUNT - 1)], &ox, &oy);
+            sink += ox + oy;
+        }
+        double lut_2d_ns = (double)(host_now_ns() - start) / (double)iterations;
+
+        start = host_now_ns();
+        for (long i = 0; i < iterations; i++) {
+            float ox, oy;
+            reference_apply(&config, samples[i & (SAMPLE_COUNT - 1)], samples[(i + 1) & (SAMPLE_COUNT - 1)], &ox, &oy);
+            fsink += ox + oy;
+        }
+        double direct_2d_ns = (double)(host_now_ns() - start) / (double)iterations;
+        (void)sink;
+        (void)fsink;
+
+        printf("%-12s %12.2f %12.2f %7.1fx %12.2f %12.2f %7.1fx\n", curves[c].name, lut_ns, direct_ns,
+               direct_ns / lut_ns, lut_2d_ns, direct_2d_ns, direct_2d_ns / lut_2d_ns);
+    }
+    return 0;
+}
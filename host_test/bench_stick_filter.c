@@ -0,0 +1,80 @@
+/**
+ * @file bench_stick_filter.c
+ * @brief 摇杆滤波周期计数基准
+ *
+ * 对一组带噪声的四轴样本逐报告调用stick_filter_process，输出每个报告（四个轴）的
+ * 平均周期数和纳秒数。主机上的周期来自host_cycles()（x86为TSC），只用于比较滤波器之间
+ * 和改动前后的相对开销。目标板上的开销由stick_filter_get_stats用esp_cpu_get_cycle_count
+ * 实测，在心跳日志 "Stick filter: ... cycles/report" 中输出。
+ *
+ * 用法：bench_stick_filter [报告数]
+ */
+
+#include "stick_filter.h"
+#include "host_test.h"
+#include <stdlib.h>
+
+#define SAMPLE_COUNT    1024    // 2的幂，循环取样本
+#define REPORT_INTERVAL_US 7500
+
+static const struct {
+    const char *name;
+    stick_filter_axis_config_t axis;
+} filters[] = {
+    { "none",     { .type = STICK_FILTER_NONE } },
+    { "ema",      { .type = STICK_FILTER_EMA, .ema_alpha = 64 } },
+    { "one-euro", { .type = STICK_FILTER_ONE_EURO, .min_cutoff_mhz = 1000, .beta = 50, .d_cutoff_mhz = 1000 } },
+};
+
+int main(int argc, char **argv)
+{
+    long iterations = argc > 1 ? atol(argv[1]) : 5000000;
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: %s [reports]\n", argv[0]);
+        return 2;
+    }
+
+    // 缓慢移动的摇杆加随机噪声，让One-Euro的速度估计和截止频率都在变化
+    static int16_t samples[SAMPLE_COUNT][STICK_FILTER_AXIS_COUNT];
+    srand(777);
+    for (int i = 0; i < SAMPLE_COUNT; i++) {
+        for (int a = 0; a < STICK_FILTER_AXIS_COUNT; a++) {
+            int32_t base = ((i * (a + 1) * 64) % 40000) - 20000;
+            samples[i][a] = (int16_t)(base + rand() % 1001 - 500);
+        }
+    }
+
+    stick_filter_init();
+    printf("%-9s %14s %14s %10s\n", "filter", "cycles/report", "cycles/axis", "ns/report");
+    for (size_t f = 0; f < sizeof(filters) / sizeof(filters[0]); f++) {
+        stick_filter_config_t config;
+        for (int a = 0; a < STICK_FILTER_AXIS_COUNT; a++) {
+            config.axes[a] = filters[f].axis;
+        }
+        stick_filter_set_config(&config);
+
+        int16_t axes[STICK_FILTER_AXIS_COUNT];
+        volatile int32_t sink = 0;
+        int64_t timestamp_us = 0;
+        uint64_t start_ns = host_now_ns();
+        uint64_t start_cycles = host_cycles();
+        for (long i = 0; i < iterations; i++) {
+            const int16_t *s = samples[i & (SAMPLE_COUNT - 1)];
+            axes[0] = s[0];
+            axes[1] = s[1];
+            axes[2] = s[2];
+            axes[3] = s[3];
+            timestamp_us += REPORT_INTERVAL_US;
+            stick_filter_process(0, axes, timestamp_us);
+            sink += axes[0];
+        }
+        uint64_t cycles = host_cycles() - start_cycles;
+        uint64_t elapsed_ns = host_now_ns() - start_ns;
+        (void)sink;
+
+        double per_report = (double)cycles / (double)iterations;
+        printf("%-9s %14.1f %14.1f %10.1f\n", filters[f].name, per_report,
+               per_report / STICK_FILTER_AXIS_COUNT, (double)elapsed_ns / (double)iterations);
+    }
+    return 0;
+}
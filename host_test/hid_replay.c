@@ -0,0 +1,410 @@
+/**
+ * @file hid_replay.c
+ * @brief 主机端HID轨迹回放工具
+ *
+ * 读取固件录制的轨迹分段（格式见main/hid_trace_format.h），按分段序号排序后把每条报告
+ * 依次送入与固件相同的输入路径：hid_report_map_extract → stick_filter_process →
+ * button_combo_process（默认组合键表取自gamepad_combos.h），不等待录制节奏，
+ * 输出吞吐量、提取结果统计、组合键动作次数和输出摘要（相同输入应得到相同摘要）。
+ *
+ * 用法：
+ *   hid_replay [-t generic|ps4|xbox|beitong] [-r 重复次数] [-e 期望报告数] [-a] 分段文件...
+ *   hid_replay -w 输出文件 [-n 报告数]      生成一段合成轨迹（DS4布局，两个槽位），用-t ps4回放；
+ *                                           槽位1在前四分之一之后改发蓝牙报告0x11
+ *
+ *   -e  成功提取的报告数不等于期望值时返回失败
+ *   -a  默认组合键表中有动作从未触发时返回失败
+ */
+
+#include "hid_trace_format.h"
+#include "hid_report_parser.h"
+#include "stick_filter.h"
+#include "gamepad_combos.h"
+#include "host_test.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define REPLAY_MAX_SEGMENTS     64
+#define REPLAY_MAX_SLOTS        4
+
+// DS4蓝牙输入报告0x11：2字节头 + 与报告0x01相同的完整布局，数据共77字节
+#define DS4_BT_REPORT_ID        0x11
+#define DS4_BT_REPORT_LEN       77
+#define DS4_BT_HEADER_LEN       2
+
+typedef struct {
+    hid_trace_file_header_t header;
+    uint8_t *data;              ///< 文件头之后的记录
+    size_t len;
+    const char *path;
+} replay_segment_t;
+
+typedef struct {
+    uint64_t records;
+    uint64_t extracted;
+    uint64_t not_found;
+    uint64_t too_short;
+    uint64_t bad_slot;
+    uint64_t truncated;         ///< 末尾有不完整记录的分段数
+    uint64_t digest;            ///< 提取和滤波后输出的FNV-1a摘要
+} replay_stats_t;
+
+static const struct {
+    const char *name;
+    hid_controller_type_t type;
+} controller_types[] = {
+    { "generic", HID_CONTROLLER_GENERIC },
+    { "ps4",     HID_CONTROLLER_PS4 },
+    { "xbox",    HID_CONTROLLER_XBOX },
+    { "beitong", HID_CONTROLLER_BEITONG },
+};
+
+static uint64_t action_counts[BUTTON_COMBO_ACTION_MAX];
+
+static void combo_action_callback(button_combo_action_t action)
+{
+    if (action < BUTTON_COMBO_ACTION_MAX) {
+        action_counts[action]++;
+    }
+}
+
+static inline uint64_t digest_update(uint64_t hash, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ p[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static bool load_segment(const char *path, replay_segment_t *segment)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        perror(path);
+        return false;
+    }
+
+    bool ok = fread(&segment->header, sizeof(segment->header), 1, file) == 1 &&
+              segment->header.magic == HID_TRACE_MAGIC &&
+              segment->header.version == HID_TRACE_VERSION;
+    if (!ok) {
+        fprintf(stderr, "%s: not a trace segment\n", path);
+        fclose(file);
+        return false;
+    }
+
+    long start = ftell(file);
+    fseek(file, 0, SEEK_END);
+    long end = ftell(file);
+    fseek(file, start, SEEK_SET);
+
+    segment->len = end > start ? (size_t)(end - start) : 0;
+    segment->data = malloc(segment->len ? segment->len : 1);
+    segment->path = path;
+    ok = segment->data && fread(segment->data, 1, segment->len, file) == segment->len;
+    fclose(file);
+    if (!ok) {
+        fprintf(stderr, "%s: read failed\n", path);
+    }
+    return ok;
+}
+
+static int compare_segments(const void *a, const void *b)
+{
+    uint32_t sa = ((const replay_segment_t *)a)->header.sequence;
+    uint32_t sb = ((const replay_segment_t *)b)->header.sequence;
+    return sa < sb ? -1 : sa > sb;
+}
+
+/**
+ * @brief 回放全部分段一次
+ */
+static void replay_all(const replay_segment_t *segments, int count, const hid_report_map_t *map,
+                       replay_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->digest = 0xcbf29ce484222325ull;
+    for (uint8_t slot = 0; slot < REPLAY_MAX_SLOTS; slot++) {
+        stick_filter_reset(slot);
+        button_combo_reset(slot);
+    }
+
+    for (int s = 0; s < count; s++) {
+        const replay_segment_t *segment = &segments[s];
+        int64_t record_us = segment->header.base_time_us;
+        size_t pos = 0;
+        hid_trace_record_t record;
+        size_t used;
+
+        // 与固件回放一致：遇到不完整的记录即结束本分段
+        while ((used = hid_trace_decode_record(&segment->data[pos], segment->len - pos, &record)) > 0) {
+            pos += used;
+            record_us += (int64_t)record.delta_us;
+            stats->records++;
+
+            if (record.slot >= REPLAY_MAX_SLOTS) {
+                stats->bad_slot++;
+                continue;
+            }
+
+            hid_gamepad_report_t report;
+            esp_err_t ret = hid_report_map_extract(map, record.report_id, record.data, record.len, &report);
+            if (ret == ESP_ERR_NOT_FOUND) {
+                stats->not_found++;
+                continue;
+            }
+            if (ret != ESP_OK) {
+                stats->too_short++;
+                continue;
+            }
+            stats->extracted++;
+
+            stick_filter_process(record.slot, report.axes, record_us);
+            button_combo_process(record.slot, report.buttons, record_us);
+
+            stats->digest = digest_update(stats->digest, &record.slot, sizeof(record.slot));
+            stats->digest = digest_update(stats->digest, &report, sizeof(report));
+        }
+        if (pos != segment->len) {
+            stats->truncated++;
+        }
+    }
+}
+
+/**
+ * @brief 按DS4内置布局编码一条报告（不含报告ID）：X Y Z Rz | 方向键4位 + 14个按键 + 6位计数 | L2 R2
+ */
+static void encode_ps4_report(uint32_t buttons, const uint8_t sticks[4], const uint8_t triggers[2],
+                              uint8_t counter, uint8_t out[9])
+{
+    // 方向键：0上，顺时针每45度加1，8为松开
+    static const uint8_t hat_values[16] = {
+        8, 0, 4, 8, 6, 7, 5, 6, 2, 1, 3, 2, 8, 0, 4, 8,
+    };
+    uint32_t dpad = ((buttons >> GAMEPAD_BUTTON_DPAD_UP) & 1) |
+                    ((buttons >> GAMEPAD_BUTTON_DPAD_DOWN) & 1) << 1 |
+                    ((buttons >> GAMEPAD_BUTTON_DPAD_LEFT) & 1) << 2 |
+                    ((buttons >> GAMEPAD_BUTTON_DPAD_RIGHT) & 1) << 3;
+
+    // 逻辑按键反查DS4按键编号
+    size_t map_len;
+    const uint8_t *map = hid_report_parser_get_button_map(HID_CONTROLLER_PS4, &map_len);
+    uint32_t raw = 0;
+    for (size_t i = 0; i < map_len && i < 14; i++) {
+        if (map[i] != HID_BUTTON_UNMAPPED && (buttons & (1UL << map[i]))) {
+            raw |= 1UL << i;
+        }
+    }
+
+    memcpy(out, sticks, 4);
+    out[4] = (uint8_t)(hat_values[dpad] | (raw & 0x0F) << 4);
+    out[5] = (uint8_t)(raw >> 4);
+    out[6] = (uint8_t)((raw >> 12) & 0x03) | (uint8_t)(counter << 2);
+    out[7] = triggers[0];
+    out[8] = triggers[1];
+}
+
+/**
+ * @brief 生成合成轨迹：两个手柄交替上报，摇杆正弦扫动，按键按固定脚本触发各默认组合键；
+ *        槽位1在前四分之一之后改发蓝牙报告0x11
+ */
+static int write_synthetic(const char *path, uint32_t count)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        perror(path);
+        return 1;
+    }
+
+    hid_trace_file_header_t header = {
+        .magic = HID_TRACE_MAGIC,
+        .version = HID_TRACE_VERSION,
+        .sequence = 1,
+        .base_time_us = 1000000,
+    };
+    fwrite(&header, sizeof(header), 1, file);
+
+    // 每400条报告（约1.5秒）一轮，依次按下油门切断、模式切换、微调和紧急停止组合
+    static const struct {
+        uint16_t from, to;
+        uint32_t buttons;
+    } script[] = {
+        { 100, 140, GAMEPAD_BUTTON_MASK(GAMEPAD_BUTTON_Y) },
+        { 180, 200, GAMEPAD_BUTTON_MASK(GAMEPAD_BUTTON_SELECT) },
+        { 220, 230, GAMEPAD_BUTTON_MASK(GAMEPAD_BUTTON_DPAD_UP) },
+        { 240, 250, GAMEPAD_BUTTON_MASK(GAMEPAD_BUTTON_DPAD_DOWN) },
+        { 260, 270, GAMEPAD_BUTTON_MASK(GAMEPAD_BUTTON_DPAD_LEFT) },
+        { 280, 290, GAMEPAD_BUTTON_MASK(GAMEPAD_BUTTON_DPAD_RIGHT) },
+        { 320, 340, GAMEPAD_BUTTON_MASK(GAMEPAD_BUTTON_L1) | GAMEPAD_BUTTON_MASK(GAMEPAD_BUTTON_R1) |
+                    GAMEPAD_BUTTON_MASK(GAMEPAD_BUTTON_SELECT) | GAMEPAD_BUTTON_MASK(GAMEPAD_BUTTON_START) },
+    };
+
+    uint32_t rng = 20240601u;
+    uint8_t record[HID_TRACE_RECORD_MAX_BYTES];
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t step = (i / 2) % 400;
+        uint32_t buttons = 0;
+        for (size_t k = 0; k < sizeof(script) / sizeof(script[0]); k++) {
+            if (step >= script[k].from && step < script[k].to) {
+                buttons = script[k].buttons;
+            }
+        }
+
+        rng = rng * 1664525u + 1013904223u;
+        uint8_t phase = (uint8_t)(i / 2);
+        const uint8_t sticks[4] = {
+            (uint8_t)(128 + (int8_t)(phase * 3)), (uint8_t)(255 - phase),
+            (uint8_t)(phase ^ 0x55), (uint8_t)(rng >> 24),
+        };
+        const uint8_t triggers[2] = { (uint8_t)(step < 200 ? step : 0), (uint8_t)(rng >> 16) };
+        uint8_t data[9];
+        encode_ps4_report(buttons, sticks, triggers, phase, data);
+
+        // 蓝牙报告间隔约7.5ms，两个手柄交替，带±2ms抖动
+        uint64_t delta = i == 0 ? 0 : 3750 + (rng >> 8) % 4000 - 2000;
+        size_t len;
+        if ((i & 1) && i >= count / 4) {
+            // DS4收到第一次震动后输入改为报告0x11，之后的报告都带2字节头
+            uint8_t bt[DS4_BT_REPORT_LEN] = { 0xC0, 0x00 };
+            memcpy(&bt[DS4_BT_HEADER_LEN], data, sizeof(data));
+            len = hid_trace_encode_record(record, delta, 1, DS4_BT_REPORT_ID, bt, sizeof(bt));
+        } else {
+            len = hid_trace_encode_record(record, delta, (uint8_t)(i & 1), 0x01, data, sizeof(data));
+        }
+        fwrite(record, 1, len, file);
+    }
+
+    // 末尾留半条记录，模拟断电截断
+    uint8_t data[9] = {0};
+    size_t len = hid_trace_encode_record(record, 3750, 0, 0x01, data, sizeof(data));
+    fwrite(record, 1, len / 2, file);
+
+    int rc = fclose(file) == 0 ? 0 : 1;
+    printf("wrote %u reports to %s\n", count, path);
+    return rc;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [-t generic|ps4|xbox|beitong] [-r repeat] [-e expected] [-a] segment...\n"
+            "       %s -w output [-n reports]\n", prog, prog);
+}
+
+int main(int argc, char **argv)
+{
+    hid_controller_type_t type = HID_CONTROLLER_GENERIC;
+    const char *type_name = "generic";
+    const char *write_path = NULL;
+    long repeat = 1;
+    long expected = -1;
+    long synth_count = 20000;
+    bool require_actions = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:r:e:aw:n:")) != -1) {
+        switch (opt) {
+        case 't': {
+            bool found = false;
+            for (size_t i = 0; i < sizeof(controller_types) / sizeof(controller_types[0]); i++) {
+                if (strcmp(optarg, controller_types[i].name) == 0) {
+                    type = controller_types[i].type;
+                    type_name = controller_types[i].name;
+                    found = true;
+                }
+            }
+            if (!found) {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        }
+        case 'r': repeat = atol(optarg); break;
+        case 'e': expected = atol(optarg); break;
+        case 'a': require_actions = true; break;
+        case 'w': write_path = optarg; break;
+        case 'n': synth_count = atol(optarg); break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (write_path) {
+        return synth_count > 0 ? write_synthetic(write_path, (uint32_t)synth_count) : 2;
+    }
+
+    int segment_count = argc - optind;
+    if (segment_count <= 0 || segment_count > REPLAY_MAX_SEGMENTS || repeat <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    static replay_segment_t segments[REPLAY_MAX_SEGMENTS];
+    for (int i = 0; i < segment_count; i++) {
+        if (!load_segment(argv[optind + i], &segments[i])) {
+            return 1;
+        }
+    }
+    qsort(segments, segment_count, sizeof(segments[0]), compare_segments);
+
+    hid_report_map_t map;
+    if (hid_report_map_compile_builtin(type, &map) != ESP_OK) {
+        fprintf(stderr, "%s: compile failed\n", type_name);
+        return 1;
+    }
+    stick_filter_init();
+    button_combo_init(combo_action_callback);
+    if (button_combo_set_table(gamepad_default_combos, GAMEPAD_DEFAULT_COMBO_COUNT) != ESP_OK) {
+        fprintf(stderr, "combo table rejected\n");
+        return 1;
+    }
+
+    // 第一遍的结果作为基准，后续每遍必须得到相同的摘要
+    replay_stats_t stats, first = {0};
+    uint64_t elapsed = 0;
+    for (long r = 0; r < repeat; r++) {
+        memset(action_counts, 0, sizeof(action_counts));
+        uint64_t start = host_now_ns();
+        replay_all(segments, segment_count, &map, &stats);
+        elapsed += host_now_ns() - start;
+        if (r == 0) {
+            first = stats;
+        }
+        TEST_CHECK(stats.digest == first.digest);
+    }
+
+    double ns = stats.records ? (double)elapsed / (double)(stats.records * repeat) : 0.0;
+    printf("%s: %d segment(s), %llu records x %ld pass(es)\n", type_name, segment_count,
+           (unsigned long long)stats.records, repeat);
+    printf("  extracted %llu, id mismatch %llu, short %llu, bad slot %llu, truncated segments %llu\n",
+           (unsigned long long)stats.extracted, (unsigned long long)stats.not_found,
+           (unsigned long long)stats.too_short, (unsigned long long)stats.bad_slot,
+           (unsigned long long)stats.truncated);
+    printf("  %.1f ns/report, %.0f reports/s\n", ns, ns > 0 ? 1e9 / ns : 0.0);
+    printf("  actions:");
+    for (int a = BUTTON_COMBO_ACTION_NONE + 1; a < BUTTON_COMBO_ACTION_MAX; a++) {
+        printf(" %d:%llu", a, (unsigned long long)action_counts[a]);
+    }
+    printf("\n  digest %016llx\n", (unsigned long long)stats.digest);
+
+    if (expected >= 0) {
+        TEST_CHECK_EQ(stats.extracted, expected);
+    }
+    if (require_actions) {
+        for (size_t i = 0; i < GAMEPAD_DEFAULT_COMBO_COUNT; i++) {
+            if (action_counts[gamepad_default_combos[i].action] == 0) {
+                fprintf(stderr, "combo action %d never fired\n", gamepad_default_combos[i].action);
+                host_test_failures++;
+            }
+        }
+    }
+
+    for (int i = 0; i < segment_count; i++) {
+        free(segments[i].data);
+    }
+    return host_test_finish("hid_replay");
+}
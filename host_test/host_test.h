@@ -0,0 +1,77 @@
+/**
+ * @file host_test.h
+ * @brief 主机端测试和基准的公共工具
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * @brief 失败计数，各测试程序以它作为退出码
+ */
+static int host_test_failures = 0;
+
+#define TEST_CHECK(cond) do {                                               \
+        if (!(cond)) {                                                      \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            host_test_failures++;                                           \
+        }                                                                   \
+    } while (0)
+
+#define TEST_CHECK_EQ(actual, expected) do {                                \
+        long long actual_ = (long long)(actual);                            \
+        long long expected_ = (long long)(expected);                        \
+        if (actual_ != expected_) {                                         \
+            fprintf(stderr, "%s:%d: %s == %lld, expected %lld\n",           \
+                    __FILE__, __LINE__, #actual, actual_, expected_);       \
+            host_test_failures++;                                           \
+        }                                                                   \
+    } while (0)
+
+/**
+ * @brief 单调时钟（纳秒）
+ */
+static inline uint64_t host_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief 周期计数器：x86读TSC，AArch64读通用计时器，其他平台退化为纳秒
+ */
+static inline uint64_t host_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t value;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#else
+    return host_now_ns();
+#endif
+}
+
+/**
+ * @brief 输出测试结论并返回退出码
+ */
+static inline int host_test_finish(const char *name)
+{
+    if (host_test_failures) {
+        printf("%s: %d check(s) FAILED\n", name, host_test_failures);
+        return 1;
+    }
+    printf("%s: all checks passed\n", name);
+    return 0;
+}
+
+#endif // HOST_TEST_H
@@ -0,0 +1,74 @@
+/**
+ * @file stick_reference.h
+ * @brief 摇杆调理的浮点参考实现（直接调用sqrtf/powf/logf）
+ *
+ * 与stick_conditioning.c的查找表语义相同：幅值在[死区, 1]内重新映射到[0, 1]后套曲线。
+ * 单轴按幅值判定死区；双轴用sqrtf求半径判定圆形死区，再把各轴幅值按半径重新映射后套曲线。
+ * 供测试核对精度、供基准对比耗时。
+ */
+
+#ifndef STICK_REFERENCE_H
+#define STICK_REFERENCE_H
+
+#include "stick_conditioning.h"
+#include <math.h>
+
+static inline float reference_curve(stick_curve_t curve, float x)
+{
+    switch (curve) {
+    case STICK_CURVE_EXPONENTIAL:
+        return powf(x, 2.0f);
+    case STICK_CURVE_LOGARITHMIC:
+        return logf(1.0f + 9.0f * x) / logf(10.0f);
+    case STICK_CURVE_LINEAR:
+    default:
+        return x;
+    }
+}
+
+/**
+ * @brief 直接计算单轴调理结果
+ */
+static inline float reference_apply_axis(const stick_conditioning_config_t *config, int16_t value)
+{
+    float deadzone = config->deadzone_percent / 100.0f;
+    float scale = (float)STICK_OUTPUT_MAX * config->max_speed / 255.0f;
+    float magnitude = fminf(fabsf((float)value) / 32767.0f, 1.0f);
+
+    float out = 0.0f;
+    if (magnitude > deadzone) {
+        out = reference_curve(config->curve, (magnitude - deadzone) / (1.0f - deadzone)) * scale;
+    }
+    return value < 0 ? -out : out;
+}
+
+/**
+ * @brief 直接计算双轴调理结果
+ */
+static inline void reference_apply(const stick_conditioning_config_t *config, int16_t x, int16_t y,
+                                   float *out_x, float *out_y)
+{
+    float deadzone = config->deadzone_percent / 100.0f;
+    float scale = (float)STICK_OUTPUT_MAX * config->max_speed / 255.0f;
+    float ax = fabsf((float)x) / 32767.0f;
+    float ay = fabsf((float)y) / 32767.0f;
+    float r = sqrtf(ax * ax + ay * ay);
+
+    *out_x = 0.0f;
+    *out_y = 0.0f;
+    if (r <= deadzone) {
+        return;
+    }
+    float ux = fminf(ax + deadzone * (r - ax) / r, 1.0f);
+    float uy = fminf(ay + deadzone * (r - ay) / r, 1.0f);
+    *out_x = reference_curve(config->curve, (ux - deadzone) / (1.0f - deadzone)) * scale;
+    *out_y = reference_curve(config->curve, (uy - deadzone) / (1.0f - deadzone)) * scale;
+    if (x < 0) {
+        *out_x = -*out_x;
+    }
+    if (y < 0) {
+        *out_y = -*out_y;
+    }
+}
+
+#endif // STICK_REFERENCE_H
@@ -0,0 +1,118 @@
+/**
+ * @file actuator_stubs.c
+ * @brief 执行器替身（主机测试用）：小车/飞机控制只计数并记录输入到"PWM"的延迟，震动全部为空操作
+ *
+ * 与设备上的car_control/plane_control一样，在输出生效处调用system_monitor_record_pwm_update，
+ * 因此主机上得到的延迟分布覆盖解析→映射→执行的完整软件路径。
+ */
+
+#include "actuator_stubs.h"
+#include "car_control.h"
+#include "plane_control.h"
+#include "vibration.h"
+#include "haptic_clip.h"
+#include "system_monitor.h"
+#include <stdatomic.h>
+
+static _Atomic uint32_t car_updates = 0;
+static _Atomic uint32_t plane_updates = 0;
+
+uint32_t actuator_stub_car_updates(void)
+{
+    return atomic_load_explicit(&car_updates, memory_order_relaxed);
+}
+
+uint32_t actuator_stub_plane_updates(void)
+{
+    return atomic_load_explicit(&plane_updates, memory_order_relaxed);
+}
+
+esp_err_t car_control_init(const car_motor_config_t *config)
+{
+    return ESP_OK;
+}
+
+esp_err_t car_control_deinit(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t car_control_set_motion(const car_control_params_t *params)
+{
+    atomic_fetch_add_explicit(&car_updates, 1, memory_order_relaxed);
+    system_monitor_record_pwm_update(params->input_seq, params->input_time_us);
+    return ESP_OK;
+}
+
+esp_err_t car_control_stop(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t plane_control_init(const plane_servo_config_t *config)
+{
+    return ESP_OK;
+}
+
+esp_err_t plane_control_deinit(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t plane_control_set_params(const plane_control_params_t *params)
+{
+    atomic_fetch_add_explicit(&plane_updates, 1, memory_order_relaxed);
+    system_monitor_record_pwm_update(params->input_seq, params->input_time_us);
+    return ESP_OK;
+}
+
+esp_err_t plane_control_set_neutral(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t plane_control_emergency_stop(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t vibration_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t vibration_deinit(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t vibration_start(const vibration_params_t *params)
+{
+    return ESP_OK;
+}
+
+esp_err_t vibration_play(uint8_t source, const vibration_params_t *params, const vibration_mix_t *mix)
+{
+    return ESP_OK;
+}
+
+esp_err_t vibration_play_clip(uint8_t source, const haptic_clip_t *clip, uint8_t intensity,
+                              const vibration_mix_t *mix)
+{
+    return ESP_OK;
+}
+
+esp_err_t vibration_stop(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t haptic_clip_bank_load_partition(const char *label)
+{
+    return ESP_ERR_NOT_FOUND;
+}
+
+const haptic_clip_t *haptic_clip_find(const char *name)
+{
+    return NULL;
+}
@@ -0,0 +1,21 @@
+/**
+ * @file actuator_stubs.h
+ * @brief 执行器替身的计数接口（主机测试用）
+ */
+
+#ifndef HOST_ACTUATOR_STUBS_H
+#define HOST_ACTUATOR_STUBS_H
+
+#include <stdint.h>
+
+/**
+ * @brief car_control_set_motion被调用的次数
+ */
+uint32_t actuator_stub_car_updates(void);
+
+/**
+ * @brief plane_control_set_params被调用的次数
+ */
+uint32_t actuator_stub_plane_updates(void);
+
+#endif // HOST_ACTUATOR_STUBS_H
@@ -0,0 +1,16 @@
+/**
+ * @file esp_heap_caps.h
+ * @brief 主机测试用堆能力接口替身
+ */
+
+#ifndef HOST_ESP_HEAP_CAPS_H
+#define HOST_ESP_HEAP_CAPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_DEFAULT  (1 << 12)
+
+size_t heap_caps_get_total_size(uint32_t caps);
+
+#endif // HOST_ESP_HEAP_CAPS_H
@@ -0,0 +1,28 @@
+/**
+ * @file esp_log.h
+ * @brief 主机测试用esp_log替身：错误和警告输出到stderr，其余级别默认关闭
+ *
+ * 编译时定义HOST_LOG_VERBOSE可打开信息和调试日志。
+ */
+
+#ifndef HOST_ESP_LOG_H
+#define HOST_ESP_LOG_H
+
+#include <stdio.h>
+
+#define HOST_LOG(level, tag, format, ...) \
+    fprintf(stderr, level " (%s) " format "\n", tag, ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, format, ...) HOST_LOG("E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) HOST_LOG("W", tag, format, ##__VA_ARGS__)
+
+#ifdef HOST_LOG_VERBOSE
+#define ESP_LOGI(tag, format, ...) HOST_LOG("I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) HOST_LOG("D", tag, format, ##__VA_ARGS__)
+#else
+#define ESP_LOGI(tag, format, ...) do { if (0) HOST_LOG("I", tag, format, ##__VA_ARGS__); } while (0)
+#define ESP_LOGD(tag, format, ...) do { if (0) HOST_LOG("D", tag, format, ##__VA_ARGS__); } while (0)
+#endif
+#define ESP_LOGV(tag, format, ...) do { if (0) HOST_LOG("V", tag, format, ##__VA_ARGS__); } while (0)
+
+#endif // HOST_ESP_LOG_H
@@ -0,0 +1,9 @@
+/**
+ * @file esp_pm.h
+ * @brief 主机测试用电源管理替身（被测代码只包含，不调用）
+ */
+
+#ifndef HOST_ESP_PM_H
+#define HOST_ESP_PM_H
+
+#endif // HOST_ESP_PM_H
@@ -0,0 +1,267 @@
+/**
+ * @file esp_posix.c
+ * @brief esp_timer、NVS、分区和系统接口的POSIX实现（主机测试用）
+ *
+ * esp_timer回调与设备上一样在单独的定时器任务中依次执行；NVS不保存数据；没有分区表。
+ */
+
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "esp_random.h"
+#include "esp_rom_crc.h"
+#include "esp_partition.h"
+#include "nvs.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+struct host_esp_timer {
+    esp_timer_cb_t callback;
+    void *arg;
+    bool active;
+    uint64_t period_us;          ///< 0表示单次
+    int64_t expiry_us;
+    struct host_esp_timer *next;
+};
+
+static pthread_mutex_t timer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t timer_cond;
+static pthread_once_t timer_once = PTHREAD_ONCE_INIT;
+static struct host_esp_timer *timer_list = NULL;
+static struct host_esp_timer *timer_running = NULL;   ///< 正在执行回调的定时器
+static pthread_t timer_thread_id;
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief 定时器任务：等待最早到期的定时器并在锁外执行回调
+ */
+static void *timer_thread(void *arg)
+{
+    pthread_mutex_lock(&timer_lock);
+    for (;;) {
+        struct host_esp_timer *due = NULL;
+        for (struct host_esp_timer *t = timer_list; t; t = t->next) {
+            if (t->active && (!due || t->expiry_us < due->expiry_us)) {
+                due = t;
+            }
+        }
+
+        if (!due) {
+            pthread_cond_wait(&timer_cond, &timer_lock);
+            continue;
+        }
+        int64_t now = esp_timer_get_time();
+        if (due->expiry_us > now) {
+            struct timespec ts = {
+                .tv_sec = (time_t)(due->expiry_us / 1000000),
+                .tv_nsec = (long)(due->expiry_us % 1000000) * 1000,
+            };
+            pthread_cond_timedwait(&timer_cond, &timer_lock, &ts);
+            continue;
+        }
+
+        if (due->period_us > 0) {
+            due->expiry_us += (int64_t)due->period_us;
+        } else {
+            due->active = false;
+        }
+        timer_running = due;
+        pthread_mutex_unlock(&timer_lock);
+        due->callback(due->arg);
+        pthread_mutex_lock(&timer_lock);
+        timer_running = NULL;
+        pthread_cond_broadcast(&timer_cond);
+    }
+    return NULL;
+}
+
+static void timer_service_init(void)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&timer_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    pthread_create(&timer_thread_id, NULL, timer_thread, NULL);
+    pthread_detach(timer_thread_id);
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out_handle)
+{
+    if (!args || !args->callback || !out_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_once(&timer_once, timer_service_init);
+
+    struct host_esp_timer *timer = calloc(1, sizeof(*timer));
+    if (!timer) {
+        return ESP_ERR_NO_MEM;
+    }
+    timer->callback = args->callback;
+    timer->arg = args->arg;
+
+    pthread_mutex_lock(&timer_lock);
+    timer->next = timer_list;
+    timer_list = timer;
+    pthread_mutex_unlock(&timer_lock);
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+static esp_err_t timer_start(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us)
+{
+    pthread_mutex_lock(&timer_lock);
+    if (timer->active) {
+        pthread_mutex_unlock(&timer_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = true;
+    timer->period_us = period_us;
+    timer->expiry_us = esp_timer_get_time() + (int64_t)timeout_us;
+    pthread_cond_broadcast(&timer_cond);
+    pthread_mutex_unlock(&timer_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return timer_start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    return timer_start(timer, period_us, period_us);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    pthread_mutex_lock(&timer_lock);
+    esp_err_t ret = timer->active ? ESP_OK : ESP_ERR_INVALID_STATE;
+    timer->active = false;
+    pthread_mutex_unlock(&timer_lock);
+    return ret;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    pthread_mutex_lock(&timer_lock);
+    if (timer->active) {
+        pthread_mutex_unlock(&timer_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    // 回调可能正在执行（且可能就是删除自己的调用者），只有别的线程才需要等它结束
+    while (timer_running == timer && !pthread_equal(pthread_self(), timer_thread_id)) {
+        pthread_cond_wait(&timer_cond, &timer_lock);
+    }
+    for (struct host_esp_timer **p = &timer_list; *p; p = &(*p)->next) {
+        if (*p == timer) {
+            *p = timer->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&timer_lock);
+    free(timer);
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    pthread_mutex_lock(&timer_lock);
+    bool active = timer->active;
+    pthread_mutex_unlock(&timer_lock);
+    return active;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *out_handle)
+{
+    *out_handle = 1;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    return ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    return ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    return ESP_OK;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                 const char *label)
+{
+    return NULL;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t *partition, size_t offset, size_t size,
+                             esp_partition_mmap_memory_t memory, const void **out_ptr,
+                             esp_partition_mmap_handle_t *out_handle)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void esp_partition_munmap(esp_partition_mmap_handle_t handle)
+{
+}
+
+uint32_t esp_get_free_heap_size(void)
+{
+    return 256 * 1024;
+}
+
+uint32_t esp_get_minimum_free_heap_size(void)
+{
+    return 256 * 1024;
+}
+
+size_t heap_caps_get_total_size(uint32_t caps)
+{
+    return 320 * 1024;
+}
+
+uint32_t esp_random(void)
+{
+    return (uint32_t)random();
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    // 与ROM实现相同：反射多项式0xEDB88320，输入输出取反
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
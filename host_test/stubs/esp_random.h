@@ -0,0 +1,13 @@
+/**
+ * @file esp_random.h
+ * @brief 主机测试用随机数替身
+ */
+
+#ifndef HOST_ESP_RANDOM_H
+#define HOST_ESP_RANDOM_H
+
+#include <stdint.h>
+
+uint32_t esp_random(void);
+
+#endif // HOST_ESP_RANDOM_H
@@ -0,0 +1,332 @@
+/**
+ * @file freertos_posix.c
+ * @brief FreeRTOS任务、通知、队列和互斥量的POSIX实现（主机测试用）
+ *
+ * 每个任务一个pthread，优先级和栈大小被忽略；节拍由单调时钟换算，1节拍=1ms。
+ * 足以在主机上跑通任务间的通知和队列交互，不模拟抢占式调度的时序。
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct host_task {
+    pthread_t thread;
+    TaskFunction_t function;
+    void *parameter;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify_value;
+    char name[16];
+};
+
+struct host_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    uint8_t *items;
+};
+
+struct host_semaphore {
+    pthread_mutex_t mutex;
+};
+
+static _Thread_local struct host_task *current_task = NULL;
+static _Atomic uint32_t task_count = 0;
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t tick_origin_ns;
+static pthread_once_t tick_origin_once = PTHREAD_ONCE_INIT;
+
+static void init_tick_origin(void)
+{
+    tick_origin_ns = monotonic_ns();
+}
+
+/**
+ * @brief 等待超时的绝对时刻（单调时钟）
+ */
+static struct timespec deadline_after(TickType_t ticks)
+{
+    uint64_t ns = monotonic_ns() + (uint64_t)ticks * (1000000000ull / configTICK_RATE_HZ);
+    struct timespec ts = { .tv_sec = (time_t)(ns / 1000000000ull), .tv_nsec = (long)(ns % 1000000000ull) };
+    return ts;
+}
+
+static void init_cond(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static struct host_task *task_alloc(const char *name)
+{
+    struct host_task *task = calloc(1, sizeof(*task));
+    if (task) {
+        pthread_mutex_init(&task->lock, NULL);
+        init_cond(&task->cond);
+        strncpy(task->name, name ? name : "", sizeof(task->name) - 1);
+    }
+    return task;
+}
+
+static void *task_entry(void *arg)
+{
+    struct host_task *task = arg;
+    current_task = task;
+    task->function(task->parameter);
+    // FreeRTOS任务函数不允许返回，这里与vTaskDelete(NULL)等价
+    atomic_fetch_sub(&task_count, 1);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_depth,
+                       void *parameter, UBaseType_t priority, TaskHandle_t *handle)
+{
+    struct host_task *task = task_alloc(name);
+    if (!task) {
+        return pdFAIL;
+    }
+    task->function = function;
+    task->parameter = parameter;
+    if (handle) {
+        *handle = task;
+    }
+
+    atomic_fetch_add(&task_count, 1);
+    if (pthread_create(&task->thread, NULL, task_entry, task) != 0) {
+        atomic_fetch_sub(&task_count, 1);
+        free(task);
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_depth,
+                                   void *parameter, UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core_id)
+{
+    return xTaskCreate(function, name, stack_depth, parameter, priority, handle);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    // 主线程等非xTaskCreate创建的线程第一次使用通知时补建任务记录
+    if (!current_task) {
+        current_task = task_alloc("main");
+        current_task->thread = pthread_self();
+    }
+    return current_task;
+}
+
+void vTaskDelete(TaskHandle_t handle)
+{
+    if (handle == NULL || handle == current_task) {
+        atomic_fetch_sub(&task_count, 1);
+        pthread_exit(NULL);
+    }
+    atomic_fetch_sub(&task_count, 1);
+    pthread_cancel(handle->thread);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    // 节拍从第一次查询时开始计数，与设备上电后从0开始一致
+    pthread_once(&tick_origin_once, init_tick_origin);
+    return (TickType_t)((monotonic_ns() - tick_origin_ns) / (1000000000ull / configTICK_RATE_HZ));
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    if (ticks == 0) {
+        sched_yield();
+        return;
+    }
+    struct timespec ts = deadline_after(ticks);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+void vTaskDelayUntil(TickType_t *previous_wake, TickType_t increment)
+{
+    *previous_wake += increment;
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(*previous_wake - now) > 0) {
+        vTaskDelay(*previous_wake - now);
+    }
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void)
+{
+    return atomic_load(&task_count);
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t handle)
+{
+    return 4096;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t handle)
+{
+    pthread_mutex_lock(&handle->lock);
+    handle->notify_value++;
+    pthread_cond_signal(&handle->cond);
+    pthread_mutex_unlock(&handle->lock);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    struct host_task *task = xTaskGetCurrentTaskHandle();
+    struct timespec deadline = deadline_after(ticks);
+
+    pthread_mutex_lock(&task->lock);
+    while (task->notify_value == 0 && ticks > 0) {
+        int rc = ticks == portMAX_DELAY ? pthread_cond_wait(&task->cond, &task->lock)
+                                        : pthread_cond_timedwait(&task->cond, &task->lock, &deadline);
+        if (rc == ETIMEDOUT) {
+            break;
+        }
+    }
+    uint32_t value = task->notify_value;
+    if (value > 0) {
+        task->notify_value = clear_on_exit ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&task->lock);
+    return value;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    struct host_queue *queue = calloc(1, sizeof(*queue));
+    if (!queue) {
+        return NULL;
+    }
+    queue->items = calloc(length, item_size);
+    if (!queue->items) {
+        free(queue);
+        return NULL;
+    }
+    queue->length = length;
+    queue->item_size = item_size;
+    pthread_mutex_init(&queue->lock, NULL);
+    init_cond(&queue->not_empty);
+    init_cond(&queue->not_full);
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    if (queue) {
+        free(queue->items);
+        free(queue);
+    }
+}
+
+/**
+ * @brief 在条件变量上等待，ticks为0时不等待
+ * @return false 超时
+ */
+static bool queue_wait(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t ticks,
+                       const struct timespec *deadline)
+{
+    if (ticks == 0) {
+        return false;
+    }
+    if (ticks == portMAX_DELAY) {
+        pthread_cond_wait(cond, lock);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, lock, deadline) != ETIMEDOUT;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+    struct timespec deadline = deadline_after(ticks);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length) {
+        if (!queue_wait(&queue->not_full, &queue->lock, ticks, &deadline)) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFALSE;
+        }
+    }
+    UBaseType_t tail = (queue->head + queue->count) % queue->length;
+    memcpy(&queue->items[tail * queue->item_size], item, queue->item_size);
+    queue->count++;
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+    struct timespec deadline = deadline_after(ticks);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0) {
+        if (!queue_wait(&queue->not_empty, &queue->lock, ticks, &deadline)) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFALSE;
+        }
+    }
+    memcpy(item, &queue->items[queue->head * queue->item_size], queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    pthread_cond_signal(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    struct host_semaphore *semaphore = calloc(1, sizeof(*semaphore));
+    if (semaphore) {
+        pthread_mutex_init(&semaphore->mutex, NULL);
+    }
+    return semaphore;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore)
+{
+    if (semaphore) {
+        pthread_mutex_destroy(&semaphore->mutex);
+        free(semaphore);
+    }
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY) {
+        return pthread_mutex_lock(&semaphore->mutex) == 0 ? pdTRUE : pdFALSE;
+    }
+    if (ticks == 0) {
+        return pthread_mutex_trylock(&semaphore->mutex) == 0 ? pdTRUE : pdFALSE;
+    }
+    struct timespec deadline = deadline_after(ticks);
+    return pthread_mutex_clocklock(&semaphore->mutex, CLOCK_MONOTONIC, &deadline) == 0 ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    return pthread_mutex_unlock(&semaphore->mutex) == 0 ? pdTRUE : pdFALSE;
+}
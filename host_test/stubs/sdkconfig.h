@@ -0,0 +1,11 @@
+/**
+ * @file sdkconfig.h
+ * @brief 主机测试用配置：没有蓝牙协议栈，HID传输使用回环后端
+ */
+
+#ifndef HOST_SDKCONFIG_H
+#define HOST_SDKCONFIG_H
+
+#define CONFIG_BLUETOOTH_HID_TRANSPORT_LOOPBACK  1
+
+#endif // HOST_SDKCONFIG_H
@@ -0,0 +1,213 @@
+/**
+ * @file test_button_combo.c
+ * @brief 组合键引擎测试
+ *
+ * 逐报告送入按键位图，记录回调触发的动作，检查：
+ *   chord     同时按键组合按下即触发一次，按住期间保持有效，松开后可再次触发
+ *   hold      按住时长到达时触发，提前松开取消
+ *   sequence  按步骤和步间超时匹配序列
+ *   exact     exact组合在有其他按键时不匹配
+ *   priority  同一报告中按优先级分发，紧急停止屏蔽更低优先级的动作
+ *   estop     默认组合键表下按任意顺序松开紧急停止组合不会触发模式切换等其他组合
+ */
+
+#include "button_combo.h"
+#include "gamepad_combos.h"
+#include "host_test.h"
+#include <string.h>
+
+#define KEY(b)              GAMEPAD_BUTTON_MASK(GAMEPAD_BUTTON_##b)
+#define MAX_FIRED           64
+
+static button_combo_action_t fired[MAX_FIRED];
+static size_t fired_count = 0;
+
+static void record_action(button_combo_action_t action)
+{
+    if (fired_count < MAX_FIRED) {
+        fired[fired_count++] = action;
+    }
+}
+
+/**
+ * @brief 换一张组合键表，清空记录和所有输入源的状态
+ */
+static void use_table(const button_combo_def_t *defs, size_t count)
+{
+    TEST_CHECK_EQ(button_combo_set_table(defs, count), ESP_OK);
+    for (uint8_t i = 0; i < BUTTON_COMBO_MAX_SOURCES; i++) {
+        button_combo_reset(i);
+    }
+    fired_count = 0;
+}
+
+static void press(uint8_t source, uint32_t buttons, int64_t t_ms)
+{
+    button_combo_process(source, buttons, t_ms * 1000);
+}
+
+static size_t count_action(button_combo_action_t action)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < fired_count; i++) {
+        n += fired[i] == action;
+    }
+    return n;
+}
+
+static void test_chord(void)
+{
+    static const button_combo_def_t defs[] = {
+        { .steps = { KEY(A) | KEY(B) }, .step_count = 1, .action = BUTTON_COMBO_ACTION_TRIM_PITCH_UP },
+    };
+    use_table(defs, 1);
+
+    press(0, KEY(A), 0);
+    TEST_CHECK_EQ(fired_count, 0);
+    press(0, KEY(A) | KEY(B), 10);
+    press(0, KEY(A) | KEY(B) | KEY(X), 20);    // 非exact组合允许多按其他键
+    TEST_CHECK_EQ(fired_count, 1);
+    TEST_CHECK(button_combo_get_active_actions() & BUTTON_COMBO_ACTION_BIT(BUTTON_COMBO_ACTION_TRIM_PITCH_UP));
+
+    press(0, KEY(B), 30);
+    TEST_CHECK_EQ(button_combo_get_active_actions(), 0);
+    press(0, KEY(A) | KEY(B), 40);
+    TEST_CHECK_EQ(fired_count, 2);
+}
+
+static void test_hold(void)
+{
+    static const button_combo_def_t defs[] = {
+        { .steps = { KEY(X) }, .step_count = 1, .hold_ms = 500, .action = BUTTON_COMBO_ACTION_THROTTLE_CUT },
+    };
+    use_table(defs, 1);
+
+    // 提前松开取消计时
+    press(0, KEY(X), 0);
+    press(0, KEY(X), 400);
+    press(0, 0, 450);
+    press(0, KEY(X), 500);
+    press(0, KEY(X), 999);
+    TEST_CHECK_EQ(fired_count, 0);
+
+    // 从500ms按下，1000ms时到达
+    press(0, KEY(X), 1000);
+    TEST_CHECK_EQ(fired_count, 1);
+    press(0, KEY(X), 2000);
+    TEST_CHECK_EQ(fired_count, 1);
+    TEST_CHECK(button_combo_get_active_actions() & BUTTON_COMBO_ACTION_BIT(BUTTON_COMBO_ACTION_THROTTLE_CUT));
+}
+
+static void test_sequence(void)
+{
+    static const button_combo_def_t defs[] = {
+        { .steps = { KEY(DPAD_UP), KEY(DPAD_DOWN), KEY(DPAD_UP) }, .step_count = 3, .step_timeout_ms = 300,
+          .action = BUTTON_COMBO_ACTION_TRIM_ROLL_LEFT },
+    };
+    use_table(defs, 1);
+
+    static const uint32_t steps[] = { KEY(DPAD_UP), 0, KEY(DPAD_DOWN), 0, KEY(DPAD_UP), 0 };
+    for (size_t i = 0; i < 6; i++) {
+        press(0, steps[i], (int64_t)i * 100);
+    }
+    TEST_CHECK_EQ(count_action(BUTTON_COMBO_ACTION_TRIM_ROLL_LEFT), 1);
+
+    // 第二步之后停顿超过步间超时，序列回到第一步
+    fired_count = 0;
+    press(0, KEY(DPAD_UP), 1000);
+    press(0, 0, 1050);
+    press(0, KEY(DPAD_DOWN), 1100);
+    press(0, 0, 1150);
+    press(0, KEY(DPAD_UP), 1500);
+    TEST_CHECK_EQ(fired_count, 0);
+}
+
+static void test_exact(void)
+{
+    static const button_combo_def_t defs[] = {
+        { .steps = { KEY(SELECT) }, .step_count = 1, .exact = true, .action = BUTTON_COMBO_ACTION_MODE_NEXT },
+    };
+    use_table(defs, 1);
+
+    press(0, KEY(SELECT) | KEY(A), 0);
+    TEST_CHECK_EQ(fired_count, 0);
+    press(0, KEY(SELECT), 10);
+    TEST_CHECK_EQ(fired_count, 1);
+}
+
+static void test_priority(void)
+{
+    static const button_combo_def_t defs[] = {
+        { .steps = { KEY(L1) }, .step_count = 1, .priority = 10, .action = BUTTON_COMBO_ACTION_TRIM_PITCH_DOWN },
+        { .steps = { KEY(L1) | KEY(R1) }, .step_count = 1, .priority = 255, .action = BUTTON_COMBO_ACTION_ESTOP },
+        { .steps = { KEY(A) }, .step_count = 1, .priority = 20, .action = BUTTON_COMBO_ACTION_TRIM_ROLL_RIGHT },
+        { .steps = { KEY(A) | KEY(B) }, .step_count = 1, .priority = 30, .action = BUTTON_COMBO_ACTION_TRIM_PITCH_UP },
+    };
+    use_table(defs, 4);
+
+    // 同一报告中按优先级从高到低分发
+    press(0, KEY(A) | KEY(B), 0);
+    TEST_CHECK_EQ(fired_count, 2);
+    TEST_CHECK_EQ(fired[0], BUTTON_COMBO_ACTION_TRIM_PITCH_UP);
+    TEST_CHECK_EQ(fired[1], BUTTON_COMBO_ACTION_TRIM_ROLL_RIGHT);
+
+    // 紧急停止屏蔽同一报告中的低优先级组合
+    fired_count = 0;
+    press(1, KEY(L1) | KEY(R1), 0);
+    TEST_CHECK_EQ(fired_count, 1);
+    TEST_CHECK_EQ(fired[0], BUTTON_COMBO_ACTION_ESTOP);
+}
+
+static void test_estop_release_order(void)
+{
+    use_table(gamepad_default_combos, GAMEPAD_DEFAULT_COMBO_COUNT);
+
+    // 按下紧急停止组合，再以SELECT最后松开：途经的单独SELECT正好是模式切换组合
+    static const uint32_t sequence[] = {
+        KEY(L1) | KEY(R1) | KEY(SELECT),
+        KEY(L1) | KEY(R1) | KEY(SELECT) | KEY(START),
+        KEY(R1) | KEY(SELECT) | KEY(START),
+        KEY(SELECT) | KEY(START),
+        KEY(SELECT),
+        KEY(SELECT) | KEY(DPAD_UP),
+        KEY(DPAD_UP),
+        0,
+    };
+    for (size_t i = 0; i < sizeof(sequence) / sizeof(sequence[0]); i++) {
+        press(0, sequence[i], (int64_t)i * 10);
+    }
+    TEST_CHECK_EQ(fired_count, 1);
+    TEST_CHECK_EQ(count_action(BUTTON_COMBO_ACTION_ESTOP), 1);
+    TEST_CHECK_EQ(count_action(BUTTON_COMBO_ACTION_MODE_NEXT), 0);
+
+    // 其他输入源不受影响
+    press(1, KEY(SELECT), 100);
+    TEST_CHECK_EQ(count_action(BUTTON_COMBO_ACTION_MODE_NEXT), 1);
+
+    // 全部松开后恢复
+    press(0, KEY(SELECT), 200);
+    TEST_CHECK_EQ(count_action(BUTTON_COMBO_ACTION_MODE_NEXT), 2);
+
+    // 紧急停止期间再次按全组合仍然触发
+    fired_count = 0;
+    press(0, KEY(L1) | KEY(R1) | KEY(SELECT) | KEY(START), 300);
+    press(0, KEY(L1) | KEY(R1) | KEY(SELECT), 310);
+    press(0, KEY(L1) | KEY(R1) | KEY(SELECT) | KEY(START), 320);
+    press(0, KEY(Y), 330);
+    TEST_CHECK_EQ(count_action(BUTTON_COMBO_ACTION_ESTOP), 2);
+    TEST_CHECK_EQ(count_action(BUTTON_COMBO_ACTION_THROTTLE_CUT), 0);
+}
+
+int main(void)
+{
+    TEST_CHECK_EQ(button_combo_init(record_action), ESP_OK);
+
+    test_chord();
+    test_hold();
+    test_sequence();
+    test_exact();
+    test_priority();
+    test_estop_release_order();
+
+    return host_test_finish("button_combo");
+}
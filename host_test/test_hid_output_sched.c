@@ -0,0 +1,349 @@
+/**
+ * @file test_hid_output_sched.c
+ * @brief 输出报告调度器测试
+ *
+ * 链接真实的hid_output_sched.c，任务和时钟由测试实现：调度任务运行在自己的线程上，
+ * 但每次ulTaskNotifyTake都停下，直到测试调用run_pass()才执行下一轮，并记录它请求的等待节拍；
+ * esp_timer_get_time返回测试推进的虚拟时钟。这样每一轮发送什么、额度何时够用都是确定的。检查：
+ *   coalesce  未发出的报告被后来的覆盖（最新的生效），又变回已发出内容时整体撤销
+ *   dedup     与上次发出内容相同的报告不再发送
+ *   pacing    额度按窗口补充，额度不足时等待到够用为止，预算可调
+ *   retry     发送失败的报告重新挂起并按预算重发；发送期间已有更新的报告时发更新的
+ *   budget    每个报告的额度不足1us的预算被拒绝
+ */
+
+#include "hid_output_sched.h"
+#include "bluetooth_hid.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_test.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_SENDS           64
+#define START_US            1000000
+#define WINDOW_MS           10         // 主机上没有sdkconfig，与hid_output_sched.c的默认预算相同
+#define WINDOW_US           (WINDOW_MS * 1000)
+#define BUDGET              1
+#define RUMBLE_ID           0x05
+#define LED_ID              0x11
+#define SLOT                0
+
+// ---- 由测试逐轮驱动的任务 ----
+
+struct host_task {
+    pthread_t thread;
+    TaskFunction_t function;
+    void *parameter;
+};
+
+static pthread_mutex_t task_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t task_cond = PTHREAD_COND_INITIALIZER;
+static bool task_idle = false;         ///< 调度任务停在ulTaskNotifyTake中
+static bool task_go = false;           ///< 允许调度任务再执行一轮
+static TickType_t task_wait = 0;       ///< 调度任务上一轮请求的等待节拍
+static int64_t virtual_now_us = START_US;
+
+int64_t esp_timer_get_time(void)
+{
+    return virtual_now_us;
+}
+
+static void *task_entry(void *arg)
+{
+    struct host_task *task = arg;
+    task->function(task->parameter);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_depth,
+                       void *parameter, UBaseType_t priority, TaskHandle_t *handle)
+{
+    struct host_task *task = calloc(1, sizeof(*task));
+    if (!task) {
+        return pdFAIL;
+    }
+    task->function = function;
+    task->parameter = parameter;
+    if (handle) {
+        *handle = task;
+    }
+    if (pthread_create(&task->thread, NULL, task_entry, task) != 0) {
+        free(task);
+        return pdFAIL;
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t handle)
+{
+    pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    sched_yield();
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t handle)
+{
+    // 唤醒由run_pass()控制
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    pthread_mutex_lock(&task_mutex);
+    task_wait = ticks;
+    task_idle = true;
+    pthread_cond_broadcast(&task_cond);
+    while (!task_go) {
+        pthread_cond_wait(&task_cond, &task_mutex);
+    }
+    task_go = false;
+    task_idle = false;
+    pthread_mutex_unlock(&task_mutex);
+    return 1;
+}
+
+static void wait_idle(void)
+{
+    pthread_mutex_lock(&task_mutex);
+    while (!task_idle || task_go) {
+        pthread_cond_wait(&task_cond, &task_mutex);
+    }
+    pthread_mutex_unlock(&task_mutex);
+}
+
+/**
+ * @brief 让调度任务执行一轮，返回它接下来请求的等待节拍
+ */
+static TickType_t run_pass(void)
+{
+    pthread_mutex_lock(&task_mutex);
+    task_go = true;
+    pthread_cond_broadcast(&task_cond);
+    pthread_mutex_unlock(&task_mutex);
+    wait_idle();
+    return task_wait;
+}
+
+// ---- 发送替身 ----
+
+typedef struct {
+    uint8_t slot;
+    uint8_t report_id;
+    uint8_t data[HID_OUTPUT_MAX_LEN];
+    uint16_t len;
+    int64_t t_us;
+} sent_report_t;
+
+static sent_report_t sends[MAX_SENDS];
+static size_t send_count = 0;
+static esp_err_t send_result = ESP_OK;
+static const uint8_t *submit_during_send = NULL;    ///< 非NULL时在发送过程中提交这份rumble报告
+
+static esp_err_t record_send(uint8_t slot, uint8_t report_id, uint8_t *data, uint16_t len)
+{
+    if (send_count < MAX_SENDS) {
+        sent_report_t *s = &sends[send_count++];
+        s->slot = slot;
+        s->report_id = report_id;
+        s->len = len;
+        s->t_us = virtual_now_us;
+        memcpy(s->data, data, len);
+    }
+    if (submit_during_send) {
+        const uint8_t *data_now = submit_during_send;
+        submit_during_send = NULL;
+        TEST_CHECK_EQ(hid_output_sched_submit(slot, RUMBLE_ID, data_now, 2), ESP_OK);
+    }
+    return send_result;
+}
+
+static void check_send(size_t index, uint8_t report_id, uint8_t left, uint8_t right)
+{
+    if (index >= send_count) {
+        fprintf(stderr, "missing send #%zu\n", index);
+        host_test_failures++;
+        return;
+    }
+    TEST_CHECK_EQ(sends[index].report_id, report_id);
+    TEST_CHECK_EQ(sends[index].len, 2);
+    TEST_CHECK_EQ(sends[index].data[0], left);
+    TEST_CHECK_EQ(sends[index].data[1], right);
+}
+
+static void submit(uint8_t report_id, uint8_t left, uint8_t right)
+{
+    uint8_t data[2] = { left, right };
+    TEST_CHECK_EQ(hid_output_sched_submit(SLOT, report_id, data, sizeof(data)), ESP_OK);
+}
+
+/**
+ * @brief 清空槽位（额度补满）和发送记录，时钟从新的整秒开始
+ */
+static void reset_case(void)
+{
+    virtual_now_us = (virtual_now_us / 1000000 + 1) * 1000000;
+    hid_output_sched_reset_slot(SLOT);
+    send_count = 0;
+    send_result = ESP_OK;
+}
+
+static hid_output_stats_t stats_delta(const hid_output_stats_t *before)
+{
+    hid_output_stats_t now;
+    TEST_CHECK_EQ(hid_output_sched_get_stats(&now), ESP_OK);
+    now.submitted -= before->submitted;
+    now.coalesced -= before->coalesced;
+    now.suppressed -= before->suppressed;
+    now.sent -= before->sent;
+    now.failed -= before->failed;
+    return now;
+}
+
+static void test_coalesce_and_dedup(void)
+{
+    reset_case();
+    hid_output_stats_t before;
+    hid_output_sched_get_stats(&before);
+
+    // 调度任务没来得及发送前连续提交，只发最后一份
+    submit(RUMBLE_ID, 10, 10);
+    submit(RUMBLE_ID, 20, 20);
+    submit(RUMBLE_ID, 30, 30);
+    run_pass();
+    TEST_CHECK_EQ(send_count, 1);
+    check_send(0, RUMBLE_ID, 30, 30);
+
+    // 与已发出内容相同，不再发送
+    submit(RUMBLE_ID, 30, 30);
+    virtual_now_us += WINDOW_US;
+    run_pass();
+    TEST_CHECK_EQ(send_count, 1);
+
+    // 改成别的又改回已发出的内容：挂起的报告撤销
+    submit(RUMBLE_ID, 40, 40);
+    submit(RUMBLE_ID, 30, 30);
+    run_pass();
+    TEST_CHECK_EQ(send_count, 1);
+
+    hid_output_stats_t d = stats_delta(&before);
+    TEST_CHECK_EQ(d.submitted, 6);
+    TEST_CHECK_EQ(d.coalesced, 3);
+    TEST_CHECK_EQ(d.suppressed, 1);
+    TEST_CHECK_EQ(d.sent, 1);
+}
+
+static void test_pacing(void)
+{
+    reset_case();
+    int64_t base = virtual_now_us;
+
+    // 额度用完后，等待节拍等于缺少的额度
+    submit(RUMBLE_ID, 1, 1);
+    run_pass();
+    submit(RUMBLE_ID, 2, 2);
+    TEST_CHECK_EQ(run_pass(), pdMS_TO_TICKS(WINDOW_MS));
+    TEST_CHECK_EQ(send_count, 1);
+
+    virtual_now_us = base + WINDOW_US / 2;
+    TEST_CHECK_EQ(run_pass(), pdMS_TO_TICKS(WINDOW_MS / 2));
+    TEST_CHECK_EQ(send_count, 1);
+
+    virtual_now_us = base + WINDOW_US;
+    TEST_CHECK_EQ(run_pass(), portMAX_DELAY);
+    TEST_CHECK_EQ(send_count, 2);
+    check_send(1, RUMBLE_ID, 2, 2);
+    TEST_CHECK_EQ(sends[1].t_us - sends[0].t_us, WINDOW_US);
+
+    // 每窗口2个：空闲一个窗口后两个报告ID在同一轮发出，第三个等半个窗口
+    TEST_CHECK_EQ(hid_output_sched_set_budget(2, WINDOW_US), ESP_OK);
+    virtual_now_us += WINDOW_US;
+    submit(RUMBLE_ID, 3, 3);
+    submit(LED_ID, 3, 3);
+    run_pass();
+    TEST_CHECK_EQ(send_count, 4);
+    submit(RUMBLE_ID, 4, 4);
+    TEST_CHECK_EQ(run_pass(), pdMS_TO_TICKS(WINDOW_MS / 2));
+    TEST_CHECK_EQ(send_count, 4);
+    virtual_now_us += WINDOW_US / 2;
+    run_pass();
+    TEST_CHECK_EQ(send_count, 5);
+    check_send(4, RUMBLE_ID, 4, 4);
+
+    TEST_CHECK_EQ(hid_output_sched_set_budget(BUDGET, WINDOW_US), ESP_OK);
+}
+
+static void test_retry(void)
+{
+    reset_case();
+    hid_output_stats_t before;
+    hid_output_sched_get_stats(&before);
+
+    // 震动关闭报告发送失败：下一个窗口重发，不能因为记为已发出而丢失
+    submit(RUMBLE_ID, 200, 200);
+    run_pass();
+    send_result = ESP_FAIL;
+    virtual_now_us += WINDOW_US;
+    submit(RUMBLE_ID, 0, 0);
+    run_pass();
+    TEST_CHECK_EQ(send_count, 2);
+
+    send_result = ESP_OK;
+    virtual_now_us += WINDOW_US;
+    run_pass();
+    TEST_CHECK_EQ(send_count, 3);
+    check_send(2, RUMBLE_ID, 0, 0);
+
+    // 成功后恢复去重
+    submit(RUMBLE_ID, 0, 0);
+    virtual_now_us += WINDOW_US;
+    run_pass();
+    TEST_CHECK_EQ(send_count, 3);
+
+    // 失败的发送进行中提交了新报告：重发新的，不回退到失败的那份
+    static const uint8_t newer[2] = { 90, 90 };
+    send_result = ESP_FAIL;
+    submit_during_send = newer;
+    submit(RUMBLE_ID, 50, 50);
+    run_pass();
+    TEST_CHECK_EQ(send_count, 4);
+    send_result = ESP_OK;
+    virtual_now_us += WINDOW_US;
+    run_pass();
+    TEST_CHECK_EQ(send_count, 5);
+    check_send(4, RUMBLE_ID, 90, 90);
+    virtual_now_us += WINDOW_US;
+    run_pass();
+    TEST_CHECK_EQ(send_count, 5);
+
+    hid_output_stats_t d = stats_delta(&before);
+    TEST_CHECK_EQ(d.failed, 2);
+    TEST_CHECK_EQ(d.sent, 3);
+}
+
+static void test_budget_limits(void)
+{
+    TEST_CHECK_EQ(hid_output_sched_set_budget(0, WINDOW_US), ESP_ERR_INVALID_ARG);
+    TEST_CHECK_EQ(hid_output_sched_set_budget(16, 15), ESP_ERR_INVALID_ARG);
+    TEST_CHECK_EQ(hid_output_sched_set_budget(16, 16), ESP_OK);
+    TEST_CHECK_EQ(hid_output_sched_set_budget(BUDGET, WINDOW_US), ESP_OK);
+}
+
+int main(void)
+{
+    TEST_CHECK_EQ(hid_output_sched_init(record_send), ESP_OK);
+    wait_idle();
+
+    test_coalesce_and_dedup();
+    test_pacing();
+    test_retry();
+    test_budget_limits();
+
+    // 调度任务停在ulTaskNotifyTake中，随进程退出
+    return host_test_finish("hid_output_sched");
+}
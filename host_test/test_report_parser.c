@@ -0,0 +1,227 @@
+/**
+ * @file test_report_parser.c
+ * @brief 报告描述符解析器的黄金值测试
+ *
+ * 对每个内置描述符（通用、DS4、Xbox、北通）编译提取表，送入手工构造的报告，
+ * 逐项核对按键位图、摇杆和扳机的提取结果；DS4另测蓝牙扩展报告0x11（完整布局前多2字节）。
+ */
+
+#include "hid_report_parser.h"
+#include "host_test.h"
+#include <string.h>
+
+#define BIT(name) (1u << HID_GAMEPAD_BUTTON_##name)
+
+typedef struct {
+    const char *name;
+    hid_controller_type_t type;
+    uint8_t report_id;
+    uint8_t data[16];
+    uint16_t len;
+    uint32_t buttons;
+    int16_t axes[HID_GAMEPAD_AXIS_MAX];
+    uint8_t triggers[HID_GAMEPAD_TRIGGER_MAX];
+} golden_case_t;
+
+static const golden_case_t golden_cases[] = {
+    {
+        // 按键1和7；X满、Y零、Z中、Rz四分之一；扳机16和255
+        .name = "generic",
+        .type = HID_CONTROLLER_GENERIC,
+        .report_id = 0,
+        .data = { 0x41, 0x00, 0xFF, 0x00, 0x80, 0x40, 0x10, 0xFF },
+        .len = 8,
+        .buttons = BIT(A) | BIT(SELECT),
+        .axes = { 32767, -32768, 128, -16320 },
+        .triggers = { 16, 255 },
+    },
+    {
+        // 方向键帽2（右）+叉；L1+Options；PS键，计数器0x15；L2=64、R2=255
+        .name = "ps4",
+        .type = HID_CONTROLLER_PS4,
+        .report_id = 0x01,
+        .data = { 0x80, 0x80, 0x00, 0xFF, 0x22, 0x21, 0x55, 0x40, 0xFF },
+        .len = 9,
+        .buttons = BIT(A) | BIT(L1) | BIT(START) | BIT(HOME) | BIT(DPAD_RIGHT),
+        .axes = { 128, 128, -32768, 32767 },
+        .triggers = { 64, 255 },
+    },
+    {
+        // 方向键帽8（中立），无按键
+        .name = "ps4 neutral hat",
+        .type = HID_CONTROLLER_PS4,
+        .report_id = 0x01,
+        .data = { 0x00, 0xFF, 0x80, 0x80, 0x08, 0x00, 0x00, 0x00, 0x00 },
+        .len = 9,
+        .buttons = 0,
+        .axes = { -32768, 32767, 128, 128 },
+        .triggers = { 0, 0 },
+    },
+    {
+        // 与"ps4"相同的输入，放在蓝牙报告0x11的2字节头（0xC0 0x00）之后
+        .name = "ps4 bt 0x11",
+        .type = HID_CONTROLLER_PS4,
+        .report_id = 0x11,
+        .data = { 0xC0, 0x00, 0x80, 0x80, 0x00, 0xFF, 0x22, 0x21, 0x55, 0x40, 0xFF },
+        .len = 11,
+        .buttons = BIT(A) | BIT(L1) | BIT(START) | BIT(HOME) | BIT(DPAD_RIGHT),
+        .axes = { 128, 128, -32768, 32767 },
+        .triggers = { 64, 255 },
+    },
+    {
+        // 16位摇杆；刹车1023、油门512；方向键帽1（上）；A、Y、Menu、Xbox
+        .name = "xbox",
+        .type = HID_CONTROLLER_XBOX,
+        .report_id = 0x01,
+        .data = { 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x80, 0x34, 0x12,
+                  0xFF, 0x03, 0x00, 0x02, 0x01, 0x11, 0x18 },
+        .len = 15,
+        .buttons = BIT(A) | BIT(Y) | BIT(START) | BIT(HOME) | BIT(DPAD_UP),
+        .axes = { -32768, 32767, 0, -28108 },
+        .triggers = { 255, 128 },
+    },
+    {
+        // 方向键帽0为中立（逻辑范围1-8），保留按键3不映射
+        .name = "xbox neutral hat",
+        .type = HID_CONTROLLER_XBOX,
+        .report_id = 0x01,
+        .data = { 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80,
+                  0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00 },
+        .len = 15,
+        .buttons = 0,
+        .axes = { 0, 0, 0, 0 },
+        .triggers = { 0, 0 },
+    },
+    {
+        // 方向键帽6（左）+按键2；按键7和9；刹车16、油门255
+        .name = "beitong",
+        .type = HID_CONTROLLER_BEITONG,
+        .report_id = 0,
+        .data = { 0x00, 0x80, 0xFF, 0x40, 0x26, 0x14, 0x10, 0xFF },
+        .len = 8,
+        .buttons = BIT(B) | BIT(L2) | BIT(SELECT) | BIT(DPAD_LEFT),
+        .axes = { -32768, 128, 32767, -16320 },
+        .triggers = { 16, 255 },
+    },
+};
+
+static void check_golden(const golden_case_t *tc)
+{
+    hid_report_map_t map;
+    TEST_CHECK_EQ(hid_report_map_compile_builtin(tc->type, &map), ESP_OK);
+
+    hid_gamepad_report_t report;
+    esp_err_t ret = hid_report_map_extract(&map, tc->report_id, tc->data, tc->len, &report);
+    if (ret != ESP_OK) {
+        fprintf(stderr, "%s: extract failed: %s\n", tc->name, esp_err_to_name(ret));
+        host_test_failures++;
+        return;
+    }
+
+    int before = host_test_failures;
+    TEST_CHECK_EQ(report.buttons, tc->buttons);
+    for (int i = 0; i < HID_GAMEPAD_AXIS_MAX; i++) {
+        TEST_CHECK_EQ(report.axes[i], tc->axes[i]);
+    }
+    for (int i = 0; i < HID_GAMEPAD_TRIGGER_MAX; i++) {
+        TEST_CHECK_EQ(report.triggers[i], tc->triggers[i]);
+    }
+    if (host_test_failures != before) {
+        fprintf(stderr, "  in case \"%s\"\n", tc->name);
+    }
+}
+
+static void check_layouts(void)
+{
+    static const struct {
+        hid_controller_type_t type;
+        uint8_t report_id;
+        uint16_t report_bytes;
+        uint8_t ext_report_id;
+        uint8_t ext_header_bytes;
+    } layouts[] = {
+        { HID_CONTROLLER_GENERIC, 0,    8,  0,    0 },
+        { HID_CONTROLLER_PS4,     0x01, 9,  0x11, 2 },
+        { HID_CONTROLLER_XBOX,    0x01, 15, 0,    0 },
+        { HID_CONTROLLER_BEITONG, 0,    8,  0,    0 },
+    };
+
+    for (size_t i = 0; i < sizeof(layouts) / sizeof(layouts[0]); i++) {
+        hid_report_map_t map;
+        TEST_CHECK_EQ(hid_report_map_compile_builtin(layouts[i].type, &map), ESP_OK);
+        TEST_CHECK_EQ(map.report_id, layouts[i].report_id);
+        TEST_CHECK_EQ(map.report_bytes, layouts[i].report_bytes);
+        TEST_CHECK_EQ(map.ext_report_id, layouts[i].ext_report_id);
+        TEST_CHECK_EQ(map.ext_header_bytes, layouts[i].ext_header_bytes);
+    }
+}
+
+/**
+ * @brief 设备描述符编译的提取表按型号补上扩展报告，报告ID不是基础报告时不补
+ */
+static void check_apply_profile(void)
+{
+    const uint8_t *desc;
+    size_t desc_len;
+    hid_report_map_t map;
+
+    TEST_CHECK_EQ(hid_report_parser_get_builtin(HID_CONTROLLER_PS4, &desc, &desc_len), ESP_OK);
+    TEST_CHECK_EQ(hid_report_map_compile(desc, desc_len, NULL, 0, &map), ESP_OK);
+    TEST_CHECK_EQ(map.ext_report_id, 0);
+    hid_report_map_apply_profile(HID_CONTROLLER_PS4, &map);
+    TEST_CHECK_EQ(map.ext_report_id, 0x11);
+    TEST_CHECK_EQ(map.ext_header_bytes, 2);
+
+    // 识别为PS4但描述符不用报告ID（兼容手柄）
+    TEST_CHECK_EQ(hid_report_parser_get_builtin(HID_CONTROLLER_GENERIC, &desc, &desc_len), ESP_OK);
+    TEST_CHECK_EQ(hid_report_map_compile(desc, desc_len, NULL, 0, &map), ESP_OK);
+    hid_report_map_apply_profile(HID_CONTROLLER_PS4, &map);
+    TEST_CHECK_EQ(map.ext_report_id, 0);
+}
+
+static void check_rejects(void)
+{
+    hid_report_map_t map;
+    hid_gamepad_report_t report;
+    const uint8_t data[16] = {0};
+
+    TEST_CHECK_EQ(hid_report_map_compile_builtin(HID_CONTROLLER_PS4, &map), ESP_OK);
+    TEST_CHECK_EQ(hid_report_map_extract(&map, 0x05, data, 9, &report), ESP_ERR_NOT_FOUND);
+    TEST_CHECK_EQ(hid_report_map_extract(&map, 0x01, data, 8, &report), ESP_ERR_INVALID_SIZE);
+    TEST_CHECK_EQ(hid_report_map_extract(&map, 0x11, data, 10, &report), ESP_ERR_INVALID_SIZE);
+    TEST_CHECK_EQ(hid_report_map_extract(&map, 0x11, data, 1, &report), ESP_ERR_INVALID_SIZE);
+
+    // 没有扩展报告的型号不接受0x11
+    TEST_CHECK_EQ(hid_report_map_compile_builtin(HID_CONTROLLER_XBOX, &map), ESP_OK);
+    TEST_CHECK_EQ(hid_report_map_extract(&map, 0x11, data, 16, &report), ESP_ERR_NOT_FOUND);
+
+    TEST_CHECK_EQ(hid_report_map_compile_builtin(HID_CONTROLLER_TYPE_MAX, &map), ESP_ERR_INVALID_ARG);
+
+    // 只有厂商自定义字段的描述符
+    static const uint8_t vendor_only[] = {
+        0x06, 0x00, 0xFF, 0x09, 0x01, 0xA1, 0x01,
+        0x15, 0x00, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x95, 0x08, 0x81, 0x02,
+        0xC0
+    };
+    TEST_CHECK_EQ(hid_report_map_compile(vendor_only, sizeof(vendor_only), NULL, 0, &map), ESP_ERR_NOT_FOUND);
+}
+
+static void check_detect(void)
+{
+    TEST_CHECK_EQ(hid_report_parser_detect_type(0x054C, 0x09CC, NULL), HID_CONTROLLER_PS4);
+    TEST_CHECK_EQ(hid_report_parser_detect_type(0x045E, 0x0B13, NULL), HID_CONTROLLER_XBOX);
+    TEST_CHECK_EQ(hid_report_parser_detect_type(0, 0, "Wireless Controller"), HID_CONTROLLER_PS4);
+    TEST_CHECK_EQ(hid_report_parser_detect_type(0, 0, "Unknown Pad"), HID_CONTROLLER_GENERIC);
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < sizeof(golden_cases) / sizeof(golden_cases[0]); i++) {
+        check_golden(&golden_cases[i]);
+    }
+    check_layouts();
+    check_apply_profile();
+    check_rejects();
+    check_detect();
+    return host_test_finish("report_parser");
+}
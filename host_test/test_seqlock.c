@@ -0,0 +1,152 @@
+/**
+ * @file test_seqlock.c
+ * @brief 状态序列锁压力测试
+ *
+ * 一个写者不停改写快照（每次写入把所有字写成同一个序号），N个读者不停读取，
+ * 读到的字不全相同即为撕裂读。输出撕裂读次数（必须为0）和读取延迟的p50/p99/最大值。
+ *
+ * 用法：test_seqlock [读者数] [持续毫秒]
+ */
+
+#define _GNU_SOURCE
+#include "state_seqlock.h"
+#include "host_test.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define MAX_READERS     16
+#define PAYLOAD_WORDS   48      // 与gamepad_snapshot_t同量级（约200字节）
+#define LATENCY_SAMPLES (1u << 20)
+
+typedef struct {
+    uint32_t words[PAYLOAD_WORDS];
+} payload_t;
+
+typedef struct {
+    pthread_t thread;
+    uint64_t reads;
+    uint64_t torn;
+    uint32_t *latency_ns;
+    uint32_t latency_count;
+} reader_t;
+
+static state_seqlock_t lock = STATE_SEQLOCK_INITIALIZER;
+static payload_t shared;
+static atomic_bool running = true;
+static uint64_t writes = 0;
+
+static void *writer_main(void *arg)
+{
+    (void)arg;
+    uint32_t value = 0;
+    while (atomic_load_explicit(&running, memory_order_relaxed)) {
+        value++;
+        state_seqlock_write_begin(&lock);
+        for (int i = 0; i < PAYLOAD_WORDS; i++) {
+            ((volatile uint32_t *)shared.words)[i] = value;
+        }
+        state_seqlock_write_end(&lock);
+        writes++;
+    }
+    return NULL;
+}
+
+static void *reader_main(void *arg)
+{
+    reader_t *reader = arg;
+    payload_t copy;
+    while (atomic_load_explicit(&running, memory_order_relaxed)) {
+        uint64_t start = host_now_ns();
+        state_seqlock_read(&lock, &copy, &shared, sizeof(copy));
+        uint64_t elapsed = host_now_ns() - start;
+
+        for (int i = 1; i < PAYLOAD_WORDS; i++) {
+            if (copy.words[i] != copy.words[0]) {
+                reader->torn++;
+                break;
+            }
+        }
+        // 延迟样本写满后循环覆盖，保留最近的分布
+        reader->latency_ns[reader->latency_count++ % LATENCY_SAMPLES] =
+            elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed;
+        reader->reads++;
+    }
+    return NULL;
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv)
+{
+    int reader_count = argc > 1 ? atoi(argv[1]) : 4;
+    int duration_ms = argc > 2 ? atoi(argv[2]) : 1000;
+    if (reader_count < 1 || reader_count > MAX_READERS || duration_ms <= 0) {
+        fprintf(stderr, "usage: %s [readers 1-%d] [duration_ms]\n", argv[0], MAX_READERS);
+        return 2;
+    }
+
+    static reader_t readers[MAX_READERS];
+    for (int i = 0; i < reader_count; i++) {
+        readers[i].latency_ns = malloc(LATENCY_SAMPLES * sizeof(uint32_t));
+        if (!readers[i].latency_ns) {
+            return 2;
+        }
+        pthread_create(&readers[i].thread, NULL, reader_main, &readers[i]);
+    }
+    pthread_t writer;
+    pthread_create(&writer, NULL, writer_main, NULL);
+
+    struct timespec duration = { duration_ms / 1000, (long)(duration_ms % 1000) * 1000000L };
+    nanosleep(&duration, NULL);
+    atomic_store(&running, false);
+    pthread_join(writer, NULL);
+
+    uint64_t reads = 0, torn = 0;
+    size_t sample_count = 0;
+    for (int i = 0; i < reader_count; i++) {
+        pthread_join(readers[i].thread, NULL);
+        reads += readers[i].reads;
+        torn += readers[i].torn;
+        sample_count += readers[i].latency_count < LATENCY_SAMPLES ? readers[i].latency_count : LATENCY_SAMPLES;
+    }
+
+    uint32_t *samples = malloc((sample_count ? sample_count : 1) * sizeof(uint32_t));
+    size_t n = 0;
+    for (int i = 0; i < reader_count; i++) {
+        uint32_t count = readers[i].latency_count < LATENCY_SAMPLES ? readers[i].latency_count : LATENCY_SAMPLES;
+        for (uint32_t j = 0; j < count; j++) {
+            samples[n++] = readers[i].latency_ns[j];
+        }
+        free(readers[i].latency_ns);
+    }
+    qsort(samples, n, sizeof(uint32_t), compare_u32);
+
+    printf("seqlock: 1 writer, %d readers, %d ms\n", reader_count, duration_ms);
+    printf("  writes      %llu\n", (unsigned long long)writes);
+    printf("  reads       %llu\n", (unsigned long long)reads);
+    printf("  torn reads  %llu\n", (unsigned long long)torn);
+    if (n > 0) {
+        printf("  read latency p50 %u ns, p99 %u ns, max %u ns\n",
+               samples[n / 2], samples[(n * 99) / 100], samples[n - 1]);
+    }
+    free(samples);
+
+    if (writes == 0 || reads == 0) {
+        fprintf(stderr, "FAIL: no progress\n");
+        return 1;
+    }
+    if (torn != 0) {
+        fprintf(stderr, "FAIL: %llu torn reads\n", (unsigned long long)torn);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,176 @@
+/**
+ * @file test_stick_conditioning.c
+ * @brief 摇杆调理查找表测试
+ *
+ * 核对死区内输出为0、死区边缘没有跳变、单调、满偏输出满量程，
+ * 以及查找表与浮点参考实现的最大误差；双轴另核对圆形死区和按半径重新映射。
+ */
+
+#include "stick_conditioning.h"
+#include "stick_reference.h"
+#include "host_test.h"
+#include <math.h>
+#include <stdlib.h>
+
+// 查表与参考实现允许的最大误差（输出单位，满量程1000）
+// 表项宽32个原始单位，误差主要来自曲线最陡处（对数曲线刚出死区时）的量化
+#define MAX_ERROR               6.0f
+
+static const stick_curve_t curves[] = {
+    STICK_CURVE_LINEAR, STICK_CURVE_EXPONENTIAL, STICK_CURVE_LOGARITHMIC
+};
+
+static const uint8_t deadzones[] = { 0, 10, 25, 50 };
+
+static void set_config(uint8_t deadzone, uint8_t max_speed, stick_curve_t curve)
+{
+    stick_conditioning_config_t config = {
+        .deadzone_percent = deadzone,
+        .max_speed = max_speed,
+        .curve = curve,
+    };
+    TEST_CHECK_EQ(stick_conditioning_set_config(&config), ESP_OK);
+}
+
+/**
+ * @brief 从负满偏扫到正满偏，核对死区、单调性、跳变和精度
+ */
+static void check_sweep(stick_curve_t curve, uint8_t deadzone, uint8_t max_speed)
+{
+    set_config(deadzone, max_speed, curve);
+    stick_conditioning_config_t config;
+    stick_conditioning_get_config(&config);
+
+    int32_t edge = deadzone * 32767 / 100;
+    int16_t previous = stick_conditioning_apply_axis(-32768);
+    float max_error = 0.0f;
+
+    for (int32_t v = -32768; v <= 32767; v++) {
+        int16_t out = stick_conditioning_apply_axis((int16_t)v);
+        float ref = reference_apply_axis(&config, (int16_t)v);
+
+        // 死区内为0
+        if (abs(v) <= edge) {
+            TEST_CHECK_EQ(out, 0);
+        }
+        // 单调不减；与连续的参考曲线误差有界，即没有跳变
+        if (out < previous) {
+            fprintf(stderr, "curve %d deadzone %d%%: %d -> %d at %ld\n",
+                    curve, deadzone, previous, out, (long)v);
+            host_test_failures++;
+            return;
+        }
+        max_error = fmaxf(max_error, fabsf(out - ref));
+        previous = out;
+    }
+
+    if (max_error > MAX_ERROR) {
+        fprintf(stderr, "curve %d deadzone %d%% max_speed %d: max error %.2f\n",
+                curve, deadzone, max_speed, max_error);
+        host_test_failures++;
+    }
+}
+
+/**
+ * @brief 双轴网格扫描：半径平方不超过死区平方时输出0，其余与参考实现误差有界
+ */
+static void check_radial(stick_curve_t curve, uint8_t deadzone)
+{
+    set_config(deadzone, 255, curve);
+    stick_conditioning_config_t config;
+    stick_conditioning_get_config(&config);
+
+    int64_t edge = deadzone * 32767 / 100;
+    float max_error = 0.0f;
+    for (int32_t x = -32768; x <= 32767; x += 257) {
+        for (int32_t y = -32768; y <= 32767; y += 263) {
+            int16_t ox, oy;
+            float rx, ry;
+            stick_conditioning_apply((int16_t)x, (int16_t)y, &ox, &oy);
+            reference_apply(&config, (int16_t)x, (int16_t)y, &rx, &ry);
+
+            if ((int64_t)x * x + (int64_t)y * y <= edge * edge) {
+                TEST_CHECK_EQ(ox, 0);
+                TEST_CHECK_EQ(oy, 0);
+            }
+            max_error = fmaxf(max_error, fmaxf(fabsf(ox - rx), fabsf(oy - ry)));
+        }
+    }
+
+    // 轴向与单轴调理相同
+    for (int32_t v = -32768; v <= 32767; v += 61) {
+        int16_t ox, oy;
+        stick_conditioning_apply((int16_t)v, 0, &ox, &oy);
+        TEST_CHECK_EQ(ox, stick_conditioning_apply_axis((int16_t)v));
+        TEST_CHECK_EQ(oy, 0);
+    }
+
+    if (max_error > MAX_ERROR) {
+        fprintf(stderr, "radial curve %d deadzone %d%%: max error %.2f\n", curve, deadzone, max_error);
+        host_test_failures++;
+    }
+}
+
+static void check_edge_and_limits(void)
+{
+    for (size_t c = 0; c < sizeof(curves) / sizeof(curves[0]); c++) {
+        set_config(10, 255, curves[c]);
+
+        // 刚出死区的输出从0开始（旧实现在这里直接跳到曲线在死区处的值，线性曲线为100）
+        TEST_CHECK(stick_conditioning_apply_axis(10 * 32767 / 100 + 32) <= 10);
+        TEST_CHECK_EQ(stick_conditioning_apply_axis(32767), STICK_OUTPUT_MAX);
+        TEST_CHECK_EQ(stick_conditioning_apply_axis(-32768), -STICK_OUTPUT_MAX);
+
+        int16_t ox, oy;
+        stick_conditioning_apply(32767, -32768, &ox, &oy);
+        TEST_CHECK_EQ(ox, STICK_OUTPUT_MAX);
+        TEST_CHECK_EQ(oy, -STICK_OUTPUT_MAX);
+        stick_conditioning_apply(1000, -2000, &ox, &oy);
+        TEST_CHECK_EQ(ox, 0);
+        TEST_CHECK_EQ(oy, 0);
+
+        // 对角线上各轴都在死区内、半径已出死区：圆形死区有输出，刚出死区时接近0
+        stick_conditioning_apply(2400, 2400, &ox, &oy);
+        TEST_CHECK(ox >= 0 && ox <= 20);
+        TEST_CHECK_EQ(ox, oy);
+        stick_conditioning_apply(3200, 3200, &ox, &oy);
+        TEST_CHECK_EQ(stick_conditioning_apply_axis(3200), 0);
+        TEST_CHECK(ox > 0);
+        TEST_CHECK_EQ(ox, oy);
+        stick_conditioning_apply(2300, -2300, &ox, &oy);
+        TEST_CHECK_EQ(ox, 0);
+        TEST_CHECK_EQ(oy, 0);
+        // 偏向一侧推动时，小的一轴不被各轴死区吞掉
+        stick_conditioning_apply(16000, 1600, &ox, &oy);
+        TEST_CHECK(oy > 0);
+    }
+
+    // 缩放：max_speed为一半时满偏输出约为一半
+    set_config(10, 128, STICK_CURVE_LINEAR);
+    TEST_CHECK(abs(stick_conditioning_apply_axis(32767) - 502) <= 1);
+}
+
+static void check_invalid(void)
+{
+    stick_conditioning_config_t config = { .deadzone_percent = 51, .max_speed = 255 };
+    TEST_CHECK_EQ(stick_conditioning_set_config(&config), ESP_ERR_INVALID_ARG);
+    TEST_CHECK_EQ(stick_conditioning_set_config(NULL), ESP_ERR_INVALID_ARG);
+}
+
+int main(void)
+{
+    TEST_CHECK_EQ(stick_conditioning_init(), ESP_OK);
+
+    for (size_t c = 0; c < sizeof(curves) / sizeof(curves[0]); c++) {
+        for (size_t d = 0; d < sizeof(deadzones) / sizeof(deadzones[0]); d++) {
+            check_sweep(curves[c], deadzones[d], 255);
+        }
+        check_sweep(curves[c], 15, 180);
+        for (size_t d = 0; d < sizeof(deadzones) / sizeof(deadzones[0]); d++) {
+            check_radial(curves[c], deadzones[d]);
+        }
+    }
+    check_edge_and_limits();
+    check_invalid();
+    return host_test_finish("stick_conditioning");
+}
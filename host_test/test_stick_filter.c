@@ -0,0 +1,239 @@
+/**
+ * @file test_stick_filter.c
+ * @brief 摇杆滤波的延迟与抖动测试
+ *
+ * 合成带噪声的摇杆轨迹（静止、匀速推杆、保持、反向阶跃），时间戳带蓝牙报告间隔抖动，
+ * 用不同滤波参数处理后输出：
+ *   jitter  静止和保持段输出相对真实值的均方根误差 / 输入噪声均方根（越小越平滑）
+ *   lag     匀速段输出落后于输入的平均时间（ms）
+ *   step90  反向阶跃后输出走完90%所需时间（ms）
+ * 并检查默认One-Euro参数同时满足平滑和低延迟，且在相同平滑程度下比EMA延迟更低。
+ * 另用满量程阶跃和最大beta检查截止频率饱和而不回绕，以及开销统计计数。
+ */
+
+#include "stick_filter.h"
+#include "host_test.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_MAX_SAMPLES   4096
+#define NOISE_SIGMA         250.0   // 输入噪声标准差（原始单位）
+
+// 轨迹分段（微秒）
+#define REST_END_US         1500000
+#define RAMP_END_US         1750000 // 250ms内从0推到24000
+#define HOLD_END_US         2750000
+#define STEP_END_US         3500000 // 阶跃到-24000后保持
+#define RAMP_TARGET         24000
+#define SETTLE_US           300000  // 计算抖动时跳过分段开头的过渡
+
+typedef struct {
+    int64_t t_us;
+    int16_t truth;
+    int16_t noisy;
+} trace_sample_t;
+
+typedef struct {
+    const char *name;
+    uint32_t interval_us;       ///< 平均报告间隔
+    uint32_t jitter_us;         ///< 间隔抖动幅度（±）
+} trace_profile_t;
+
+typedef struct {
+    double jitter;
+    double lag_ms;
+    double step90_ms;
+} filter_metrics_t;
+
+static trace_sample_t trace[TRACE_MAX_SAMPLES];
+static size_t trace_len;
+
+static uint32_t rng_state;
+
+static double rng_uniform(void)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return ((rng_state >> 8) + 0.5) / 16777216.0;
+}
+
+static double rng_gaussian(void)
+{
+    return sqrt(-2.0 * log(rng_uniform())) * cos(2.0 * M_PI * rng_uniform());
+}
+
+static double truth_at(int64_t t)
+{
+    if (t < REST_END_US) {
+        return 0.0;
+    }
+    if (t < RAMP_END_US) {
+        return (double)RAMP_TARGET * (t - REST_END_US) / (RAMP_END_US - REST_END_US);
+    }
+    if (t < HOLD_END_US) {
+        return RAMP_TARGET;
+    }
+    return -RAMP_TARGET;
+}
+
+static void generate_trace(const trace_profile_t *profile, uint32_t seed)
+{
+    rng_state = seed;
+    trace_len = 0;
+    int64_t t = 0;
+    while (t < STEP_END_US && trace_len < TRACE_MAX_SAMPLES) {
+        double noisy = truth_at(t) + NOISE_SIGMA * rng_gaussian();
+        trace[trace_len].t_us = t;
+        trace[trace_len].truth = (int16_t)lround(truth_at(t));
+        trace[trace_len].noisy = (int16_t)fmax(-32768.0, fmin(32767.0, lround(noisy)));
+        trace_len++;
+
+        int32_t jitter = profile->jitter_us ? (int32_t)(rng_uniform() * 2 * profile->jitter_us) - (int32_t)profile->jitter_us : 0;
+        t += (int32_t)profile->interval_us + jitter;
+    }
+}
+
+static void set_all_axes(const stick_filter_axis_config_t *axis)
+{
+    stick_filter_config_t config;
+    for (int i = 0; i < STICK_FILTER_AXIS_COUNT; i++) {
+        config.axes[i] = *axis;
+    }
+    TEST_CHECK_EQ(stick_filter_set_config(&config), ESP_OK);
+}
+
+static filter_metrics_t run_filter(const stick_filter_axis_config_t *axis)
+{
+    set_all_axes(axis);
+    stick_filter_reset(0);
+
+    double err_sq = 0.0, noise_sq = 0.0;
+    double lag_sum = 0.0;
+    size_t lag_count = 0;
+    double step90_ms = -1.0;
+    double slope = (double)RAMP_TARGET / (RAMP_END_US - REST_END_US);  // 原始单位/us
+    double step_threshold = RAMP_TARGET - 0.9 * 2 * RAMP_TARGET;
+
+    for (size_t i = 0; i < trace_len; i++) {
+        const trace_sample_t *s = &trace[i];
+        int16_t axes[STICK_FILTER_AXIS_COUNT] = { s->noisy, 0, 0, 0 };
+        stick_filter_process(0, axes, s->t_us);
+        double out = axes[0];
+
+        bool settled_rest = s->t_us >= SETTLE_US && s->t_us < REST_END_US;
+        bool settled_hold = s->t_us >= RAMP_END_US + SETTLE_US && s->t_us < HOLD_END_US;
+        if (settled_rest || settled_hold) {
+            err_sq += (out - s->truth) * (out - s->truth);
+            noise_sq += (double)(s->noisy - s->truth) * (s->noisy - s->truth);
+        }
+        // 匀速段中间部分，避开起点的加速过渡
+        if (s->t_us >= REST_END_US + 100000 && s->t_us < RAMP_END_US) {
+            lag_sum += (s->noisy - out) / slope / 1000.0;
+            lag_count++;
+        }
+        if (s->t_us >= HOLD_END_US && step90_ms < 0 && out <= step_threshold) {
+            step90_ms = (s->t_us - HOLD_END_US) / 1000.0;
+        }
+    }
+
+    filter_metrics_t metrics = {
+        .jitter = noise_sq > 0 ? sqrt(err_sq / noise_sq) : 0.0,
+        .lag_ms = lag_count ? lag_sum / lag_count : 0.0,
+        .step90_ms = step90_ms,
+    };
+    return metrics;
+}
+
+/**
+ * @brief 最大beta乘满量程速度超出32位：截止频率应饱和到上限，而不是回绕成极低频率冻结输出
+ */
+static void test_cutoff_saturation(void)
+{
+    // 速度估计的截止频率高到tau为0，速度估计一步到位：65535/ms * 65535 + min_cutoff 正好回绕到10mHz
+    const stick_filter_axis_config_t axis = {
+        .type = STICK_FILTER_ONE_EURO,
+        .min_cutoff_mhz = 131081,
+        .beta = UINT16_MAX,
+        .d_cutoff_mhz = 200000000,
+    };
+    set_all_axes(&axis);
+
+    stick_filter_stats_t before;
+    TEST_CHECK_EQ(stick_filter_get_stats(&before), ESP_OK);
+
+    int16_t axes[STICK_FILTER_AXIS_COUNT] = { INT16_MIN, INT16_MIN, INT16_MIN, INT16_MIN };
+    stick_filter_process(0, axes, 0);
+    for (int i = 0; i < STICK_FILTER_AXIS_COUNT; i++) {
+        axes[i] = INT16_MAX;
+    }
+    stick_filter_process(0, axes, 1000);
+
+    // 饱和在100Hz时1ms一步走约39%，回绕成10mHz时几乎不动
+    for (int i = 0; i < STICK_FILTER_AXIS_COUNT; i++) {
+        TEST_CHECK(axes[i] > -16000);
+    }
+
+    // 首个样本只作初值，不计入开销统计
+    stick_filter_stats_t after;
+    TEST_CHECK_EQ(stick_filter_get_stats(&after), ESP_OK);
+    TEST_CHECK_EQ(after.reports - before.reports, 1);
+    TEST_CHECK(after.cycles_max >= before.cycles_max);
+}
+
+int main(void)
+{
+    static const trace_profile_t profiles[] = {
+        { "bt 133Hz", 7500, 2500 },
+        { "1kHz",     1000, 200 },
+    };
+
+    static const struct {
+        const char *name;
+        stick_filter_axis_config_t axis;
+    } filters[] = {
+        { "none",           { .type = STICK_FILTER_NONE } },
+        { "ema a=128",      { .type = STICK_FILTER_EMA, .ema_alpha = 128 } },
+        { "ema a=64",       { .type = STICK_FILTER_EMA, .ema_alpha = 64 } },
+        { "ema a=32",       { .type = STICK_FILTER_EMA, .ema_alpha = 32 } },
+        { "1euro default",  { .type = STICK_FILTER_ONE_EURO, .min_cutoff_mhz = 1000, .beta = 50, .d_cutoff_mhz = 1000 } },
+        { "1euro fc=3Hz",   { .type = STICK_FILTER_ONE_EURO, .min_cutoff_mhz = 3000, .beta = 50, .d_cutoff_mhz = 1000 } },
+    };
+    enum { F_NONE = 0, F_EMA_32 = 3, F_ONE_EURO = 4 };
+    const size_t filter_count = sizeof(filters) / sizeof(filters[0]);
+
+    TEST_CHECK_EQ(stick_filter_init(), ESP_OK);
+
+    for (size_t p = 0; p < sizeof(profiles) / sizeof(profiles[0]); p++) {
+        generate_trace(&profiles[p], 20240601u + (uint32_t)p);
+        printf("trace %s: %zu samples, noise sigma %.0f\n", profiles[p].name, trace_len, NOISE_SIGMA);
+        printf("  %-14s %8s %9s %10s\n", "filter", "jitter", "lag ms", "step90 ms");
+
+        filter_metrics_t results[sizeof(filters) / sizeof(filters[0])];
+        for (size_t f = 0; f < filter_count; f++) {
+            results[f] = run_filter(&filters[f].axis);
+            printf("  %-14s %7.1f%% %9.1f %10.1f\n", filters[f].name,
+                   results[f].jitter * 100.0, results[f].lag_ms, results[f].step90_ms);
+        }
+
+        // 不滤波：输出即输入
+        TEST_CHECK(fabs(results[F_NONE].jitter - 1.0) < 0.01);
+        TEST_CHECK(fabs(results[F_NONE].lag_ms) < 0.01);
+
+        // 默认One-Euro：静止时抖动至少减半，推杆时延迟和阶跃响应都在一帧控制周期量级
+        const filter_metrics_t *one_euro = &results[F_ONE_EURO];
+        TEST_CHECK(one_euro->jitter < 0.5);
+        TEST_CHECK(one_euro->lag_ms < 20.0);
+        TEST_CHECK(one_euro->step90_ms >= 0 && one_euro->step90_ms < 40.0);
+
+        // 与平滑程度相近或更弱的EMA相比，One-Euro的推杆延迟更低
+        const filter_metrics_t *ema = &results[F_EMA_32];
+        if (ema->jitter >= one_euro->jitter) {
+            TEST_CHECK(one_euro->lag_ms < ema->lag_ms);
+        }
+    }
+
+    test_cutoff_saturation();
+
+    return host_test_finish("stick_filter");
+}
@@ -0,0 +1,490 @@
+/**
+ * @file test_vibration_sequencer.c
+ * @brief 震动序列器的虚拟时钟测试
+ *
+ * 序列器只从esp_timer_get_time取时间，这里链接真实的vibration.c，用虚拟时钟实现esp_timer：
+ * 定时器不在线程中触发，由run_until()按到期顺序把时钟拨到到期时刻（加上注入的回调延迟）
+ * 再执行回调。手柄发送接口记录每次输出的时刻和强度，检查：
+ *   pulse    脉冲串的开/关沿时刻和强度，播完后定时器停止
+ *   pattern  模式逐步缩放、重复到总时长截止（最后一步截短），一直重复的模式不结束
+ *   drift    每次回调都迟到时，截止时间仍按理想时刻累加，迟到不累积
+ * 以及多个来源同时播放时的混合器：
+ *   blend    按优先级从低到高混合，MAX/SUM/OVERRIDE三种方式，SUM饱和到255
+ *   envelope 渐强和渐弱期间按帧输出，强度按包络线性变化
+ *   steal    声部用尽时只替换优先级不高于新效果的声部
+ *   suppress 混合结果不变时不发送
+ *   failure  手柄发送失败时放弃新效果，被替换或被抢占的效果继续播放
+ */
+
+#include "vibration.h"
+#include "haptic_clip.h"
+#include "hid_rumble.h"
+#include "esp_timer.h"
+#include "host_test.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_EVENTS          1024
+#define START_US            1000000    // 虚拟时钟起点，避开0
+
+/**
+ * @brief 一次发送到手柄的输出
+ */
+typedef struct {
+    int64_t t_us;
+    uint8_t left;
+    uint8_t right;
+} output_event_t;
+
+// ---- 虚拟时钟上的esp_timer ----
+
+struct host_esp_timer {
+    esp_timer_cb_t callback;
+    void *arg;
+    bool active;
+    int64_t expiry_us;
+};
+
+static int64_t virtual_now_us = START_US;
+static int64_t callback_latency_us = 0;    ///< 每次回调相对到期时刻的延迟
+static struct host_esp_timer *the_timer = NULL;
+static int64_t armed_expiry[MAX_EVENTS];   ///< 每次esp_timer_start_once设定的到期时刻
+static size_t armed_count = 0;
+
+int64_t esp_timer_get_time(void)
+{
+    return virtual_now_us;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out_handle)
+{
+    struct host_esp_timer *timer = calloc(1, sizeof(*timer));
+    if (!timer) {
+        return ESP_ERR_NO_MEM;
+    }
+    timer->callback = args->callback;
+    timer->arg = args->arg;
+    the_timer = timer;
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    if (timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = true;
+    timer->expiry_us = virtual_now_us + (int64_t)timeout_us;
+    if (armed_count < MAX_EVENTS) {
+        armed_expiry[armed_count++] = timer->expiry_us;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (timer == the_timer) {
+        the_timer = NULL;
+    }
+    free(timer);
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    return timer->active;
+}
+
+/**
+ * @brief 把虚拟时钟推进到until_us，途中按到期顺序执行定时器回调
+ */
+static void run_until(int64_t until_us)
+{
+    while (the_timer && the_timer->active && the_timer->expiry_us + callback_latency_us <= until_us) {
+        virtual_now_us = the_timer->expiry_us + callback_latency_us;
+        the_timer->active = false;
+        the_timer->callback(the_timer->arg);
+    }
+    virtual_now_us = until_us;
+}
+
+// ---- 序列器的输出替身 ----
+
+static output_event_t events[MAX_EVENTS];
+static size_t event_count = 0;
+static esp_err_t rumble_result = ESP_OK;   ///< 非ESP_OK时模拟发送失败，失败的发送不记录
+
+esp_err_t hid_rumble_send(uint8_t slot, uint8_t left, uint8_t right)
+{
+    if (rumble_result != ESP_OK) {
+        return rumble_result;
+    }
+    if (event_count < MAX_EVENTS) {
+        events[event_count++] = (output_event_t){ virtual_now_us, left, right };
+    }
+    return ESP_OK;
+}
+
+bool vibration_local_is_ready(void)
+{
+    return false;
+}
+
+esp_err_t vibration_local_set(uint8_t left, uint8_t right, uint32_t fade_ms)
+{
+    return ESP_ERR_INVALID_STATE;
+}
+
+uint32_t haptic_clip_sample(const haptic_clip_t *clip, uint32_t t_ms, uint8_t *left, uint8_t *right)
+{
+    // 这里不播放片段
+    abort();
+}
+
+/**
+ * @brief 停止上一个用例的效果并清空记录，时钟从新的整秒开始
+ */
+static int64_t reset_case(void)
+{
+    rumble_result = ESP_OK;
+    vibration_stop();
+    callback_latency_us = 0;
+    virtual_now_us = (virtual_now_us / 1000000 + 1) * 1000000;
+    event_count = 0;
+    armed_count = 0;
+    return virtual_now_us;
+}
+
+static void check_event(size_t index, int64_t t_us, uint8_t left, uint8_t right)
+{
+    if (index >= event_count) {
+        fprintf(stderr, "missing output #%zu (expected at +%lld us)\n", index, (long long)t_us);
+        host_test_failures++;
+        return;
+    }
+    TEST_CHECK_EQ(events[index].t_us, t_us);
+    TEST_CHECK_EQ(events[index].left, left);
+    TEST_CHECK_EQ(events[index].right, right);
+}
+
+static void test_pulse_train(void)
+{
+    int64_t base = reset_case();
+    vibration_params_t params = {
+        .left_intensity = 200,
+        .right_intensity = 100,
+        .duration_ms = 100,
+        .mode = VIBRATION_MODE_PULSE,
+        .pulse_count = 3,
+        .pulse_interval_ms = 50
+    };
+    TEST_CHECK_EQ(vibration_start(&params), ESP_OK);
+    run_until(base + 1000000);
+
+    // 开100ms、关50ms，最后一个脉冲后没有间隔
+    static const int64_t edges_ms[] = { 0, 100, 150, 250, 300, 400 };
+    TEST_CHECK_EQ(event_count, 6);
+    for (size_t i = 0; i < 6; i++) {
+        bool on = (i & 1) == 0;
+        check_event(i, base + edges_ms[i] * 1000, on ? 200 : 0, on ? 100 : 0);
+    }
+    TEST_CHECK(!vibration_is_active());
+    TEST_CHECK(!esp_timer_is_active(the_timer));
+}
+
+static void test_pattern(void)
+{
+    static uint8_t levels[] = { 255, 128, 0, 64 };
+    vibration_pattern_t pattern = {
+        .pattern_data = levels,
+        .pattern_length = 4,
+        .step_duration_ms = 20,
+        .repeat = true
+    };
+    TEST_CHECK_EQ(vibration_set_pattern(&pattern), ESP_OK);
+
+    // 重复到170ms：第9步(255)只播10ms
+    int64_t base = reset_case();
+    vibration_params_t params = {
+        .left_intensity = 255,
+        .right_intensity = 128,
+        .duration_ms = 170,
+        .mode = VIBRATION_MODE_PATTERN
+    };
+    TEST_CHECK_EQ(vibration_start(&params), ESP_OK);
+    run_until(base + 1000000);
+
+    TEST_CHECK_EQ(event_count, 10);
+    for (size_t i = 0; i < 9; i++) {
+        uint8_t level = levels[i % 4];
+        check_event(i, base + (int64_t)i * 20000, level, (uint8_t)((level * 128 + 127) / 255));
+    }
+    check_event(9, base + 170000, 0, 0);
+    TEST_CHECK(!vibration_is_active());
+
+    // 不重复：播完4步即结束，第5步的时刻输出0
+    pattern.repeat = false;
+    TEST_CHECK_EQ(vibration_set_pattern(&pattern), ESP_OK);
+    base = reset_case();
+    TEST_CHECK_EQ(vibration_start(&params), ESP_OK);
+    run_until(base + 1000000);
+    TEST_CHECK_EQ(event_count, 5);
+    check_event(3, base + 60000, 64, (uint8_t)((64 * 128 + 127) / 255));
+    check_event(4, base + 80000, 0, 0);
+    TEST_CHECK(!vibration_is_active());
+
+    // 总时长为0时一直重复，直到停止
+    pattern.repeat = true;
+    TEST_CHECK_EQ(vibration_set_pattern(&pattern), ESP_OK);
+    base = reset_case();
+    params.duration_ms = 0;
+    TEST_CHECK_EQ(vibration_start(&params), ESP_OK);
+    run_until(base + 10000000);
+    TEST_CHECK_EQ(event_count, 10000000 / 20000 + 1);
+    check_event(event_count - 1, base + 10000000, 255, 128);
+    TEST_CHECK(vibration_is_active());
+    vibration_status_t status;
+    TEST_CHECK_EQ(vibration_get_status(&status), ESP_OK);
+    TEST_CHECK_EQ(status.remaining_time, UINT32_MAX);
+    TEST_CHECK_EQ(vibration_stop(), ESP_OK);
+    TEST_CHECK(!esp_timer_is_active(the_timer));
+}
+
+static void test_drift_free(void)
+{
+    // 100个10ms脉冲、10ms间隔，每次回调迟到3ms
+    const int64_t latency_us = 3000;
+    const size_t pulses = 100;
+    int64_t base = reset_case();
+    callback_latency_us = latency_us;
+    vibration_params_t params = {
+        .left_intensity = 255,
+        .right_intensity = 255,
+        .duration_ms = 10,
+        .mode = VIBRATION_MODE_PULSE,
+        .pulse_count = pulses,
+        .pulse_interval_ms = 10
+    };
+    TEST_CHECK_EQ(vibration_start(&params), ESP_OK);
+    run_until(base + 10000000);
+
+    // 第k个沿在理想时刻k*10ms之后固定迟到3ms，不随k累积
+    TEST_CHECK_EQ(event_count, pulses * 2);
+    int64_t worst_us = 0;
+    for (size_t k = 1; k < event_count; k++) {
+        int64_t late_us = events[k].t_us - (base + (int64_t)k * 10000);
+        if (late_us > worst_us) {
+            worst_us = late_us;
+        }
+        TEST_CHECK_EQ(late_us, latency_us);
+    }
+
+    // 定时器总是设到理想的截止时刻
+    TEST_CHECK_EQ(armed_count, pulses * 2 - 1);
+    for (size_t k = 0; k < armed_count; k++) {
+        TEST_CHECK_EQ(armed_expiry[k], base + (int64_t)(k + 1) * 10000);
+    }
+
+    printf("drift: %zu edges with %lld us callback latency, worst edge lateness %lld us\n",
+           event_count, (long long)latency_us, (long long)worst_us);
+}
+
+/**
+ * @brief 从source播放一个连续效果
+ */
+static esp_err_t play(uint8_t source, uint8_t left, uint8_t right, uint32_t duration_ms,
+                      uint8_t priority, vibration_blend_t blend)
+{
+    vibration_params_t params = {
+        .left_intensity = left,
+        .right_intensity = right,
+        .duration_ms = duration_ms,
+        .mode = VIBRATION_MODE_CONTINUOUS
+    };
+    vibration_mix_t mix = {
+        .priority = priority,
+        .blend = blend
+    };
+    return vibration_play(source, &params, &mix);
+}
+
+static void check_last_output(uint8_t left, uint8_t right)
+{
+    if (event_count == 0) {
+        fprintf(stderr, "no output sent\n");
+        host_test_failures++;
+        return;
+    }
+    TEST_CHECK_EQ(events[event_count - 1].left, left);
+    TEST_CHECK_EQ(events[event_count - 1].right, right);
+}
+
+static void test_blend(void)
+{
+    reset_case();
+
+    TEST_CHECK_EQ(play(1, 100, 50, 1000, 10, VIBRATION_BLEND_MAX), ESP_OK);
+    check_last_output(100, 50);
+    TEST_CHECK_EQ(play(2, 60, 80, 1000, 20, VIBRATION_BLEND_MAX), ESP_OK);
+    check_last_output(100, 80);
+
+    // 同一来源再次播放替换原来的效果
+    TEST_CHECK_EQ(play(2, 60, 80, 1000, 20, VIBRATION_BLEND_SUM), ESP_OK);
+    check_last_output(160, 130);
+    TEST_CHECK_EQ(play(3, 200, 200, 1000, 30, VIBRATION_BLEND_SUM), ESP_OK);
+    check_last_output(255, 255);
+
+    // 按优先级而不是提交顺序混合：后提交的低优先级声部被先混合，再被OVERRIDE覆盖
+    TEST_CHECK_EQ(vibration_stop_source(3), ESP_OK);
+    TEST_CHECK_EQ(play(2, 10, 20, 1000, 20, VIBRATION_BLEND_OVERRIDE), ESP_OK);
+    check_last_output(10, 20);
+    TEST_CHECK_EQ(play(3, 250, 250, 1000, 5, VIBRATION_BLEND_MAX), ESP_OK);
+    check_last_output(10, 20);
+    TEST_CHECK_EQ(play(3, 250, 250, 1000, 25, VIBRATION_BLEND_MAX), ESP_OK);
+    check_last_output(250, 250);
+}
+
+static void test_envelope(void)
+{
+    int64_t base = reset_case();
+    vibration_params_t params = {
+        .left_intensity = 200,
+        .right_intensity = 200,
+        .duration_ms = 100,
+        .mode = VIBRATION_MODE_CONTINUOUS
+    };
+    vibration_mix_t mix = {
+        .attack_ms = 20,
+        .release_ms = 40
+    };
+    TEST_CHECK_EQ(vibration_play(1, &params, &mix), ESP_OK);
+    run_until(base + 1000000);
+
+    // 0ms增益为0（与当前输出相同，不发送）；渐强段和渐弱段按帧输出，其间不发送
+    static const struct {
+        int64_t t_ms;
+        uint8_t level;
+    } expected[] = {
+        { 10, 100 }, { 20, 200 }, { 70, 150 }, { 80, 100 }, { 90, 50 }, { 100, 0 }
+    };
+    TEST_CHECK_EQ(event_count, 6);
+    for (size_t i = 0; i < 6; i++) {
+        check_event(i, base + expected[i].t_ms * 1000, expected[i].level, expected[i].level);
+    }
+    TEST_CHECK(!vibration_is_active());
+}
+
+static void test_steal(void)
+{
+    reset_case();
+    vibration_stats_t before, after;
+    TEST_CHECK_EQ(vibration_get_stats(&before), ESP_OK);
+
+    TEST_CHECK_EQ(play(1, 250, 0, 1000, 10, VIBRATION_BLEND_MAX), ESP_OK);
+    for (uint8_t source = 2; source <= VIBRATION_MAX_VOICES; source++) {
+        TEST_CHECK_EQ(play(source, 10, 10, 1000, (uint8_t)(source * 10), VIBRATION_BLEND_MAX), ESP_OK);
+    }
+    check_last_output(250, 10);
+
+    // 优先级低于所有声部时不替换
+    TEST_CHECK_EQ(play(9, 20, 20, 1000, 5, VIBRATION_BLEND_MAX), ESP_ERR_NO_MEM);
+    check_last_output(250, 10);
+
+    // 替换优先级最低的来源1
+    TEST_CHECK_EQ(play(9, 20, 20, 1000, 15, VIBRATION_BLEND_MAX), ESP_OK);
+    check_last_output(20, 20);
+    TEST_CHECK_EQ(vibration_get_stats(&after), ESP_OK);
+    TEST_CHECK_EQ(after.voices_stolen - before.voices_stolen, 1);
+    TEST_CHECK_EQ(after.active_voices, VIBRATION_MAX_VOICES);
+}
+
+static void test_suppress(void)
+{
+    reset_case();
+    vibration_stats_t before, after;
+
+    TEST_CHECK_EQ(play(1, 100, 100, 1000, 10, VIBRATION_BLEND_MAX), ESP_OK);
+    TEST_CHECK_EQ(vibration_get_stats(&before), ESP_OK);
+    size_t sent = event_count;
+
+    // 更弱的MAX声部和同强度的重新提交都不改变混合结果
+    TEST_CHECK_EQ(play(2, 50, 50, 1000, 5, VIBRATION_BLEND_MAX), ESP_OK);
+    TEST_CHECK_EQ(play(1, 100, 100, 1000, 10, VIBRATION_BLEND_MAX), ESP_OK);
+    TEST_CHECK_EQ(vibration_stop_source(2), ESP_OK);
+    TEST_CHECK_EQ(event_count, sent);
+    TEST_CHECK_EQ(vibration_get_stats(&after), ESP_OK);
+    TEST_CHECK_EQ(after.reports_suppressed - before.reports_suppressed, 3);
+    TEST_CHECK_EQ(after.reports_sent, before.reports_sent);
+}
+
+static void test_send_failure(void)
+{
+    // 替换同一来源的效果时发送失败：原来的效果继续播放
+    int64_t base = reset_case();
+    TEST_CHECK_EQ(play(1, 100, 100, 200, 10, VIBRATION_BLEND_MAX), ESP_OK);
+    rumble_result = ESP_ERR_INVALID_STATE;
+    TEST_CHECK_EQ(play(1, 200, 200, 1000, 10, VIBRATION_BLEND_MAX), ESP_ERR_INVALID_STATE);
+    rumble_result = ESP_OK;
+    vibration_status_t status;
+    TEST_CHECK_EQ(vibration_get_status(&status), ESP_OK);
+    TEST_CHECK(status.active);
+    TEST_CHECK_EQ(status.params.left_intensity, 100);
+    run_until(base + 1000000);
+    TEST_CHECK_EQ(event_count, 2);
+    check_event(1, base + 200000, 0, 0);
+
+    // 抢占声部时发送失败：被抢占的效果还在，也不计为替换
+    reset_case();
+    vibration_stats_t before, after;
+    TEST_CHECK_EQ(vibration_get_stats(&before), ESP_OK);
+    TEST_CHECK_EQ(play(1, 250, 0, 1000, 10, VIBRATION_BLEND_MAX), ESP_OK);
+    for (uint8_t source = 2; source <= VIBRATION_MAX_VOICES; source++) {
+        TEST_CHECK_EQ(play(source, 10, 10, 1000, (uint8_t)(source * 10), VIBRATION_BLEND_MAX), ESP_OK);
+    }
+    rumble_result = ESP_ERR_INVALID_STATE;
+    TEST_CHECK_EQ(play(9, 20, 20, 1000, 50, VIBRATION_BLEND_MAX), ESP_ERR_INVALID_STATE);
+    rumble_result = ESP_OK;
+    TEST_CHECK_EQ(vibration_get_stats(&after), ESP_OK);
+    TEST_CHECK_EQ(after.voices_stolen, before.voices_stolen);
+    TEST_CHECK_EQ(after.active_voices, VIBRATION_MAX_VOICES);
+
+    // 停掉其他来源后输出仍是来源1的强度，停掉来源1才归零
+    for (uint8_t source = 2; source <= VIBRATION_MAX_VOICES; source++) {
+        TEST_CHECK_EQ(vibration_stop_source(source), ESP_OK);
+    }
+    check_last_output(250, 0);
+    TEST_CHECK_EQ(vibration_stop_source(1), ESP_OK);
+    check_last_output(0, 0);
+}
+
+int main(void)
+{
+    TEST_CHECK_EQ(vibration_init(), ESP_OK);
+
+    test_pulse_train();
+    test_pattern();
+    test_drift_free();
+    test_blend();
+    test_envelope();
+    test_steal();
+    test_suppress();
+    test_send_failure();
+
+    TEST_CHECK_EQ(vibration_deinit(), ESP_OK);
+    return host_test_finish("vibration_sequencer");
+}
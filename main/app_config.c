@@ -0,0 +1,251 @@
+/**
+ * @file app_config.c
+ * @brief 配置管理器与应用模块之间的桥接实现
+ */
+
+#include "app_config.h"
+#include "config_manager.h"
+#include "stick_conditioning.h"
+#include "stick_filter.h"
+#include "button_combo.h"
+#include "hid_trace.h"
+#include "hid_reconnect.h"
+#include "hid_discovery.h"
+#include "vibration_local.h"
+#include "esp_log.h"
+
+static const char *TAG = "APP_CONFIG";
+
+/**
+ * @brief 把以Hz等为单位的浮点配置换算为千分之一单位的整数，负值和NaN取0，过大时饱和
+ */
+static uint32_t to_milli_units(float value)
+{
+    float milli = value * 1000.0f;
+    if (!(milli > 0.0f)) {
+        return 0;
+    }
+    if (milli >= (float)UINT32_MAX) {
+        return UINT32_MAX;
+    }
+    return (uint32_t)milli;
+}
+
+/**
+ * @brief 应用控制配置
+ */
+static void apply_control_config(const control_config_t *control)
+{
+    stick_conditioning_config_t stick = {
+        .deadzone_percent = control->stick_deadzone,
+        .max_speed = control->max_speed,
+    };
+
+    switch (control->acceleration_curve) {
+    case ACCEL_CURVE_EXPONENTIAL:
+        stick.curve = STICK_CURVE_EXPONENTIAL;
+        break;
+    case ACCEL_CURVE_LOGARITHMIC:
+        stick.curve = STICK_CURVE_LOGARITHMIC;
+        break;
+    case ACCEL_CURVE_LINEAR:
+    default:
+        stick.curve = STICK_CURVE_LINEAR;
+        break;
+    }
+
+    esp_err_t ret = stick_conditioning_set_config(&stick);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to apply stick config: %s", esp_err_to_name(ret));
+    }
+
+    // 配置轴顺序与滤波器轴顺序一致，频率从Hz换算为mHz
+    stick_filter_config_t filter;
+    for (int i = 0; i < STICK_AXIS_MAX; i++) {
+        const axis_filter_config_t *src = &control->stick_filter[i];
+        stick_filter_axis_config_t *dst = &filter.axes[i];
+
+        switch (src->type) {
+        case FILTER_TYPE_EMA:
+            dst->type = STICK_FILTER_EMA;
+            break;
+        case FILTER_TYPE_ONE_EURO:
+            dst->type = STICK_FILTER_ONE_EURO;
+            break;
+        case FILTER_TYPE_NONE:
+        default:
+            dst->type = STICK_FILTER_NONE;
+            break;
+        }
+        dst->ema_alpha = src->ema_alpha;
+        dst->min_cutoff_mhz = to_milli_units(src->min_cutoff);
+        dst->beta = to_milli_units(src->beta);
+        dst->d_cutoff_mhz = to_milli_units(src->d_cutoff);
+    }
+
+    ret = stick_filter_set_config(&filter);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to apply stick filter config: %s", esp_err_to_name(ret));
+    }
+}
+
+_Static_assert((int)STICK_AXIS_MAX == (int)STICK_FILTER_AXIS_COUNT, "stick axis count mismatch");
+
+/**
+ * @brief 应用安全配置
+ */
+static void apply_safety_config(const safety_config_t *safety)
+{
+    esp_err_t ret = button_combo_set_estop_keys(safety->emergency_stop_keys);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to apply emergency stop keys: %s", esp_err_to_name(ret));
+    }
+}
+
+/**
+ * @brief 应用震动配置：输出到本地马达时按gpio配置的引脚初始化马达，再设置默认输出目标
+ */
+static void apply_vibration_config(const vibration_config_t *vibration)
+{
+    vibration_output_t output;
+    switch (vibration->output) {
+    case VIBRATION_OUTPUT_TARGET_LOCAL:
+        output = VIBRATION_OUTPUT_LOCAL;
+        break;
+    case VIBRATION_OUTPUT_TARGET_BOTH:
+        output = VIBRATION_OUTPUT_BOTH;
+        break;
+    case VIBRATION_OUTPUT_TARGET_PAD:
+    default:
+        output = VIBRATION_OUTPUT_PAD;
+        break;
+    }
+
+    if (output != VIBRATION_OUTPUT_PAD && !vibration_local_is_ready()) {
+        const gpio_config_t *gpio = config_manager_get_gpio_config();
+        vibration_local_config_t local = {
+            .left_gpio = gpio ? gpio->vibration_motor_left : -1,
+            .right_gpio = gpio ? gpio->vibration_motor_right : -1,
+        };
+        esp_err_t ret = vibration_local_init(&local);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Local vibration motors unavailable, using pad: %s", esp_err_to_name(ret));
+            output = VIBRATION_OUTPUT_PAD;
+        }
+    }
+
+    vibration_set_default_output(output);
+}
+
+/**
+ * @brief 配置文件中的手柄型号转换为解析器型号
+ */
+static hid_controller_type_t to_hid_controller(controller_type_t type)
+{
+    switch (type) {
+    case CONTROLLER_TYPE_PS4:
+        return HID_CONTROLLER_PS4;
+    case CONTROLLER_TYPE_XBOX:
+        return HID_CONTROLLER_XBOX;
+    case CONTROLLER_TYPE_BEITONG:
+        return HID_CONTROLLER_BEITONG;
+    case CONTROLLER_TYPE_GENERIC:
+    default:
+        return HID_CONTROLLER_GENERIC;
+    }
+}
+
+/**
+ * @brief 应用手柄配置：支持的型号作为查询时的首选型号，
+ *        连接超时作为每轮查询扫描时长，重连次数作为最大轮数
+ */
+static void apply_gamepad_config(const gamepad_config_t *gamepad)
+{
+    // 通用手柄靠类别码识别，不作为首选
+    uint32_t preferred = 0;
+    for (int i = 0; i < (int)(sizeof(gamepad->supported_controllers) / sizeof(gamepad->supported_controllers[0])); i++) {
+        hid_controller_type_t type = to_hid_controller(gamepad->supported_controllers[i]);
+        if (type != HID_CONTROLLER_GENERIC) {
+            preferred |= 1u << type;
+        }
+    }
+    hid_discovery_set_preferred(preferred);
+
+    hid_reconnect_config_t reconnect;
+    hid_reconnect_get_config(&reconnect);
+    if (gamepad->connection_timeout > 0) {
+        reconnect.inquiry_sec = gamepad->connection_timeout;
+    }
+    reconnect.max_attempts = gamepad->max_reconnect_attempts;
+
+    esp_err_t ret = hid_reconnect_set_config(&reconnect);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to apply reconnect config: %s", esp_err_to_name(ret));
+    }
+}
+
+/**
+ * @brief 配置更新回调
+ */
+static void config_update_callback(config_type_t type, const void *config)
+{
+    switch (type) {
+    case CONFIG_TYPE_GAMEPAD:
+        apply_gamepad_config((const gamepad_config_t *)config);
+        break;
+    case CONFIG_TYPE_CONTROL:
+        apply_control_config((const control_config_t *)config);
+        break;
+    case CONFIG_TYPE_VIBRATION:
+        apply_vibration_config((const vibration_config_t *)config);
+        break;
+    case CONFIG_TYPE_SAFETY:
+        apply_safety_config((const safety_config_t *)config);
+        break;
+    default:
+        break;
+    }
+}
+
+esp_err_t app_config_init(void)
+{
+    esp_err_t ret = config_manager_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Config manager unavailable, using built-in defaults: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    const gamepad_config_t *gamepad = config_manager_get_gamepad_config();
+    if (gamepad) {
+        apply_gamepad_config(gamepad);
+    }
+
+    const control_config_t *control = config_manager_get_control_config();
+    if (control) {
+        apply_control_config(control);
+    }
+
+    const vibration_config_t *vibration = config_manager_get_vibration_config();
+    if (vibration) {
+        apply_vibration_config(vibration);
+    }
+
+    const safety_config_t *safety = config_manager_get_safety_config();
+    if (safety) {
+        apply_safety_config(safety);
+    }
+
+    // SPIFFS由配置管理器挂载，之后才能开始录制
+    const debug_config_t *debug = config_manager_get_debug_config();
+    if (debug && debug->hid_trace_record) {
+        ret = hid_trace_start_recording();
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to start HID trace: %s", esp_err_to_name(ret));
+        }
+    }
+
+    config_manager_register_callback(config_update_callback);
+
+    ESP_LOGI(TAG, "Application config applied");
+    return ESP_OK;
+}
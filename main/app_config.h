@@ -0,0 +1,29 @@
+/**
+ * @file app_config.h
+ * @brief 配置管理器与应用模块之间的桥接头文件
+ *
+ * config_manager.h 与 gamepad_controller.h 存在同名类型，不能在同一编译单元中
+ * 同时包含，因此由本模块负责把配置文件中的参数转换后下发给各应用模块。
+ */
+
+#ifndef APP_CONFIG_H
+#define APP_CONFIG_H
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 加载配置文件并应用到各应用模块，之后的配置变更自动下发
+ * @note 需要在gamepad_controller_init之后调用
+ * @return ESP_OK 成功，其他值表示错误（各模块保持默认参数）
+ */
+esp_err_t app_config_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // APP_CONFIG_H
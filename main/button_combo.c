@@ -0,0 +1,342 @@
+/**
+ * @file button_combo.c
+ * @brief 组合键引擎实现
+ */
+
+#include "button_combo.h"
+#include "esp_log.h"
+#include <stdatomic.h>
+#include <string.h>
+
+static const char *TAG = "BUTTON_COMBO";
+
+/**
+ * @brief 编译后的匹配表
+ *
+ * 槽位按优先级从高到低分配，位号越小优先级越高；序列的各步占用连续槽位。
+ */
+typedef struct {
+    uint32_t required[BUTTON_COMBO_BUTTON_COUNT];   ///< 需要该键按下的槽位
+    uint32_t forbidden[BUTTON_COMBO_BUTTON_COUNT];  ///< 该键按下即不匹配的槽位（exact组合）
+    uint32_t used_slots;                            ///< 已使用的槽位
+    uint32_t instant_slots;                         ///< 按下即触发的同时按键组合
+    uint32_t hold_slots;                            ///< 需要按住时长的同时按键组合
+    uint32_t sequence_first_slots;                  ///< 各序列第一步所在槽位
+    uint32_t estop_slots;                           ///< 紧急停止动作的槽位
+    uint8_t slot_action[BUTTON_COMBO_MAX_SLOTS];    ///< 槽位触发的动作
+    uint8_t slot_first[BUTTON_COMBO_MAX_SLOTS];     ///< 序列槽位：该序列第一步的槽位
+    uint8_t slot_last[BUTTON_COMBO_MAX_SLOTS];      ///< 序列槽位：该序列最后一步的槽位
+    uint16_t slot_hold_ms[BUTTON_COMBO_MAX_SLOTS];  ///< 按住时长
+    uint16_t slot_timeout_ms[BUTTON_COMBO_MAX_SLOTS]; ///< 序列步间超时
+} combo_table_t;
+
+// 组合键定义（配置任务访问）
+static button_combo_def_t combo_defs[BUTTON_COMBO_MAX_SLOTS];
+static size_t combo_def_count = 0;
+
+// 匹配表双缓冲：配置任务编译到空闲缓冲，解析路径无锁读取
+static combo_table_t tables[2];
+static _Atomic(const combo_table_t *) active_table = NULL;
+
+static button_combo_action_cb_t action_callback = NULL;
+
+/**
+ * @brief 单个输入源的匹配状态
+ */
+typedef struct {
+    const combo_table_t *table;                     ///< 状态对应的匹配表
+    uint32_t prev_satisfied;                        ///< 上一报告满足的槽位
+    uint32_t hold_armed;                            ///< 正在计时的按住槽位
+    uint32_t latched;                               ///< 已触发且仍按住的槽位
+    uint32_t sequence_expected;                     ///< 各序列等待的下一步
+    bool estop_latched;                             ///< 紧急停止已触发，松开所有按键前不触发其他组合
+    int64_t hold_start_us[BUTTON_COMBO_MAX_SLOTS];
+    int64_t sequence_deadline_us[BUTTON_COMBO_MAX_SLOTS];
+    volatile bool valid;
+} combo_state_t;
+
+// 匹配状态只在报告解析路径中访问
+static combo_state_t source_states[BUTTON_COMBO_MAX_SOURCES];
+
+// 各输入源保持中的动作
+static _Atomic uint32_t active_actions[BUTTON_COMBO_MAX_SOURCES];
+
+/**
+ * @brief 编译组合键定义
+ */
+static esp_err_t compile_table(const button_combo_def_t *defs, size_t count, combo_table_t *table)
+{
+    memset(table, 0, sizeof(combo_table_t));
+
+    // 按优先级从高到低分配槽位（插入排序，定义数量很少）
+    uint8_t order[BUTTON_COMBO_MAX_SLOTS];
+    for (size_t i = 0; i < count; i++) {
+        size_t j = i;
+        while (j > 0 && defs[order[j - 1]].priority < defs[i].priority) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    uint8_t slot = 0;
+    for (size_t n = 0; n < count; n++) {
+        const button_combo_def_t *def = &defs[order[n]];
+        uint8_t steps = def->step_count ? def->step_count : 1;
+
+        if (steps > BUTTON_COMBO_MAX_STEPS || def->action == BUTTON_COMBO_ACTION_NONE ||
+            def->action >= BUTTON_COMBO_ACTION_MAX) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (slot + steps > BUTTON_COMBO_MAX_SLOTS) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        uint8_t first = slot;
+        for (uint8_t s = 0; s < steps; s++, slot++) {
+            uint32_t chord = def->steps[s];
+            uint32_t bit = 1UL << slot;
+            if (chord == 0 || (chord >> BUTTON_COMBO_BUTTON_COUNT) != 0) {
+                return ESP_ERR_INVALID_ARG;
+            }
+
+            for (int b = 0; b < BUTTON_COMBO_BUTTON_COUNT; b++) {
+                if (chord & (1UL << b)) {
+                    table->required[b] |= bit;
+                } else if (def->exact) {
+                    table->forbidden[b] |= bit;
+                }
+            }
+
+            table->used_slots |= bit;
+            if (def->action == BUTTON_COMBO_ACTION_ESTOP) {
+                table->estop_slots |= bit;
+            }
+            table->slot_action[slot] = def->action;
+            table->slot_first[slot] = first;
+            table->slot_last[slot] = first + steps - 1;
+            table->slot_hold_ms[slot] = def->hold_ms;
+            table->slot_timeout_ms[slot] = def->step_timeout_ms;
+        }
+
+        if (steps == 1) {
+            if (def->hold_ms > 0) {
+                table->hold_slots |= 1UL << first;
+            } else {
+                table->instant_slots |= 1UL << first;
+            }
+        } else {
+            table->sequence_first_slots |= 1UL << first;
+        }
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief 编译组合键定义并发布，成功后保存定义
+ */
+static esp_err_t publish_table(const button_combo_def_t *defs, size_t count)
+{
+    const combo_table_t *current = atomic_load_explicit(&active_table, memory_order_relaxed);
+    combo_table_t *next = (current == &tables[0]) ? &tables[1] : &tables[0];
+
+    esp_err_t ret = compile_table(defs, count, next);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to compile combo table: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    if (defs != combo_defs) {
+        memcpy(combo_defs, defs, count * sizeof(button_combo_def_t));
+    }
+    combo_def_count = count;
+    atomic_store_explicit(&active_table, next, memory_order_release);
+
+    ESP_LOGI(TAG, "Combo table compiled: %d combos, %d slots",
+             (int)count, __builtin_popcount(next->used_slots));
+    return ESP_OK;
+}
+
+/**
+ * @brief 按优先级分发触发的动作
+ */
+static void dispatch_actions(const combo_table_t *table, uint32_t fired)
+{
+    while (fired) {
+        int slot = __builtin_ctz(fired);
+        fired &= fired - 1;
+
+        button_combo_action_t action = table->slot_action[slot];
+        ESP_LOGD(TAG, "Combo slot %d fired: action=%d", slot, action);
+        if (action_callback) {
+            action_callback(action);
+        }
+
+        // 紧急停止屏蔽同一报告中优先级更低的动作
+        if (action == BUTTON_COMBO_ACTION_ESTOP) {
+            break;
+        }
+    }
+}
+
+esp_err_t button_combo_init(button_combo_action_cb_t callback)
+{
+    action_callback = callback;
+    combo_def_count = 0;
+    for (uint8_t i = 0; i < BUTTON_COMBO_MAX_SOURCES; i++) {
+        button_combo_reset(i);
+    }
+
+    ESP_LOGI(TAG, "Button combo engine initialized");
+    return ESP_OK;
+}
+
+esp_err_t button_combo_set_table(const button_combo_def_t *defs, size_t count)
+{
+    if ((!defs && count > 0) || count > BUTTON_COMBO_MAX_SLOTS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return publish_table(defs, count);
+}
+
+esp_err_t button_combo_set_estop_keys(uint32_t chord)
+{
+    if (chord == 0 || (chord >> BUTTON_COMBO_BUTTON_COUNT) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 在副本上修改，编译失败时保留原定义
+    button_combo_def_t defs[BUTTON_COMBO_MAX_SLOTS];
+    size_t count = combo_def_count;
+    memcpy(defs, combo_defs, count * sizeof(button_combo_def_t));
+
+    bool found = false;
+    for (size_t i = 0; i < count; i++) {
+        if (defs[i].action == BUTTON_COMBO_ACTION_ESTOP) {
+            defs[i].steps[0] = chord;
+            defs[i].step_count = 1;
+            found = true;
+        }
+    }
+    if (!found) {
+        ESP_LOGW(TAG, "No emergency stop combo defined");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    ESP_LOGI(TAG, "Emergency stop keys set to 0x%04lx", (unsigned long)chord);
+    return publish_table(defs, count);
+}
+
+void button_combo_process(uint8_t source, uint32_t buttons, int64_t timestamp_us)
+{
+    const combo_table_t *table = atomic_load_explicit(&active_table, memory_order_acquire);
+    if (!table || source >= BUTTON_COMBO_MAX_SOURCES) {
+        return;
+    }
+
+    combo_state_t *st = &source_states[source];
+
+    // 表切换或重置后从空状态开始
+    if (!st->valid || table != st->table) {
+        st->table = table;
+        st->prev_satisfied = 0;
+        st->hold_armed = 0;
+        st->latched = 0;
+        st->sequence_expected = table->sequence_first_slots;
+        st->estop_latched = false;
+        atomic_store_explicit(&active_actions[source], 0, memory_order_relaxed);
+        st->valid = true;
+    }
+
+    // 紧急停止后按任意顺序松开按键时会经过其他组合（如只剩SELECT），全部松开前不触发
+    if (st->estop_latched && buttons == 0) {
+        st->estop_latched = false;
+    }
+
+    // 所有槽位并行匹配：按下的键排除exact槽位，未按下的键排除需要它的槽位
+    uint32_t satisfied = table->used_slots;
+    for (int b = 0; b < BUTTON_COMBO_BUTTON_COUNT; b++) {
+        satisfied &= ~((buttons & (1UL << b)) ? table->forbidden[b] : table->required[b]);
+    }
+
+    uint32_t rising = satisfied & ~st->prev_satisfied;
+    st->prev_satisfied = satisfied;
+
+    uint32_t fired = rising & table->instant_slots;
+
+    // 按住时长：匹配开始时记录时间，松开即取消
+    uint32_t newly_armed = rising & table->hold_slots;
+    for (uint32_t m = newly_armed; m; m &= m - 1) {
+        st->hold_start_us[__builtin_ctz(m)] = timestamp_us;
+    }
+    st->hold_armed = (st->hold_armed | newly_armed) & satisfied;
+    for (uint32_t m = st->hold_armed; m; m &= m - 1) {
+        int slot = __builtin_ctz(m);
+        if (timestamp_us - st->hold_start_us[slot] >= (int64_t)table->slot_hold_ms[slot] * 1000) {
+            fired |= 1UL << slot;
+            st->hold_armed &= ~(1UL << slot);
+        }
+    }
+
+    // 序列：超时回到第一步，当前步匹配时前进
+    for (uint32_t m = st->sequence_expected & ~table->sequence_first_slots; m; m &= m - 1) {
+        int slot = __builtin_ctz(m);
+        uint8_t first = table->slot_first[slot];
+        if (timestamp_us > st->sequence_deadline_us[first]) {
+            st->sequence_expected = (st->sequence_expected & ~(1UL << slot)) | (1UL << first);
+        }
+    }
+    for (uint32_t m = rising & st->sequence_expected; m; m &= m - 1) {
+        int slot = __builtin_ctz(m);
+        uint8_t first = table->slot_first[slot];
+        st->sequence_expected &= ~(1UL << slot);
+        if (slot == table->slot_last[slot]) {
+            fired |= 1UL << slot;
+            st->sequence_expected |= 1UL << first;
+        } else {
+            st->sequence_expected |= 1UL << (slot + 1);
+            st->sequence_deadline_us[first] = timestamp_us + (int64_t)table->slot_timeout_ms[slot] * 1000;
+        }
+    }
+
+    if (st->estop_latched) {
+        fired &= table->estop_slots;
+        st->hold_armed = 0;
+        st->sequence_expected = table->sequence_first_slots;
+    } else if (fired & table->estop_slots) {
+        st->estop_latched = true;
+    }
+
+    // 同时按键组合触发后在按住期间保持有效
+    uint32_t chord_slots = table->instant_slots | table->hold_slots;
+    st->latched = (st->latched | (fired & chord_slots)) & satisfied;
+    uint32_t actions = 0;
+    for (uint32_t m = st->latched; m; m &= m - 1) {
+        actions |= BUTTON_COMBO_ACTION_BIT(table->slot_action[__builtin_ctz(m)]);
+    }
+    atomic_store_explicit(&active_actions[source], actions, memory_order_relaxed);
+
+    if (fired) {
+        dispatch_actions(table, fired);
+    }
+}
+
+uint32_t button_combo_get_active_actions(void)
+{
+    uint32_t actions = 0;
+    for (int i = 0; i < BUTTON_COMBO_MAX_SOURCES; i++) {
+        actions |= atomic_load_explicit(&active_actions[i], memory_order_relaxed);
+    }
+    return actions;
+}
+
+void button_combo_reset(uint8_t source)
+{
+    if (source >= BUTTON_COMBO_MAX_SOURCES) {
+        return;
+    }
+    source_states[source].valid = false;
+    atomic_store_explicit(&active_actions[source], 0, memory_order_relaxed);
+}
@@ -0,0 +1,129 @@
+/**
+ * @file button_combo.h
+ * @brief 组合键引擎头文件
+ *
+ * 把配置的同时按键组合（可要求按住时长）和按键序列编译成按位匹配表，
+ * 每个输入报告评估一次。所有组合的匹配通过按键遍历一次完成，
+ * 开销与组合数量无关（最多32个槽位）。
+ */
+
+#ifndef BUTTON_COMBO_H
+#define BUTTON_COMBO_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 匹配表槽位数（每个同时按键组合占1个，序列每一步占1个）
+ */
+#define BUTTON_COMBO_MAX_SLOTS       32
+
+/**
+ * @brief 序列最多步数
+ */
+#define BUTTON_COMBO_MAX_STEPS       4
+
+/**
+ * @brief 参与匹配的按键数（按键位号与gamepad_button_t一致）
+ */
+#define BUTTON_COMBO_BUTTON_COUNT    15
+
+/**
+ * @brief 独立匹配的输入源个数（每个手柄槽位一个）
+ */
+#define BUTTON_COMBO_MAX_SOURCES     4
+
+/**
+ * @brief 组合键触发的动作
+ */
+typedef enum {
+    BUTTON_COMBO_ACTION_NONE = 0,
+    BUTTON_COMBO_ACTION_ESTOP,           ///< 紧急停止（在输入路径中立即执行）
+    BUTTON_COMBO_ACTION_THROTTLE_CUT,    ///< 切断油门（按住期间保持）
+    BUTTON_COMBO_ACTION_MODE_NEXT,       ///< 在小车和飞机模式之间切换（禁用时无效）
+    BUTTON_COMBO_ACTION_TRIM_PITCH_UP,   ///< 俯仰微调+
+    BUTTON_COMBO_ACTION_TRIM_PITCH_DOWN, ///< 俯仰微调-
+    BUTTON_COMBO_ACTION_TRIM_ROLL_LEFT,  ///< 横滚/转向微调-
+    BUTTON_COMBO_ACTION_TRIM_ROLL_RIGHT, ///< 横滚/转向微调+
+    BUTTON_COMBO_ACTION_MAX
+} button_combo_action_t;
+
+/**
+ * @brief 动作位掩码
+ */
+#define BUTTON_COMBO_ACTION_BIT(action)  (1UL << (action))
+
+/**
+ * @brief 组合键定义
+ */
+typedef struct {
+    uint32_t steps[BUTTON_COMBO_MAX_STEPS]; ///< 每一步需要同时按下的按键位图
+    uint8_t step_count;                     ///< 步数，1表示普通同时按键组合
+    uint16_t hold_ms;                       ///< 同时按键组合需要按住的时长，0表示按下即触发
+    uint16_t step_timeout_ms;               ///< 序列相邻两步的最大间隔
+    bool exact;                             ///< true时不允许按下组合之外的按键
+    uint8_t priority;                       ///< 优先级，越大越优先；同一报告中紧急停止会屏蔽低优先级动作，
+                                            ///< 紧急停止触发后该输入源松开所有按键前不再触发其他组合
+    button_combo_action_t action;           ///< 触发的动作
+} button_combo_def_t;
+
+/**
+ * @brief 动作回调函数类型（在输入报告解析路径中调用）
+ */
+typedef void (*button_combo_action_cb_t)(button_combo_action_t action);
+
+/**
+ * @brief 初始化组合键引擎
+ * @param callback 动作回调
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t button_combo_init(button_combo_action_cb_t callback);
+
+/**
+ * @brief 设置并编译组合键表
+ * @note 在空闲缓冲中编译后原子切换，可在任意任务中调用
+ * @param defs 组合键定义数组
+ * @param count 定义个数
+ * @return ESP_OK 成功，ESP_ERR_NO_MEM 槽位不足，其他值表示错误
+ */
+esp_err_t button_combo_set_table(const button_combo_def_t *defs, size_t count);
+
+/**
+ * @brief 替换所有紧急停止组合的按键并重新编译
+ * @param chord 紧急停止按键位图
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t button_combo_set_estop_keys(uint32_t chord);
+
+/**
+ * @brief 评估一个输入报告的按键状态
+ * @note 只能在报告解析路径中调用（每个输入源单写者），组合键不会跨输入源拼凑
+ * @param source 输入源 (0 to BUTTON_COMBO_MAX_SOURCES-1)
+ * @param buttons 按键位图
+ * @param timestamp_us 报告时间戳 (esp_timer微秒)
+ */
+void button_combo_process(uint8_t source, uint32_t buttons, int64_t timestamp_us);
+
+/**
+ * @brief 获取当前保持中的动作（任一输入源已触发且组合仍按住）
+ * @return 动作位图，位号见button_combo_action_t
+ */
+uint32_t button_combo_get_active_actions(void);
+
+/**
+ * @brief 清除一个输入源的匹配状态（手柄断开时调用）
+ * @param source 输入源 (0 to BUTTON_COMBO_MAX_SOURCES-1)
+ */
+void button_combo_reset(uint8_t source);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BUTTON_COMBO_H
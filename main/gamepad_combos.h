@@ -0,0 +1,40 @@
+/**
+ * @file gamepad_combos.h
+ * @brief 默认组合键表（控制器和主机端回放工具共用）
+ *
+ * 只应被一个源文件包含：表定义为static const。
+ */
+
+#ifndef GAMEPAD_COMBOS_H
+#define GAMEPAD_COMBOS_H
+
+#include "button_combo.h"
+#include "gamepad_controller.h"
+
+#define COMBO_KEYS(...)  { __VA_ARGS__ }
+#define KEY(b)           GAMEPAD_BUTTON_MASK(GAMEPAD_BUTTON_##b)
+
+// 默认组合键表，紧急停止按键可由配置文件emergency_stop_keys覆盖
+static const button_combo_def_t gamepad_default_combos[] = {
+    { .steps = COMBO_KEYS(KEY(L1) | KEY(R1) | KEY(SELECT) | KEY(START)), .step_count = 1,
+      .priority = 255, .action = BUTTON_COMBO_ACTION_ESTOP },
+    { .steps = COMBO_KEYS(KEY(Y)), .step_count = 1,
+      .priority = 200, .action = BUTTON_COMBO_ACTION_THROTTLE_CUT },
+    { .steps = COMBO_KEYS(KEY(SELECT)), .step_count = 1, .exact = true,
+      .priority = 100, .action = BUTTON_COMBO_ACTION_MODE_NEXT },
+    { .steps = COMBO_KEYS(KEY(DPAD_UP)), .step_count = 1, .exact = true,
+      .priority = 50, .action = BUTTON_COMBO_ACTION_TRIM_PITCH_UP },
+    { .steps = COMBO_KEYS(KEY(DPAD_DOWN)), .step_count = 1, .exact = true,
+      .priority = 50, .action = BUTTON_COMBO_ACTION_TRIM_PITCH_DOWN },
+    { .steps = COMBO_KEYS(KEY(DPAD_LEFT)), .step_count = 1, .exact = true,
+      .priority = 50, .action = BUTTON_COMBO_ACTION_TRIM_ROLL_LEFT },
+    { .steps = COMBO_KEYS(KEY(DPAD_RIGHT)), .step_count = 1, .exact = true,
+      .priority = 50, .action = BUTTON_COMBO_ACTION_TRIM_ROLL_RIGHT },
+};
+
+#define GAMEPAD_DEFAULT_COMBO_COUNT  (sizeof(gamepad_default_combos) / sizeof(gamepad_default_combos[0]))
+
+#undef COMBO_KEYS
+#undef KEY
+
+#endif // GAMEPAD_COMBOS_H
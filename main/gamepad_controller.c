@@ -5,21 +5,32 @@
 
 #include "gamepad_controller.h"
 #include "bluetooth_hid.h"
+#include "hid_report_parser.h"
+#include "hid_battery.h"
 #include "car_control.h"
 #include "plane_control.h"
 #include "vibration.h"
+#include "haptic_clip.h"
+#include "stick_conditioning.h"
+#include "stick_filter.h"
+#include "button_combo.h"
+#include "gamepad_combos.h"
+#include "hid_trace.h"
+#include "state_seqlock.h"
+#include "system_monitor.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/semphr.h"
 #include <inttypes.h>
+#include <stdatomic.h>
+#include <stdlib.h>
 #include <string.h>
 
 static const char *TAG = "GAMEPAD_CTRL";
 
 // 函数声明
-static void parse_gamepad_input(const uint8_t *data, uint16_t len);
+static void parse_gamepad_input(uint8_t slot, const hid_input_report_t *input);
 
 // 任务参数
 #define GAMEPAD_INPUT_TASK_STACK_SIZE   4096
@@ -28,15 +39,81 @@ static void parse_gamepad_input(const uint8_t *data, uint16_t len);
 #define CONTROL_OUTPUT_TASK_PRIORITY    9
 
 // 更新频率
-#define GAMEPAD_UPDATE_INTERVAL_MS      10   // 100Hz
+#define GAMEPAD_UPDATE_INTERVAL_MS      10   // 100Hz，连接状态检查周期
+#define GAMEPAD_INPUT_QUEUE_DEPTH       16
 #define CONTROL_UPDATE_INTERVAL_MS      20   // 50Hz
 
+// 事件驱动模式参数
+#define CONTROL_MIN_INTERVAL_MS         4    // 速率上限250Hz，防止报告风暴占满CPU
+#define CONTROL_FALLBACK_TIMEOUT_MS     CONTROL_UPDATE_INTERVAL_MS  // 无报告时兜底唤醒，保持失联保护
+#define DEFAULT_PIPELINE_MODE           GAMEPAD_PIPELINE_EVENT
+
+// 微调步长和范围（控制量满量程为1000）
+#define TRIM_STEP                   10
+#define TRIM_LIMIT                  200
+
 // 静态变量
-static control_mode_t current_mode = CONTROL_MODE_DISABLED;
-static gamepad_state_t current_state = {0};
-static SemaphoreHandle_t state_mutex = NULL;
+static volatile control_mode_t current_mode = CONTROL_MODE_DISABLED;
+static gamepad_snapshot_t current_slots = {0};
+static bool initialized = false;
 static TaskHandle_t input_task_handle = NULL;
 static TaskHandle_t output_task_handle = NULL;
+static volatile gamepad_pipeline_mode_t pipeline_mode = DEFAULT_PIPELINE_MODE;
+
+// 状态快照序列锁：读者无锁，遇到并发写入只需重试
+static state_seqlock_t state_lock = STATE_SEQLOCK_INITIALIZER;
+
+// 组合键触发、等待控制任务处理的动作（紧急停止不经过这里）
+static _Atomic uint32_t pending_actions = 0;
+
+// 当前微调量
+static int16_t trim_pitch = 0;
+static int16_t trim_roll = 0;
+
+// 震动来源：同一来源的新效果替换旧效果，不同来源的效果混合
+enum {
+    HAPTIC_SOURCE_APP = VIBRATION_SOURCE_DEFAULT,  ///< gamepad_controller_vibrate
+    HAPTIC_SOURCE_CONNECT,                         ///< 连接成功提示
+    HAPTIC_SOURCE_DRIVE,                           ///< 转向震动
+    HAPTIC_SOURCE_ALERT                            ///< 紧急停止和模式切换提示
+};
+
+// 转向震动每个控制周期重新提交，叠加在其他效果上并在松开后渐弱
+static const vibration_mix_t haptic_mix_drive = { .priority = 10, .blend = VIBRATION_BLEND_SUM, .release_ms = 30 };
+static const vibration_mix_t haptic_mix_connect = { .priority = 100, .blend = VIBRATION_BLEND_MAX };
+// 警示覆盖其他所有效果，确保能被感知
+static const vibration_mix_t haptic_mix_alert = { .priority = 255, .blend = VIBRATION_BLEND_OVERRIDE };
+
+// 片段库中的连接提示，没有片段库时为NULL，改用固定脉冲
+static const haptic_clip_t *haptic_clip_connect = NULL;
+
+// 最近一个控制周期的按键边沿（控制任务写，其他任务读）
+static gamepad_button_edges_t last_button_edges = {0};
+static portMUX_TYPE button_edges_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// 报告提取表：每个槽位双缓冲，连接时在空闲缓冲中编译后原子切换，解析路径无锁读取
+static hid_report_map_t report_maps[GAMEPAD_MAX_SLOTS][2];
+static _Atomic(hid_report_map_t *) active_report_map[GAMEPAD_MAX_SLOTS];
+
+// 输入报告队列：蓝牙回调只入队池缓冲，解析和录制在输入任务中完成
+static hid_report_queue_t input_queue;
+
+// 回放注入的槽位：回放期间视为已连接
+static _Atomic uint8_t replay_slot_mask = 0;
+
+// 待清除的槽位：断开事件在蓝牙/回放任务中到达，清除交给输入任务，滤波和组合键状态只由输入任务修改
+static _Atomic uint8_t slot_clear_mask = 0;
+
+// 通道映射双缓冲：设置任务写空闲缓冲，控制任务无锁读取
+static gamepad_channel_map_t channel_maps[2];
+static _Atomic(const gamepad_channel_map_t *) active_channel_map = NULL;
+
+// 默认映射：单手柄，所有通道由槽位0驱动
+static const gamepad_channel_map_t default_channel_map = {
+    .channel_slot = { 0 },
+    .override_slot = GAMEPAD_SLOT_NONE,
+    .override_buttons = 0
+};
 
 // 默认配置
 static car_motor_config_t default_car_config = {
@@ -60,6 +137,321 @@ static plane_servo_config_t default_plane_config = {
     .servo_center_us = 1500
 };
 
+/**
+ * @brief 开始写入状态快照
+ * @note 必须与state_write_end()成对调用，中间只允许做简单的内存赋值
+ */
+static inline void state_write_begin(void)
+{
+    state_seqlock_write_begin(&state_lock);
+}
+
+/**
+ * @brief 结束写入状态快照
+ */
+static inline void state_write_end(void)
+{
+    state_seqlock_write_end(&state_lock);
+}
+
+/**
+ * @brief 无锁读取所有槽位的一致快照
+ *
+ * 写者在临界区内只更新一个槽位的几十字节，因此重试窗口只有数百纳秒。
+ */
+static void state_read(gamepad_snapshot_t *out)
+{
+    state_seqlock_read(&state_lock, out, &current_slots, sizeof(gamepad_snapshot_t));
+}
+
+/**
+ * @brief 已连接槽位中槽位号最小的槽位
+ * @return 槽位号，无连接时返回GAMEPAD_SLOT_NONE
+ */
+static inline uint8_t primary_slot(uint8_t connected_mask)
+{
+    return connected_mask ? (uint8_t)__builtin_ctz(connected_mask) : GAMEPAD_SLOT_NONE;
+}
+
+/**
+ * @brief 从快照中取出一个槽位的兼容状态视图
+ */
+static void snapshot_to_state(const gamepad_snapshot_t *snapshot, uint8_t slot, gamepad_state_t *state)
+{
+    memset(state, 0, sizeof(gamepad_state_t));
+    if (slot >= GAMEPAD_MAX_SLOTS) {
+        return;
+    }
+    
+    state->connected = (snapshot->connected_mask & (1u << slot)) != 0;
+    state->buttons = snapshot->buttons[slot];
+    state->sticks.left_x = snapshot->axes[slot][GAMEPAD_AXIS_LX];
+    state->sticks.left_y = snapshot->axes[slot][GAMEPAD_AXIS_LY];
+    state->sticks.right_x = snapshot->axes[slot][GAMEPAD_AXIS_RX];
+    state->sticks.right_y = snapshot->axes[slot][GAMEPAD_AXIS_RY];
+    state->sticks.left_trigger = snapshot->triggers[slot][GAMEPAD_TRIGGER_LEFT];
+    state->sticks.right_trigger = snapshot->triggers[slot][GAMEPAD_TRIGGER_RIGHT];
+    state->last_update = snapshot->last_update[slot];
+    state->input_time_us = snapshot->input_time_us[slot];
+}
+
+// 槽位与蓝牙设备槽位一一对应，滤波和组合键为每个槽位保留独立状态
+_Static_assert(GAMEPAD_MAX_SLOTS == BLUETOOTH_HID_MAX_DEVICES, "slot count mismatch");
+_Static_assert(GAMEPAD_MAX_SLOTS <= STICK_FILTER_MAX_SOURCES, "slot count mismatch");
+_Static_assert(GAMEPAD_MAX_SLOTS <= BUTTON_COMBO_MAX_SOURCES, "slot count mismatch");
+_Static_assert(GAMEPAD_MAX_SLOTS <= 8, "connected_mask is 8 bits");
+
+// 按键位图直接沿用提取器的位号，摇杆轴顺序与提取器、滤波器一致
+_Static_assert((int)GAMEPAD_AXIS_COUNT == (int)HID_GAMEPAD_AXIS_MAX, "axis layout mismatch");
+_Static_assert((int)GAMEPAD_AXIS_RY == (int)HID_GAMEPAD_AXIS_RY, "axis layout mismatch");
+_Static_assert((int)GAMEPAD_TRIGGER_RIGHT == (int)HID_GAMEPAD_TRIGGER_RIGHT, "trigger layout mismatch");
+_Static_assert((int)HID_GAMEPAD_AXIS_MAX == (int)STICK_FILTER_AXIS_COUNT, "axis layout mismatch");
+_Static_assert((int)HID_GAMEPAD_AXIS_RY == (int)STICK_FILTER_AXIS_RY, "axis layout mismatch");
+_Static_assert((int)GAMEPAD_BUTTON_COUNT == (int)HID_GAMEPAD_BUTTON_MAX, "button bit layout mismatch");
+_Static_assert((int)GAMEPAD_BUTTON_DPAD_RIGHT == (int)HID_GAMEPAD_BUTTON_DPAD_RIGHT, "button bit layout mismatch");
+_Static_assert((int)GAMEPAD_BUTTON_SELECT == (int)HID_GAMEPAD_BUTTON_SELECT, "button bit layout mismatch");
+
+/**
+ * @brief 发布本周期的按键边沿
+ */
+static void publish_button_edges(const gamepad_button_edges_t *edges)
+{
+    portENTER_CRITICAL(&button_edges_lock);
+    last_button_edges = *edges;
+    portEXIT_CRITICAL(&button_edges_lock);
+}
+
+/**
+ * @brief 立即停止所有输出（紧急停止）
+ */
+static void emergency_stop_outputs(void)
+{
+    car_control_stop();
+    plane_control_emergency_stop();
+}
+
+/**
+ * @brief 以指定来源播放一次双侧脉冲
+ */
+static void haptic_pulse(uint8_t source, const vibration_mix_t *mix, uint8_t intensity, uint32_t duration_ms)
+{
+    vibration_params_t params = {
+        .left_intensity = intensity,
+        .right_intensity = intensity,
+        .duration_ms = duration_ms,
+        .mode = VIBRATION_MODE_PULSE,
+        .pulse_count = 1
+    };
+    vibration_play(source, &params, mix);
+}
+
+/**
+ * @brief 组合键动作回调（在输入报告解析路径中调用）
+ */
+static void combo_action_callback(button_combo_action_t action)
+{
+    switch (action) {
+    case BUTTON_COMBO_ACTION_ESTOP:
+        // 不等待控制周期：先禁用控制，再直接停止输出
+        ESP_LOGW(TAG, "Emergency stop triggered");
+        current_mode = CONTROL_MODE_DISABLED;
+        emergency_stop_outputs();
+        haptic_pulse(HAPTIC_SOURCE_ALERT, &haptic_mix_alert, 255, 500);
+        break;
+        
+    case BUTTON_COMBO_ACTION_THROTTLE_CUT:
+        if (current_mode == CONTROL_MODE_PLANE) {
+            plane_control_emergency_stop();
+            haptic_pulse(HAPTIC_SOURCE_ALERT, &haptic_mix_alert, 255, 500);
+        }
+        break;
+        
+    default:
+        // 其余动作交给控制任务在下一个周期处理
+        atomic_fetch_or_explicit(&pending_actions, BUTTON_COMBO_ACTION_BIT(action), memory_order_relaxed);
+        break;
+    }
+}
+
+/**
+ * @brief 调整微调量
+ */
+static void adjust_trim(int16_t *trim, int16_t delta)
+{
+    int16_t value = *trim + delta;
+    if (value > TRIM_LIMIT) value = TRIM_LIMIT;
+    if (value < -TRIM_LIMIT) value = -TRIM_LIMIT;
+    *trim = value;
+}
+
+/**
+ * @brief 处理组合键触发的延迟动作（控制任务中调用）
+ */
+static void handle_pending_actions(void)
+{
+    uint32_t actions = atomic_exchange_explicit(&pending_actions, 0, memory_order_relaxed);
+    if (actions == 0) {
+        return;
+    }
+    
+    if (actions & BUTTON_COMBO_ACTION_BIT(BUTTON_COMBO_ACTION_MODE_NEXT)) {
+        // 只在小车和飞机之间切换；禁用（如紧急停止后）只能由gamepad_controller_set_mode显式恢复
+        control_mode_t mode = current_mode;
+        if (mode == CONTROL_MODE_DISABLED) {
+            ESP_LOGW(TAG, "Mode switch ignored while control is disabled");
+        } else {
+            control_mode_t new_mode = mode == CONTROL_MODE_CAR ? CONTROL_MODE_PLANE : CONTROL_MODE_CAR;
+            gamepad_controller_set_mode(new_mode);
+            haptic_pulse(HAPTIC_SOURCE_ALERT, &haptic_mix_alert, 100, 100); // 模式切换提示
+        }
+    }
+    if (actions & BUTTON_COMBO_ACTION_BIT(BUTTON_COMBO_ACTION_TRIM_PITCH_UP)) {
+        adjust_trim(&trim_pitch, TRIM_STEP);
+    }
+    if (actions & BUTTON_COMBO_ACTION_BIT(BUTTON_COMBO_ACTION_TRIM_PITCH_DOWN)) {
+        adjust_trim(&trim_pitch, -TRIM_STEP);
+    }
+    if (actions & BUTTON_COMBO_ACTION_BIT(BUTTON_COMBO_ACTION_TRIM_ROLL_LEFT)) {
+        adjust_trim(&trim_roll, -TRIM_STEP);
+    }
+    if (actions & BUTTON_COMBO_ACTION_BIT(BUTTON_COMBO_ACTION_TRIM_ROLL_RIGHT)) {
+        adjust_trim(&trim_roll, TRIM_STEP);
+    }
+    ESP_LOGD(TAG, "Trim: pitch=%d, roll=%d", trim_pitch, trim_roll);
+}
+
+/**
+ * @brief 控制量加微调并限幅到-1000到1000
+ */
+static inline int16_t apply_trim(int16_t value, int16_t trim)
+{
+    int32_t out = (int32_t)value + trim;
+    if (out > 1000) return 1000;
+    if (out < -1000) return -1000;
+    return (int16_t)out;
+}
+
+/**
+ * @brief 为槽位上新连接的手柄编译报告提取表
+ *
+ * 优先解析设备上报的描述符，缺失或解析失败时退回到识别出的型号的内置描述符。
+ */
+static void load_report_map(uint8_t slot)
+{
+    hid_device_info_t device;
+    hid_controller_type_t type = HID_CONTROLLER_GENERIC;
+    const uint8_t *desc = NULL;
+    uint16_t desc_len = 0;
+
+    if (bluetooth_hid_get_device(slot, &device) == ESP_OK) {
+        type = hid_report_parser_detect_type(device.vendor_id, device.product_id, device.name);
+        desc = device.report_desc;
+        desc_len = device.report_desc_len;
+    }
+
+    hid_report_map_t *current = atomic_load_explicit(&active_report_map[slot], memory_order_relaxed);
+    hid_report_map_t *next = (current == &report_maps[slot][0]) ? &report_maps[slot][1] : &report_maps[slot][0];
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    if (desc != NULL && desc_len > 0) {
+        size_t map_len;
+        const uint8_t *button_map = hid_report_parser_get_button_map(type, &map_len);
+        ret = hid_report_map_compile(desc, desc_len, button_map, map_len, next);
+        if (ret == ESP_OK) {
+            // 设备描述符中扩展报告（如DS4蓝牙0x11）多为厂商自定义用途，按型号补上
+            hid_report_map_apply_profile(type, next);
+        } else {
+            ESP_LOGW(TAG, "Device report descriptor unusable, using built-in layout");
+        }
+    }
+    if (ret != ESP_OK) {
+        ret = hid_report_map_compile_builtin(type, next);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to compile report map: %s", esp_err_to_name(ret));
+        return;
+    }
+
+    atomic_store_explicit(&active_report_map[slot], next, memory_order_release);
+    ESP_LOGI(TAG, "Report map loaded for slot %d, controller type %d", slot, type);
+}
+
+/**
+ * @brief 把非传输后端来源的报告（旧式数据事件、回放）装入池缓冲并入队
+ * @note 序号和时间戳在取缓冲时分配，随状态传到PWM更新用于延迟统计
+ */
+static void submit_report(uint8_t slot, uint8_t report_id, const uint8_t *data, uint16_t len, uint8_t flags)
+{
+    if (len > HID_REPORT_MAX_LEN) {
+        len = HID_REPORT_MAX_LEN;
+    }
+    
+    hid_report_buf_t *buf = hid_report_pool_alloc();
+    if (buf == NULL) {
+        return;
+    }
+    buf->slot = slot;
+    buf->report_id = report_id;
+    buf->flags = flags;
+    buf->len = len;
+    memcpy(buf->data, data, len);
+    
+    hid_report_queue_push(&input_queue, buf);
+    hid_report_pool_release(buf);
+}
+
+/**
+ * @brief 处理一个出队的报告：录制后解析
+ */
+static void process_report(const hid_report_buf_t *buf)
+{
+    hid_input_report_t input = {
+        .data = (uint8_t *)buf->data,
+        .len = buf->len,
+        .report_id = buf->report_id,
+        .map_index = buf->map_index,
+        .seq = buf->seq,
+        .timestamp_us = buf->timestamp_us
+    };
+    
+    // 回放的报告不再录制
+    if (!(buf->flags & HID_REPORT_FLAG_REPLAY)) {
+        hid_trace_record(buf->slot, buf->report_id, buf->data, buf->len, buf->timestamp_us);
+    }
+    parse_gamepad_input(buf->slot, &input);
+}
+
+/**
+ * @brief 请求清除断开槽位的状态，由输入任务在处理完已入队的报告后执行
+ */
+static void clear_slot(uint8_t slot)
+{
+    atomic_fetch_or(&slot_clear_mask, (uint8_t)(1u << slot));
+    TaskHandle_t task = input_task_handle;
+    if (task != NULL) {
+        xTaskNotifyGive(task);
+    }
+}
+
+/**
+ * @brief 执行待清除的槽位（仅在输入任务中调用）
+ */
+static void apply_slot_clears(void)
+{
+    uint8_t mask = atomic_exchange(&slot_clear_mask, 0);
+    for (uint32_t m = mask; m; m &= m - 1) {
+        uint8_t slot = __builtin_ctz(m);
+        state_write_begin();
+        current_slots.connected_mask &= ~(1u << slot);
+        current_slots.buttons[slot] = 0;
+        memset(current_slots.axes[slot], 0, sizeof(current_slots.axes[slot]));
+        memset(current_slots.triggers[slot], 0, sizeof(current_slots.triggers[slot]));
+        state_write_end();
+        stick_filter_reset(slot);
+        button_combo_reset(slot);
+    }
+}
+
 /**
  * @brief HID事件回调函数
  */
@@ -75,34 +467,36 @@ static void hid_event_callback(hid_event_param_t *param)
         break;
         
     case HID_EVENT_OPEN:
-        if (param->param.open.status == ESP_OK) {
-            ESP_LOGI(TAG, "HID device connected successfully");
-            if (xSemaphoreTake(state_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-                current_state.connected = true;
-                xSemaphoreGive(state_mutex);
-            }
+        if (param->param.open.status == ESP_OK && param->param.open.slot < GAMEPAD_MAX_SLOTS) {
+            uint8_t slot = param->param.open.slot;
+            ESP_LOGI(TAG, "HID device connected successfully in slot %d", slot);
+            load_report_map(slot);
+            state_write_begin();
+            current_slots.connected_mask |= 1u << slot;
+            state_write_end();
             
             // 连接成功震动反馈
-            vibration_quick_pulse(150, 200);
+            if (haptic_clip_connect) {
+                vibration_play_clip(HAPTIC_SOURCE_CONNECT, haptic_clip_connect, 255, &haptic_mix_connect);
+            } else {
+                haptic_pulse(HAPTIC_SOURCE_CONNECT, &haptic_mix_connect, 150, 200);
+            }
         } else {
             ESP_LOGE(TAG, "HID device connection failed");
         }
         break;
         
     case HID_EVENT_CLOSE:
-        ESP_LOGI(TAG, "HID device disconnected");
-        if (xSemaphoreTake(state_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-            current_state.connected = false;
-            memset(&current_state.buttons, 0, sizeof(current_state.buttons));
-            memset(&current_state.sticks, 0, sizeof(current_state.sticks));
-            xSemaphoreGive(state_mutex);
+        if (param->param.close.slot < GAMEPAD_MAX_SLOTS) {
+            ESP_LOGI(TAG, "HID device in slot %d disconnected", param->param.close.slot);
+            clear_slot(param->param.close.slot);
         }
         break;
         
     case HID_EVENT_DATA:
-        ESP_LOGD(TAG, "HID data received: len=%d", param->param.data.len);
+        ESP_LOGD(TAG, "HID data received: slot=%d, len=%d", param->param.data.slot, param->param.data.len);
         if (param->param.data.data && param->param.data.len > 0) {
-            parse_gamepad_input(param->param.data.data, param->param.data.len);
+            submit_report(param->param.data.slot, 0, param->param.data.data, param->param.data.len, 0);
         }
         break;
         
@@ -113,63 +507,89 @@ static void hid_event_callback(hid_event_param_t *param)
 }
 
 /**
- * @brief 解析通用手柄输入数据
+ * @brief 按槽位的报告提取表解析手柄输入数据
  */
-static void parse_gamepad_input(const uint8_t *data, uint16_t len)
+static void parse_gamepad_input(uint8_t slot, const hid_input_report_t *input)
 {
-    if (len < 8) {
-        ESP_LOGW(TAG, "Input data too short: %d bytes", len);
+    if (slot >= GAMEPAD_MAX_SLOTS) {
         return;
     }
     
-    // 这是一个通用的解析示例，实际格式取决于具体手柄
-    // 字节0-1: 按键状态
-    // 字节2-3: 左摇杆X,Y
-    // 字节4-5: 右摇杆X,Y
-    // 字节6-7: 扳机值
-    
-    if (xSemaphoreTake(state_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-        // 解析按键
-        uint16_t buttons = (data[1] << 8) | data[0];
-        current_state.buttons.button_a = (buttons & 0x0001) != 0;
-        current_state.buttons.button_b = (buttons & 0x0002) != 0;
-        current_state.buttons.button_x = (buttons & 0x0004) != 0;
-        current_state.buttons.button_y = (buttons & 0x0008) != 0;
-        current_state.buttons.button_l1 = (buttons & 0x0010) != 0;
-        current_state.buttons.button_r1 = (buttons & 0x0020) != 0;
-        current_state.buttons.button_select = (buttons & 0x0040) != 0;
-        current_state.buttons.button_start = (buttons & 0x0080) != 0;
-        
-        // 解析摇杆 (转换为-32768到32767范围)
-        current_state.sticks.left_x = (int16_t)((data[2] - 128) * 256);
-        current_state.sticks.left_y = (int16_t)((data[3] - 128) * 256);
-        current_state.sticks.right_x = (int16_t)((data[4] - 128) * 256);
-        current_state.sticks.right_y = (int16_t)((data[5] - 128) * 256);
-        
-        // 解析扳机
-        current_state.sticks.left_trigger = data[6];
-        current_state.sticks.right_trigger = data[7];
-        
-        // 更新时间戳
-        current_state.last_update = esp_timer_get_time() / 1000;
-        
-        xSemaphoreGive(state_mutex);
-        
-        ESP_LOGD(TAG, "Gamepad input: LX=%d, LY=%d, RX=%d, RY=%d, Buttons=0x%04x", 
-                 current_state.sticks.left_x, current_state.sticks.left_y,
-                 current_state.sticks.right_x, current_state.sticks.right_y, buttons);
+    const hid_report_map_t *map = atomic_load_explicit(&active_report_map[slot], memory_order_acquire);
+    if (map == NULL) {
+        return;
+    }
+    
+    hid_gamepad_report_t report;
+    esp_err_t ret = hid_report_map_extract(map, input->report_id, input->data, input->len, &report);
+    if (ret == ESP_ERR_INVALID_SIZE) {
+        ESP_LOGW(TAG, "Input data too short: %d bytes", input->len);
+        return;
     }
+    if (ret != ESP_OK) {
+        return;  // 非手柄数据报告（电量、触摸板等）
+    }
+    
+    // 先在栈上完成解析，再一次性发布，缩短写临界区
+    // 按键位号、轴和扳机顺序与提取器一一对应，直接发布
+    uint32_t buttons = report.buttons;
+    
+    int64_t now_us = input->timestamp_us;
+    uint32_t now_ms = now_us / 1000;
+    
+    // 摇杆滤波：按报告到达时间逐轴平滑，车辆控制只看到滤波后的值
+    stick_filter_process(slot, report.axes, now_us);
+    
+    // 发布新状态：写者从不等待，报告不会再因争用而丢弃
+    state_write_begin();
+    current_slots.buttons[slot] = buttons;
+    memcpy(current_slots.axes[slot], report.axes, sizeof(current_slots.axes[slot]));
+    memcpy(current_slots.triggers[slot], report.triggers, sizeof(current_slots.triggers[slot]));
+    current_slots.last_update[slot] = now_ms;
+    current_slots.input_time_us[slot] = now_us;
+    current_slots.input_seq[slot] = input->seq;
+    state_write_end();
+    
+    // 组合键每个报告评估一次，紧急停止在此直接执行（任一槽位都可触发）
+    button_combo_process(slot, buttons, now_us);
+    
+    // 事件驱动模式：新报告到达立即唤醒控制任务
+    if (pipeline_mode == GAMEPAD_PIPELINE_EVENT && output_task_handle != NULL) {
+        xTaskNotifyGive(output_task_handle);
+    }
+    
+    ESP_LOGD(TAG, "Gamepad %d input: LX=%d, LY=%d, RX=%d, RY=%d, Buttons=0x%04" PRIx32, slot,
+             report.axes[HID_GAMEPAD_AXIS_LX], report.axes[HID_GAMEPAD_AXIS_LY],
+             report.axes[HID_GAMEPAD_AXIS_RX], report.axes[HID_GAMEPAD_AXIS_RY], buttons);
 }
 
 /**
- * @brief HID输入数据回调函数
+ * @brief 回放报告回调：与真实报告走同一条解析路径
  */
-static void hid_input_callback(hid_device_info_t *device, hid_input_report_t *report)
+static void replay_report_callback(uint8_t slot, uint8_t report_id, const uint8_t *data, uint16_t len)
 {
-    ESP_LOGD(TAG, "HID input received: len=%d", report->len);
+    if (slot >= GAMEPAD_MAX_SLOTS) {
+        return;
+    }
     
-    if (report->data && report->len > 0) {
-        parse_gamepad_input(report->data, report->len);
+    uint8_t bit = 1u << slot;
+    if ((atomic_fetch_or(&replay_slot_mask, bit) & bit) == 0) {
+        state_write_begin();
+        current_slots.connected_mask |= bit;
+        state_write_end();
+    }
+    
+    submit_report(slot, report_id, data, len, HID_REPORT_FLAG_REPLAY);
+}
+
+/**
+ * @brief 回放结束回调：清除回放注入的槽位
+ */
+static void replay_done_callback(void)
+{
+    uint8_t mask = atomic_exchange(&replay_slot_mask, 0);
+    for (uint32_t m = mask; m; m &= m - 1) {
+        clear_slot(__builtin_ctz(m));
     }
 }
 /**
@@ -180,58 +600,205 @@ static void gamepad_input_task(void *parameter)
     ESP_LOGI(TAG, "Gamepad input task started");
     
     TickType_t last_wake_time = xTaskGetTickCount();
+    const TickType_t interval = pdMS_TO_TICKS(GAMEPAD_UPDATE_INTERVAL_MS);
     
     while (1) {
+        // 等待新报告，最长等到下一次连接状态检查
+        TickType_t elapsed = xTaskGetTickCount() - last_wake_time;
+        ulTaskNotifyTake(pdTRUE, elapsed < interval ? interval - elapsed : 0);
+        
+        hid_report_buf_t *buf;
+        while ((buf = hid_report_queue_pop(&input_queue)) != NULL) {
+            process_report(buf);
+            hid_report_pool_release(buf);
+        }
+        apply_slot_clears();
+        
+        if (xTaskGetTickCount() - last_wake_time < interval) {
+            continue;
+        }
+        last_wake_time += interval;
+        
         // 检查蓝牙连接状态
-        if (xSemaphoreTake(state_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-            // 更新连接状态
-            current_state.connected = bluetooth_hid_is_connected();
-            
-            // 更新时间戳
-            if (current_state.connected) {
-                current_state.last_update = esp_timer_get_time() / 1000;
-            }
-            
-            xSemaphoreGive(state_mutex);
+        uint8_t connected_mask = bluetooth_hid_get_connected_mask() | atomic_load(&replay_slot_mask);
+        uint32_t now_ms = esp_timer_get_time() / 1000;
+        
+        state_write_begin();
+        current_slots.connected_mask = connected_mask;
+        for (uint32_t m = connected_mask; m; m &= m - 1) {
+            current_slots.last_update[__builtin_ctz(m)] = now_ms;
         }
+        state_write_end();
+    }
+}
+
+/**
+ * @brief 等待下一个控制周期
+ *
+ * 轮询模式按固定周期运行；事件驱动模式等待输入报告通知，
+ * 两次执行之间至少间隔CONTROL_MIN_INTERVAL_MS，无报告时CONTROL_FALLBACK_TIMEOUT_MS后兜底运行。
+ */
+static void wait_for_next_cycle(TickType_t *last_wake_time)
+{
+    if (pipeline_mode == GAMEPAD_PIPELINE_EVENT) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONTROL_FALLBACK_TIMEOUT_MS));
         
+        // 速率上限：距上次执行不足最小间隔时补足剩余时间
+        TickType_t elapsed = xTaskGetTickCount() - *last_wake_time;
+        if (elapsed < pdMS_TO_TICKS(CONTROL_MIN_INTERVAL_MS)) {
+            vTaskDelay(pdMS_TO_TICKS(CONTROL_MIN_INTERVAL_MS) - elapsed);
+        }
+        *last_wake_time = xTaskGetTickCount();
+    } else {
         // 精确的任务调度
-        vTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS(GAMEPAD_UPDATE_INTERVAL_MS));
+        vTaskDelayUntil(last_wake_time, pdMS_TO_TICKS(CONTROL_UPDATE_INTERVAL_MS));
     }
 }
 
 /**
- * @brief 控制输出处理任务
+ * @brief 计算各槽位的按键边沿，发布主槽位的边沿
+ */
+static void update_button_edges(const gamepad_snapshot_t *snapshot, uint32_t prev_buttons[GAMEPAD_MAX_SLOTS])
+{
+    uint8_t primary = primary_slot(snapshot->connected_mask);
+    
+    for (int slot = 0; slot < GAMEPAD_MAX_SLOTS; slot++) {
+        uint32_t buttons = snapshot->buttons[slot];
+        if (slot == primary) {
+            gamepad_button_edges_t edges;
+            gamepad_buttons_compute_edges(prev_buttons[slot], buttons, &edges);
+            publish_button_edges(&edges);
+        }
+        prev_buttons[slot] = buttons;
+    }
+}
+
+/**
+ * @brief 计算一个槽位在各通道上的控制量
+ *
+ * 死区、曲线和缩放一次查表完成，摇杆通道输出-1000到1000，油门通道0到1000。
+ */
+static void compute_slot_channels(control_mode_t mode, const gamepad_snapshot_t *snapshot, uint8_t slot,
+                                  int16_t out[GAMEPAD_CHANNEL_COUNT])
+{
+    const int16_t *axes = snapshot->axes[slot];
+    int16_t stick_x, stick_y;
+    stick_conditioning_apply(axes[GAMEPAD_AXIS_LX], axes[GAMEPAD_AXIS_LY], &stick_x, &stick_y);
+    
+    // 小车用左摇杆Y轴控制前进/后退，飞机用右扳机控制油门（转换到0-1000）
+    out[GAMEPAD_CHANNEL_THROTTLE] = (mode == CONTROL_MODE_PLANE) ?
+        snapshot->triggers[slot][GAMEPAD_TRIGGER_RIGHT] * 4 : -stick_y;
+    out[GAMEPAD_CHANNEL_STEERING] = stick_x;
+    out[GAMEPAD_CHANNEL_PITCH] = -stick_y;
+    out[GAMEPAD_CHANNEL_YAW] = stick_conditioning_apply_axis(axes[GAMEPAD_AXIS_RX]);
+    out[GAMEPAD_CHANNEL_BRAKE] = gamepad_button_is_down(snapshot->buttons[slot], GAMEPAD_BUTTON_B); // B键刹车
+}
+
+/**
+ * @brief 按通道映射规则从各槽位选出每个通道的控制量
+ */
+static void resolve_channels(control_mode_t mode, const gamepad_snapshot_t *snapshot,
+                             int16_t out[GAMEPAD_CHANNEL_COUNT])
+{
+    const gamepad_channel_map_t *map = atomic_load_explicit(&active_channel_map, memory_order_acquire);
+    if (map == NULL) {
+        map = &default_channel_map;
+    }
+    
+    uint8_t connected = snapshot->connected_mask;
+    int16_t values[GAMEPAD_MAX_SLOTS][GAMEPAD_CHANNEL_COUNT];
+    for (uint32_t m = connected; m; m &= m - 1) {
+        uint8_t slot = __builtin_ctz(m);
+        compute_slot_channels(mode, snapshot, slot, values[slot]);
+    }
+    
+    // 接管槽位：按住接管键时接管全部通道，未配置接管键时按通道离开死区接管
+    uint8_t trainer = map->override_slot;
+    bool trainer_connected = trainer < GAMEPAD_MAX_SLOTS && (connected & (1u << trainer));
+    bool trainer_all = trainer_connected && map->override_buttons != 0 &&
+                       (snapshot->buttons[trainer] & map->override_buttons) != 0;
+    
+    for (int ch = 0; ch < GAMEPAD_CHANNEL_COUNT; ch++) {
+        uint8_t slot = map->channel_slot[ch];
+        if (trainer_all ||
+            (trainer_connected && map->override_buttons == 0 && values[trainer][ch] != 0)) {
+            slot = trainer;
+        }
+        out[ch] = (slot < GAMEPAD_MAX_SLOTS && (connected & (1u << slot))) ? values[slot][ch] : 0;
+    }
+}
+
+/**
+ * @brief 已连接槽位中最近一次输入报告的序号和到达时间
  */
+static void latest_input(const gamepad_snapshot_t *snapshot, uint32_t *seq, int64_t *time_us)
+{
+    *seq = 0;
+    *time_us = 0;
+    for (uint32_t m = snapshot->connected_mask; m; m &= m - 1) {
+        int slot = __builtin_ctz(m);
+        if (snapshot->input_time_us[slot] > *time_us) {
+            *time_us = snapshot->input_time_us[slot];
+            *seq = snapshot->input_seq[slot];
+        }
+    }
+}
+
 /**
  * @brief 控制输出处理任务
  */
 static void control_output_task(void *parameter)
 {
-    ESP_LOGI(TAG, "Control output task started");
+    ESP_LOGI(TAG, "Control output task started (%s mode)",
+             pipeline_mode == GAMEPAD_PIPELINE_EVENT ? "event" : "polled");
     
     TickType_t last_wake_time = xTaskGetTickCount();
+    uint32_t prev_buttons[GAMEPAD_MAX_SLOTS] = {0};
     
     while (1) {
-        gamepad_state_t state;
-        if (gamepad_controller_get_state(&state) == ESP_OK && state.connected) {
+        // 一次读取所有槽位，各通道取值来自同一时刻的快照
+        gamepad_snapshot_t snapshot;
+        state_read(&snapshot);
+        
+        if (snapshot.connected_mask != 0) {
+            update_button_edges(&snapshot, prev_buttons);
+            
+            handle_pending_actions();
             
-            switch (current_mode) {
+            // 输出带上驱动它的最新报告标记，PWM更新时记录端到端延迟
+            uint32_t input_seq;
+            int64_t input_time_us;
+            latest_input(&snapshot, &input_seq, &input_time_us);
+            
+            control_mode_t mode = current_mode;
+            int16_t channels[GAMEPAD_CHANNEL_COUNT] = {0};
+            if (mode != CONTROL_MODE_DISABLED) {
+                resolve_channels(mode, &snapshot, channels);
+            }
+            
+            switch (mode) {
                 case CONTROL_MODE_CAR:
                     {
                         // 小车控制逻辑
                         car_control_params_t car_params;
                         
-                        // 左摇杆控制前进/后退和转向
-                        car_params.forward_speed = -state.sticks.left_y / 32;  // 转换到-1000到1000
-                        car_params.turn_speed = state.sticks.left_x / 32;      // 转换到-1000到1000
-                        car_params.brake_enable = state.buttons.button_b;      // B键刹车
+                        car_params.forward_speed = channels[GAMEPAD_CHANNEL_THROTTLE];
+                        car_params.turn_speed = apply_trim(channels[GAMEPAD_CHANNEL_STEERING], trim_roll);
+                        car_params.brake_enable = channels[GAMEPAD_CHANNEL_BRAKE] != 0;
+                        car_params.input_seq = input_seq;
+                        car_params.input_time_us = input_time_us;
                         
                         car_control_set_motion(&car_params);
                         
                         // 转向时的震动反馈
                         if (abs(car_params.turn_speed) > 500) {
-                            vibration_dual_motor(50, 50, 50);
+                            vibration_params_t rumble = {
+                                .left_intensity = 50,
+                                .right_intensity = 50,
+                                .duration_ms = 50,
+                                .mode = VIBRATION_MODE_CONTINUOUS
+                            };
+                            vibration_play(HAPTIC_SOURCE_DRIVE, &rumble, &haptic_mix_drive);
                         }
                         
                         ESP_LOGD(TAG, "Car control: forward=%d, turn=%d, brake=%d", 
@@ -244,24 +811,21 @@ static void control_output_task(void *parameter)
                         // 飞机控制逻辑
                         plane_control_params_t plane_params;
                         
-                        // 右扳机控制油门 (0-1000)
-                        plane_params.throttle = state.sticks.right_trigger * 4; // 转换到0-1000
-                        
-                        // 左摇杆控制升降舵和副翼
-                        plane_params.elevator = -state.sticks.left_y / 32;  // 转换到-1000到1000
-                        plane_params.aileron = state.sticks.left_x / 32;    // 转换到-1000到1000
+                        // 按住油门切断组合键期间油门保持为0
+                        plane_params.throttle = channels[GAMEPAD_CHANNEL_THROTTLE];
+                        if (button_combo_get_active_actions() &
+                            BUTTON_COMBO_ACTION_BIT(BUTTON_COMBO_ACTION_THROTTLE_CUT)) {
+                            plane_params.throttle = 0;
+                        }
                         
-                        // 右摇杆X轴控制方向舵
-                        plane_params.rudder = state.sticks.right_x / 32;    // 转换到-1000到1000
+                        plane_params.elevator = apply_trim(channels[GAMEPAD_CHANNEL_PITCH], trim_pitch);
+                        plane_params.aileron = apply_trim(channels[GAMEPAD_CHANNEL_STEERING], trim_roll);
+                        plane_params.rudder = channels[GAMEPAD_CHANNEL_YAW];
+                        plane_params.input_seq = input_seq;
+                        plane_params.input_time_us = input_time_us;
                         
                         plane_control_set_params(&plane_params);
                         
-                        // 紧急停止
-                        if (state.buttons.button_y) {
-                            plane_control_emergency_stop();
-                            vibration_quick_pulse(255, 500); // 紧急停止震动提示
-                        }
-                        
                         ESP_LOGD(TAG, "Plane control: throttle=%d, elevator=%d, rudder=%d, aileron=%d", 
                                  plane_params.throttle, plane_params.elevator, 
                                  plane_params.rudder, plane_params.aileron);
@@ -275,17 +839,15 @@ static void control_output_task(void *parameter)
                     break;
             }
             
-            // 模式切换检测
-            if (state.buttons.button_select) {
-                // Select键切换模式
-                control_mode_t new_mode = (current_mode + 1) % 3;
-                gamepad_controller_set_mode(new_mode);
-                vibration_quick_pulse(100, 100); // 模式切换提示
+            // 紧急停止可能在本周期输出期间触发，重新停止以免被本周期的输出覆盖
+            if (mode != CONTROL_MODE_DISABLED && current_mode == CONTROL_MODE_DISABLED) {
+                emergency_stop_outputs();
             }
             
         } else {
-            // 手柄未连接或获取状态失败
+            // 没有手柄连接
             ESP_LOGD(TAG, "Gamepad not connected");
+            memset(prev_buttons, 0, sizeof(prev_buttons));
             
             // 确保所有输出都停止
             if (current_mode == CONTROL_MODE_CAR) {
@@ -295,8 +857,7 @@ static void control_output_task(void *parameter)
             }
         }
         
-        // 精确的任务调度
-        vTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS(CONTROL_UPDATE_INTERVAL_MS));
+        wait_for_next_cycle(&last_wake_time);
     }
 }
 
@@ -305,9 +866,9 @@ static void control_output_task(void *parameter)
  */
 static void init_gamepad_state(void)
 {
-    memset(&current_state, 0, sizeof(current_state));
-    current_state.connected = false;
-    current_state.last_update = 0;
+    state_write_begin();
+    memset(&current_slots, 0, sizeof(current_slots));
+    state_write_end();
 }
 
 esp_err_t gamepad_controller_init(void)
@@ -315,28 +876,51 @@ esp_err_t gamepad_controller_init(void)
     ESP_LOGI(TAG, "Initializing gamepad controller...");
     
     // 检查是否已经初始化
-    if (state_mutex != NULL) {
+    if (initialized) {
         ESP_LOGW(TAG, "Gamepad controller already initialized");
         return ESP_OK;
     }
     
-    // 创建互斥锁
-    state_mutex = xSemaphoreCreateMutex();
-    if (state_mutex == NULL) {
-        ESP_LOGE(TAG, "Failed to create state mutex");
-        return ESP_ERR_NO_MEM;
-    }
-    
     // 初始化状态
     init_gamepad_state();
     current_mode = CONTROL_MODE_DISABLED;
     
+    // 未连接前各槽位使用通用布局，兼容不带描述符的数据事件
+    esp_err_t ret = hid_report_map_compile_builtin(HID_CONTROLLER_GENERIC, &report_maps[0][0]);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to compile default report map: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    for (int slot = 0; slot < GAMEPAD_MAX_SLOTS; slot++) {
+        report_maps[slot][0] = report_maps[0][0];
+        atomic_store_explicit(&active_report_map[slot], &report_maps[slot][0], memory_order_release);
+    }
+    
+    channel_maps[0] = default_channel_map;
+    atomic_store_explicit(&active_channel_map, &channel_maps[0], memory_order_release);
+    
+    // 摇杆滤波和调理使用默认参数，配置文件加载后再更新
+    stick_filter_init();
+    stick_conditioning_init();
+    
+    // 组合键使用默认表，紧急停止按键由配置文件覆盖
+    button_combo_init(combo_action_callback);
+    ret = button_combo_set_table(gamepad_default_combos, GAMEPAD_DEFAULT_COMBO_COUNT);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set default combo table: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    // 录制与回放，录制由配置文件开启
+    hid_trace_init(replay_report_callback, replay_done_callback);
+    
     // 初始化蓝牙HID
-    esp_err_t ret = bluetooth_hid_init(hid_event_callback, hid_input_callback);
+    // 输入报告经队列交给输入任务，任务创建前到达的报告先在队列中等待
+    hid_report_queue_init(&input_queue, GAMEPAD_INPUT_QUEUE_DEPTH, NULL);
+    bluetooth_hid_add_report_queue(&input_queue);
+    ret = bluetooth_hid_init(hid_event_callback, NULL);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize Bluetooth HID: %s", esp_err_to_name(ret));
-        vSemaphoreDelete(state_mutex);
-        state_mutex = NULL;
         return ret;
     }
     
@@ -345,19 +929,20 @@ esp_err_t gamepad_controller_init(void)
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize vibration: %s", esp_err_to_name(ret));
         bluetooth_hid_deinit();
-        vSemaphoreDelete(state_mutex);
-        state_mutex = NULL;
         return ret;
     }
     
+    // 片段库是可选的，没有时使用内置效果
+    if (haptic_clip_bank_load_partition(NULL) == ESP_OK) {
+        haptic_clip_connect = haptic_clip_find("connect");
+    }
+    
     // 初始化小车控制
     ret = car_control_init(&default_car_config);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize car control: %s", esp_err_to_name(ret));
         vibration_deinit();
         bluetooth_hid_deinit();
-        vSemaphoreDelete(state_mutex);
-        state_mutex = NULL;
         return ret;
     }
     
@@ -368,17 +953,9 @@ esp_err_t gamepad_controller_init(void)
         car_control_deinit();
         vibration_deinit();
         bluetooth_hid_deinit();
-        vSemaphoreDelete(state_mutex);
-        state_mutex = NULL;
         return ret;
     }
     
-    // 开始扫描手柄
-    ret = bluetooth_hid_start_scan(30); // 扫描30秒
-    if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "Failed to start HID scan: %s", esp_err_to_name(ret));
-    }
-    
     // 创建输入处理任务
     BaseType_t task_ret = xTaskCreate(
         gamepad_input_task,
@@ -395,10 +972,10 @@ esp_err_t gamepad_controller_init(void)
         car_control_deinit();
         vibration_deinit();
         bluetooth_hid_deinit();
-        vSemaphoreDelete(state_mutex);
-        state_mutex = NULL;
         return ESP_ERR_NO_MEM;
     }
+    hid_report_queue_set_notify(&input_queue, input_task_handle);
+    xTaskNotifyGive(input_task_handle);
     
     // 创建控制输出任务
     task_ret = xTaskCreate(
@@ -417,11 +994,10 @@ esp_err_t gamepad_controller_init(void)
         car_control_deinit();
         vibration_deinit();
         bluetooth_hid_deinit();
-        vSemaphoreDelete(state_mutex);
-        state_mutex = NULL;
         return ESP_ERR_NO_MEM;
     }
     
+    initialized = true;
     ESP_LOGI(TAG, "Gamepad controller initialized successfully");
     ESP_LOGI(TAG, "Input task priority: %d, Output task priority: %d", 
              GAMEPAD_INPUT_TASK_PRIORITY, CONTROL_OUTPUT_TASK_PRIORITY);
@@ -474,20 +1050,184 @@ control_mode_t gamepad_controller_get_mode(void)
     return current_mode;
 }
 
+esp_err_t gamepad_controller_set_pipeline_mode(gamepad_pipeline_mode_t mode)
+{
+    if (mode != GAMEPAD_PIPELINE_POLLED && mode != GAMEPAD_PIPELINE_EVENT) {
+        ESP_LOGE(TAG, "Invalid pipeline mode: %d", mode);
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if (mode == pipeline_mode) {
+        return ESP_OK;
+    }
+    
+    ESP_LOGI(TAG, "Switching control pipeline to %s mode",
+             mode == GAMEPAD_PIPELINE_EVENT ? "event" : "polled");
+    pipeline_mode = mode;
+    system_monitor_reset_latency();
+    
+    // 唤醒可能正在等待通知的控制任务，使新模式立即生效
+    if (output_task_handle != NULL) {
+        xTaskNotifyGive(output_task_handle);
+    }
+    
+    return ESP_OK;
+}
+
+gamepad_pipeline_mode_t gamepad_controller_get_pipeline_mode(void)
+{
+    return pipeline_mode;
+}
+
+esp_err_t gamepad_controller_get_latency_stats(gamepad_latency_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // 延迟由执行器在PWM更新后记录到系统监控，这里只是按调度模式转述
+    performance_stats_t perf;
+    esp_err_t ret = system_monitor_get_performance_stats(&perf);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    stats->mode = pipeline_mode;
+    stats->samples = perf.latency_samples;
+    stats->p50_us = perf.latency_p50_us;
+    stats->p90_us = perf.latency_p90_us;
+    stats->p99_us = perf.latency_p99_us;
+    stats->max_us = perf.latency_max_us;
+    
+    return ESP_OK;
+}
+
 esp_err_t gamepad_controller_get_state(gamepad_state_t *state)
 {
     if (state == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    if (xSemaphoreTake(state_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-        memcpy(state, &current_state, sizeof(gamepad_state_t));
-        xSemaphoreGive(state_mutex);
-        return ESP_OK;
+    gamepad_snapshot_t snapshot;
+    state_read(&snapshot);
+    snapshot_to_state(&snapshot, primary_slot(snapshot.connected_mask), state);
+    state->connected = snapshot.connected_mask != 0;
+    return ESP_OK;
+}
+
+esp_err_t gamepad_controller_get_slot_state(uint8_t slot, gamepad_state_t *state)
+{
+    if (state == NULL || slot >= GAMEPAD_MAX_SLOTS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    gamepad_snapshot_t snapshot;
+    state_read(&snapshot);
+    snapshot_to_state(&snapshot, slot, state);
+    return ESP_OK;
+}
+
+esp_err_t gamepad_controller_get_all_states(gamepad_snapshot_t *snapshot)
+{
+    if (snapshot == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    state_read(snapshot);
+    return ESP_OK;
+}
+
+esp_err_t gamepad_controller_set_channel_map(const gamepad_channel_map_t *map)
+{
+    if (map == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    for (int ch = 0; ch < GAMEPAD_CHANNEL_COUNT; ch++) {
+        if (map->channel_slot[ch] >= GAMEPAD_MAX_SLOTS) {
+            ESP_LOGE(TAG, "Invalid slot %d for channel %d", map->channel_slot[ch], ch);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    if ((map->override_slot >= GAMEPAD_MAX_SLOTS && map->override_slot != GAMEPAD_SLOT_NONE) ||
+        (map->override_buttons >> GAMEPAD_BUTTON_COUNT) != 0) {
+        ESP_LOGE(TAG, "Invalid override: slot=%d, buttons=0x%04" PRIx32,
+                 map->override_slot, map->override_buttons);
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    const gamepad_channel_map_t *current = atomic_load_explicit(&active_channel_map, memory_order_relaxed);
+    gamepad_channel_map_t *next = (current == &channel_maps[0]) ? &channel_maps[1] : &channel_maps[0];
+    *next = *map;
+    atomic_store_explicit(&active_channel_map, next, memory_order_release);
+    
+    ESP_LOGI(TAG, "Channel map updated: slots=[%d,%d,%d,%d,%d], override slot=%d",
+             map->channel_slot[GAMEPAD_CHANNEL_THROTTLE], map->channel_slot[GAMEPAD_CHANNEL_STEERING],
+             map->channel_slot[GAMEPAD_CHANNEL_PITCH], map->channel_slot[GAMEPAD_CHANNEL_YAW],
+             map->channel_slot[GAMEPAD_CHANNEL_BRAKE], map->override_slot);
+    return ESP_OK;
+}
+
+esp_err_t gamepad_controller_get_channel_map(gamepad_channel_map_t *map)
+{
+    if (map == NULL) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    ESP_LOGW(TAG, "Failed to acquire state mutex");
-    return ESP_ERR_TIMEOUT;
+    const gamepad_channel_map_t *current = atomic_load_explicit(&active_channel_map, memory_order_acquire);
+    *map = current ? *current : default_channel_map;
+    return ESP_OK;
+}
+
+void gamepad_buttons_unpack(uint32_t buttons, gamepad_buttons_t *out)
+{
+    if (!out) {
+        return;
+    }
+    
+    out->button_a = gamepad_button_is_down(buttons, GAMEPAD_BUTTON_A);
+    out->button_b = gamepad_button_is_down(buttons, GAMEPAD_BUTTON_B);
+    out->button_x = gamepad_button_is_down(buttons, GAMEPAD_BUTTON_X);
+    out->button_y = gamepad_button_is_down(buttons, GAMEPAD_BUTTON_Y);
+    out->button_l1 = gamepad_button_is_down(buttons, GAMEPAD_BUTTON_L1);
+    out->button_r1 = gamepad_button_is_down(buttons, GAMEPAD_BUTTON_R1);
+    out->button_l2 = gamepad_button_is_down(buttons, GAMEPAD_BUTTON_L2);
+    out->button_r2 = gamepad_button_is_down(buttons, GAMEPAD_BUTTON_R2);
+    out->button_select = gamepad_button_is_down(buttons, GAMEPAD_BUTTON_SELECT);
+    out->button_start = gamepad_button_is_down(buttons, GAMEPAD_BUTTON_START);
+    out->button_home = gamepad_button_is_down(buttons, GAMEPAD_BUTTON_HOME);
+    out->dpad_up = gamepad_button_is_down(buttons, GAMEPAD_BUTTON_DPAD_UP);
+    out->dpad_down = gamepad_button_is_down(buttons, GAMEPAD_BUTTON_DPAD_DOWN);
+    out->dpad_left = gamepad_button_is_down(buttons, GAMEPAD_BUTTON_DPAD_LEFT);
+    out->dpad_right = gamepad_button_is_down(buttons, GAMEPAD_BUTTON_DPAD_RIGHT);
+}
+
+esp_err_t gamepad_controller_get_buttons(gamepad_buttons_t *buttons)
+{
+    if (!buttons) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    gamepad_state_t state;
+    esp_err_t ret = gamepad_controller_get_state(&state);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    gamepad_buttons_unpack(state.buttons, buttons);
+    return ESP_OK;
+}
+
+esp_err_t gamepad_controller_get_button_edges(gamepad_button_edges_t *edges)
+{
+    if (!edges) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    portENTER_CRITICAL(&button_edges_lock);
+    *edges = last_button_edges;
+    portEXIT_CRITICAL(&button_edges_lock);
+    return ESP_OK;
 }
 
 esp_err_t gamepad_controller_vibrate(const vibration_params_t *params)
@@ -510,16 +1250,17 @@ esp_err_t gamepad_controller_stop_vibration(void)
 
 bool gamepad_controller_is_connected(void)
 {
-    gamepad_state_t state;
-    if (gamepad_controller_get_state(&state) == ESP_OK) {
-        return state.connected;
-    }
-    return false;
+    gamepad_snapshot_t snapshot;
+    state_read(&snapshot);
+    return snapshot.connected_mask != 0;
 }
 
 int8_t gamepad_controller_get_battery_level(void)
 {
-    // TODO: 实现电池电量检测
-    // 大多数手柄通过HID协议可以获取电池信息
-    return -1; // 暂时返回不支持
+    uint8_t slot = primary_slot(bluetooth_hid_get_connected_mask());
+    hid_battery_status_t status;
+    if (slot >= GAMEPAD_MAX_SLOTS || hid_battery_get(slot, &status) != ESP_OK) {
+        return HID_BATTERY_LEVEL_UNKNOWN;
+    }
+    return status.level;
 }
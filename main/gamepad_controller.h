@@ -25,7 +25,73 @@ typedef enum {
 } control_mode_t;
 
 /**
- * @brief 手柄按键状态结构体
+ * @brief 控制输出调度模式枚举
+ */
+typedef enum {
+    GAMEPAD_PIPELINE_POLLED = 0,  ///< 固定周期轮询（每CONTROL_UPDATE_INTERVAL_MS）
+    GAMEPAD_PIPELINE_EVENT        ///< 报告到达即唤醒控制任务（带速率上限和超时兜底）
+} gamepad_pipeline_mode_t;
+
+/**
+ * @brief 输入到PWM更新的延迟统计
+ */
+typedef struct {
+    gamepad_pipeline_mode_t mode; ///< 统计所属的调度模式
+    uint32_t samples;             ///< 样本数
+    uint32_t p50_us;              ///< 中位数延迟(微秒)
+    uint32_t p90_us;              ///< P90延迟(微秒)
+    uint32_t p99_us;              ///< P99延迟(微秒)
+    uint32_t max_us;              ///< 最大延迟(微秒)
+} gamepad_latency_stats_t;
+
+/**
+ * @brief 同时连接的手柄数上限
+ */
+#define GAMEPAD_MAX_SLOTS        4
+
+/**
+ * @brief 无效槽位（通道映射中表示不启用）
+ */
+#define GAMEPAD_SLOT_NONE        0xFF
+
+/**
+ * @brief 按键位号（gamepad_state_t.buttons中的位）
+ */
+typedef enum {
+    GAMEPAD_BUTTON_A = 0,        ///< A键
+    GAMEPAD_BUTTON_B,            ///< B键
+    GAMEPAD_BUTTON_X,            ///< X键
+    GAMEPAD_BUTTON_Y,            ///< Y键
+    GAMEPAD_BUTTON_L1,           ///< L1键
+    GAMEPAD_BUTTON_R1,           ///< R1键
+    GAMEPAD_BUTTON_L2,           ///< L2键
+    GAMEPAD_BUTTON_R2,           ///< R2键
+    GAMEPAD_BUTTON_SELECT,       ///< 选择键
+    GAMEPAD_BUTTON_START,        ///< 开始键
+    GAMEPAD_BUTTON_HOME,         ///< Home键
+    GAMEPAD_BUTTON_DPAD_UP,      ///< 方向键上
+    GAMEPAD_BUTTON_DPAD_DOWN,    ///< 方向键下
+    GAMEPAD_BUTTON_DPAD_LEFT,    ///< 方向键左
+    GAMEPAD_BUTTON_DPAD_RIGHT,   ///< 方向键右
+    GAMEPAD_BUTTON_COUNT
+} gamepad_button_t;
+
+/**
+ * @brief 按键位掩码
+ */
+#define GAMEPAD_BUTTON_MASK(button)  (1UL << (button))
+
+/**
+ * @brief 按键边沿（一个控制周期内相对上一周期的变化）
+ */
+typedef struct {
+    uint32_t pressed;        ///< 本周期新按下的按键
+    uint32_t released;       ///< 本周期新松开的按键
+    uint32_t held;           ///< 上一周期和本周期都按下的按键
+} gamepad_button_edges_t;
+
+/**
+ * @brief 手柄按键状态结构体（兼容视图，由按键位图展开）
  */
 typedef struct {
     bool button_a;           ///< A键状态
@@ -57,18 +123,115 @@ typedef struct {
     uint8_t right_trigger;   ///< 右扳机 (0 to 255)
 } gamepad_sticks_t;
 
+/**
+ * @brief 摇杆轴编号（gamepad_snapshot_t.axes的第二维）
+ */
+typedef enum {
+    GAMEPAD_AXIS_LX = 0,         ///< 左摇杆X轴
+    GAMEPAD_AXIS_LY,             ///< 左摇杆Y轴
+    GAMEPAD_AXIS_RX,             ///< 右摇杆X轴
+    GAMEPAD_AXIS_RY,             ///< 右摇杆Y轴
+    GAMEPAD_AXIS_COUNT
+} gamepad_axis_t;
+
+/**
+ * @brief 扳机编号（gamepad_snapshot_t.triggers的第二维）
+ */
+typedef enum {
+    GAMEPAD_TRIGGER_LEFT = 0,    ///< 左扳机
+    GAMEPAD_TRIGGER_RIGHT,       ///< 右扳机
+    GAMEPAD_TRIGGER_COUNT
+} gamepad_trigger_t;
+
+/**
+ * @brief 所有槽位的手柄状态（结构数组布局）
+ *
+ * 同类字段按槽位连续存放，控制任务逐通道取值时访问的是相邻内存；
+ * 整个快照由一个序列锁保护，一次读取即得到所有槽位在同一时刻的状态。
+ */
+typedef struct {
+    uint8_t connected_mask;                                         ///< 已连接槽位位图
+    uint32_t buttons[GAMEPAD_MAX_SLOTS];                            ///< 各槽位按键位图
+    int16_t axes[GAMEPAD_MAX_SLOTS][GAMEPAD_AXIS_COUNT];            ///< 各槽位摇杆 (-32768 to 32767)
+    uint8_t triggers[GAMEPAD_MAX_SLOTS][GAMEPAD_TRIGGER_COUNT];     ///< 各槽位扳机 (0 to 255)
+    uint32_t last_update[GAMEPAD_MAX_SLOTS];                        ///< 各槽位最后更新时间戳
+    int64_t input_time_us[GAMEPAD_MAX_SLOTS];                       ///< 各槽位最近一次输入报告到达时间
+    uint32_t input_seq[GAMEPAD_MAX_SLOTS];                          ///< 各槽位最近一次输入报告序号
+} gamepad_snapshot_t;
+
+/**
+ * @brief 车辆控制通道
+ */
+typedef enum {
+    GAMEPAD_CHANNEL_THROTTLE = 0, ///< 小车前进/后退（左摇杆Y），飞机油门（右扳机）
+    GAMEPAD_CHANNEL_STEERING,     ///< 小车转向、飞机副翼（左摇杆X）
+    GAMEPAD_CHANNEL_PITCH,        ///< 飞机升降舵（左摇杆Y）
+    GAMEPAD_CHANNEL_YAW,          ///< 飞机方向舵（右摇杆X）
+    GAMEPAD_CHANNEL_BRAKE,        ///< 小车刹车（B键）
+    GAMEPAD_CHANNEL_COUNT
+} gamepad_channel_t;
+
+/**
+ * @brief 通道映射规则
+ *
+ * 每个通道由channel_slot指定的槽位驱动，可实现双人分别控制油门和方向。
+ * 启用接管槽位（教练）后：override_buttons非0时，接管槽位按住其中任一键即接管全部通道；
+ * override_buttons为0时，接管槽位的某个通道离开死区即接管该通道。
+ * 驱动槽位未连接的通道输出为0。
+ */
+typedef struct {
+    uint8_t channel_slot[GAMEPAD_CHANNEL_COUNT]; ///< 各通道的驱动槽位
+    uint8_t override_slot;                       ///< 接管槽位，GAMEPAD_SLOT_NONE表示不启用
+    uint32_t override_buttons;                   ///< 接管按键位图
+} gamepad_channel_map_t;
+
 /**
  * @brief 完整的手柄状态结构体
  */
 typedef struct {
-    gamepad_buttons_t buttons;
+    uint32_t buttons;        ///< 按键位图，位号见gamepad_button_t
     gamepad_sticks_t sticks;
     bool connected;          ///< 连接状态
     uint32_t last_update;    ///< 最后更新时间戳
+    int64_t input_time_us;   ///< 最近一次输入报告到达时间(esp_timer微秒)
 } gamepad_state_t;
 
+/**
+ * @brief 检查按键是否按下
+ * @param buttons 按键位图
+ * @param button 按键
+ * @return true 按下，false 未按下
+ */
+static inline bool gamepad_button_is_down(uint32_t buttons, gamepad_button_t button)
+{
+    return (buttons & GAMEPAD_BUTTON_MASK(button)) != 0;
+}
+
+/**
+ * @brief 根据相邻两个控制周期的按键位图计算边沿
+ * @param prev 上一周期按键位图
+ * @param cur 本周期按键位图
+ * @param edges 输出的按键边沿
+ */
+static inline void gamepad_buttons_compute_edges(uint32_t prev, uint32_t cur,
+                                                 gamepad_button_edges_t *edges)
+{
+    uint32_t changed = prev ^ cur;
+    edges->pressed = changed & cur;
+    edges->released = changed & prev;
+    edges->held = prev & cur;
+}
+
+/**
+ * @brief 把按键位图展开为兼容的按键结构体
+ * @param buttons 按键位图
+ * @param out 输出的按键结构体
+ */
+void gamepad_buttons_unpack(uint32_t buttons, gamepad_buttons_t *out);
+
 /**
  * @brief 初始化游戏手柄控制器
+ * @note 不主动发起连接：重连参数来自配置文件，加载后由调用者调用hid_reconnect_start
  * @return ESP_OK 成功，其他值表示错误
  */
 esp_err_t gamepad_controller_init(void);
@@ -87,12 +250,77 @@ esp_err_t gamepad_controller_set_mode(control_mode_t mode);
 control_mode_t gamepad_controller_get_mode(void);
 
 /**
- * @brief 获取当前手柄状态
- * @param state 输出的手柄状态
+ * @brief 设置控制输出调度模式
+ * @param mode 调度模式
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t gamepad_controller_set_pipeline_mode(gamepad_pipeline_mode_t mode);
+
+/**
+ * @brief 获取当前控制输出调度模式
+ * @return 当前调度模式
+ */
+gamepad_pipeline_mode_t gamepad_controller_get_pipeline_mode(void);
+
+/**
+ * @brief 获取输入报告到PWM更新的延迟分布（切换调度模式时清零）
+ * @param stats 输出的延迟统计
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t gamepad_controller_get_latency_stats(gamepad_latency_stats_t *stats);
+
+/**
+ * @brief 获取当前手柄状态（已连接槽位中槽位号最小的手柄）
+ * @note 无锁读取，不会阻塞；与HID报告写入并发时内部重试以保证快照一致
+ * @param state 输出的手柄状态，connected表示是否有任一手柄连接
  * @return ESP_OK 成功，其他值表示错误
  */
 esp_err_t gamepad_controller_get_state(gamepad_state_t *state);
 
+/**
+ * @brief 获取指定槽位的手柄状态
+ * @param slot 槽位 (0 to GAMEPAD_MAX_SLOTS-1)
+ * @param state 输出的手柄状态
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t gamepad_controller_get_slot_state(uint8_t slot, gamepad_state_t *state);
+
+/**
+ * @brief 一次无锁读取所有槽位的手柄状态
+ * @param snapshot 输出的状态快照
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t gamepad_controller_get_all_states(gamepad_snapshot_t *snapshot);
+
+/**
+ * @brief 设置通道映射规则
+ * @note 规则在空闲缓冲中准备好后原子切换，下一个控制周期生效
+ * @param map 通道映射规则
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t gamepad_controller_set_channel_map(const gamepad_channel_map_t *map);
+
+/**
+ * @brief 获取当前通道映射规则
+ * @param map 输出的通道映射规则
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t gamepad_controller_get_channel_map(gamepad_channel_map_t *map);
+
+/**
+ * @brief 获取当前按键状态（兼容接口）
+ * @param buttons 输出的按键结构体
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t gamepad_controller_get_buttons(gamepad_buttons_t *buttons);
+
+/**
+ * @brief 获取最近一个控制周期计算出的按键边沿（已连接槽位中槽位号最小的手柄）
+ * @param edges 输出的按键边沿
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t gamepad_controller_get_button_edges(gamepad_button_edges_t *edges);
+
 /**
  * @brief 发送震动反馈
  * @param params 震动参数
@@ -113,8 +341,9 @@ esp_err_t gamepad_controller_stop_vibration(void);
 bool gamepad_controller_is_connected(void);
 
 /**
- * @brief 获取手柄电池电量（如果支持）
- * @return 电池电量百分比 (0-100)，-1表示不支持
+ * @brief 获取主手柄（编号最小的已连接槽位）的电池电量
+ * @note 读取连接时解析缓存的值，不发起蓝牙传输；各槽位的完整状态见hid_battery_get
+ * @return 电池电量百分比 (0-100)，-1表示未连接或手柄未上报电量
  */
 int8_t gamepad_controller_get_battery_level(void);
 
@@ -0,0 +1,535 @@
+/**
+ * @file hid_trace.c
+ * @brief HID输入报告录制与回放实现
+ */
+
+#include "hid_trace.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "HID_TRACE";
+
+// 分段文件：两个分段轮流覆盖
+#define TRACE_SEGMENT_COUNT         2
+#define TRACE_SEGMENT_PATH          "/spiffs/hid_trace_%d.bin"
+#define TRACE_SEGMENT_MAX_BYTES     (192 * 1024)
+
+// 环形缓冲大小（2的幂），约可容纳1秒的4路高速报告
+#define TRACE_RING_SIZE             8192
+
+// 批量写入：攒够一个闪存页或超过间隔才写文件
+#define TRACE_BATCH_SIZE            4096
+#define TRACE_FLUSH_INTERVAL_MS     1000
+#define TRACE_POLL_INTERVAL_MS      50
+
+// 尽快回放时每隔多少条记录让出CPU
+#define TRACE_REPLAY_YIELD_EVERY    64
+
+// 任务参数
+#define TRACE_TASK_STACK_SIZE       4096
+#define TRACE_WRITER_PRIORITY       3
+#define TRACE_REPLAY_PRIORITY       8
+
+/**
+ * @brief 环形缓冲中的记录头
+ */
+typedef struct __attribute__((packed)) {
+    int64_t timestamp_us;
+    uint8_t slot;
+    uint8_t report_id;
+    uint16_t len;
+} ring_entry_t;
+
+/**
+ * @brief 带缓冲的分段读取器
+ */
+typedef struct {
+    FILE *file;
+    uint8_t buf[512];
+    size_t pos;
+    size_t len;
+    bool eof;
+} trace_reader_t;
+
+static hid_trace_report_cb_t report_callback = NULL;
+static hid_trace_done_cb_t done_callback = NULL;
+
+// 单生产者单消费者环形缓冲：计数器自由递增，差值即占用字节数
+static uint8_t ring[TRACE_RING_SIZE];
+static _Atomic uint32_t ring_head = 0;   // 输入回调写
+static _Atomic uint32_t ring_tail = 0;   // 写入任务写
+
+static volatile bool recording = false;
+static volatile bool replaying = false;
+static volatile bool replay_stop_requested = false;
+static TaskHandle_t writer_task_handle = NULL;
+static TaskHandle_t replay_task_handle = NULL;
+static uint16_t replay_speed_percent = 100;
+
+// 写入任务状态
+static FILE *segment_file = NULL;
+static int segment_index = 0;
+static uint32_t segment_sequence = 0;
+static uint32_t segment_bytes = 0;
+static int64_t last_record_us = 0;
+static uint8_t batch[TRACE_BATCH_SIZE];
+static size_t batch_len = 0;
+
+static _Atomic uint32_t stat_recorded = 0;
+static _Atomic uint32_t stat_dropped = 0;
+static _Atomic uint32_t stat_bytes = 0;
+static _Atomic uint32_t stat_replayed = 0;
+
+/**
+ * @brief 生成分段文件路径
+ */
+static void segment_path(int index, char *path, size_t size)
+{
+    snprintf(path, size, TRACE_SEGMENT_PATH, index);
+}
+
+/**
+ * @brief 读取分段文件头
+ */
+static bool read_segment_header(int index, hid_trace_file_header_t *header)
+{
+    char path[32];
+    segment_path(index, path, sizeof(path));
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+    bool ok = fread(header, sizeof(*header), 1, f) == 1 &&
+              header->magic == HID_TRACE_MAGIC && header->version == HID_TRACE_VERSION;
+    fclose(f);
+    return ok;
+}
+
+/**
+ * @brief 从环形缓冲拷贝数据（处理回绕）
+ */
+static void ring_copy_out(uint32_t pos, void *dst, size_t len)
+{
+    uint32_t offset = pos & (TRACE_RING_SIZE - 1);
+    size_t first = TRACE_RING_SIZE - offset;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(dst, &ring[offset], first);
+    memcpy((uint8_t *)dst + first, ring, len - first);
+}
+
+/**
+ * @brief 向环形缓冲拷贝数据（处理回绕）
+ */
+static void ring_copy_in(uint32_t pos, const void *src, size_t len)
+{
+    uint32_t offset = pos & (TRACE_RING_SIZE - 1);
+    size_t first = TRACE_RING_SIZE - offset;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(&ring[offset], src, first);
+    memcpy(ring, (const uint8_t *)src + first, len - first);
+}
+
+/**
+ * @brief 把批量缓冲写入当前分段
+ */
+static void flush_batch(void)
+{
+    if (batch_len == 0 || segment_file == NULL) {
+        batch_len = 0;
+        return;
+    }
+
+    size_t written = fwrite(batch, 1, batch_len, segment_file);
+    fflush(segment_file);
+    if (written != batch_len) {
+        ESP_LOGW(TAG, "Short write to trace segment: %d/%d", (int)written, (int)batch_len);
+    }
+    segment_bytes += written;
+    atomic_fetch_add_explicit(&stat_bytes, written, memory_order_relaxed);
+    batch_len = 0;
+}
+
+/**
+ * @brief 切换到下一个分段并写入文件头
+ */
+static esp_err_t open_next_segment(int64_t base_time_us)
+{
+    if (segment_file) {
+        flush_batch();
+        fclose(segment_file);
+        segment_file = NULL;
+    }
+
+    segment_index = (segment_index + 1) % TRACE_SEGMENT_COUNT;
+    segment_sequence++;
+
+    char path[32];
+    segment_path(segment_index, path, sizeof(path));
+    segment_file = fopen(path, "wb");
+    if (!segment_file) {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        return ESP_FAIL;
+    }
+
+    hid_trace_file_header_t header = {
+        .magic = HID_TRACE_MAGIC,
+        .version = HID_TRACE_VERSION,
+        .sequence = segment_sequence,
+        .base_time_us = base_time_us
+    };
+    fwrite(&header, sizeof(header), 1, segment_file);
+    segment_bytes = sizeof(header);
+    last_record_us = base_time_us;
+
+    ESP_LOGI(TAG, "Recording to %s (segment %lu)", path, (unsigned long)segment_sequence);
+    return ESP_OK;
+}
+
+/**
+ * @brief 取出环形缓冲中的所有记录并编码到批量缓冲
+ */
+static void drain_ring(void)
+{
+    uint32_t tail = atomic_load_explicit(&ring_tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring_head, memory_order_acquire);
+
+    while (tail != head) {
+        ring_entry_t entry;
+        uint8_t data[HID_TRACE_MAX_REPORT_LEN];
+        ring_copy_out(tail, &entry, sizeof(entry));
+        ring_copy_out(tail + sizeof(entry), data, entry.len);
+        tail += sizeof(entry) + entry.len;
+
+        // 分段写满时先换段，新分段的时间基准就是这条记录
+        if (segment_file == NULL ||
+            segment_bytes + batch_len + HID_TRACE_RECORD_MAX_BYTES > TRACE_SEGMENT_MAX_BYTES) {
+            if (open_next_segment(entry.timestamp_us) != ESP_OK) {
+                continue;
+            }
+        }
+        if (batch_len + HID_TRACE_RECORD_MAX_BYTES > TRACE_BATCH_SIZE) {
+            flush_batch();
+        }
+
+        int64_t delta = entry.timestamp_us - last_record_us;
+        last_record_us = entry.timestamp_us;
+        batch_len += hid_trace_encode_record(&batch[batch_len], delta > 0 ? (uint64_t)delta : 0,
+                                             entry.slot, entry.report_id, data, entry.len);
+        atomic_fetch_add_explicit(&stat_recorded, 1, memory_order_relaxed);
+    }
+
+    atomic_store_explicit(&ring_tail, tail, memory_order_release);
+}
+
+/**
+ * @brief 录制写入任务：定期取出环形缓冲，攒批后写入闪存
+ */
+static void trace_writer_task(void *parameter)
+{
+    ESP_LOGI(TAG, "Trace writer task started");
+
+    int64_t last_flush_us = esp_timer_get_time();
+
+    while (recording) {
+        vTaskDelay(pdMS_TO_TICKS(TRACE_POLL_INTERVAL_MS));
+        drain_ring();
+
+        int64_t now_us = esp_timer_get_time();
+        if (batch_len >= TRACE_BATCH_SIZE / 2 ||
+            (batch_len > 0 && now_us - last_flush_us >= (int64_t)TRACE_FLUSH_INTERVAL_MS * 1000)) {
+            flush_batch();
+            last_flush_us = now_us;
+        }
+    }
+
+    // 停止后写完剩余记录
+    drain_ring();
+    flush_batch();
+    if (segment_file) {
+        fclose(segment_file);
+        segment_file = NULL;
+    }
+
+    ESP_LOGI(TAG, "Trace writer task stopped: %lu reports, %lu dropped",
+             (unsigned long)atomic_load(&stat_recorded), (unsigned long)atomic_load(&stat_dropped));
+    writer_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief 读取下一条记录
+ * @param record 输出的记录，data在下一次读取前有效
+ * @return false 分段结束或遇到不完整的记录
+ */
+static bool reader_next(trace_reader_t *reader, hid_trace_record_t *record)
+{
+    // 缓冲中不足一条最长记录时，把剩余数据移到开头再补读
+    size_t remain = reader->len - reader->pos;
+    if (!reader->eof && remain < HID_TRACE_RECORD_MAX_BYTES) {
+        memmove(reader->buf, &reader->buf[reader->pos], remain);
+        size_t want = sizeof(reader->buf) - remain;
+        size_t got = fread(&reader->buf[remain], 1, want, reader->file);
+        reader->eof = got < want;
+        reader->len = remain + got;
+        reader->pos = 0;
+    }
+
+    size_t used = hid_trace_decode_record(&reader->buf[reader->pos], reader->len - reader->pos, record);
+    reader->pos += used;
+    return used > 0;
+}
+
+/**
+ * @brief 回放一个分段
+ * @param start_us 回放开始的本地时间
+ * @param trace_start_us 录制中第一条记录的时间
+ * @return false 被要求停止
+ */
+static bool replay_segment(int index, int64_t start_us, int64_t *trace_start_us)
+{
+    char path[32];
+    segment_path(index, path, sizeof(path));
+
+    trace_reader_t reader = { .file = fopen(path, "rb") };
+    if (!reader.file) {
+        return true;
+    }
+
+    hid_trace_file_header_t header;
+    if (fread(&header, sizeof(header), 1, reader.file) != 1) {
+        fclose(reader.file);
+        return true;
+    }
+
+    int64_t record_us = header.base_time_us;
+    if (*trace_start_us == 0) {
+        *trace_start_us = header.base_time_us;
+    }
+
+    uint32_t count = 0;
+    hid_trace_record_t record;
+
+    // 断电可能留下半条记录，读到不完整的记录即结束本分段
+    while (!replay_stop_requested && reader_next(&reader, &record)) {
+        record_us += (int64_t)record.delta_us;
+
+        if (replay_speed_percent > 0) {
+            // 按速度缩放录制时间，等待到目标时刻
+            int64_t target_us = start_us + (record_us - *trace_start_us) * 100 / replay_speed_percent;
+            int64_t wait_us = target_us - esp_timer_get_time();
+            if (wait_us >= 1000) {
+                TickType_t ticks = pdMS_TO_TICKS(wait_us / 1000);
+                vTaskDelay(ticks > 0 ? ticks : 1);
+            }
+        } else if (++count % TRACE_REPLAY_YIELD_EVERY == 0) {
+            vTaskDelay(1);
+        }
+
+        if (report_callback) {
+            report_callback(record.slot, record.report_id, record.data, record.len);
+        }
+        atomic_fetch_add_explicit(&stat_replayed, 1, memory_order_relaxed);
+    }
+
+    fclose(reader.file);
+    return !replay_stop_requested;
+}
+
+/**
+ * @brief 回放任务：按分段序号从旧到新回放
+ */
+static void trace_replay_task(void *parameter)
+{
+    hid_trace_file_header_t headers[TRACE_SEGMENT_COUNT];
+    bool valid[TRACE_SEGMENT_COUNT];
+    for (int i = 0; i < TRACE_SEGMENT_COUNT; i++) {
+        valid[i] = read_segment_header(i, &headers[i]);
+    }
+
+    ESP_LOGI(TAG, "Replay started at %d%% speed", replay_speed_percent);
+
+    int64_t start_us = esp_timer_get_time();
+    int64_t trace_start_us = 0;
+    bool played[TRACE_SEGMENT_COUNT] = {false};
+
+    for (int n = 0; n < TRACE_SEGMENT_COUNT; n++) {
+        int oldest = -1;
+        for (int i = 0; i < TRACE_SEGMENT_COUNT; i++) {
+            if (valid[i] && !played[i] && (oldest < 0 || headers[i].sequence < headers[oldest].sequence)) {
+                oldest = i;
+            }
+        }
+        if (oldest < 0) {
+            break;
+        }
+        played[oldest] = true;
+        if (!replay_segment(oldest, start_us, &trace_start_us)) {
+            break;
+        }
+    }
+
+    ESP_LOGI(TAG, "Replay finished: %lu reports", (unsigned long)atomic_load(&stat_replayed));
+
+    replaying = false;
+    replay_task_handle = NULL;
+    if (done_callback) {
+        done_callback();
+    }
+    vTaskDelete(NULL);
+}
+
+esp_err_t hid_trace_init(hid_trace_report_cb_t report_cb, hid_trace_done_cb_t done_cb)
+{
+    report_callback = report_cb;
+    done_callback = done_cb;
+
+    ESP_LOGI(TAG, "HID trace initialized");
+    return ESP_OK;
+}
+
+esp_err_t hid_trace_start_recording(void)
+{
+    if (recording || writer_task_handle != NULL) {
+        ESP_LOGW(TAG, "Already recording");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // 接着已有分段的序号，从较旧的分段开始覆盖
+    segment_sequence = 0;
+    segment_index = 0;
+    for (int i = 0; i < TRACE_SEGMENT_COUNT; i++) {
+        hid_trace_file_header_t header;
+        if (read_segment_header(i, &header) && header.sequence >= segment_sequence) {
+            segment_sequence = header.sequence;
+            segment_index = i;
+        }
+    }
+
+    batch_len = 0;
+    atomic_store(&ring_head, 0);
+    atomic_store(&ring_tail, 0);
+    atomic_store(&stat_recorded, 0);
+    atomic_store(&stat_dropped, 0);
+    atomic_store(&stat_bytes, 0);
+    recording = true;
+
+    BaseType_t ret = xTaskCreate(trace_writer_task, "hid_trace_wr", TRACE_TASK_STACK_SIZE,
+                                 NULL, TRACE_WRITER_PRIORITY, &writer_task_handle);
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create trace writer task");
+        recording = false;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "HID trace recording started");
+    return ESP_OK;
+}
+
+esp_err_t hid_trace_stop_recording(void)
+{
+    if (!recording) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    recording = false;
+    ESP_LOGI(TAG, "HID trace recording stopping");
+    return ESP_OK;
+}
+
+void hid_trace_record(uint8_t slot, uint8_t report_id, const uint8_t *data, uint16_t len, int64_t timestamp_us)
+{
+    if (!recording || data == NULL || len > HID_TRACE_MAX_REPORT_LEN) {
+        return;
+    }
+
+    uint32_t head = atomic_load_explicit(&ring_head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring_tail, memory_order_acquire);
+    size_t need = sizeof(ring_entry_t) + len;
+
+    if (TRACE_RING_SIZE - (head - tail) < need) {
+        atomic_fetch_add_explicit(&stat_dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    ring_entry_t entry = {
+        .timestamp_us = timestamp_us,
+        .slot = slot,
+        .report_id = report_id,
+        .len = len
+    };
+    ring_copy_in(head, &entry, sizeof(entry));
+    ring_copy_in(head + sizeof(entry), data, len);
+    atomic_store_explicit(&ring_head, head + need, memory_order_release);
+}
+
+esp_err_t hid_trace_start_replay(uint16_t speed_percent)
+{
+    if (replaying) {
+        ESP_LOGW(TAG, "Already replaying");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (recording) {
+        ESP_LOGW(TAG, "Stop recording before replay");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    bool found = false;
+    for (int i = 0; i < TRACE_SEGMENT_COUNT; i++) {
+        hid_trace_file_header_t header;
+        found |= read_segment_header(i, &header);
+    }
+    if (!found) {
+        ESP_LOGW(TAG, "No trace to replay");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    replay_speed_percent = speed_percent;
+    replay_stop_requested = false;
+    atomic_store(&stat_replayed, 0);
+    replaying = true;
+
+    BaseType_t ret = xTaskCreate(trace_replay_task, "hid_trace_rp", TRACE_TASK_STACK_SIZE,
+                                 NULL, TRACE_REPLAY_PRIORITY, &replay_task_handle);
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create trace replay task");
+        replaying = false;
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t hid_trace_stop_replay(void)
+{
+    if (!replaying) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    replay_stop_requested = true;
+    return ESP_OK;
+}
+
+esp_err_t hid_trace_get_stats(hid_trace_stats_t *stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    stats->recording = recording;
+    stats->replaying = replaying;
+    stats->recorded = atomic_load_explicit(&stat_recorded, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&stat_dropped, memory_order_relaxed);
+    stats->bytes_written = atomic_load_explicit(&stat_bytes, memory_order_relaxed);
+    stats->replayed = atomic_load_explicit(&stat_replayed, memory_order_relaxed);
+    return ESP_OK;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file hid_trace.h
+ * @brief HID输入报告录制与回放头文件
+ *
+ * 录制：输入回调把原始报告压入无锁环形缓冲，后台任务批量编码后写入SPIFFS，
+ * 输入回调从不等待文件系统。两个分段文件轮流覆盖，构成循环日志。
+ * 回放：按原始节奏或加速把记录重新送入报告解析路径，用于复现现场问题。
+ * 分段文件格式见hid_trace_format.h，主机端回放工具(host_test/hid_replay.c)读取同一格式。
+ */
+
+#ifndef HID_TRACE_H
+#define HID_TRACE_H
+
+#include "esp_err.h"
+#include "hid_trace_format.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 回放报告回调（在回放任务中调用）
+ */
+typedef void (*hid_trace_report_cb_t)(uint8_t slot, uint8_t report_id, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief 回放结束回调（正常结束或被停止时调用）
+ */
+typedef void (*hid_trace_done_cb_t)(void);
+
+/**
+ * @brief 录制与回放统计
+ */
+typedef struct {
+    bool recording;              ///< 正在录制
+    bool replaying;              ///< 正在回放
+    uint32_t recorded;           ///< 已写入的报告数
+    uint32_t dropped;            ///< 缓冲区满丢弃的报告数
+    uint32_t bytes_written;      ///< 已写入文件的字节数
+    uint32_t replayed;           ///< 已回放的报告数
+} hid_trace_stats_t;
+
+/**
+ * @brief 初始化录制与回放模块
+ * @param report_cb 回放报告回调
+ * @param done_cb 回放结束回调，可为NULL
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t hid_trace_init(hid_trace_report_cb_t report_cb, hid_trace_done_cb_t done_cb);
+
+/**
+ * @brief 开始录制（覆盖较旧的分段）
+ * @note 需要SPIFFS已挂载
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t hid_trace_start_recording(void);
+
+/**
+ * @brief 停止录制，缓冲中剩余的记录由后台任务写完后关闭文件
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t hid_trace_stop_recording(void);
+
+/**
+ * @brief 录制一条输入报告
+ * @note 在输入回调中调用，不阻塞；缓冲区满时丢弃并计数。所有调用须来自同一任务（单生产者）
+ * @param slot 手柄槽位
+ * @param report_id 报告ID
+ * @param data 报告数据
+ * @param len 数据长度
+ * @param timestamp_us 报告到达时间 (esp_timer微秒)
+ */
+void hid_trace_record(uint8_t slot, uint8_t report_id, const uint8_t *data, uint16_t len, int64_t timestamp_us);
+
+/**
+ * @brief 开始回放已录制的报告
+ * @param speed_percent 回放速度百分比，100为原始节奏，0为不等待尽快回放
+ * @return ESP_OK 成功，ESP_ERR_NOT_FOUND 没有录制文件，其他值表示错误
+ */
+esp_err_t hid_trace_start_replay(uint16_t speed_percent);
+
+/**
+ * @brief 停止回放
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t hid_trace_stop_replay(void);
+
+/**
+ * @brief 获取录制与回放统计
+ * @param stats 输出的统计
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t hid_trace_get_stats(hid_trace_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HID_TRACE_H
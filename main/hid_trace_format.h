@@ -0,0 +1,145 @@
+/**
+ * @file hid_trace_format.h
+ * @brief HID输入轨迹分段文件格式（固件与主机端回放工具共用）
+ *
+ * 分段文件格式（小端）：
+ *   文件头  hid_trace_file_header_t
+ *   记录    varint(距上一条记录的微秒数) | 槽位(1B) | 报告ID(1B) | varint(长度) | 数据
+ * 每个分段的第一条记录相对文件头中的base_time_us。varint为无符号LEB128。
+ */
+
+#ifndef HID_TRACE_FORMAT_H
+#define HID_TRACE_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 分段文件魔数 "HIDT"
+ */
+#define HID_TRACE_MAGIC              0x54444948
+
+/**
+ * @brief 文件格式版本
+ */
+#define HID_TRACE_VERSION            1
+
+/**
+ * @brief 单条报告最大长度（与报告池缓冲相同，容纳DS4蓝牙报告0x11的77字节），超出的报告不录制
+ */
+#define HID_TRACE_MAX_REPORT_LEN     80
+
+/**
+ * @brief 单条记录编码后的最大长度：两个varint + 槽位 + 报告ID + 数据
+ */
+#define HID_TRACE_RECORD_MAX_BYTES   (10 + 1 + 1 + 3 + HID_TRACE_MAX_REPORT_LEN)
+
+/**
+ * @brief 分段文件头
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;              ///< HID_TRACE_MAGIC
+    uint8_t version;             ///< HID_TRACE_VERSION
+    uint8_t reserved[3];
+    uint32_t sequence;           ///< 分段序号，回放时从小到大
+    int64_t base_time_us;        ///< 第一条记录的时间基准 (esp_timer微秒)
+} hid_trace_file_header_t;
+
+/**
+ * @brief 解码后的一条记录
+ */
+typedef struct {
+    uint64_t delta_us;           ///< 距上一条记录的微秒数
+    uint8_t slot;                ///< 手柄槽位
+    uint8_t report_id;           ///< 报告ID
+    uint16_t len;                ///< 数据长度
+    const uint8_t *data;         ///< 数据，指向解码缓冲内部
+} hid_trace_record_t;
+
+/**
+ * @brief 写入无符号LEB128变长整数
+ * @return 写入的字节数
+ */
+static inline size_t hid_trace_put_varint(uint8_t *out, uint64_t value)
+{
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+/**
+ * @brief 读取无符号LEB128变长整数
+ * @return 读取的字节数，数据不完整时返回0
+ */
+static inline size_t hid_trace_get_varint(const uint8_t *buf, size_t len, uint64_t *value)
+{
+    uint64_t result = 0;
+    for (size_t n = 0; n < len && n < 10; n++) {
+        result |= (uint64_t)(buf[n] & 0x7F) << (7 * n);
+        if ((buf[n] & 0x80) == 0) {
+            *value = result;
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 编码一条记录
+ * @param out 输出缓冲，至少HID_TRACE_RECORD_MAX_BYTES字节
+ * @return 写入的字节数
+ */
+static inline size_t hid_trace_encode_record(uint8_t *out, uint64_t delta_us, uint8_t slot, uint8_t report_id,
+                                             const uint8_t *data, uint16_t len)
+{
+    size_t n = hid_trace_put_varint(out, delta_us);
+    out[n++] = slot;
+    out[n++] = report_id;
+    n += hid_trace_put_varint(&out[n], len);
+    memcpy(&out[n], data, len);
+    return n + len;
+}
+
+/**
+ * @brief 解码一条记录
+ * @param buf 编码数据
+ * @param len 可用字节数
+ * @param record 输出的记录，data指向buf内部
+ * @return 记录占用的字节数，数据不完整或长度非法时返回0（如断电留下的半条记录）
+ */
+static inline size_t hid_trace_decode_record(const uint8_t *buf, size_t len, hid_trace_record_t *record)
+{
+    uint64_t delta, data_len;
+    size_t n = hid_trace_get_varint(buf, len, &delta);
+    if (n == 0 || len - n < 2) {
+        return 0;
+    }
+    record->slot = buf[n++];
+    record->report_id = buf[n++];
+
+    size_t used = hid_trace_get_varint(&buf[n], len - n, &data_len);
+    if (used == 0 || data_len > HID_TRACE_MAX_REPORT_LEN || len - n - used < data_len) {
+        return 0;
+    }
+    n += used;
+
+    record->delta_us = delta;
+    record->len = (uint16_t)data_len;
+    record->data = &buf[n];
+    return n + (size_t)data_len;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HID_TRACE_FORMAT_H
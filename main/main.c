@@ -11,14 +11,25 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
 #include "esp_bt.h"
 #include "esp_bt_main.h"
 #include "esp_bt_device.h"
 #include "gamepad_controller.h"
+#include "app_config.h"
+#include "system_monitor.h"
+#include "hid_report_pool.h"
+#include "hid_output_sched.h"
+#include "hid_reconnect.h"
+#include "hid_battery.h"
+#include "stick_filter.h"
 
 static const char *TAG = "MAIN";
 
+// 系统心跳间隔
+#define HEARTBEAT_INTERVAL_MS    10000
+
 /**
  * @brief 系统初始化
  */
@@ -35,6 +46,21 @@ static void system_init(void)
     ESP_LOGI(TAG, "NVS Flash initialized");
 }
 
+#if !CONFIG_BLUETOOTH_HID_TRANSPORT_LOOPBACK
+// 蓝牙内存配置：启用的模式及初始化前释放的模式（见Kconfig BLUETOOTH_HID_BT_PROFILE）
+#if CONFIG_BLUETOOTH_HID_BT_PROFILE_BLE
+#define BT_PROFILE_NAME          "BLE"
+#define BT_PROFILE_MODE          ESP_BT_MODE_BLE
+#define BT_PROFILE_RELEASE       ESP_BT_MODE_CLASSIC_BT
+#elif CONFIG_BLUETOOTH_HID_BT_PROFILE_DUAL
+#define BT_PROFILE_NAME          "dual mode"
+#define BT_PROFILE_MODE          ESP_BT_MODE_BTDM
+#else
+#define BT_PROFILE_NAME          "Classic"
+#define BT_PROFILE_MODE          ESP_BT_MODE_CLASSIC_BT
+#define BT_PROFILE_RELEASE       ESP_BT_MODE_BLE
+#endif
+
 /**
  * @brief 蓝牙初始化
  */
@@ -42,11 +68,24 @@ static void bluetooth_init(void)
 {
     esp_err_t ret;
     
-    ESP_LOGI(TAG, "Starting Bluetooth initialization...");
+    ESP_LOGI(TAG, "Starting Bluetooth initialization (%s profile)...", BT_PROFILE_NAME);
+    int64_t start_us = esp_timer_get_time();
+    uint32_t heap_before = esp_get_free_heap_size();
     
-    // ESP-IDF 5.4+ 蓝牙初始化：先尝试不释放内存
-    esp_bt_controller_config_t bt_cfg = BT_CONTROLLER_INIT_CONFIG_DEFAULT();
+    // 不用的模式在控制器初始化前释放，之后不能再启用该模式
+#ifdef BT_PROFILE_RELEASE
+    ret = esp_bt_controller_mem_release(BT_PROFILE_RELEASE);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to release unused controller memory: %s", esp_err_to_name(ret));
+    }
+#endif
+    uint32_t heap_reclaimed = esp_get_free_heap_size() - heap_before;
     
+#if CONFIG_BT_A2DP_ENABLE || CONFIG_BT_SPP_ENABLED || CONFIG_BT_HFP_ENABLE
+    ESP_LOGW(TAG, "A2DP/SPP/HFP are compiled into Bluedroid but unused; disable them to save memory");
+#endif
+    
+    esp_bt_controller_config_t bt_cfg = BT_CONTROLLER_INIT_CONFIG_DEFAULT();
     ret = esp_bt_controller_init(&bt_cfg);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Bluetooth controller init failed: %s", esp_err_to_name(ret));
@@ -54,31 +93,12 @@ static void bluetooth_init(void)
     }
     ESP_LOGI(TAG, "Bluetooth controller initialized");
     
-    // 尝试启用BTDM模式（双模式）
-    ret = esp_bt_controller_enable(ESP_BT_MODE_BTDM);
+    // 控制器编译模式（BTDM_CTRL_MODE）须包含所选配置的模式
+    ret = esp_bt_controller_enable(BT_PROFILE_MODE);
     if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "BTDM mode failed: %s, trying Classic BT only", esp_err_to_name(ret));
-        
-        // 如果BTDM失败，尝试释放BLE内存后使用经典蓝牙
+        ESP_LOGE(TAG, "Bluetooth controller enable (%s) failed: %s", BT_PROFILE_NAME, esp_err_to_name(ret));
         esp_bt_controller_deinit();
-        
-        ret = esp_bt_controller_mem_release(ESP_BT_MODE_BLE);
-        if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
-            ESP_LOGW(TAG, "Failed to release BLE memory: %s", esp_err_to_name(ret));
-        }
-        
-        ret = esp_bt_controller_init(&bt_cfg);
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "Bluetooth controller re-init failed: %s", esp_err_to_name(ret));
-            return;
-        }
-        
-        ret = esp_bt_controller_enable(ESP_BT_MODE_CLASSIC_BT);
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "Classic BT enable failed: %s", esp_err_to_name(ret));
-            esp_bt_controller_deinit();
-            return;
-        }
+        return;
     }
     ESP_LOGI(TAG, "Bluetooth controller enabled");
     
@@ -100,8 +120,11 @@ static void bluetooth_init(void)
         return;
     }
     
-    ESP_LOGI(TAG, "Bluetooth initialized successfully");
+    ESP_LOGI(TAG, "Bluetooth initialized successfully: %s profile, %"PRIu32" bytes reclaimed, "
+             "up in %"PRId64" ms, free heap %"PRIu32" bytes",
+             BT_PROFILE_NAME, heap_reclaimed, (esp_timer_get_time() - start_us) / 1000, esp_get_free_heap_size());
 }
+#endif
 
 /**
  * @brief 应用程序主函数
@@ -117,11 +140,30 @@ void app_main(void)
     // 系统初始化
     system_init();
     
-    // 蓝牙初始化
+    // 系统监控（输入到PWM延迟统计）
+    if (system_monitor_init() != ESP_OK) {
+        ESP_LOGW(TAG, "System monitor unavailable");
+    }
+    
+    // 蓝牙初始化（回环传输不需要蓝牙控制器）
+#if !CONFIG_BLUETOOTH_HID_TRANSPORT_LOOPBACK
     bluetooth_init();
+#endif
     
     // 游戏手柄控制器初始化
-    gamepad_controller_init();
+    esp_err_t ret = gamepad_controller_init();
+    
+    // 加载配置文件并下发到各模块
+    app_config_init();
+    
+    // 重连参数(connection_timeout、max_reconnect_attempts)已生效后再开始连接：
+    // 已绑定的手柄直接寻呼，都未响应时按轮次页扫描、查询并退避重试
+    if (ret == ESP_OK) {
+        ret = hid_reconnect_start();
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to start HID connection: %s", esp_err_to_name(ret));
+        }
+    }
     
     ESP_LOGI(TAG, "System initialization completed");
     ESP_LOGI(TAG, "System is ready for gamepad connection...");
@@ -130,6 +172,80 @@ void app_main(void)
     while (1) {
         // 系统心跳
         ESP_LOGI(TAG, "System running... Free heap: %"PRIu32" bytes", esp_get_free_heap_size());
-        vTaskDelay(pdMS_TO_TICKS(10000)); // 10秒心跳
+        
+        performance_stats_t perf;
+        if (system_monitor_get_performance_stats(&perf) == ESP_OK && perf.latency_samples > 0) {
+            ESP_LOGI(TAG, "Input->PWM latency (%s): n=%"PRIu32", p50=%"PRIu32"us, p90=%"PRIu32"us, p99=%"PRIu32"us, max=%"PRIu32"us",
+                     gamepad_controller_get_pipeline_mode() == GAMEPAD_PIPELINE_EVENT ? "event" : "polled",
+                     perf.latency_samples, perf.latency_p50_us, perf.latency_p90_us,
+                     perf.latency_p99_us, perf.latency_max_us);
+        }
+        
+        hid_report_pool_stats_t pool;
+        if (hid_report_pool_get_stats(&pool) == ESP_OK && pool.high_water > 0) {
+            ESP_LOGI(TAG, "Report pool: in use %"PRIu32"/%"PRIu32", high water %"PRIu32", exhausted %"PRIu32,
+                     pool.in_use, pool.capacity, pool.high_water, pool.exhausted);
+        }
+        
+        hid_output_stats_t output;
+        if (hid_output_sched_get_stats(&output) == ESP_OK && output.submitted > 0) {
+            ESP_LOGI(TAG, "Output reports: submitted %"PRIu32", sent %"PRIu32", coalesced %"PRIu32
+                     ", suppressed %"PRIu32", failed %"PRIu32,
+                     output.submitted, output.sent, output.coalesced, output.suppressed, output.failed);
+        }
+        
+        // 混合帧数与实际发送的震动报告数之差即为省去的报告
+        static vibration_stats_t last_haptics = {0};
+        vibration_stats_t haptics;
+        if (vibration_get_stats(&haptics) == ESP_OK && haptics.frames != last_haptics.frames) {
+            uint32_t period_s = HEARTBEAT_INTERVAL_MS / 1000;
+            uint32_t frames = haptics.frames - last_haptics.frames;
+            ESP_LOGI(TAG, "Haptics: %.1f frames/s mixed, %.1f reports/s sent, %"PRIu32" voices stolen, "
+                     "render %"PRIu32"us/frame avg, %"PRIu32"us max",
+                     (float)frames / period_s,
+                     (float)(haptics.reports_sent - last_haptics.reports_sent) / period_s, haptics.voices_stolen,
+                     (haptics.render_us - last_haptics.render_us) / frames, haptics.render_us_max);
+            last_haptics = haptics;
+        }
+        
+        // 摇杆滤波在目标板上的实测开销（CPU周期）
+        static stick_filter_stats_t last_filter = {0};
+        stick_filter_stats_t filter;
+        if (stick_filter_get_stats(&filter) == ESP_OK && filter.reports != last_filter.reports) {
+            ESP_LOGI(TAG, "Stick filter: %"PRIu32" cycles/report avg, %"PRIu32" max",
+                     (filter.cycles - last_filter.cycles) / (filter.reports - last_filter.reports),
+                     filter.cycles_max);
+            last_filter = filter;
+        }
+        
+        connection_stats_t conn;
+        if (system_monitor_get_connection_stats(&conn) == ESP_OK) {
+            for (int i = 0; i < HID_LINK_STATS_MAX_DEVICES; i++) {
+                const hid_link_stats_t *link = &conn.links[i];
+                if (!link->connected) {
+                    continue;
+                }
+                ESP_LOGI(TAG, "Link %d: %.1f Hz (avg %"PRIu32"us), gaps %"PRIu32", max gap %"PRIu32"us, RSSI %d (min %d)",
+                         i, link->report_rate_hz, link->avg_interval_us, link->gaps, link->max_gap_us,
+                         link->rssi_valid ? link->rssi : 0, link->rssi_valid ? link->rssi_min : 0);
+                if (link->conn_interval_us > 0) {
+                    ESP_LOGI(TAG, "Link %d: BLE connection interval %"PRIu32"us, latency %u",
+                             i, link->conn_interval_us, link->conn_latency);
+                }
+                hid_battery_status_t battery;
+                if (hid_battery_get(i, &battery) == ESP_OK && battery.level != HID_BATTERY_LEVEL_UNKNOWN) {
+                    ESP_LOGI(TAG, "Link %d: battery %d%%%s", i, battery.level,
+                             battery.cable ? (battery.charging ? ", charging" : ", on cable") : "");
+                }
+            }
+        }
+        
+        hid_reconnect_stats_t reconnect;
+        if (hid_reconnect_get_stats(&reconnect) == ESP_OK && (reconnect.reconnects > 0 || reconnect.give_ups > 0)) {
+            ESP_LOGI(TAG, "Reconnects: %"PRIu32" (last %"PRIu32"ms, avg %"PRIu32"ms, max %"PRIu32"ms), gave up %"PRIu32,
+                     reconnect.reconnects, reconnect.last_reconnect_ms, reconnect.avg_reconnect_ms,
+                     reconnect.max_reconnect_ms, reconnect.give_ups);
+        }
+        vTaskDelay(pdMS_TO_TICKS(HEARTBEAT_INTERVAL_MS));
     }
 }
@@ -0,0 +1,79 @@
+/**
+ * @file state_seqlock.h
+ * @brief 单写多读的序列锁
+ *
+ * 序号为奇数表示写入进行中。写者之间用临界区串行化（同时禁止本核抢占），
+ * 读者无锁，遇到并发写入只需重试。主机端压力测试(host_test/test_seqlock.c)使用同一份实现。
+ */
+
+#ifndef STATE_SEQLOCK_H
+#define STATE_SEQLOCK_H
+
+#include "freertos/FreeRTOS.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 序列锁
+ */
+typedef struct {
+    _Atomic uint32_t seq;            ///< 写入序号，奇数表示写入进行中
+    portMUX_TYPE write_lock;         ///< 写者互斥
+} state_seqlock_t;
+
+#define STATE_SEQLOCK_INITIALIZER { 0, portMUX_INITIALIZER_UNLOCKED }
+
+/**
+ * @brief 开始写入受保护的数据
+ * @note 必须与state_seqlock_write_end()成对调用，中间只允许做简单的内存赋值
+ */
+static inline void state_seqlock_write_begin(state_seqlock_t *lock)
+{
+    portENTER_CRITICAL(&lock->write_lock);
+    uint32_t seq = atomic_load_explicit(&lock->seq, memory_order_relaxed);
+    atomic_store_explicit(&lock->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+/**
+ * @brief 结束写入受保护的数据
+ */
+static inline void state_seqlock_write_end(state_seqlock_t *lock)
+{
+    uint32_t seq = atomic_load_explicit(&lock->seq, memory_order_relaxed);
+    atomic_store_explicit(&lock->seq, seq + 1, memory_order_release);
+    portEXIT_CRITICAL(&lock->write_lock);
+}
+
+/**
+ * @brief 无锁读取受保护数据的一致副本
+ *
+ * 读取期间若有写入发生（序号为奇数或前后不一致），丢弃副本重新读取。
+ * @param lock 序列锁
+ * @param dst 输出副本
+ * @param src 受保护的数据
+ * @param size 数据长度
+ */
+static inline void state_seqlock_read(state_seqlock_t *lock, void *dst, const void *src, size_t size)
+{
+    uint32_t begin, end;
+
+    do {
+        begin = atomic_load_explicit(&lock->seq, memory_order_acquire);
+        memcpy(dst, src, size);
+        atomic_thread_fence(memory_order_acquire);
+        end = atomic_load_explicit(&lock->seq, memory_order_relaxed);
+    } while ((begin & 1u) != 0 || begin != end);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STATE_SEQLOCK_H
@@ -0,0 +1,195 @@
+/**
+ * @file stick_conditioning.c
+ * @brief 摇杆调理实现
+ */
+
+#include "stick_conditioning.h"
+#include "esp_log.h"
+#include <math.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+static const char *TAG = "STICK_COND";
+
+// 原始轴幅值(0-32768)右移5位得到查找表索引
+#define STICK_LUT_SHIFT         5
+
+// 指数曲线的幂次
+#define STICK_EXPO_POWER        2.0f
+
+// 对数曲线 log(1 + k*x) / log(1 + k) 中的k
+#define STICK_LOG_FACTOR        9.0f
+
+/**
+ * @brief 预计算的调理表，死区阈值与表内容一起切换
+ *
+ * 死区外的幅值[死区, 1]先重新映射到[0, 1]再套曲线，死区内为0，
+ * 所以死区、曲线和缩放都在这一次查表里完成，死区边缘的输出从0连续上升。
+ */
+typedef struct {
+    uint32_t deadzone;                       ///< 径向死区半径（原始单位）
+    uint32_t deadzone_sq;                    ///< 径向死区半径的平方
+    int16_t table[STICK_LUT_SIZE];           ///< 幅值到输出的映射 (0 to STICK_OUTPUT_MAX)
+} stick_lut_t;
+
+// 默认参数与config_manager默认配置一致
+static stick_conditioning_config_t current_config = {
+    .deadzone_percent = 10,
+    .max_speed = 255,
+    .curve = STICK_CURVE_EXPONENTIAL
+};
+
+// 双缓冲：在空闲表中重建后原子切换
+static stick_lut_t luts[2];
+static _Atomic(const stick_lut_t *) active_lut = NULL;
+
+/**
+ * @brief 计算响应曲线 (输入输出均为0.0-1.0)
+ */
+static float evaluate_curve(stick_curve_t curve, float x)
+{
+    switch (curve) {
+    case STICK_CURVE_EXPONENTIAL:
+        return powf(x, STICK_EXPO_POWER);
+    case STICK_CURVE_LOGARITHMIC:
+        return logf(1.0f + STICK_LOG_FACTOR * x) / logf(1.0f + STICK_LOG_FACTOR);
+    case STICK_CURVE_LINEAR:
+    default:
+        return x;
+    }
+}
+
+/**
+ * @brief 按参数生成调理表
+ */
+static void build_lut(const stick_conditioning_config_t *config, stick_lut_t *lut)
+{
+    lut->deadzone = (uint32_t)config->deadzone_percent * 32767 / 100;
+    lut->deadzone_sq = lut->deadzone * lut->deadzone;
+
+    float deadzone = config->deadzone_percent / 100.0f;
+    float scale = (float)STICK_OUTPUT_MAX * config->max_speed / 255.0f;
+    for (int i = 0; i < STICK_LUT_SIZE; i++) {
+        float x = (float)i / (STICK_LUT_SIZE - 1);
+        float shaped = 0.0f;
+        if (x > deadzone) {
+            shaped = evaluate_curve(config->curve, (x - deadzone) / (1.0f - deadzone));
+        }
+        lut->table[i] = (int16_t)lroundf(shaped * scale);
+    }
+}
+
+/**
+ * @brief 按幅值查表（幅值为原始单位，可超出32767）
+ */
+static inline int16_t lookup_magnitude(const stick_lut_t *lut, uint32_t magnitude)
+{
+    uint32_t index = magnitude >> STICK_LUT_SHIFT;
+    if (index >= STICK_LUT_SIZE) {
+        index = STICK_LUT_SIZE - 1;
+    }
+    return lut->table[index];
+}
+
+/**
+ * @brief 单轴查表（保留符号）
+ */
+static inline int16_t lookup(const stick_lut_t *lut, int32_t value)
+{
+    int16_t out = lookup_magnitude(lut, (uint32_t)(value < 0 ? -value : value));
+    return value < 0 ? -out : out;
+}
+
+/**
+ * @brief 求半径（向下取整），不用浮点开方
+ *
+ * max + 3/8*min的估计误差在-3%到+7%之间，两次牛顿迭代后误差小于1个原始单位。
+ * 结果不小于较大的一轴，调用方的 r - |轴| 不会下溢。
+ */
+static inline uint32_t stick_radius(uint32_t ax, uint32_t ay, uint32_t r_sq)
+{
+    uint32_t hi = ax > ay ? ax : ay;
+    uint32_t lo = ax > ay ? ay : ax;
+    uint32_t r = hi + (lo * 3 >> 3);
+    r = (r + r_sq / r) >> 1;
+    r = (r + r_sq / r) >> 1;
+    return r < hi ? hi : r;
+}
+
+esp_err_t stick_conditioning_init(void)
+{
+    build_lut(&current_config, &luts[0]);
+    atomic_store_explicit(&active_lut, &luts[0], memory_order_release);
+
+    ESP_LOGI(TAG, "Stick conditioning initialized: deadzone=%d%%, max_speed=%d, curve=%d",
+             current_config.deadzone_percent, current_config.max_speed, current_config.curve);
+    return ESP_OK;
+}
+
+esp_err_t stick_conditioning_set_config(const stick_conditioning_config_t *config)
+{
+    if (!config) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (config->deadzone_percent > 50 || config->curve > STICK_CURVE_LOGARITHMIC) {
+        ESP_LOGE(TAG, "Invalid stick config: deadzone=%d%%, curve=%d",
+                 config->deadzone_percent, config->curve);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 在当前未使用的缓冲中重建，完成后再发布
+    const stick_lut_t *current = atomic_load_explicit(&active_lut, memory_order_relaxed);
+    stick_lut_t *next = (current == &luts[0]) ? &luts[1] : &luts[0];
+    build_lut(config, next);
+
+    current_config = *config;
+    atomic_store_explicit(&active_lut, next, memory_order_release);
+
+    ESP_LOGI(TAG, "Stick config updated: deadzone=%d%%, max_speed=%d, curve=%d",
+             config->deadzone_percent, config->max_speed, config->curve);
+    return ESP_OK;
+}
+
+esp_err_t stick_conditioning_get_config(stick_conditioning_config_t *config)
+{
+    if (!config) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *config = current_config;
+    return ESP_OK;
+}
+
+void stick_conditioning_apply(int16_t x, int16_t y, int16_t *out_x, int16_t *out_y)
+{
+    const stick_lut_t *lut = atomic_load_explicit(&active_lut, memory_order_acquire);
+
+    // 径向死区：比较半径平方，无需开方（最大2^31，用无符号避免溢出）
+    uint32_t ax = (uint32_t)(x < 0 ? -(int32_t)x : x);
+    uint32_t ay = (uint32_t)(y < 0 ? -(int32_t)y : y);
+    uint32_t r_sq = ax * ax + ay * ay;
+    if (lut == NULL || r_sq <= lut->deadzone_sq) {
+        *out_x = 0;
+        *out_y = 0;
+        return;
+    }
+
+    // 按半径重新映射：各轴幅值加上 死区*(r-|轴|)/r 后查表。轴向时不变（与单轴相同），
+    // 刚出死区圆时两轴都落在表的死区边缘，输出从0连续上升；角落超出满偏的部分由查表截断
+    uint32_t r = stick_radius(ax, ay, r_sq);
+    int16_t mx = lookup_magnitude(lut, ax + lut->deadzone * (r - ax) / r);
+    int16_t my = lookup_magnitude(lut, ay + lut->deadzone * (r - ay) / r);
+    *out_x = x < 0 ? -mx : mx;
+    *out_y = y < 0 ? -my : my;
+}
+
+int16_t stick_conditioning_apply_axis(int16_t value)
+{
+    const stick_lut_t *lut = atomic_load_explicit(&active_lut, memory_order_acquire);
+    if (lut == NULL) {
+        return 0;
+    }
+
+    return lookup(lut, value);
+}
@@ -0,0 +1,90 @@
+/**
+ * @file stick_conditioning.h
+ * @brief 摇杆调理（死区、响应曲线、输出缩放）头文件
+ *
+ * 配置变化时预先计算定点查找表，控制循环中每个轴只需一次查表。
+ * 死区外的幅值[死区, 1]重新映射到[0, 1]后再套响应曲线，死区边缘的输出连续。
+ * 双轴摇杆按半径判定死区（圆形），单轴按幅值判定。
+ */
+
+#ifndef STICK_CONDITIONING_H
+#define STICK_CONDITIONING_H
+
+#include "esp_err.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 查找表项数（按摇杆幅值的高10位索引）
+ */
+#define STICK_LUT_SIZE          1024
+
+/**
+ * @brief 调理后输出的满量程值
+ */
+#define STICK_OUTPUT_MAX        1000
+
+/**
+ * @brief 响应曲线类型（与配置文件acceleration_curve对应）
+ */
+typedef enum {
+    STICK_CURVE_LINEAR = 0,      ///< 线性
+    STICK_CURVE_EXPONENTIAL,     ///< 指数（中心区域更细腻）
+    STICK_CURVE_LOGARITHMIC      ///< 对数（中心区域更灵敏）
+} stick_curve_t;
+
+/**
+ * @brief 摇杆调理参数
+ */
+typedef struct {
+    uint8_t deadzone_percent;    ///< 死区，占满量程的百分比 (0-50)
+    uint8_t max_speed;           ///< 输出缩放 (0-255，255为满量程)
+    stick_curve_t curve;         ///< 响应曲线
+} stick_conditioning_config_t;
+
+/**
+ * @brief 初始化摇杆调理，使用默认参数生成查找表
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t stick_conditioning_init(void);
+
+/**
+ * @brief 更新调理参数并重建查找表
+ * @note 在空闲缓冲中生成后原子切换，控制循环不会读到未完成的表
+ * @param config 调理参数
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t stick_conditioning_set_config(const stick_conditioning_config_t *config);
+
+/**
+ * @brief 获取当前调理参数
+ * @param config 输出的调理参数
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t stick_conditioning_get_config(stick_conditioning_config_t *config);
+
+/**
+ * @brief 调理一个双轴摇杆
+ * @note 半径在死区内时两轴都输出0；死区外按半径重新映射后逐轴查表，不做开方浮点运算
+ * @param x 原始X轴 (-32768 to 32767)
+ * @param y 原始Y轴 (-32768 to 32767)
+ * @param out_x 输出X轴 (-STICK_OUTPUT_MAX to STICK_OUTPUT_MAX)
+ * @param out_y 输出Y轴 (-STICK_OUTPUT_MAX to STICK_OUTPUT_MAX)
+ */
+void stick_conditioning_apply(int16_t x, int16_t y, int16_t *out_x, int16_t *out_y);
+
+/**
+ * @brief 调理单个轴
+ * @param value 原始轴值 (-32768 to 32767)
+ * @return 调理后的值 (-STICK_OUTPUT_MAX to STICK_OUTPUT_MAX)
+ */
+int16_t stick_conditioning_apply_axis(int16_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STICK_CONDITIONING_H
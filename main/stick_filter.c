@@ -0,0 +1,267 @@
+/**
+ * @file stick_filter.c
+ * @brief 摇杆滤波实现
+ */
+
+#include "stick_filter.h"
+#include "esp_log.h"
+#include "esp_cpu.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+
+static const char *TAG = "STICK_FILTER";
+
+// 滤波器状态使用Q8定点
+#define FILTER_STATE_SHIFT      8
+
+// 平滑系数使用Q15定点
+#define FILTER_ALPHA_SHIFT      15
+
+// 采样间隔限制：报告不会快于1kHz；长时间无报告时按50ms计算，避免系数溢出
+#define FILTER_MIN_DT_US        1000
+#define FILTER_MAX_DT_US        50000
+
+// 时间常数 tau(us) = 1e9 / (2 * pi * fc(mHz))
+#define FILTER_TAU_NUMERATOR    159154943UL
+
+// One-Euro截止频率上限 (mHz)
+#define FILTER_MAX_CUTOFF_MHZ   100000
+
+/**
+ * @brief 单轴滤波状态
+ */
+typedef struct {
+    int32_t x_hat;               ///< 滤波后的值 (Q8)
+    int32_t dx_hat;              ///< 滤波后的速度 (原始单位/ms)
+} axis_state_t;
+
+/**
+ * @brief 单个输入源的滤波状态
+ */
+typedef struct {
+    axis_state_t axes[STICK_FILTER_AXIS_COUNT];
+    int64_t last_timestamp_us;
+    volatile bool valid;
+    // 开销统计，只由该输入源的解析路径写入
+    volatile uint32_t reports;
+    volatile uint32_t cycles;
+    volatile uint32_t cycles_max;
+} source_state_t;
+
+static const stick_filter_axis_config_t default_axis_config = {
+    .type = STICK_FILTER_ONE_EURO,
+    .ema_alpha = 64,
+    .min_cutoff_mhz = 1000,
+    .beta = 50,
+    .d_cutoff_mhz = 1000
+};
+
+// 参数双缓冲：设置任务写空闲缓冲，解析路径无锁读取
+static stick_filter_config_t configs[2];
+static _Atomic(const stick_filter_config_t *) active_config = NULL;
+
+// 滤波状态只在报告解析路径中访问
+static source_state_t source_states[STICK_FILTER_MAX_SOURCES];
+
+/**
+ * @brief 清除所有输入源的滤波状态
+ */
+static void reset_all_sources(void)
+{
+    for (int i = 0; i < STICK_FILTER_MAX_SOURCES; i++) {
+        source_states[i].valid = false;
+    }
+}
+
+/**
+ * @brief 根据截止频率和采样间隔计算平滑系数 alpha = dt / (dt + tau)
+ */
+static inline int32_t smoothing_alpha(uint32_t cutoff_mhz, uint32_t dt_us)
+{
+    if (cutoff_mhz == 0) {
+        cutoff_mhz = 1;
+    }
+    uint32_t tau_us = FILTER_TAU_NUMERATOR / cutoff_mhz;
+    return (int32_t)((dt_us << FILTER_ALPHA_SHIFT) / (dt_us + tau_us));
+}
+
+/**
+ * @brief 把Q8状态还原为轴值
+ */
+static inline int16_t state_to_axis(int32_t x_hat)
+{
+    int32_t value = (x_hat + (1 << (FILTER_STATE_SHIFT - 1))) >> FILTER_STATE_SHIFT;
+    if (value > INT16_MAX) return INT16_MAX;
+    if (value < INT16_MIN) return INT16_MIN;
+    return (int16_t)value;
+}
+
+/**
+ * @brief One-Euro滤波单步
+ */
+static int16_t filter_one_euro(const stick_filter_axis_config_t *cfg, axis_state_t *st,
+                               int16_t x, uint32_t dt_us)
+{
+    int32_t x_q8 = (int32_t)x << FILTER_STATE_SHIFT;
+
+    // 速度估计（原始单位/ms），dt不小于1ms保证乘法不溢出
+    int32_t dx = ((int32_t)x - (st->x_hat >> FILTER_STATE_SHIFT)) * 1000 / (int32_t)dt_us;
+    int32_t alpha_d = smoothing_alpha(cfg->d_cutoff_mhz, dt_us);
+    st->dx_hat += (int32_t)(((int64_t)(dx - st->dx_hat) * alpha_d) >> FILTER_ALPHA_SHIFT);
+
+    // 截止频率随速度升高：静止时强平滑，快速移动时低延迟；64位求和后饱和到上限，beta*速度不会回绕
+    uint32_t speed = (uint32_t)(st->dx_hat < 0 ? -(int64_t)st->dx_hat : st->dx_hat);
+    uint64_t cutoff_sum = (uint64_t)cfg->min_cutoff_mhz + (uint64_t)cfg->beta * speed;
+    uint32_t cutoff = cutoff_sum > FILTER_MAX_CUTOFF_MHZ ? FILTER_MAX_CUTOFF_MHZ : (uint32_t)cutoff_sum;
+
+    int32_t alpha = smoothing_alpha(cutoff, dt_us);
+    st->x_hat += (int32_t)(((int64_t)(x_q8 - st->x_hat) * alpha) >> FILTER_ALPHA_SHIFT);
+    return state_to_axis(st->x_hat);
+}
+
+/**
+ * @brief EMA滤波单步
+ */
+static int16_t filter_ema(const stick_filter_axis_config_t *cfg, axis_state_t *st, int16_t x)
+{
+    int32_t x_q8 = (int32_t)x << FILTER_STATE_SHIFT;
+    st->x_hat += (int32_t)(((int64_t)(x_q8 - st->x_hat) * cfg->ema_alpha) >> 8);
+    return state_to_axis(st->x_hat);
+}
+
+esp_err_t stick_filter_init(void)
+{
+    for (int i = 0; i < STICK_FILTER_AXIS_COUNT; i++) {
+        configs[0].axes[i] = default_axis_config;
+    }
+    atomic_store_explicit(&active_config, &configs[0], memory_order_release);
+    reset_all_sources();
+
+    ESP_LOGI(TAG, "Stick filter initialized: one-euro, min_cutoff=%lumHz, beta=%lu",
+             (unsigned long)default_axis_config.min_cutoff_mhz, (unsigned long)default_axis_config.beta);
+    return ESP_OK;
+}
+
+esp_err_t stick_filter_set_config(const stick_filter_config_t *config)
+{
+    if (!config) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (int i = 0; i < STICK_FILTER_AXIS_COUNT; i++) {
+        const stick_filter_axis_config_t *axis = &config->axes[i];
+        if (axis->type > STICK_FILTER_ONE_EURO ||
+            (axis->type == STICK_FILTER_EMA && axis->ema_alpha == 0) ||
+            (axis->type == STICK_FILTER_ONE_EURO &&
+             (axis->min_cutoff_mhz == 0 || axis->d_cutoff_mhz == 0 || axis->beta > UINT16_MAX))) {
+            ESP_LOGE(TAG, "Invalid filter config for axis %d", i);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    const stick_filter_config_t *current = atomic_load_explicit(&active_config, memory_order_relaxed);
+    stick_filter_config_t *next = (current == &configs[0]) ? &configs[1] : &configs[0];
+    *next = *config;
+    atomic_store_explicit(&active_config, next, memory_order_release);
+
+    // 滤波器类型可能变化，从下一个样本重新开始
+    reset_all_sources();
+
+    ESP_LOGI(TAG, "Stick filter config updated");
+    return ESP_OK;
+}
+
+esp_err_t stick_filter_get_config(stick_filter_config_t *config)
+{
+    if (!config) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const stick_filter_config_t *current = atomic_load_explicit(&active_config, memory_order_acquire);
+    if (!current) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    *config = *current;
+    return ESP_OK;
+}
+
+void stick_filter_reset(uint8_t source)
+{
+    if (source < STICK_FILTER_MAX_SOURCES) {
+        source_states[source].valid = false;
+    }
+}
+
+void stick_filter_process(uint8_t source, int16_t axes[STICK_FILTER_AXIS_COUNT], int64_t timestamp_us)
+{
+    const stick_filter_config_t *config = atomic_load_explicit(&active_config, memory_order_acquire);
+    if (!config || source >= STICK_FILTER_MAX_SOURCES) {
+        return;
+    }
+
+    uint32_t start_cycles = esp_cpu_get_cycle_count();
+    source_state_t *state = &source_states[source];
+    axis_state_t *axis_states = state->axes;
+
+    // 首个样本直接作为初值
+    if (!state->valid) {
+        for (int i = 0; i < STICK_FILTER_AXIS_COUNT; i++) {
+            axis_states[i].x_hat = (int32_t)axes[i] << FILTER_STATE_SHIFT;
+            axis_states[i].dx_hat = 0;
+        }
+        state->last_timestamp_us = timestamp_us;
+        state->valid = true;
+        return;
+    }
+
+    int64_t elapsed = timestamp_us - state->last_timestamp_us;
+    state->last_timestamp_us = timestamp_us;
+    uint32_t dt_us = elapsed < FILTER_MIN_DT_US ? FILTER_MIN_DT_US :
+                     elapsed > FILTER_MAX_DT_US ? FILTER_MAX_DT_US : (uint32_t)elapsed;
+
+    for (int i = 0; i < STICK_FILTER_AXIS_COUNT; i++) {
+        const stick_filter_axis_config_t *cfg = &config->axes[i];
+        switch (cfg->type) {
+        case STICK_FILTER_EMA:
+            axes[i] = filter_ema(cfg, &axis_states[i], axes[i]);
+            break;
+        case STICK_FILTER_ONE_EURO:
+            axes[i] = filter_one_euro(cfg, &axis_states[i], axes[i], dt_us);
+            break;
+        case STICK_FILTER_NONE:
+        default:
+            // 保持状态跟随，切换滤波器类型时不会跳变
+            axis_states[i].x_hat = (int32_t)axes[i] << FILTER_STATE_SHIFT;
+            axis_states[i].dx_hat = 0;
+            break;
+        }
+    }
+
+    // 周期计数器按核心计数，报告路径被抢占时单次值偏大，只影响最大值
+    uint32_t cycles = esp_cpu_get_cycle_count() - start_cycles;
+    state->reports++;
+    state->cycles += cycles;
+    if (cycles > state->cycles_max) {
+        state->cycles_max = cycles;
+    }
+}
+
+esp_err_t stick_filter_get_stats(stick_filter_stats_t *stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    for (int i = 0; i < STICK_FILTER_MAX_SOURCES; i++) {
+        const source_state_t *state = &source_states[i];
+        stats->reports += state->reports;
+        stats->cycles += state->cycles;
+        if (state->cycles_max > stats->cycles_max) {
+            stats->cycles_max = state->cycles_max;
+        }
+    }
+    return ESP_OK;
+}
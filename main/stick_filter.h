@@ -0,0 +1,118 @@
+/**
+ * @file stick_filter.h
+ * @brief 摇杆滤波（定点EMA / One-Euro）头文件
+ *
+ * 位于报告解析与车辆控制之间，对每个摇杆轴独立滤波，只使用整数运算。
+ */
+
+#ifndef STICK_FILTER_H
+#define STICK_FILTER_H
+
+#include "esp_err.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 独立滤波的输入源个数（每个手柄槽位一个）
+ */
+#define STICK_FILTER_MAX_SOURCES    4
+
+/**
+ * @brief 摇杆轴编号
+ */
+typedef enum {
+    STICK_FILTER_AXIS_LX = 0,    ///< 左摇杆X轴
+    STICK_FILTER_AXIS_LY,        ///< 左摇杆Y轴
+    STICK_FILTER_AXIS_RX,        ///< 右摇杆X轴
+    STICK_FILTER_AXIS_RY,        ///< 右摇杆Y轴
+    STICK_FILTER_AXIS_COUNT
+} stick_filter_axis_t;
+
+/**
+ * @brief 滤波器类型
+ */
+typedef enum {
+    STICK_FILTER_NONE = 0,       ///< 不滤波
+    STICK_FILTER_EMA,            ///< 固定系数指数滑动平均
+    STICK_FILTER_ONE_EURO        ///< 自适应One-Euro滤波（静止时平滑、快速移动时低延迟）
+} stick_filter_type_t;
+
+/**
+ * @brief 单轴滤波参数
+ */
+typedef struct {
+    stick_filter_type_t type;    ///< 滤波器类型
+    uint8_t ema_alpha;           ///< EMA系数 (1-255，对应1/256到255/256，越大越跟手)
+    uint32_t min_cutoff_mhz;     ///< One-Euro最小截止频率 (mHz)
+    uint32_t beta;               ///< One-Euro速度系数 (每原始单位/ms增加的截止频率，mHz)
+    uint32_t d_cutoff_mhz;       ///< One-Euro速度估计的截止频率 (mHz)
+} stick_filter_axis_config_t;
+
+/**
+ * @brief 滤波参数
+ */
+typedef struct {
+    stick_filter_axis_config_t axes[STICK_FILTER_AXIS_COUNT];
+} stick_filter_config_t;
+
+/**
+ * @brief 滤波开销统计（目标板上用esp_cpu_get_cycle_count测量，只含经过滤波的报告）
+ * @note 计数器会回绕，按两次读数之差计算平均值
+ */
+typedef struct {
+    uint32_t reports;            ///< 滤波的报告数（所有输入源）
+    uint32_t cycles;             ///< 累计CPU周期数
+    uint32_t cycles_max;         ///< 单个报告的最大周期数
+} stick_filter_stats_t;
+
+/**
+ * @brief 初始化摇杆滤波，使用默认参数
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t stick_filter_init(void);
+
+/**
+ * @brief 更新滤波参数
+ * @note 参数在空闲缓冲中准备好后原子切换，可在任意任务中调用
+ * @param config 滤波参数
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t stick_filter_set_config(const stick_filter_config_t *config);
+
+/**
+ * @brief 获取当前滤波参数
+ * @param config 输出的滤波参数
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t stick_filter_get_config(stick_filter_config_t *config);
+
+/**
+ * @brief 清除一个输入源的滤波器状态（手柄断开时调用，下一个样本直接作为初值）
+ * @param source 输入源 (0 to STICK_FILTER_MAX_SOURCES-1)
+ */
+void stick_filter_reset(uint8_t source);
+
+/**
+ * @brief 对一组摇杆样本滤波（原地修改）
+ * @note 只能在报告解析路径中调用（每个输入源单写者），各输入源状态互相独立
+ * @param source 输入源 (0 to STICK_FILTER_MAX_SOURCES-1)
+ * @param axes 摇杆轴值 (-32768 to 32767)，按stick_filter_axis_t排列
+ * @param timestamp_us 样本时间戳 (esp_timer微秒)
+ */
+void stick_filter_process(uint8_t source, int16_t axes[STICK_FILTER_AXIS_COUNT], int64_t timestamp_us);
+
+/**
+ * @brief 获取滤波开销统计
+ * @param stats 输出的统计数据
+ * @return ESP_OK 成功，其他值表示错误
+ */
+esp_err_t stick_filter_get_stats(stick_filter_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STICK_FILTER_H
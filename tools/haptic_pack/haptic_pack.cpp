@@ -0,0 +1,328 @@
+/**
+ * @file haptic_pack.cpp
+ * @brief 震动片段库打包工具（主机端）
+ *
+ * 把文本描述的震动片段编译为片段库二进制（格式见components/vibration/include/haptic_clip_format.h）。
+ *
+ * 编译：  g++ -std=c++17 -O2 -o haptic_pack haptic_pack.cpp
+ * 使用：  ./haptic_pack clips.txt haptics.bin
+ * 烧写：  parttool.py write_partition --partition-name haptics --input haptics.bin
+ *
+ * 文本格式（#之后为注释）：
+ *
+ *   clip <名称>                    开始一个片段，名称最长11个字符
+ *   adsr <a_ms> <d_ms> <s> <r_ms>  包络，s为持续段强度(0-255)；省略时包络恒为255
+ *   duration <ms>                  片段时长；省略时为最后一个关键帧的时间
+ *   loop                           循环播放，直到被停止或替换
+ *   left  <关键帧>...              左马达曲线
+ *   right <关键帧>...              右马达曲线
+ *   both  <关键帧>...              两个马达使用同一条曲线（只存一份）
+ *
+ * 关键帧写作 时间ms:强度[:插值]，插值为step、linear（默认）或smooth，表示到下一个关键帧的过渡方式。
+ */
+
+#include "../../components/vibration/include/haptic_clip_format.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static_assert(sizeof(haptic_bank_header_t) == 16, "haptic bank header layout");
+static_assert(sizeof(haptic_clip_entry_t) == 16, "haptic clip entry layout");
+static_assert(sizeof(haptic_clip_t) == 16, "haptic clip header layout");
+static_assert(sizeof(haptic_keyframe_t) == 4, "haptic keyframe layout");
+
+namespace {
+
+struct Clip {
+    std::string name;
+    int line = 0;
+    haptic_clip_t header{};
+    bool has_duration = false;
+    bool has_left = false;
+    bool has_right = false;
+    bool shared = false;                     // both：右马达与左马达相同
+    std::vector<haptic_keyframe_t> tracks[2];
+};
+
+struct ParseError : std::runtime_error {
+    ParseError(int line, const std::string &what)
+        : std::runtime_error("line " + std::to_string(line) + ": " + what) {}
+};
+
+unsigned long parse_number(const std::string &text, unsigned long max, int line, const char *what)
+{
+    char *end = nullptr;
+    unsigned long value = std::strtoul(text.c_str(), &end, 0);
+    if (text.empty() || *end != '\0' || value > max) {
+        throw ParseError(line, std::string("invalid ") + what + " '" + text + "'");
+    }
+    return value;
+}
+
+haptic_keyframe_t parse_keyframe(const std::string &text, int line)
+{
+    std::vector<std::string> fields;
+    std::stringstream stream(text);
+    std::string field;
+    while (std::getline(stream, field, ':')) {
+        fields.push_back(field);
+    }
+    if (fields.size() < 2 || fields.size() > 3) {
+        throw ParseError(line, "keyframe '" + text + "' is not time:level[:interp]");
+    }
+
+    haptic_keyframe_t frame{};
+    frame.time_ms = static_cast<uint16_t>(parse_number(fields[0], UINT16_MAX, line, "keyframe time"));
+    frame.level = static_cast<uint8_t>(parse_number(fields[1], 255, line, "keyframe level"));
+    frame.interp = HAPTIC_INTERP_LINEAR;
+    if (fields.size() == 3) {
+        static const std::map<std::string, haptic_interp_t> interps = {
+            {"step", HAPTIC_INTERP_STEP}, {"linear", HAPTIC_INTERP_LINEAR}, {"smooth", HAPTIC_INTERP_SMOOTH}};
+        auto it = interps.find(fields[2]);
+        if (it == interps.end()) {
+            throw ParseError(line, "unknown interpolation '" + fields[2] + "'");
+        }
+        frame.interp = it->second;
+    }
+    return frame;
+}
+
+std::vector<haptic_keyframe_t> parse_track(std::istringstream &words, int line)
+{
+    std::vector<haptic_keyframe_t> track;
+    std::string word;
+    while (words >> word) {
+        haptic_keyframe_t frame = parse_keyframe(word, line);
+        if (!track.empty() && frame.time_ms < track.back().time_ms) {
+            throw ParseError(line, "keyframe times must not decrease");
+        }
+        track.push_back(frame);
+    }
+    if (track.empty() || track.size() > HAPTIC_CLIP_MAX_KEYFRAMES) {
+        throw ParseError(line, "a track needs 1 to " + std::to_string(HAPTIC_CLIP_MAX_KEYFRAMES) + " keyframes");
+    }
+    return track;
+}
+
+/**
+ * @brief 补全并检查一个片段：默认时长、曲线齐全
+ */
+void finish_clip(Clip &clip)
+{
+    if (!clip.has_left && !clip.shared) {
+        throw ParseError(clip.line, "clip '" + clip.name + "' has no left or both track");
+    }
+    if (clip.shared && (clip.has_left || clip.has_right)) {
+        throw ParseError(clip.line, "clip '" + clip.name + "' mixes both with left/right");
+    }
+    if (clip.has_left != clip.has_right && !clip.shared) {
+        throw ParseError(clip.line, "clip '" + clip.name + "' needs both left and right tracks (or 'both')");
+    }
+
+    if (!clip.has_duration) {
+        uint32_t last = 0;
+        for (const auto &track : clip.tracks) {
+            if (!track.empty() && track.back().time_ms > last) {
+                last = track.back().time_ms;
+            }
+        }
+        clip.header.duration_ms = last;
+    }
+    if (clip.header.duration_ms == 0) {
+        throw ParseError(clip.line, "clip '" + clip.name + "' has zero duration");
+    }
+    clip.header.keyframe_count[0] = static_cast<uint8_t>(clip.tracks[0].size());
+    clip.header.keyframe_count[1] = static_cast<uint8_t>(clip.shared ? 0 : clip.tracks[1].size());
+}
+
+std::vector<Clip> parse(std::istream &in)
+{
+    std::vector<Clip> clips;
+    std::string text;
+    int line = 0;
+    while (std::getline(in, text)) {
+        line++;
+        text = text.substr(0, text.find('#'));
+        std::istringstream words(text);
+        std::string keyword;
+        if (!(words >> keyword)) {
+            continue;
+        }
+
+        if (keyword == "clip") {
+            if (!clips.empty()) {
+                finish_clip(clips.back());
+            }
+            Clip clip;
+            clip.line = line;
+            if (!(words >> clip.name) || clip.name.size() >= HAPTIC_CLIP_NAME_LEN) {
+                throw ParseError(line, "clip name must be 1 to " + std::to_string(HAPTIC_CLIP_NAME_LEN - 1) +
+                                 " characters");
+            }
+            for (const auto &other : clips) {
+                if (other.name == clip.name) {
+                    throw ParseError(line, "duplicate clip '" + clip.name + "'");
+                }
+            }
+            clip.header.sustain_level = 255;
+            clips.push_back(clip);
+            continue;
+        }
+
+        if (clips.empty()) {
+            throw ParseError(line, "'" + keyword + "' outside of a clip");
+        }
+        Clip &clip = clips.back();
+        std::string arg;
+        if (keyword == "adsr") {
+            std::string a, d, s, r;
+            if (!(words >> a >> d >> s >> r)) {
+                throw ParseError(line, "adsr needs attack_ms decay_ms sustain release_ms");
+            }
+            clip.header.attack_ms = static_cast<uint16_t>(parse_number(a, UINT16_MAX, line, "attack"));
+            clip.header.decay_ms = static_cast<uint16_t>(parse_number(d, UINT16_MAX, line, "decay"));
+            clip.header.sustain_level = static_cast<uint8_t>(parse_number(s, 255, line, "sustain"));
+            clip.header.release_ms = static_cast<uint16_t>(parse_number(r, UINT16_MAX, line, "release"));
+        } else if (keyword == "duration") {
+            if (!(words >> arg)) {
+                throw ParseError(line, "duration needs a value");
+            }
+            clip.header.duration_ms = static_cast<uint32_t>(parse_number(arg, UINT32_MAX, line, "duration"));
+            clip.has_duration = true;
+        } else if (keyword == "loop") {
+            clip.header.flags |= HAPTIC_CLIP_FLAG_LOOP;
+        } else if (keyword == "left") {
+            clip.tracks[0] = parse_track(words, line);
+            clip.has_left = true;
+        } else if (keyword == "right") {
+            clip.tracks[1] = parse_track(words, line);
+            clip.has_right = true;
+        } else if (keyword == "both") {
+            clip.tracks[0] = parse_track(words, line);
+            clip.shared = true;
+        } else {
+            throw ParseError(line, "unknown keyword '" + keyword + "'");
+        }
+        if (words >> arg) {
+            throw ParseError(line, "unexpected '" + arg + "'");
+        }
+    }
+
+    if (clips.empty()) {
+        throw std::runtime_error("no clips defined");
+    }
+    if (clips.size() > UINT16_MAX) {
+        throw std::runtime_error("too many clips");
+    }
+    finish_clip(clips.back());
+    return clips;
+}
+
+/**
+ * @brief 与zlib相同的CRC32（固件用esp_rom_crc32_le(0, ...)校验）
+ */
+uint32_t crc32(const uint8_t *data, size_t len)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+template <typename T>
+void put(std::vector<uint8_t> &out, size_t offset, const T &value)
+{
+    std::memcpy(out.data() + offset, &value, sizeof(value));
+}
+
+/**
+ * @brief 按库头、目录、片段的顺序排布，各结构天然4字节对齐
+ */
+std::vector<uint8_t> pack(const std::vector<Clip> &clips)
+{
+    size_t size = sizeof(haptic_bank_header_t) + clips.size() * sizeof(haptic_clip_entry_t);
+    std::vector<uint8_t> out(size);
+
+    for (size_t i = 0; i < clips.size(); i++) {
+        const Clip &clip = clips[i];
+        haptic_clip_entry_t entry{};
+        std::strncpy(entry.name, clip.name.c_str(), sizeof(entry.name) - 1);
+        entry.offset = static_cast<uint32_t>(out.size());
+        put(out, sizeof(haptic_bank_header_t) + i * sizeof(entry), entry);
+
+        size_t offset = out.size();
+        size_t frames = clip.header.keyframe_count[0] + clip.header.keyframe_count[1];
+        out.resize(offset + sizeof(clip.header) + frames * sizeof(haptic_keyframe_t));
+        put(out, offset, clip.header);
+        offset += sizeof(clip.header);
+        for (int motor = 0; motor < 2; motor++) {
+            for (size_t k = 0; k < clip.header.keyframe_count[motor]; k++) {
+                put(out, offset, clip.tracks[motor][k]);
+                offset += sizeof(haptic_keyframe_t);
+            }
+        }
+    }
+
+    haptic_bank_header_t header{};
+    header.magic = HAPTIC_CLIP_MAGIC;
+    header.version = HAPTIC_CLIP_VERSION;
+    header.clip_count = static_cast<uint16_t>(clips.size());
+    header.size = static_cast<uint32_t>(out.size());
+    header.crc32 = crc32(out.data() + sizeof(header), out.size() - sizeof(header));
+    put(out, 0, header);
+    return out;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc != 3) {
+        std::fprintf(stderr, "usage: %s <clips.txt> <haptics.bin>\n", argv[0]);
+        return 2;
+    }
+
+    std::ifstream in(argv[1]);
+    if (!in) {
+        std::fprintf(stderr, "%s: cannot open\n", argv[1]);
+        return 1;
+    }
+
+    std::vector<uint8_t> blob;
+    std::vector<Clip> clips;
+    try {
+        clips = parse(in);
+        blob = pack(clips);
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s: %s\n", argv[1], e.what());
+        return 1;
+    }
+
+    std::ofstream out(argv[2], std::ios::binary);
+    out.write(reinterpret_cast<const char *>(blob.data()), static_cast<std::streamsize>(blob.size()));
+    if (!out) {
+        std::fprintf(stderr, "%s: write failed\n", argv[2]);
+        return 1;
+    }
+
+    for (const auto &clip : clips) {
+        std::printf("%-11s %6lu ms%s  keyframes %u/%u\n", clip.name.c_str(),
+                    static_cast<unsigned long>(clip.header.duration_ms),
+                    (clip.header.flags & HAPTIC_CLIP_FLAG_LOOP) ? " loop" : "     ",
+                    clip.header.keyframe_count[0], clip.header.keyframe_count[1]);
+    }
+    std::printf("%zu clips, %zu bytes\n", clips.size(), blob.size());
+    return 0;
+}